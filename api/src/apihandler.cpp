@@ -513,7 +513,7 @@ api::SmartContract APIHandler::fetch_smart_body(const csdb::Transaction& tr) {
 #endif
 
 #ifdef MONITOR_NODE
-    s_blockchain.applyToWallet(tr.target(), [&res](const cs::WalletsCache::WalletData& wd) { res.createTime = wd.createTime_; });
+    s_blockchain.applyToWallet(tr.target(), [&res](const cs::WalletsCache::WalletHead& wd) { res.createTime = wd.createTime_; });
 #endif
 	if (tr.user_field(0).is_valid())
 		res.transactionsCount = s_blockchain.getTransactionsCount(tr.target());
@@ -1954,37 +1954,38 @@ void APIHandler::TokensListGet(api::TokensListResult& _return, int64_t offset, i
 }
 
 //////////Wallets
-typedef std::list<std::pair<const cs::WalletsCache::WalletData::Address*, const cs::WalletsCache::WalletData*>> WCSortedList;
+// the copies of the wallets, the cache passes them while a block may be applied
+typedef std::list<cs::WalletsCache::WalletHead> WCSortedList;
 template <typename T>
-void walletStep(const cs::WalletsCache::WalletData::Address* addr, const cs::WalletsCache::WalletData* wd, const uint64_t num,
-                std::function<const T&(const cs::WalletsCache::WalletData&)> getter, std::function<bool(const T&, const T&)> comparator, WCSortedList& lst) {
+void walletStep(const cs::WalletsCache::WalletHead& wd, const uint64_t num,
+                std::function<const T&(const cs::WalletsCache::WalletHead&)> getter, std::function<bool(const T&, const T&)> comparator, WCSortedList& lst) {
     assert(num > 0);
 
-    const T& val = getter(*wd);
-    if (lst.size() < num || comparator(val, getter(*(lst.back().second)))) {
+    const T& val = getter(wd);
+    if (lst.size() < num || comparator(val, getter(lst.back()))) {
         // Guess why I can't use std::upper_bound in here
         // C++ is not as expressive as I've imagined it to be...
         auto it = lst.begin();
-        while (it != lst.end() && !comparator(val, getter(*(it->second)))) /* <-- this looks more like Lisp, doesn't it... */
+        while (it != lst.end() && !comparator(val, getter(*it))) /* <-- this looks more like Lisp, doesn't it... */
             ++it;
 
-        lst.insert(it, std::make_pair(addr, wd));
+        lst.insert(it, wd);
         if (lst.size() > num)
             lst.pop_back();
     }
 }
 
 template <typename T>
-void iterateOverWallets(std::function<const T&(const cs::WalletsCache::WalletData&)> getter, const uint64_t num, const bool desc, WCSortedList& lst, BlockChain& bc) {
+void iterateOverWallets(std::function<const T&(const cs::WalletsCache::WalletHead&)> getter, const uint64_t num, const bool desc, WCSortedList& lst, BlockChain& bc) {
     std::function<bool(const T&, const T&)> comparator;
     if (desc)
         comparator = std::greater<T>();
     else
         comparator = std::less<T>();
 
-    bc.iterateOverWallets([&lst, num, getter, comparator](const cs::WalletsCache::WalletData::Address& addr, const cs::WalletsCache::WalletData& wd) {
+    bc.iterateOverWallets([&lst, num, getter, comparator](const cs::WalletsCache::WalletData::Address& addr, const cs::WalletsCache::WalletHead& wd) {
         if (!addr.empty() && wd.balance_ >= csdb::Amount(0))
-            walletStep(&addr, &wd, num, getter, comparator, lst);
+            walletStep(wd, num, getter, comparator, lst);
         return true;
     });
 }
@@ -1999,14 +2000,14 @@ void APIHandler::WalletsGet(WalletsGetResult& _return, int64_t _offset, int64_t
     const uint64_t num = _offset + _limit;
 
     if (_ordCol == 0) {  // Balance
-        iterateOverWallets<csdb::Amount>([](const cs::WalletsCache::WalletData& wd) -> const csdb::Amount& { return wd.balance_; }, num, _desc, lst, s_blockchain);
+        iterateOverWallets<csdb::Amount>([](const cs::WalletsCache::WalletHead& wd) -> const csdb::Amount& { return wd.balance_; }, num, _desc, lst, s_blockchain);
     }
 #ifdef MONITOR_NODE
     else if (_ordCol == 1) {  // TimeReg
-        iterateOverWallets<uint64_t>([](const cs::WalletsCache::WalletData& wd) -> const uint64_t& { return wd.createTime_; }, num, _desc, lst, s_blockchain);
+        iterateOverWallets<uint64_t>([](const cs::WalletsCache::WalletHead& wd) -> const uint64_t& { return wd.createTime_; }, num, _desc, lst, s_blockchain);
     }
     else {  // Tx count
-        iterateOverWallets<uint64_t>([](const cs::WalletsCache::WalletData& wd) -> const uint64_t& { return wd.transNum_; }, num, _desc, lst, s_blockchain);
+        iterateOverWallets<uint64_t>([](const cs::WalletsCache::WalletHead& wd) -> const uint64_t& { return wd.transNum_; }, num, _desc, lst, s_blockchain);
     }
 #endif
 
@@ -2018,13 +2019,13 @@ void APIHandler::WalletsGet(WalletsGetResult& _return, int64_t _offset, int64_t
 
     for (; ptr != lst.end(); ++ptr) {
         api::WalletInfo wi;
-        const cs::Bytes addr_b((*(ptr->first)).begin(), (*(ptr->first)).end());
+        const cs::Bytes addr_b(ptr->address_.begin(), ptr->address_.end());
         wi.address = fromByteArray(addr_b);
-        wi.balance.integral = ptr->second->balance_.integral();
-        wi.balance.fraction = ptr->second->balance_.fraction();
+        wi.balance.integral = ptr->balance_.integral();
+        wi.balance.fraction = ptr->balance_.fraction();
 #ifdef MONITOR_NODE
-        wi.transactionsNumber = ptr->second->transNum_;
-        wi.firstTransactionTime = ptr->second->createTime_;
+        wi.transactionsNumber = ptr->transNum_;
+        wi.firstTransactionTime = ptr->createTime_;
 #endif
 
         _return.wallets.push_back(wi);
@@ -55,6 +55,40 @@ struct PoolSyncData {
     uint16_t sequencesVerificationFrequency = 350;  // sequences received verification frequency : 0-never; 1-once per round: other- in ms;
 };
 
+struct NetworkData {
+    uint16_t recvBatchSize = 1;     // datagrams read by one recvmmsg call (linux only): 1 - one receive_from per datagram
+    uint16_t recvBatchTimeout = 0;  // time to wait for the rest of a batch after its first datagram, in microseconds: 0 - never wait
+    uint16_t shards = 1;            // reader/processor pairs on SO_REUSEPORT sockets (linux only): 1 - single reader
+
+    uint16_t compressionMinSize = 128;       // smaller payloads are sent uncompressed, in bytes
+    uint16_t compressionMinGain = 5;         // a message type is not compressed while its estimated gain is lower, in percents
+    std::string compressionTypes;            // comma separated MsgTypes numbers to compress: empty - all
+    std::string compressionDictionary;       // LZ4 dictionary file: trained on the traffic and saved on exit, if there is none
+    bool compressionDictionarySend = false;  // compress with the dictionary, every node should have the same file
+
+    uint16_t pacingRate = 0;        // fragments per second to one peer (linux only): 0 - no limit
+    uint16_t pacingGlobalRate = 0;  // fragments per second to all the peers (linux only): 0 - no limit
+    uint16_t pacingBurst = 256;     // fragments sent at once before the rates apply
+};
+
+struct DatabaseData {
+    std::string engine = "berkeleydb";  // berkeleydb, blocklog or leveldb (if the node is built with CSDB_LEVELDB)
+
+    uint16_t cacheSize = 64;        // leveldb block cache, in megabytes
+    uint16_t writeBufferSize = 16;  // leveldb memtable size, in megabytes
+    uint8_t bloomBits = 10;         // leveldb bloom filter bits per key: 0 - no filter
+    bool compression = true;        // leveldb table blocks compression
+
+    uint16_t segmentSize = 256;  // blocklog segment file size, in megabytes
+
+    uint16_t blockCacheSize = 64;  // decoded blocks read from the database, in megabytes: 0 - no cache
+
+    uint16_t snapshotInterval = 10000;  // blocks between the wallets state snapshots: 0 - no snapshots
+
+    bool addressIndex = true;           // address -> transactions index for the wallet history lookups
+    bool rebuildAddressIndex = false;  // build the address index anew, set by --rebuild-address-index
+};
+
 struct ApiData {
     uint16_t port = 9090;
     uint16_t ajaxPort = 8081;
@@ -133,6 +167,14 @@ public:
         return apiData_;
     }
 
+    const NetworkData& getNetworkSettings() const {
+        return networkData_;
+    }
+
+    const DatabaseData& getDatabaseSettings() const {
+        return databaseData_;
+    }
+
     const cs::PublicKey& getMyPublicKey() const {
         return publicKey_;
     }
@@ -147,6 +189,8 @@ private:
     void setLoggerSettings(const boost::property_tree::ptree& config);
     void readPoolSynchronizerData(const boost::property_tree::ptree& config);
     void readApiData(const boost::property_tree::ptree& config);
+    void readNetworkData(const boost::property_tree::ptree& config);
+    void readDatabaseData(const boost::property_tree::ptree& config);
 
     bool readKeys(const std::string& pathToPk, const std::string& pathToSk, const bool encrypt);
     void showKeys(const std::string& pk58);
@@ -186,6 +230,8 @@ private:
 
     PoolSyncData poolSyncData_;
     ApiData apiData_;
+    NetworkData networkData_;
+    DatabaseData databaseData_;
 };
 
 #endif  // CONFIG_HPP
@@ -35,6 +35,8 @@ const std::string BLOCK_NAME_HOST_OUTPUT = "host_output";
 const std::string BLOCK_NAME_HOST_ADDRESS = "host_address";
 const std::string BLOCK_NAME_POOL_SYNC = "pool_sync";
 const std::string BLOCK_NAME_API = "api";
+const std::string BLOCK_NAME_NETWORK = "network";
+const std::string BLOCK_NAME_DATABASE = "database";
 
 const std::string PARAM_NAME_NODE_TYPE = "node_type";
 const std::string PARAM_NAME_BOOTSTRAP_TYPE = "bootstrap_type";
@@ -58,8 +60,31 @@ const std::string PARAM_NAME_AJAX_PORT = "ajax_port";
 const std::string PARAM_NAME_EXECUTOR_PORT = "executor_port";
 const std::string PARAM_NAME_APIEXEC_PORT = "apiexec_port";
 
+const std::string PARAM_NAME_NETWORK_RECV_BATCH_SIZE = "recv_batch_size";
+const std::string PARAM_NAME_NETWORK_RECV_BATCH_TIMEOUT = "recv_batch_timeout";
+const std::string PARAM_NAME_NETWORK_SHARDS = "shards";
+const std::string PARAM_NAME_NETWORK_COMPRESSION_MIN_SIZE = "compression_min_size";
+const std::string PARAM_NAME_NETWORK_COMPRESSION_MIN_GAIN = "compression_min_gain";
+const std::string PARAM_NAME_NETWORK_COMPRESSION_TYPES = "compression_types";
+const std::string PARAM_NAME_NETWORK_COMPRESSION_DICTIONARY = "compression_dictionary";
+const std::string PARAM_NAME_NETWORK_COMPRESSION_DICTIONARY_SEND = "compression_dictionary_send";
+const std::string PARAM_NAME_NETWORK_PACING_RATE = "pacing_rate";
+const std::string PARAM_NAME_NETWORK_PACING_GLOBAL_RATE = "pacing_global_rate";
+const std::string PARAM_NAME_NETWORK_PACING_BURST = "pacing_burst";
+
+const std::string PARAM_NAME_DATABASE_ENGINE = "engine";
+const std::string PARAM_NAME_DATABASE_CACHE_SIZE = "cache_size";
+const std::string PARAM_NAME_DATABASE_WRITE_BUFFER_SIZE = "write_buffer_size";
+const std::string PARAM_NAME_DATABASE_BLOOM_BITS = "bloom_bits";
+const std::string PARAM_NAME_DATABASE_COMPRESSION = "compression";
+const std::string PARAM_NAME_DATABASE_SNAPSHOT_INTERVAL = "snapshot_interval";
+const std::string PARAM_NAME_DATABASE_SEGMENT_SIZE = "segment_size";
+const std::string PARAM_NAME_DATABASE_BLOCK_CACHE_SIZE = "block_cache_size";
+const std::string PARAM_NAME_DATABASE_ADDRESS_INDEX = "address_index";
+
 const std::string ARG_NAME_CONFIG_FILE = "config-file";
 const std::string ARG_NAME_DB_PATH = "db-path";
+const std::string ARG_NAME_REBUILD_ADDRESS_INDEX = "rebuild-address-index";
 const std::string ARG_NAME_PUBLIC_KEY_FILE = "public-key-file";
 const std::string ARG_NAME_PRIVATE_KEY_FILE = "private-key-file";
 const std::string ARG_NAME_ENCRYPT_KEY_FILE = "encryptkey";
@@ -148,6 +173,7 @@ Config Config::read(po::variables_map& vm) {
     Config result = readFromFile(getArgFromCmdLine(vm, ARG_NAME_CONFIG_FILE, DEFAULT_PATH_TO_CONFIG));
 
     result.pathToDb_ = getArgFromCmdLine(vm, ARG_NAME_DB_PATH, DEFAULT_PATH_TO_DB);
+    result.databaseData_.rebuildAddressIndex = vm.count(ARG_NAME_REBUILD_ADDRESS_INDEX) > 0;
 
     if (result.good_)
         result.good_ = result.readKeys(getArgFromCmdLine(vm, ARG_NAME_PUBLIC_KEY_FILE, DEFAULT_PATH_TO_PUBLIC_KEY),
@@ -568,6 +594,8 @@ Config Config::readFromFile(const std::string& fileName) {
         result.setLoggerSettings(config);
         result.readPoolSynchronizerData(config);
         result.readApiData(config);
+        result.readNetworkData(config);
+        result.readDatabaseData(config);
         result.good_ = true;
     }
     catch (boost::property_tree::ini_parser_error& e) {
@@ -647,6 +675,57 @@ void Config::readApiData(const boost::property_tree::ptree& config) {
     checkAndSaveValue(data, BLOCK_NAME_API, PARAM_NAME_APIEXEC_PORT, apiData_.apiexecPort);
 }
 
+void Config::readNetworkData(const boost::property_tree::ptree& config) {
+    const std::string& block = BLOCK_NAME_NETWORK;
+
+    if (!config.count(block)) {
+        return;
+    }
+
+    const boost::property_tree::ptree& data = config.get_child(block);
+
+    checkAndSaveValue(data, block, PARAM_NAME_NETWORK_RECV_BATCH_SIZE, networkData_.recvBatchSize);
+    checkAndSaveValue(data, block, PARAM_NAME_NETWORK_RECV_BATCH_TIMEOUT, networkData_.recvBatchTimeout);
+    checkAndSaveValue(data, block, PARAM_NAME_NETWORK_SHARDS, networkData_.shards);
+    checkAndSaveValue(data, block, PARAM_NAME_NETWORK_COMPRESSION_MIN_SIZE, networkData_.compressionMinSize);
+    checkAndSaveValue(data, block, PARAM_NAME_NETWORK_COMPRESSION_MIN_GAIN, networkData_.compressionMinGain);
+    checkAndSaveValue(data, block, PARAM_NAME_NETWORK_COMPRESSION_DICTIONARY_SEND, networkData_.compressionDictionarySend);
+    checkAndSaveValue(data, block, PARAM_NAME_NETWORK_PACING_RATE, networkData_.pacingRate);
+    checkAndSaveValue(data, block, PARAM_NAME_NETWORK_PACING_GLOBAL_RATE, networkData_.pacingGlobalRate);
+    checkAndSaveValue(data, block, PARAM_NAME_NETWORK_PACING_BURST, networkData_.pacingBurst);
+
+    if (data.count(PARAM_NAME_NETWORK_COMPRESSION_TYPES)) {
+        networkData_.compressionTypes = data.get<std::string>(PARAM_NAME_NETWORK_COMPRESSION_TYPES);
+    }
+
+    if (data.count(PARAM_NAME_NETWORK_COMPRESSION_DICTIONARY)) {
+        networkData_.compressionDictionary = data.get<std::string>(PARAM_NAME_NETWORK_COMPRESSION_DICTIONARY);
+    }
+}
+
+void Config::readDatabaseData(const boost::property_tree::ptree& config) {
+    const std::string& block = BLOCK_NAME_DATABASE;
+
+    if (!config.count(block)) {
+        return;
+    }
+
+    const boost::property_tree::ptree& data = config.get_child(block);
+
+    checkAndSaveValue(data, block, PARAM_NAME_DATABASE_CACHE_SIZE, databaseData_.cacheSize);
+    checkAndSaveValue(data, block, PARAM_NAME_DATABASE_WRITE_BUFFER_SIZE, databaseData_.writeBufferSize);
+    checkAndSaveValue(data, block, PARAM_NAME_DATABASE_BLOOM_BITS, databaseData_.bloomBits);
+    checkAndSaveValue(data, block, PARAM_NAME_DATABASE_COMPRESSION, databaseData_.compression);
+    checkAndSaveValue(data, block, PARAM_NAME_DATABASE_SNAPSHOT_INTERVAL, databaseData_.snapshotInterval);
+    checkAndSaveValue(data, block, PARAM_NAME_DATABASE_SEGMENT_SIZE, databaseData_.segmentSize);
+    checkAndSaveValue(data, block, PARAM_NAME_DATABASE_BLOCK_CACHE_SIZE, databaseData_.blockCacheSize);
+    checkAndSaveValue(data, block, PARAM_NAME_DATABASE_ADDRESS_INDEX, databaseData_.addressIndex);
+
+    if (data.count(PARAM_NAME_DATABASE_ENGINE)) {
+        databaseData_.engine = data.get<std::string>(PARAM_NAME_DATABASE_ENGINE);
+    }
+}
+
 template <typename T>
 bool Config::checkAndSaveValue(const boost::property_tree::ptree& data, const std::string& block, const std::string& param, T& value) {
     if (data.count(param)) {
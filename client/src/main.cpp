@@ -128,6 +128,41 @@ BOOL WINAPI CtrlHandler(DWORD fdwCtrlType) {
 }
 #endif  // !WIN32
 
+// copies the blocks of the database at db-path into <db-path>.<engine>, the node is not started
+bool convertDatabase(const Config& config, const std::string& engine) {
+    const std::string& path = config.getPathToDB();
+    auto from = BlockChain::openDatabase(path, config.getDatabaseSettings());
+    if (!from) {
+        return false;
+    }
+
+    DatabaseData settings = config.getDatabaseSettings();
+    settings.engine = engine;
+
+    std::string toPath = path;
+    while (!toPath.empty() && (toPath.back() == '/' || toPath.back() == '\\')) {
+        toPath.pop_back();
+    }
+    toPath += '.' + engine;
+
+    auto to = BlockChain::openDatabase(toPath, settings);
+    if (!to) {
+        return false;
+    }
+
+    cslog() << "Converting " << path << " into " << engine << " database at " << toPath;
+
+    const bool ok = csdb::copy_blocks(*from, *to, [](uint64_t copied) { std::cout << '\r' << WithDelimiters(copied) << std::flush; });
+
+    if (!ok) {
+        cserror() << "Conversion failed: " << to->last_error_message();
+        return false;
+    }
+
+    cslog() << "\rDB is converted, set engine=" << engine << " and db-path to " << toPath;
+    return true;
+}
+
 int main(int argc, char* argv[]) {
 #ifdef WIN32
     if (!SetConsoleCtrlHandler(CtrlHandler, TRUE)) {
@@ -150,7 +185,9 @@ int main(int argc, char* argv[]) {
         "public-key-file", po::value<std::string>(), "path to public key file (default: \"NodePublic.txt\")")("private-key-file", po::value<std::string>(),
                                                                                                               "path to private key file (default: \"NodePrivate.txt\")")(
         "dumpkeys", po::value<std::string>(), "dump your public and private keys into a JSON file with the specified name (UNENCRYPTED!)")(
-        "encryptkey", "encrypts the private key with password upon startup (if not yet encrypted)");
+        "encryptkey", "encrypts the private key with password upon startup (if not yet encrypted)")(
+        "convert-db", po::value<std::string>(), "copy the blocks of the DB into a new DB of the given engine (berkeleydb, blocklog, leveldb) and exit")(
+        "rebuild-address-index", "drop the address index of the DB and build it anew in the background");
 
     variables_map vm;
     try {
@@ -200,6 +237,12 @@ int main(int argc, char* argv[]) {
 
     logger::initialize(config.getLoggerSettings());
 
+    if (vm.count("convert-db")) {
+        const bool converted = convertDatabase(config, vm["convert-db"].as<std::string>());
+        logger::cleanup();
+        return converted ? 0 : 1;
+    }
+
     Node node(config);
 
     if (!node.isGood()) {
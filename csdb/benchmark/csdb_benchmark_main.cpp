@@ -1,11 +1,142 @@
 #include <benchmark/benchmark.h>
 
-static void bench(benchmark::State &state)
-{
-  for(auto _ : state)
-  {
-  }
+#include <cstdlib>
+#include <memory>
+#include <random>
+
+#include <boost/filesystem.hpp>
+
+#include "csdb/database_berkeleydb.hpp"
+#include "csdb/database_blocklog.hpp"
+#include "csdb/database_leveldb.hpp"
+
+// Block append and random read throughput of the storage engines.
+// The blocks are taken from the BerkeleyDB chain at $CSDB_BENCHMARK_CHAIN, or generated if it is not set.
+
+namespace {
+constexpr size_t kBlocks = 20000;
+constexpr size_t kGeneratedBlockSize = 2048;
+
+const std::vector<cs::Bytes>& blocks() {
+    static std::vector<cs::Bytes> result = [] {
+        std::vector<cs::Bytes> blocks;
+        blocks.reserve(kBlocks);
+
+        if (const char* chain = std::getenv("CSDB_BENCHMARK_CHAIN")) {
+            csdb::DatabaseBerkeleyDB db;
+            if (db.open(chain)) {
+                auto it = static_cast<csdb::Database&>(db).new_iterator();
+                for (it->seek_to_first(); it->is_valid() && blocks.size() < kBlocks; it->next()) {
+                    blocks.push_back(it->value());
+                }
+            }
+        }
+
+        std::mt19937 gen(42);
+        while (blocks.size() < kBlocks) {
+            cs::Bytes block(kGeneratedBlockSize);
+            for (auto& byte : block) {
+                byte = static_cast<uint8_t>(gen() % 16);  // compressible like the real blocks
+            }
+            blocks.push_back(std::move(block));
+        }
+
+        return blocks;
+    }();
+
+    return result;
+}
+
+cs::Bytes block_hash(size_t index) {
+    cs::Bytes hash(32);
+    for (size_t i = 0; i < sizeof(index); ++i) {
+        hash[i] = static_cast<uint8_t>(index >> (8 * i));
+    }
+    return hash;
+}
+
+std::string fresh_path(const char* name) {
+    auto path = boost::filesystem::temp_directory_path() / name;
+    boost::filesystem::remove_all(path);
+    return path.string();
+}
+
+std::unique_ptr<csdb::Database> open_db(int engine, const std::string& path) {
+    if (engine == 0) {
+        auto db = std::make_unique<csdb::DatabaseBerkeleyDB>();
+        return db->open(path) ? std::move(db) : nullptr;
+    }
+
+    if (engine == 1) {
+        auto db = std::make_unique<csdb::DatabaseLevelDB>();
+        return db->open(path) ? std::move(db) : nullptr;
+    }
+
+    auto db = std::make_unique<csdb::DatabaseBlockLog>();
+    return db->open(path) ? std::move(db) : nullptr;
+}
+
+const char* engine_name(int engine) {
+    return engine == 0 ? "berkeleydb" : engine == 1 ? "leveldb" : "blocklog";
+}
+
+void fill(csdb::Database& db, size_t batch) {
+    const auto& data = blocks();
+    csdb::Database::PoolItemList items;
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        items.push_back(csdb::Database::PoolItem{block_hash(i), static_cast<uint32_t>(i), data[i]});
+        if (items.size() == batch || i + 1 == data.size()) {
+            db.put(items);
+            items.clear();
+        }
+    }
+}
+}  // namespace
+
+// range(0): engine, range(1): blocks per transaction
+static void BM_Append(benchmark::State& state) {
+    state.SetLabel(engine_name(static_cast<int>(state.range(0))));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto db = open_db(static_cast<int>(state.range(0)), fresh_path("csdb_benchmark_append"));
+        state.ResumeTiming();
+
+        if (!db) {
+            state.SkipWithError("cannot open the database");
+            break;
+        }
+        fill(*db, static_cast<size_t>(state.range(1)));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * blocks().size()));
+}
+BENCHMARK(BM_Append)->Args({0, 1})->Args({0, 256})->Args({1, 1})->Args({1, 256})->Args({2, 1})->Args({2, 256})->Unit(benchmark::kMillisecond);
+
+// range(0): engine, range(1): 0 - by hash, 1 - by sequence
+static void BM_RandomRead(benchmark::State& state) {
+    state.SetLabel(engine_name(static_cast<int>(state.range(0))));
+
+    auto db = open_db(static_cast<int>(state.range(0)), fresh_path("csdb_benchmark_read"));
+    if (!db) {
+        state.SkipWithError("cannot open the database");
+        return;
+    }
+    fill(*db, 256);
+
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<size_t> index(0, blocks().size() - 1);
+    cs::Bytes value;
+
+    for (auto _ : state) {
+        const size_t i = index(gen);
+        const bool found = state.range(1) == 0 ? db->get(block_hash(i), &value) : db->get(static_cast<uint32_t>(i + 1), &value);
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
 }
-BENCHMARK(bench);
+BENCHMARK(BM_RandomRead)->Args({0, 0})->Args({0, 1})->Args({1, 0})->Args({1, 1})->Args({2, 0})->Args({2, 1});
 
 BENCHMARK_MAIN();
@@ -7,6 +7,7 @@
 #define _CREDITS_CSDB_DATABASE_H_INCLUDED_
 
 #include <client/params.hpp>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -40,10 +41,31 @@ public:
     virtual bool get(const uint32_t seq_no, cs::Bytes* value = nullptr) = 0;
     virtual bool remove(const cs::Bytes& key) = 0;
 
+    // a block with its hash and sequence number, see put()
+    struct PoolItem {
+        cs::Bytes key;
+        uint32_t seq_no;
+        cs::Bytes value;
+    };
+    using PoolItemList = std::vector<PoolItem>;
+
+    // writes several blocks at once, the default implementation puts them one by one
+    virtual bool put(const PoolItemList& items);
+
     using Item = std::pair<cs::Bytes, cs::Bytes>;
     using ItemList = std::vector<Item>;
+    // writes all the items atomically: either every item is stored or none;
+    // the items are (hash, block) pairs, the blocks get the record numbers after the highest one stored
     virtual bool write_batch(const ItemList& items) = 0;
 
+    // the secondary index kept apart from the blocks: puts the items and removes the keys atomically,
+    // the default implementations fail with NotSupported
+    virtual bool update_index(const ItemList& items, const std::vector<cs::Bytes>& removed);
+    // the items with from <= key < to in the key order (descending if reverse), at most limit of them if not 0
+    virtual bool index_range(const cs::Bytes& from, const cs::Bytes& to, bool reverse, size_t limit, ItemList* items);
+    // removes every item of the index, the default implementation removes them by ranges through the two above
+    virtual bool clear_index();
+
 #ifdef TRANSACTIONS_INDEX
     virtual bool putToTransIndex(const cs::Bytes& key, const cs::Bytes& value) = 0;
     virtual bool getFromTransIndex(const cs::Bytes& key, cs::Bytes* value) = 0;
@@ -78,6 +100,10 @@ protected:
     void set_last_error(Error error, const char* message, ...);
 };
 
+// copies every block with its hash in the record order, to move a database to another engine;
+// the progress gets the number of blocks copied, the transactions index is not copied
+bool copy_blocks(Database& from, Database& to, const std::function<void(uint64_t)>& progress = nullptr);
+
 }  // namespace csdb
 
 #endif  // _CREDITS_CSDB_DATABASE_H_INCLUDED_
@@ -30,11 +30,14 @@ public:
 private:
     bool is_open() const final;
     bool put(const cs::Bytes& key, uint32_t seq_no, const cs::Bytes& value) final;
+    bool put(const PoolItemList& items) final;
     bool get(const cs::Bytes& key, cs::Bytes* value) final;
     bool get(const uint32_t seq_no, cs::Bytes* value) final;
     bool remove(const cs::Bytes&) final;
     bool write_batch(const ItemList&) final;
     IteratorPtr new_iterator() final;
+    bool update_index(const ItemList& items, const std::vector<cs::Bytes>& removed) final;
+    bool index_range(const cs::Bytes& from, const cs::Bytes& to, bool reverse, size_t limit, ItemList* items) final;
 
 #ifdef TRANSACTIONS_INDEX
     bool putToTransIndex(const cs::Bytes& key, const cs::Bytes& value) override final;
@@ -51,6 +54,7 @@ private:
     DbEnv env_;
     std::unique_ptr<Db> db_blocks_;
     std::unique_ptr<Db> db_seq_no_;
+    std::unique_ptr<Db> db_addr_idx_;  // the address index, see update_index()
 #ifdef TRANSACTIONS_INDEX
     std::unique_ptr<Db> db_trans_idx_;
 #endif
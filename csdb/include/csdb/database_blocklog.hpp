@@ -0,0 +1,141 @@
+/**
+ * @file database_blocklog.h
+ */
+
+#ifndef _CREDITS_CSDB_DATABASE_BLOCKLOG_H_INCLUDED_
+#define _CREDITS_CSDB_DATABASE_BLOCKLOG_H_INCLUDED_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "csdb/database.hpp"
+
+namespace csdb {
+
+/**
+ * @brief Блоки в сегментированном журнале только для дописывания
+ *
+ * Блоки дописываются в файлы сегментов blocks.NNNNNN.log. Файл index.dat хранит записи
+ * фиксированной длины (сегмент, смещение, размер, контрольная сумма) по номеру записи
+ * (sequence + 1), сегменты и индекс читаются через отображение в память окнами по 64 МБ (на POSIX
+ * окно отображается целиком, и дописанные в него данные читаются без нового отображения). Журнал
+ * hashes.dat (хеш -> номер записи) при открытии загружается в память.
+ *
+ * put(), write_batch() и remove() возвращаются после fsync сегмента, hashes.dat и index.dat.
+ * Журнал индекса адресов (addresses.dat) только сбрасывается из буфера stdio: после сбоя питания
+ * его хвост может потеряться, и индекс отстанет от блоков, но не опередит их.
+ *
+ * Вторичный индекс (\ref update_index) хранится на диске: отсортированный файл addresses.run
+ * (в памяти только первый ключ и смещение каждого блока из 64 записей) и журнал addresses.dat,
+ * в который пакеты с контрольной суммой дописываются. Изменения из журнала держатся в памяти
+ * и сливаются с addresses.run в новый файл (запись во временный файл и переименование)
+ * при открытии и когда журнал превышает Options::index_journal_size записей.
+ * Очистка индекса (\ref clear_index) опустошает оба файла.
+ *
+ * При открытии хвост, записанный не полностью (например, при аварийном завершении), отбрасывается.
+ */
+class DatabaseBlockLog : public Database {
+public:
+    struct Options {
+        size_t segment_size = 256 << 20;  // a new segment is started when the current one grows over it, bytes
+        size_t index_journal_size = 1 << 18;  // the address index journal is merged into the sorted run when it grows over it, entries
+    };
+
+    DatabaseBlockLog();
+    ~DatabaseBlockLog() override;
+
+public:
+    bool open(const std::string& path);
+    bool open(const std::string& path, const Options& options);
+
+private:
+    bool is_open() const final;
+    bool put(const cs::Bytes& key, uint32_t seq_no, const cs::Bytes& value) final;
+    bool put(const PoolItemList& items) final;
+    bool get(const cs::Bytes& key, cs::Bytes* value) final;
+    bool get(const uint32_t seq_no, cs::Bytes* value) final;
+    bool remove(const cs::Bytes&) final;
+    bool write_batch(const ItemList&) final;
+    IteratorPtr new_iterator() final;
+    bool update_index(const ItemList& items, const std::vector<cs::Bytes>& removed) final;
+    bool index_range(const cs::Bytes& from, const cs::Bytes& to, bool reverse, size_t limit, ItemList* items) final;
+    bool clear_index() final;
+
+#ifdef TRANSACTIONS_INDEX
+    bool putToTransIndex(const cs::Bytes& key, const cs::Bytes& value) override final;
+    bool getFromTransIndex(const cs::Bytes& key, cs::Bytes* value) override final;
+#endif
+
+private:
+    class Iterator;
+    class File;
+
+    struct IndexEntry {
+        uint32_t segment;
+        uint32_t offset;
+        uint32_t size;
+        uint32_t checksum;
+    };
+
+    // a change of the address index not merged into the run yet
+    struct JournalValue {
+        bool put;
+        std::string value;
+    };
+
+    using IndexItem = std::pair<std::string, std::string>;
+
+private:
+    /* Assuming lock_ has been locked */
+    bool recover();
+    bool load_hashes();
+    bool load_address_index();
+    bool load_address_run();
+    bool read_run_block(size_t block, std::vector<IndexItem>& items);
+    size_t find_run_block(const std::string& key, bool inclusive) const;
+    bool compact_address_index();
+#ifdef TRANSACTIONS_INDEX
+    bool load_trans_index();
+#endif
+    bool append(const cs::Bytes& key, uint32_t record, const cs::Bytes& value);
+    bool flush();
+    bool read(uint32_t record, cs::Bytes* value);
+    bool read_entry(uint32_t record, IndexEntry& entry);
+    bool find(const cs::Bytes& key, uint32_t& record) const;
+    uint32_t next_record(uint32_t record, bool forward);
+    bool open_segment(uint32_t segment);
+    std::string segment_name(uint32_t segment) const;
+    void close();
+
+private:
+    std::string path_;
+    Options options_;
+
+    std::vector<std::unique_ptr<File>> segments_;
+    std::unique_ptr<File> index_;
+    std::unique_ptr<File> hashes_;
+    uint32_t records_ = 0;  // index entries, the last one is the last record
+
+    std::unordered_map<std::string, uint32_t> hash_records_;
+
+    std::unique_ptr<File> addresses_;
+    std::unique_ptr<File> address_run_;
+    std::vector<std::pair<std::string, uint64_t>> address_blocks_;  // the first key and the offset of every block of the run
+    uint64_t address_run_size_ = 0;                                 // the entries of the run, the footer excluded, bytes
+    std::map<std::string, JournalValue> address_journal_;
+
+#ifdef TRANSACTIONS_INDEX
+    std::unique_ptr<File> trans_index_;
+    std::unordered_map<std::string, cs::Bytes> trans_index_values_;
+#endif
+
+    std::mutex lock_;
+};
+
+}  // namespace csdb
+
+#endif  // _CREDITS_CSDB_DATABASE_BLOCKLOG_H_INCLUDED_
@@ -0,0 +1,74 @@
+/**
+ * @file database_leveldb.h
+ */
+
+#ifndef _CREDITS_CSDB_DATABASE_LEVELDB_H_INCLUDED_
+#define _CREDITS_CSDB_DATABASE_LEVELDB_H_INCLUDED_
+
+#include <memory>
+#include <mutex>
+
+#include "csdb/database.hpp"
+
+namespace leveldb {
+class DB;
+class Cache;
+class FilterPolicy;
+class Status;
+}  // namespace leveldb
+
+namespace csdb {
+
+class DatabaseLevelDB : public Database {
+public:
+    struct Options {
+        size_t cache_size = 64 << 20;         // block cache, bytes
+        size_t write_buffer_size = 16 << 20;  // memtable size, bytes
+        int bloom_bits = 10;                  // bloom filter bits per key: 0 - no filter
+        bool compression = true;              // snappy compression of the table blocks
+    };
+
+    DatabaseLevelDB();
+    ~DatabaseLevelDB() override;
+
+public:
+    bool open(const std::string& path);
+    bool open(const std::string& path, const Options& options);
+
+private:
+    bool is_open() const final;
+    bool put(const cs::Bytes& key, uint32_t seq_no, const cs::Bytes& value) final;
+    bool put(const PoolItemList& items) final;
+    bool get(const cs::Bytes& key, cs::Bytes* value) final;
+    bool get(const uint32_t seq_no, cs::Bytes* value) final;
+    bool remove(const cs::Bytes&) final;
+    bool write_batch(const ItemList&) final;
+    IteratorPtr new_iterator() final;
+    bool update_index(const ItemList& items, const std::vector<cs::Bytes>& removed) final;
+    bool index_range(const cs::Bytes& from, const cs::Bytes& to, bool reverse, size_t limit, ItemList* items) final;
+
+#ifdef TRANSACTIONS_INDEX
+    bool putToTransIndex(const cs::Bytes& key, const cs::Bytes& value) override final;
+    bool getFromTransIndex(const cs::Bytes& key, cs::Bytes* value) override final;
+#endif
+
+private:
+    class Iterator;
+
+private:
+    void set_last_error_from_leveldb(const leveldb::Status& status);
+    bool read_last_record();
+
+private:
+    // the filter policy and the cache must outlive the database
+    std::unique_ptr<const leveldb::FilterPolicy> filter_;
+    std::unique_ptr<leveldb::Cache> cache_;
+    std::unique_ptr<leveldb::DB> db_;
+
+    std::mutex write_lock_;
+    uint32_t last_record_ = 0;  // write_batch() appends after it
+};
+
+}  // namespace csdb
+
+#endif  // _CREDITS_CSDB_DATABASE_LEVELDB_H_INCLUDED_
@@ -136,6 +136,13 @@ public:
     Pool(PoolHash previous_hash, cs::Sequence sequence, const Storage& storage = Storage());
 
     static Pool from_binary(cs::Bytes&& data);
+    /**
+     * @brief Пул, транзакции которого разбираются из бинарного представления при обращении к ним.
+     *
+     * При создании проверяется формат и запоминаются смещения транзакций, \ref binary_view
+     * возвращает исходные данные без копирования.
+     */
+    static Pool lazy_from_binary(cs::Bytes&& data);
     static Pool meta_from_binary(cs::Bytes&& data, size_t& cnt);
     static Pool load(const PoolHash& hash, Storage storage = Storage());
 
@@ -233,6 +240,12 @@ public:
      */
     cs::Bytes to_binary() const noexcept;
 
+    /**
+     * @brief Бинарное представление пула без копирования
+     * @return Представление, действительное пока существует пул; пустое, если пул не в режиме read-only.
+     */
+    cs::BytesView binary_view() const noexcept;
+
     /**
      * @brief Сохранение пула в хранилище.
      * @param[in] storage Хранилище, в котором нужно сохранить пул.
@@ -6,6 +6,7 @@
 #ifndef _CREDITS_CSDB_STORAGE_H_INCLUDED_
 #define _CREDITS_CSDB_STORAGE_H_INCLUDED_
 
+#include <array>
 #include <functional>
 #include <memory>
 #include <string>
@@ -39,8 +40,9 @@ using ReadBlockSignal = cs::Signal<void(const csdb::Pool& block, bool* test_fail
  *
  * Для работы с физическим хранилищем используется интерфейсный класс \ref ::csdb::Database.
  *
- * В данный момент имеется единственная реализация интерфейса \ref ::csdb::Database -
- * \ref ::csdb::DatabaseLevelDB. Она же используется при открытии объекта \ref ::csdb::Storage.
+ * Интерфейс \ref ::csdb::Database реализуют \ref ::csdb::DatabaseBerkeleyDB, \ref ::csdb::DatabaseBlockLog и, при сборке с CSDB_LEVELDB,
+ * \ref ::csdb::DatabaseLevelDB. При открытии объекта \ref ::csdb::Storage по пути используется
+ * \ref ::csdb::DatabaseBerkeleyDB, другой драйвер передаётся через \ref OpenOptions.
  *
  * При создании объект \ref ::csdb::Storage имеет статус "не открытого", вызовы любых методов получени
  * или записи данных порождают ошибку ::csdb::Storage::NotOpen. Для работы с объектом \ref ::csdb::Storage
@@ -91,6 +93,8 @@ public:
     struct OpenOptions {
         /// Экземпляр драйвера базы данных
         ::std::shared_ptr<Database> db;
+        /// Объём кеша прочитанных пулов в байтах, 0 - без кеша
+        size_t cache_size = 64 << 20;
     };
 
     struct OpenProgress {
@@ -180,6 +184,10 @@ public:
      * @param[in] pool Пул для записи в хранилище.
      * @return true, если пул успешно записан.
      *
+     * Пул записывается фоновым потоком. Если очередь записи заполнена, а запись в базу данных
+     * не удаётся, пул не принимается. Ошибка записи ранее принятых пулов возвращается
+     * \ref last_error при следующем вызове.
+     *
      * \sa ::csdb::Pool::save
      */
     bool pool_save(Pool pool);
@@ -199,6 +207,70 @@ public:
 
     Pool pool_remove_last();
 
+    /**
+     * @brief Статистика асинхронной записи пулов
+     *
+     * Пулы, переданные в \ref pool_save, пишутся фоновым потоком группами, по одной транзакции
+     * базы данных на группу. Гистограммы логарифмические: в ячейке i учтены записи
+     * длительностью [2^i, 2^(i+1)) микросекунд или размером [2^i, 2^(i+1)) пулов.
+     */
+    struct WriteStats {
+        static constexpr size_t Buckets = 24;
+
+        uint64_t commits = 0;
+        uint64_t pools = 0;
+        uint64_t failures = 0;
+        uint64_t stalls = 0;    // pool_save ждал места в очереди
+        uint64_t rejected = 0;  // pool_save не дождался места, пока запись в базу данных не удаётся
+        uint64_t lost = 0;      // пулы, отброшенные после неудачных повторов записи
+        size_t queued = 0;
+
+        std::array<uint64_t, Buckets> latency{};
+        std::array<uint64_t, Buckets> batch_size{};
+    };
+
+    WriteStats write_stats() const;
+
+    /**
+     * @brief Статистика кеша прочитанных пулов
+     *
+     * Пулы, прочитанные из базы данных в \ref pool_load и \ref pool_load_meta, хранятся
+     * декодированными, пока их примерный объём в памяти не превысит \ref OpenOptions::cache_size.
+     * Пул, удалённый \ref pool_remove_last, удаляется и из кеша.
+     */
+    struct CacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t pools = 0;
+        size_t bytes = 0;  // примерный объём пулов в памяти
+    };
+
+    CacheStats cache_stats() const;
+
+    /**
+     * @brief Ждёт, пока все пулы из очереди записи будут записаны в базу данных
+     *
+     * Если фоновый поток отбросил пулы, которые не удалось записать, \ref last_error
+     * возвращает \ref DatabaseError.
+     */
+    void flush();
+
+    /**
+     * @brief Начинает групповую запись пулов
+     *
+     * Пулы, переданные в \ref pool_save до вызова \ref commit_batch, не отдаются фоновому потоку,
+     * а записываются в базу данных одной транзакцией в \ref commit_batch. До этого они доступны
+     * для чтения так же, как пулы из очереди записи.
+     */
+    void begin_batch();
+
+    /**
+     * @brief Записывает пулы, накопленные после \ref begin_batch, одной транзакцией
+     * @return true, если пулы записаны. При ошибке пулы передаются фоновому потоку для повторной записи.
+     */
+    bool commit_batch();
+
     /**
      * @brief Получение транзакции по идентификатору.
      * @param[in] id Идентификатор транзакции
@@ -223,6 +295,60 @@ public:
      */
     Transaction get_last_by_target(Address target) const noexcept;
 
+    /**
+     * @brief Преобразование адреса транзакции в открытый ключ для индекса адресов
+     *
+     * Возвращает адрес-открытый ключ. Адрес другого вида в индекс не попадает.
+     */
+    using AddressResolver = ::std::function<Address(const Address&)>;
+
+    /**
+     * @brief Добавляет транзакции пула в индекс адресов
+     * @param[in] pool      Пул с номером \ref address_index_next
+     * @param[in] resolver  Преобразование адресов источника и получателя в открытые ключи,
+     *                      если не задано, в индекс попадают только открытые ключи.
+     * @return true, если пул проиндексирован.
+     *
+     * Индекс адресов хранится в базе данных рядом с пулами (\ref Database::update_index). Для каждого
+     * открытого ключа в нём есть номера (sequence, индекс) транзакций, в которых ключ - источник или
+     * получатель, и номер транзакции по внутреннему идентификатору источника. Пока проиндексированы
+     * все пулы хранилища, \ref transactions, \ref get_last_by_source, \ref get_last_by_target и
+     * \ref get_from_blockchain находят транзакции открытого ключа по индексу, а не просматривают
+     * цепочку от последнего пула.
+     */
+    bool address_index_add(const Pool& pool, const AddressResolver& resolver = nullptr);
+
+    /**
+     * @brief Удаляет транзакции последнего проиндексированного пула из индекса адресов
+     * @param[in] pool      Пул с номером \ref address_index_next - 1
+     * @param[in] resolver  То же преобразование, что и в \ref address_index_add
+     * @return true, если пул удалён из индекса.
+     */
+    bool address_index_remove(const Pool& pool, const AddressResolver& resolver = nullptr);
+
+    /**
+     * @brief Номер пула, который должен быть проиндексирован следующим
+     *
+     * Индекс построен, если номер равен \ref size.
+     */
+    cs::Sequence address_index_next() const noexcept;
+
+    /**
+     * @brief Удаляет индекс адресов целиком
+     * @return true, если индекс удалён.
+     */
+    bool address_index_reset();
+
+    /**
+     * @brief Получить транзакции открытого ключа по индексу адресов
+     * @param[in]  key    Адрес-открытый ключ
+     * @param[in]  skip   Сколько последних транзакций пропустить
+     * @param[in]  limit  Максимальное число транзакций в списке
+     * @param[out] result Транзакции от последней к первой
+     * @return false, если индекс не построен или адрес не открытый ключ.
+     */
+    bool address_transactions(const Address& key, size_t skip, size_t limit, ::std::vector<Transaction>& result) const;
+
     // And now for something completely different
     PoolHash get_previous_transaction_block(const Address&, const PoolHash&);
     void set_previous_transaction_block(const Address&, const PoolHash& currTransBlock, const PoolHash& prevTransBlock);
@@ -264,6 +390,7 @@ public:
      *
      * \параметр addr должен точно совпадать с полем source у транзакции в блокчейне (если addr - id, source должен быть также id)
      * \используется для входного параметра addr в виде id кошелька
+     * \если addr - открытый ключ и индекс адресов построен, транзакция ищется по индексу, и source может быть любого вида
      */
     bool get_from_blockchain(const Address& addr /*input*/, const int64_t& innerId /*input*/, Transaction& trx /*output*/) const;
 
@@ -273,6 +400,10 @@ public signals:
 private:
   static cs::Bytes get_trans_index_key(const Address&, const PoolHash&);
   Pool pool_load_internal(const PoolHash& hash, const bool metaOnly, size_t& trxCnt) const;
+  bool address_index_ready() const noexcept;
+  bool address_index_update(const Pool& pool, const AddressResolver& resolver, bool add);
+  Transaction address_index_load(const cs::Bytes& position, Pool& pool) const;
+  Transaction address_index_last(const Address& addr, uint8_t role) const;
 
   ::std::shared_ptr<priv> d;
 };
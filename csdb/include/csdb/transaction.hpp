@@ -159,6 +159,8 @@ public:
 private:
   void put(::csdb::priv::obstream&) const;
   bool get(::csdb::priv::ibstream&);
+  // moves the stream past a transaction without decoding it into an object
+  static bool skip(::csdb::priv::ibstream&);
   friend class ::csdb::priv::obstream;
   friend class ::csdb::priv::ibstream;
   friend class Pool;
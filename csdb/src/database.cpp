@@ -1,4 +1,5 @@
 #include "csdb/database.hpp"
+#include "csdb/pool.hpp"
 
 #include <cstdarg>
 #include <cstdio>
@@ -22,6 +23,50 @@ Database::Database() {
 
 Database::~Database() = default;
 
+bool Database::put(const PoolItemList& items) {
+    for (const auto& item : items) {
+        if (!put(item.key, item.seq_no, item.value)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Database::update_index(const ItemList&, const std::vector<cs::Bytes>&) {
+    set_last_error(NotSupported);
+    return false;
+}
+
+bool Database::index_range(const cs::Bytes&, const cs::Bytes&, bool, size_t, ItemList*) {
+    set_last_error(NotSupported);
+    return false;
+}
+
+bool Database::clear_index() {
+    constexpr size_t batch_size = 4096;
+    ItemList items;
+
+    do {
+        if (!index_range(cs::Bytes{}, cs::Bytes{0xFF}, false, batch_size, &items)) {
+            return false;
+        }
+
+        std::vector<cs::Bytes> keys;
+        keys.reserve(items.size());
+        for (auto& item : items) {
+            keys.push_back(std::move(item.first));
+        }
+
+        if (!keys.empty() && !update_index({}, keys)) {
+            return false;
+        }
+    } while (items.size() == batch_size);
+
+    set_last_error();
+    return true;
+}
+
 Database::Iterator::Iterator() = default;
 
 Database::Iterator::~Iterator() = default;
@@ -80,4 +125,54 @@ void Database::set_last_error(Error error, const char* message, ...) {
     }
 }
 
+bool copy_blocks(Database& from, Database& to, const std::function<void(uint64_t)>& progress) {
+    constexpr size_t batch_size = 256;
+
+    auto it = from.new_iterator();
+    if (!it) {
+        return false;
+    }
+
+    Database::PoolItemList items;
+    uint64_t copied = 0;
+
+    for (it->seek_to_first(); it->is_valid(); it->next()) {
+        cs::Bytes value = it->value();
+
+        const Pool pool = Pool::from_binary(cs::Bytes(value));
+        if (!pool.is_valid()) {
+            return false;
+        }
+
+        items.push_back(Database::PoolItem{pool.hash().to_binary(), static_cast<uint32_t>(pool.sequence()), std::move(value)});
+
+        if (items.size() == batch_size) {
+            if (!to.put(items)) {
+                return false;
+            }
+
+            copied += items.size();
+            items.clear();
+
+            if (progress) {
+                progress(copied);
+            }
+        }
+    }
+
+    if (!items.empty()) {
+        if (!to.put(items)) {
+            return false;
+        }
+
+        copied += items.size();
+
+        if (progress) {
+            progress(copied);
+        }
+    }
+
+    return true;
+}
+
 }  // namespace csdb
@@ -1,6 +1,8 @@
 #include <db_cxx.h>
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 #include <exception>
 
 #include <boost/filesystem.hpp>
@@ -51,6 +53,27 @@ struct Dbt_copy<cs::Bytes> : public Dbt {
     }
 };
 
+// a buffer the database reallocates when it returns a key or a value into it, see DB_SET_RANGE
+struct Dbt_realloc : public Dbt {
+    explicit Dbt_realloc(const cs::Bytes &data = cs::Bytes{}) {
+        void *buf = std::malloc(std::max<size_t>(data.size(), 1));
+        if (buf != nullptr && !data.empty()) {
+            std::memcpy(buf, data.data(), data.size());
+        }
+        set_data(buf);
+        set_size(buf != nullptr ? static_cast<uint32_t>(data.size()) : 0);
+        set_flags(DB_DBT_REALLOC);
+    }
+    ~Dbt_realloc() {
+        std::free(get_data());
+    }
+
+    cs::Bytes bytes() const {
+        auto begin = static_cast<const uint8_t *>(get_data());
+        return cs::Bytes(begin, begin + get_size());
+    }
+};
+
 struct Dbt_safe : public Dbt {
     Dbt_safe() {
         set_data(nullptr);
@@ -68,7 +91,8 @@ struct Dbt_safe : public Dbt {
 DatabaseBerkeleyDB::DatabaseBerkeleyDB()
 : env_(static_cast<uint32_t>(0))
 , db_blocks_(nullptr)
-, db_seq_no_(nullptr) {
+, db_seq_no_(nullptr)
+, db_addr_idx_(nullptr) {
 }
 
 DatabaseBerkeleyDB::~DatabaseBerkeleyDB() {
@@ -78,6 +102,9 @@ DatabaseBerkeleyDB::~DatabaseBerkeleyDB() {
     std::cout << "Attempt db_seq_no_ to close...\n" << std::flush;
     db_seq_no_->close(0);
     std::cout << "DB db_seq_no_ was closed.\n" << std::flush;
+    if (db_addr_idx_) {
+        db_addr_idx_->close(0);
+    }
 #ifdef TRANSACTIONS_INDEX
     db_trans_idx_->close(0);
 #endif
@@ -115,6 +142,7 @@ bool DatabaseBerkeleyDB::open(const std::string &path) {
 
     db_blocks_.reset(nullptr);
     db_seq_no_.reset(nullptr);
+    db_addr_idx_.reset(nullptr);
 
     env_.log_set_config(DB_LOG_AUTO_REMOVE, 1);
 
@@ -154,6 +182,11 @@ bool DatabaseBerkeleyDB::open(const std::string &path) {
         status = db_seq_no->open(txn, "sequence.db", NULL, DB_HASH, DB_CREATE | DB_READ_UNCOMMITTED, 0);
         db_seq_no_.swap(db_seq_no);
     }
+    if (!status) {
+        decltype(db_addr_idx_) db_addr_idx(new Db(&env_, 0));
+        status = db_addr_idx->open(txn, "addresses.db", NULL, DB_BTREE, DB_CREATE | DB_READ_UNCOMMITTED, 0);
+        db_addr_idx_.swap(db_addr_idx);
+    }
 
     if (status) {
         set_last_error_from_berkeleydb(status);
@@ -217,6 +250,54 @@ bool DatabaseBerkeleyDB::put(const cs::Bytes &key, uint32_t seq_no, const cs::By
     }
 }
 
+bool DatabaseBerkeleyDB::put(const PoolItemList &items) {
+    if (!db_blocks_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    if (items.empty()) {
+        set_last_error();
+        return true;
+    }
+
+    // all the blocks go in one transaction: one log flush and one lock round instead of a pair per block
+    DbTxn *tid;
+    int status = env_.txn_begin(nullptr, &tid, DB_READ_UNCOMMITTED);
+    int txn_create_status = status;
+    auto g = cs::scopeGuard([&]() {
+        if (txn_create_status) {
+            return;
+        }
+        if (status) {
+            tid->abort();
+        }
+        else {
+            tid->commit(0);
+        }
+    });
+
+    for (auto it = items.begin(); !status && it != items.end(); ++it) {
+        Dbt_copy<uint32_t> db_seq_no(it->seq_no + 1);
+        Dbt_copy<cs::Bytes> db_value(it->value);
+        status = db_blocks_->put(tid, &db_seq_no, &db_value, 0);
+
+        if (!status) {
+            Dbt_copy<cs::Bytes> db_key(it->key);
+            status = db_seq_no_->put(tid, &db_key, &db_seq_no, 0);
+        }
+    }
+
+    if (!status) {
+        set_last_error();
+        return true;
+    }
+    else {
+        set_last_error_from_berkeleydb(status);
+        return false;
+    }
+}
+
 bool DatabaseBerkeleyDB::get(const cs::Bytes &key, cs::Bytes *value) {
     if (!db_blocks_) {
         set_last_error(NotOpen);
@@ -304,16 +385,76 @@ bool DatabaseBerkeleyDB::remove(const cs::Bytes &key) {
     return true;
 }
 
-bool DatabaseBerkeleyDB::write_batch(const ItemList &) {
-    assert(false);
-
+bool DatabaseBerkeleyDB::write_batch(const ItemList &items) {
     if (!db_blocks_) {
         set_last_error(NotOpen);
         return false;
     }
 
-    set_last_error();
-    return true;
+    if (items.empty()) {
+        set_last_error();
+        return true;
+    }
+
+    // items are (hash, block) pairs, the blocks are appended after the last record in one transaction
+    DbTxn *tid;
+    int status = env_.txn_begin(nullptr, &tid, DB_READ_UNCOMMITTED);
+    int txn_create_status = status;
+    auto g = cs::scopeGuard([&]() {
+        if (txn_create_status) {
+            return;
+        }
+        if (status) {
+            tid->abort();
+        }
+        else {
+            tid->commit(0);
+        }
+    });
+
+    // DB_APPEND would go after the removed records too, a record left deleted in place without DB_RENUMBER
+    uint32_t record = 0;
+
+    if (!status) {
+        Dbc *cursorp = nullptr;
+        status = db_blocks_->cursor(tid, &cursorp, 0);
+
+        if (!status) {
+            Dbt_copy<uint32_t> db_last;
+            Dbt db_value;
+            db_value.set_flags(DB_DBT_PARTIAL);  // the key is enough
+
+            const int found = cursorp->get(&db_last, &db_value, DB_LAST);
+            cursorp->close();
+
+            if (!found) {
+                record = static_cast<uint32_t>(db_last);
+            }
+            else if (found != DB_NOTFOUND) {
+                status = found;
+            }
+        }
+    }
+
+    for (auto it = items.begin(); !status && it != items.end(); ++it) {
+        Dbt_copy<uint32_t> db_seq_no(++record);
+        Dbt_copy<cs::Bytes> db_value(it->second);
+        status = db_blocks_->put(tid, &db_seq_no, &db_value, 0);
+
+        if (!status) {
+            Dbt_copy<cs::Bytes> db_key(it->first);
+            status = db_seq_no_->put(tid, &db_key, &db_seq_no, 0);
+        }
+    }
+
+    if (!status) {
+        set_last_error();
+        return true;
+    }
+    else {
+        set_last_error_from_berkeleydb(status);
+        return false;
+    }
 }
 
 class DatabaseBerkeleyDB::Iterator final : public Database::Iterator {
@@ -416,6 +557,97 @@ DatabaseBerkeleyDB::IteratorPtr DatabaseBerkeleyDB::new_iterator() {
     return Database::IteratorPtr(new DatabaseBerkeleyDB::Iterator(cursorp));
 }
 
+bool DatabaseBerkeleyDB::update_index(const ItemList &items, const std::vector<cs::Bytes> &removed) {
+    if (!db_addr_idx_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    DbTxn *tid;
+    int status = env_.txn_begin(nullptr, &tid, DB_READ_UNCOMMITTED);
+    int txn_create_status = status;
+    auto g = cs::scopeGuard([&]() {
+        if (txn_create_status) {
+            return;
+        }
+        if (status) {
+            tid->abort();
+        }
+        else {
+            tid->commit(0);
+        }
+    });
+
+    for (auto it = removed.begin(); !status && it != removed.end(); ++it) {
+        Dbt_copy<cs::Bytes> db_key(*it);
+        status = db_addr_idx_->del(tid, &db_key, 0);
+        if (status == DB_NOTFOUND) {
+            status = 0;
+        }
+    }
+
+    for (auto it = items.begin(); !status && it != items.end(); ++it) {
+        Dbt_copy<cs::Bytes> db_key(it->first);
+        Dbt_copy<cs::Bytes> db_value(it->second);
+        status = db_addr_idx_->put(tid, &db_key, &db_value, 0);
+    }
+
+    if (!status) {
+        set_last_error();
+        return true;
+    }
+    else {
+        set_last_error_from_berkeleydb(status);
+        return false;
+    }
+}
+
+bool DatabaseBerkeleyDB::index_range(const cs::Bytes &from, const cs::Bytes &to, bool reverse, size_t limit, ItemList *items) {
+    if (!db_addr_idx_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    items->clear();
+
+    Dbc *cursorp = nullptr;
+    int status = db_addr_idx_->cursor(nullptr, &cursorp, 0);
+    if (status) {
+        set_last_error_from_berkeleydb(status);
+        return false;
+    }
+    auto g = cs::scopeGuard([&]() { cursorp->close(); });
+
+    // the keys are compared as bytes, the same way the btree orders them
+    auto in_range = [&](const cs::Bytes &key) { return !(key < from) && key < to; };
+
+    Dbt_realloc key(reverse ? to : from);
+    Dbt_realloc value;
+
+    status = cursorp->get(&key, &value, DB_SET_RANGE);
+    if (reverse) {
+        status = cursorp->get(&key, &value, status == 0 ? DB_PREV : DB_LAST);
+    }
+
+    while (status == 0 && (limit == 0 || items->size() < limit)) {
+        cs::Bytes bytes = key.bytes();
+        if (!in_range(bytes)) {
+            break;
+        }
+
+        items->emplace_back(std::move(bytes), value.bytes());
+        status = cursorp->get(&key, &value, reverse ? DB_PREV : DB_NEXT);
+    }
+
+    if (status != 0 && status != DB_NOTFOUND) {
+        set_last_error_from_berkeleydb(status);
+        return false;
+    }
+
+    set_last_error();
+    return true;
+}
+
 #ifdef TRANSACTIONS_INDEX
 bool DatabaseBerkeleyDB::putToTransIndex(const cs::Bytes &key, const cs::Bytes &value) {
     if (!db_trans_idx_) {
@@ -0,0 +1,1256 @@
+#include "csdb/database_blocklog.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#ifdef _MSC_VER
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace csdb {
+
+namespace {
+namespace fs = boost::filesystem;
+namespace ipc = boost::interprocess;
+
+const char *const kIndexName = "index.dat";
+const char *const kHashesName = "hashes.dat";
+const char *const kAddressesName = "addresses.dat";
+const char *const kAddressRunName = "addresses.run";
+#ifdef TRANSACTIONS_INDEX
+const char *const kTransIndexName = "transindex.dat";
+#endif
+
+// the files are mapped by windows of this size aligned to it, a read over a window boundary maps the windows it covers
+constexpr uint64_t kMapWindow = 64 << 20;
+
+// an index entry of a removed record or of a gap before a record put out of order
+constexpr uint32_t kNoSegment = std::numeric_limits<uint32_t>::max();
+
+// hashes.dat entry: record, key size, key; record 0 removes the key
+constexpr size_t kHashHeaderSize = sizeof(uint32_t) + sizeof(uint16_t);
+
+// addresses.dat batch: payload size, payload checksum, then entries of op, key size, key, value size, value
+constexpr size_t kAddressBatchHeaderSize = 2 * sizeof(uint32_t);
+constexpr uint8_t kAddressRemove = 0;
+constexpr uint8_t kAddressPut = 1;
+constexpr size_t kAddressHeaderSize = sizeof(uint8_t) + 2 * sizeof(uint16_t);
+
+// addresses.run: entries of key size, key, value size, value in the key order, then the number of entries
+// and the checksum of them; the first key of every kRunBlock entries is kept in memory
+constexpr size_t kRunBlock = 64;
+constexpr size_t kRunFooterSize = sizeof(uint64_t) + sizeof(uint32_t);
+
+uint32_t checksum(const uint8_t *data, size_t size) {
+    boost::crc_32_type crc;
+    crc.process_bytes(data, size);
+    return crc.checksum();
+}
+
+std::string to_string(const cs::Bytes &key) {
+    return std::string(key.begin(), key.end());
+}
+
+cs::Bytes encode_record(uint32_t record) {
+    return cs::Bytes{uint8_t(record >> 24), uint8_t(record >> 16), uint8_t(record >> 8), uint8_t(record)};
+}
+
+// parses the run entry at pos and moves pos past it, false if it does not fit before end
+bool next_run_entry(const uint8_t *data, uint64_t &pos, uint64_t end, std::string *key, std::string *value) {
+    uint16_t key_size = 0;
+    uint16_t value_size = 0;
+    if (pos + 2 * sizeof(uint16_t) > end) {
+        return false;
+    }
+    std::memcpy(&key_size, data + pos, sizeof(key_size));
+    if (pos + 2 * sizeof(uint16_t) + key_size > end) {
+        return false;
+    }
+    std::memcpy(&value_size, data + pos + sizeof(key_size) + key_size, sizeof(value_size));
+    if (pos + 2 * sizeof(uint16_t) + key_size + value_size > end) {
+        return false;
+    }
+
+    const char *key_data = reinterpret_cast<const char *>(data + pos + sizeof(key_size));
+    if (key != nullptr) {
+        key->assign(key_data, key_size);
+    }
+    if (value != nullptr) {
+        value->assign(key_data + key_size + sizeof(value_size), value_size);
+    }
+
+    pos += 2 * sizeof(uint16_t) + key_size + value_size;
+    return true;
+}
+}  // namespace
+
+// A file written through stdio and read through a memory mapping of the windows around the last read. On POSIX a window
+// is mapped whole even past the end of the file, so the bytes appended into it later are read without a new mapping
+class DatabaseBlockLog::File {
+public:
+    ~File() {
+        close();
+    }
+
+    bool open(const std::string &name) {
+        name_ = name;
+        file_ = std::fopen(name.c_str(), "r+b");
+        if (file_ == nullptr) {
+            file_ = std::fopen(name.c_str(), "w+b");
+        }
+        if (file_ == nullptr || std::fseek(file_, 0, SEEK_END) != 0) {
+            return false;
+        }
+
+        size_ = static_cast<uint64_t>(std::ftell(file_));
+        return true;
+    }
+
+    void close() {
+        unmap();
+        if (file_ != nullptr) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    const std::string &name() const {
+        return name_;
+    }
+
+    uint64_t size() const {
+        return size_;
+    }
+
+    bool append(const void *data, size_t size) {
+        return write_at(size_, data, size);
+    }
+
+    bool write_at(uint64_t offset, const void *data, size_t size) {
+        if (std::fseek(file_, static_cast<long>(offset), SEEK_SET) != 0 || std::fwrite(data, 1, size, file_) != size) {
+            return false;
+        }
+
+        size_ = std::max<uint64_t>(size_, offset + size);
+        return true;
+    }
+
+    bool flush() {
+        return std::fflush(file_) == 0;
+    }
+
+    // flushes and waits for the bytes to reach the disk
+    bool sync() {
+#ifdef _MSC_VER
+        return flush() && _commit(_fileno(file_)) == 0;
+#else
+        return flush() && fsync(fileno(file_)) == 0;
+#endif
+    }
+
+    bool truncate(uint64_t size) {
+        if (!flush()) {
+            return false;
+        }
+        close();
+
+        boost::system::error_code error;
+        fs::resize_file(name_, size, error);
+        return !error && open(name_);
+    }
+
+    // the bytes must be flushed; the pointer is valid until the next data() or truncate()
+    const uint8_t *data(uint64_t offset, size_t size) {
+        if (size == 0 || offset + size > size_) {
+            return nullptr;
+        }
+
+        if (offset < mapped_begin_ || offset + size > mapped_end_) {
+            unmap();
+
+            const uint64_t begin = offset / kMapWindow * kMapWindow;
+            uint64_t end = (offset + size + kMapWindow - 1) / kMapWindow * kMapWindow;
+#ifdef _MSC_VER
+            // a view past the end of the file cannot be mapped there
+            end = size_;
+#endif
+            try {
+                mapping_ = ipc::file_mapping(name_.c_str(), ipc::read_only);
+                region_ = ipc::mapped_region(mapping_, ipc::read_only, static_cast<ipc::offset_t>(begin), static_cast<size_t>(end - begin));
+            }
+            catch (const ipc::interprocess_exception &) {
+                return nullptr;
+            }
+            mapped_begin_ = begin;
+            mapped_end_ = end;
+        }
+
+        return static_cast<const uint8_t *>(region_.get_address()) + (offset - mapped_begin_);
+    }
+
+private:
+    void unmap() {
+        region_ = ipc::mapped_region();
+        mapping_ = ipc::file_mapping();
+        mapped_begin_ = 0;
+        mapped_end_ = 0;
+    }
+
+    std::string name_;
+    std::FILE *file_ = nullptr;
+    uint64_t size_ = 0;
+
+    ipc::file_mapping mapping_;
+    ipc::mapped_region region_;
+    uint64_t mapped_begin_ = 0;
+    uint64_t mapped_end_ = 0;
+};
+
+DatabaseBlockLog::DatabaseBlockLog() = default;
+
+DatabaseBlockLog::~DatabaseBlockLog() {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (index_) {
+        flush();
+    }
+    close();
+}
+
+bool DatabaseBlockLog::open(const std::string &path) {
+    return open(path, Options{});
+}
+
+bool DatabaseBlockLog::open(const std::string &path, const Options &options) {
+    std::lock_guard<std::mutex> lock(lock_);
+    close();
+
+    path_ = path;
+    options_ = options;
+
+    boost::system::error_code error;
+    fs::create_directories(path_, error);
+    if (error) {
+        set_last_error(IOError, "BlockLog error: cannot create %s: %s", path_.c_str(), error.message().c_str());
+        return false;
+    }
+
+    auto open_file = [this](std::unique_ptr<File> &file, const char *name) {
+        file.reset(new File);
+        if (!file->open((fs::path(path_) / name).string())) {
+            set_last_error(IOError, "BlockLog error: cannot open %s", file->name().c_str());
+            return false;
+        }
+        return true;
+    };
+
+    bool ok = open_file(index_, kIndexName) && open_file(hashes_, kHashesName) && open_file(addresses_, kAddressesName) &&
+              open_file(address_run_, kAddressRunName);
+#ifdef TRANSACTIONS_INDEX
+    ok = ok && open_file(trans_index_, kTransIndexName);
+#endif
+
+    for (uint32_t segment = 0; ok && fs::exists(segment_name(segment)); ++segment) {
+        ok = open_segment(segment);
+    }
+
+    ok = ok && recover() && load_hashes() && load_address_index();
+#ifdef TRANSACTIONS_INDEX
+    ok = ok && load_trans_index();
+#endif
+
+    if (!ok) {
+        close();
+        return false;
+    }
+
+    set_last_error();
+    return true;
+}
+
+bool DatabaseBlockLog::is_open() const {
+    return static_cast<bool>(index_);
+}
+
+void DatabaseBlockLog::close() {
+    segments_.clear();
+    index_.reset();
+    hashes_.reset();
+    records_ = 0;
+    hash_records_.clear();
+    addresses_.reset();
+    address_run_.reset();
+    address_blocks_.clear();
+    address_run_size_ = 0;
+    address_journal_.clear();
+#ifdef TRANSACTIONS_INDEX
+    trans_index_.reset();
+    trans_index_values_.clear();
+#endif
+}
+
+std::string DatabaseBlockLog::segment_name(uint32_t segment) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "blocks.%06u.log", segment);
+    return (fs::path(path_) / name).string();
+}
+
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::open_segment(uint32_t segment) {
+    std::unique_ptr<File> file(new File);
+    if (!file->open(segment_name(segment))) {
+        set_last_error(IOError, "BlockLog error: cannot open %s", file->name().c_str());
+        return false;
+    }
+
+    segments_.push_back(std::move(file));
+    return true;
+}
+
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::read_entry(uint32_t record, IndexEntry &entry) {
+    if (record == 0 || record > records_) {
+        return false;
+    }
+
+    const uint8_t *data = index_->data(uint64_t(record - 1) * sizeof(IndexEntry), sizeof(IndexEntry));
+    if (data == nullptr) {
+        return false;
+    }
+
+    std::memcpy(&entry, data, sizeof(IndexEntry));
+    return entry.segment != kNoSegment;
+}
+
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::recover() {
+    // an entry written partly is dropped
+    records_ = static_cast<uint32_t>(index_->size() / sizeof(IndexEntry));
+
+    // so are the last entries whose data has not reached the disk
+    auto is_whole = [this](const IndexEntry &entry) {
+        if (entry.segment >= segments_.size()) {
+            return false;
+        }
+        if (entry.size == 0) {
+            return entry.offset <= segments_[entry.segment]->size();
+        }
+        const uint8_t *data = segments_[entry.segment]->data(entry.offset, entry.size);
+        return data != nullptr && checksum(data, entry.size) == entry.checksum;
+    };
+
+    IndexEntry entry{};
+    while (records_ > 0 && (!read_entry(records_, entry) || !is_whole(entry))) {
+        --records_;
+    }
+
+    if (uint64_t(records_) * sizeof(IndexEntry) != index_->size()) {
+        if (!index_->truncate(uint64_t(records_) * sizeof(IndexEntry))) {
+            set_last_error(IOError, "BlockLog error: cannot truncate %s", index_->name().c_str());
+            return false;
+        }
+    }
+
+    if (segments_.empty()) {
+        return true;
+    }
+
+    // and the data written after the last entry; the entries kept of the last segment are the last ones
+    const uint32_t last_segment = static_cast<uint32_t>(segments_.size() - 1);
+    uint64_t end = 0;
+
+    for (uint32_t record = records_; record > 0; --record) {
+        const uint8_t *data = index_->data(uint64_t(record - 1) * sizeof(IndexEntry), sizeof(IndexEntry));
+        if (data == nullptr) {
+            break;
+        }
+
+        std::memcpy(&entry, data, sizeof(IndexEntry));
+        if (entry.segment == kNoSegment) {
+            continue;
+        }
+        if (entry.segment != last_segment) {
+            break;
+        }
+        end = std::max<uint64_t>(end, uint64_t(entry.offset) + entry.size);
+    }
+
+    if (segments_.back()->size() > end && !segments_.back()->truncate(end)) {
+        set_last_error(IOError, "BlockLog error: cannot truncate %s", segments_.back()->name().c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::load_hashes() {
+    const uint64_t size = hashes_->size();
+    const uint8_t *data = hashes_->data(0, static_cast<size_t>(size));
+
+    uint64_t pos = 0;
+    bool stale = false;
+
+    while (data != nullptr && pos + kHashHeaderSize <= size) {
+        uint32_t record = 0;
+        uint16_t key_size = 0;
+        std::memcpy(&record, data + pos, sizeof(record));
+        std::memcpy(&key_size, data + pos + sizeof(record), sizeof(key_size));
+
+        if (pos + kHashHeaderSize + key_size > size) {
+            break;
+        }
+
+        std::string key(reinterpret_cast<const char *>(data + pos + kHashHeaderSize), key_size);
+        pos += kHashHeaderSize + key_size;
+
+        IndexEntry entry{};
+        if (record == 0) {
+            hash_records_.erase(key);
+        }
+        else if (read_entry(record, entry)) {
+            hash_records_[key] = record;
+        }
+        else {
+            // the record was dropped by recover(), the key must not point at a record put later
+            hash_records_.erase(key);
+            stale = true;
+        }
+    }
+
+    if (!stale && pos == size) {
+        return true;
+    }
+
+    // the torn tail and the stale keys are dropped by writing the map anew
+    if (!hashes_->truncate(0)) {
+        set_last_error(IOError, "BlockLog error: cannot truncate %s", hashes_->name().c_str());
+        return false;
+    }
+
+    for (const auto &item : hash_records_) {
+        const uint16_t key_size = static_cast<uint16_t>(item.first.size());
+        if (!hashes_->append(&item.second, sizeof(item.second)) || !hashes_->append(&key_size, sizeof(key_size)) || !hashes_->append(item.first.data(), key_size)) {
+            set_last_error(IOError, "BlockLog error: cannot write %s", hashes_->name().c_str());
+            return false;
+        }
+    }
+
+    return hashes_->flush();
+}
+
+#ifdef TRANSACTIONS_INDEX
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::load_trans_index() {
+    // the transactions index: key size, key, value size, value; the last value of a key wins
+    const uint64_t trans_size = trans_index_->size();
+    const uint8_t *trans_data = trans_index_->data(0, static_cast<size_t>(trans_size));
+    uint64_t pos = 0;
+
+    while (trans_data != nullptr && pos + sizeof(uint16_t) <= trans_size) {
+        uint16_t key_size = 0;
+        uint32_t value_size = 0;
+        std::memcpy(&key_size, trans_data + pos, sizeof(key_size));
+        if (pos + sizeof(key_size) + key_size + sizeof(value_size) > trans_size) {
+            break;
+        }
+        std::memcpy(&value_size, trans_data + pos + sizeof(key_size) + key_size, sizeof(value_size));
+        const uint64_t value_pos = pos + sizeof(key_size) + key_size + sizeof(value_size);
+        if (value_pos + value_size > trans_size) {
+            break;
+        }
+
+        trans_index_values_[std::string(reinterpret_cast<const char *>(trans_data + pos + sizeof(key_size)), key_size)] =
+            cs::Bytes(trans_data + value_pos, trans_data + value_pos + value_size);
+        pos = value_pos + value_size;
+    }
+
+    if (pos != trans_size && !trans_index_->truncate(pos)) {
+        set_last_error(IOError, "BlockLog error: cannot truncate %s", trans_index_->name().c_str());
+        return false;
+    }
+
+    return true;
+}
+#endif
+
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::load_address_run() {
+    address_blocks_.clear();
+    address_run_size_ = 0;
+
+    const uint64_t size = address_run_->size();
+    if (size == 0) {
+        return true;
+    }
+
+    const uint8_t *data = size >= kRunFooterSize ? address_run_->data(0, static_cast<size_t>(size)) : nullptr;
+    if (data != nullptr) {
+        const uint64_t end = size - kRunFooterSize;
+        uint64_t entries = 0;
+        uint32_t crc = 0;
+        std::memcpy(&entries, data + end, sizeof(entries));
+        std::memcpy(&crc, data + end + sizeof(entries), sizeof(crc));
+
+        uint64_t pos = 0;
+        uint64_t count = 0;
+        std::string key;
+        if (checksum(data, static_cast<size_t>(end)) == crc) {
+            for (uint64_t entry = 0; next_run_entry(data, entry, end, &key, nullptr); pos = entry, ++count) {
+                if (count % kRunBlock == 0) {
+                    address_blocks_.emplace_back(key, pos);
+                }
+            }
+        }
+
+        if (pos == end && count == entries) {
+            address_run_size_ = end;
+            return true;
+        }
+    }
+
+    // the run is replaced as a whole, so a damaged one is not a torn write: the index is dropped together with
+    // the journal over it, Storage builds it anew from the blocks
+    address_blocks_.clear();
+    if (!address_run_->truncate(0) || !addresses_->truncate(0)) {
+        set_last_error(IOError, "BlockLog error: cannot truncate %s", address_run_->name().c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::load_address_index() {
+    if (!load_address_run()) {
+        return false;
+    }
+
+    // a batch of update_index(): payload size, payload checksum, then entries of op, key size, key, value size, value;
+    // a batch written partly is dropped as a whole
+    const uint64_t size = addresses_->size();
+    const uint8_t *data = addresses_->data(0, static_cast<size_t>(size));
+    uint64_t pos = 0;
+
+    while (data != nullptr && pos + kAddressBatchHeaderSize <= size) {
+        uint32_t payload = 0;
+        uint32_t crc = 0;
+        std::memcpy(&payload, data + pos, sizeof(payload));
+        std::memcpy(&crc, data + pos + sizeof(payload), sizeof(crc));
+
+        const uint64_t end = pos + kAddressBatchHeaderSize + payload;
+        if (end > size || checksum(data + pos + kAddressBatchHeaderSize, payload) != crc) {
+            break;
+        }
+
+        uint64_t entry = pos + kAddressBatchHeaderSize;
+        while (entry + kAddressHeaderSize <= end) {
+            const uint8_t op = data[entry];
+            uint16_t key_size = 0;
+            uint16_t value_size = 0;
+            std::memcpy(&key_size, data + entry + 1, sizeof(key_size));
+            if (entry + kAddressHeaderSize + key_size > end) {
+                break;
+            }
+            std::memcpy(&value_size, data + entry + 1 + sizeof(key_size) + key_size, sizeof(value_size));
+
+            const char *key = reinterpret_cast<const char *>(data + entry + 1 + sizeof(key_size));
+            const char *value = key + key_size + sizeof(value_size);
+            if (entry + kAddressHeaderSize + key_size + value_size > end) {
+                break;
+            }
+
+            address_journal_[std::string(key, key_size)] = JournalValue{op == kAddressPut, op == kAddressPut ? std::string(value, value_size) : std::string()};
+            entry += kAddressHeaderSize + key_size + value_size;
+        }
+
+        pos = end;
+    }
+
+    if (pos != size && !addresses_->truncate(pos)) {
+        set_last_error(IOError, "BlockLog error: cannot truncate %s", addresses_->name().c_str());
+        return false;
+    }
+
+    return address_journal_.empty() || compact_address_index();
+}
+
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::read_run_block(size_t block, std::vector<IndexItem> &items) {
+    items.clear();
+    if (block >= address_blocks_.size()) {
+        return true;
+    }
+
+    const uint64_t begin = address_blocks_[block].second;
+    const uint64_t end = block + 1 < address_blocks_.size() ? address_blocks_[block + 1].second : address_run_size_;
+    const uint8_t *data = address_run_->data(begin, static_cast<size_t>(end - begin));
+
+    uint64_t pos = 0;
+    IndexItem item;
+    while (data != nullptr && next_run_entry(data, pos, end - begin, &item.first, &item.second)) {
+        items.push_back(item);
+    }
+
+    if (data == nullptr || pos != end - begin) {
+        set_last_error(Corruption, "BlockLog error: block %zu of %s is damaged", block, address_run_->name().c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/* Assuming lock_ has been locked */
+size_t DatabaseBlockLog::find_run_block(const std::string &key, bool inclusive) const {
+    // the last block starting before the key (or at it if inclusive), the first one if there is none
+    auto less = [](const std::pair<std::string, uint64_t> &block, const std::string &value) { return block.first < value; };
+    auto less_equal = [](const std::string &value, const std::pair<std::string, uint64_t> &block) { return value < block.first; };
+
+    const auto it = inclusive ? std::upper_bound(address_blocks_.begin(), address_blocks_.end(), key, less_equal)
+                              : std::lower_bound(address_blocks_.begin(), address_blocks_.end(), key, less);
+    const size_t next = static_cast<size_t>(it - address_blocks_.begin());
+    return next > 0 ? next - 1 : 0;
+}
+
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::compact_address_index() {
+    // the journal is merged with the run into a new file, it replaces the run only after reaching the disk,
+    // so a crash leaves either run with the whole journal over it
+    const std::string name = address_run_->name();
+    const std::string temp = name + ".tmp";
+
+    File run;
+    if (!run.open(temp) || !run.truncate(0)) {
+        set_last_error(IOError, "BlockLog error: cannot open %s", temp.c_str());
+        return false;
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> blocks;
+    boost::crc_32_type crc;
+    uint64_t count = 0;
+    bool written = true;
+    std::vector<uint8_t> bytes;
+
+    auto write = [&](const std::string &key, const std::string &value) {
+        if (count % kRunBlock == 0) {
+            blocks.emplace_back(key, run.size());
+        }
+
+        const uint16_t key_size = static_cast<uint16_t>(key.size());
+        const uint16_t value_size = static_cast<uint16_t>(value.size());
+        bytes.assign(reinterpret_cast<const uint8_t *>(&key_size), reinterpret_cast<const uint8_t *>(&key_size) + sizeof(key_size));
+        bytes.insert(bytes.end(), key.begin(), key.end());
+        bytes.insert(bytes.end(), reinterpret_cast<const uint8_t *>(&value_size), reinterpret_cast<const uint8_t *>(&value_size) + sizeof(value_size));
+        bytes.insert(bytes.end(), value.begin(), value.end());
+
+        crc.process_bytes(bytes.data(), bytes.size());
+        written = written && run.append(bytes.data(), bytes.size());
+        ++count;
+    };
+
+    auto journal = address_journal_.begin();
+    auto write_journal = [&](const std::string *before) {
+        for (; journal != address_journal_.end() && (before == nullptr || journal->first < *before); ++journal) {
+            if (journal->second.put) {
+                write(journal->first, journal->second.value);
+            }
+        }
+    };
+
+    std::vector<IndexItem> items;
+    for (size_t block = 0; block < address_blocks_.size(); ++block) {
+        if (!read_run_block(block, items)) {
+            return false;
+        }
+
+        for (const auto &item : items) {
+            write_journal(&item.first);
+            if (journal != address_journal_.end() && journal->first == item.first) {
+                if (journal->second.put) {
+                    write(journal->first, journal->second.value);
+                }
+                ++journal;
+            }
+            else {
+                write(item.first, item.second);
+            }
+        }
+    }
+    write_journal(nullptr);
+
+    const uint64_t run_size = run.size();
+    const uint32_t run_crc = crc.checksum();
+    // an empty run is kept as an empty file
+    if (count > 0) {
+        written = written && run.append(&count, sizeof(count)) && run.append(&run_crc, sizeof(run_crc));
+    }
+    if (!written || !run.sync()) {
+        set_last_error(IOError, "BlockLog error: cannot write %s", temp.c_str());
+        return false;
+    }
+    run.close();
+
+    // the old run is opened again if the rename fails
+    boost::system::error_code error;
+    address_run_->close();
+    fs::rename(temp, name, error);
+    if (!address_run_->open(name) || error) {
+        set_last_error(IOError, "BlockLog error: cannot replace %s: %s", name.c_str(), error.message().c_str());
+        return false;
+    }
+
+    address_blocks_ = std::move(blocks);
+    address_run_size_ = count > 0 ? run_size : 0;
+
+    if (!addresses_->truncate(0)) {
+        set_last_error(IOError, "BlockLog error: cannot truncate %s", addresses_->name().c_str());
+        return false;
+    }
+
+    address_journal_.clear();
+    return true;
+}
+
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::append(const cs::Bytes &key, uint32_t record, const cs::Bytes &value) {
+    if (record == 0 || key.size() > std::numeric_limits<uint16_t>::max()) {
+        set_last_error(InvalidArgument, "BlockLog error: bad record or key");
+        return false;
+    }
+
+    if (segments_.empty() || (segments_.back()->size() > 0 && segments_.back()->size() + value.size() > options_.segment_size)) {
+        if (!segments_.empty() && !segments_.back()->sync()) {
+            set_last_error(IOError, "BlockLog error: cannot write %s", segments_.back()->name().c_str());
+            return false;
+        }
+        if (!open_segment(static_cast<uint32_t>(segments_.size()))) {
+            return false;
+        }
+    }
+
+    File &segment = *segments_.back();
+    const IndexEntry entry{static_cast<uint32_t>(segments_.size() - 1), static_cast<uint32_t>(segment.size()), static_cast<uint32_t>(value.size()),
+                           checksum(value.data(), value.size())};
+
+    // the data goes first, then the hash and the index entry, so recover() can find a torn tail
+    if (!segment.append(value.data(), value.size())) {
+        set_last_error(IOError, "BlockLog error: cannot write %s", segment.name().c_str());
+        return false;
+    }
+
+    const uint16_t key_size = static_cast<uint16_t>(key.size());
+    if (!hashes_->append(&record, sizeof(record)) || !hashes_->append(&key_size, sizeof(key_size)) || !hashes_->append(key.data(), key.size())) {
+        set_last_error(IOError, "BlockLog error: cannot write %s", hashes_->name().c_str());
+        return false;
+    }
+
+    bool written = true;
+    if (record <= records_) {
+        written = index_->write_at(uint64_t(record - 1) * sizeof(IndexEntry), &entry, sizeof(entry));
+    }
+    else {
+        const IndexEntry gap{kNoSegment, 0, 0, 0};
+        for (uint32_t i = records_ + 1; written && i < record; ++i) {
+            written = index_->append(&gap, sizeof(gap));
+        }
+        written = written && index_->append(&entry, sizeof(entry));
+    }
+
+    if (!written) {
+        set_last_error(IOError, "BlockLog error: cannot write %s", index_->name().c_str());
+        return false;
+    }
+
+    records_ = std::max(records_, record);
+    hash_records_[to_string(key)] = record;
+    return true;
+}
+
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::flush() {
+    // a group commit: put(), write_batch() and remove() return after their records reach the disk,
+    // the order they reach it in is not kept, recover() checks the last records against their checksums
+    if ((!segments_.empty() && !segments_.back()->sync()) || !hashes_->sync() || !index_->sync()) {
+        set_last_error(IOError, "BlockLog error: cannot flush %s", path_.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseBlockLog::put(const cs::Bytes &key, uint32_t seq_no, const cs::Bytes &value) {
+    return put(PoolItemList{PoolItem{key, seq_no, value}});
+}
+
+bool DatabaseBlockLog::put(const PoolItemList &items) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!index_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    for (const auto &item : items) {
+        if (!append(item.key, item.seq_no + 1, item.value)) {
+            flush();
+            return false;
+        }
+    }
+
+    if (!flush()) {
+        return false;
+    }
+
+    set_last_error();
+    return true;
+}
+
+bool DatabaseBlockLog::write_batch(const ItemList &items) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!index_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    // items are (hash, block) pairs, the blocks are appended after the last record as with DB_APPEND in BerkeleyDB
+    for (const auto &item : items) {
+        if (!append(item.first, records_ + 1, item.second)) {
+            flush();
+            return false;
+        }
+    }
+
+    if (!flush()) {
+        return false;
+    }
+
+    set_last_error();
+    return true;
+}
+
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::find(const cs::Bytes &key, uint32_t &record) const {
+    auto it = hash_records_.find(to_string(key));
+    if (it == hash_records_.end()) {
+        return false;
+    }
+
+    record = it->second;
+    return true;
+}
+
+/* Assuming lock_ has been locked */
+bool DatabaseBlockLog::read(uint32_t record, cs::Bytes *value) {
+    IndexEntry entry{};
+    if (!read_entry(record, entry)) {
+        set_last_error(NotFound);
+        return false;
+    }
+
+    if (entry.size == 0) {
+        value->clear();
+        set_last_error();
+        return true;
+    }
+
+    // a single copy straight from the mapping
+    const uint8_t *data = entry.segment < segments_.size() ? segments_[entry.segment]->data(entry.offset, entry.size) : nullptr;
+    if (data == nullptr) {
+        set_last_error(Corruption, "BlockLog error: record %u is out of its segment", record);
+        return false;
+    }
+
+    value->assign(data, data + entry.size);
+    set_last_error();
+    return true;
+}
+
+bool DatabaseBlockLog::get(const cs::Bytes &key, cs::Bytes *value) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!index_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    uint32_t record = 0;
+    if (!find(key, record)) {
+        set_last_error(NotFound);
+        return false;
+    }
+
+    if (value == nullptr) {
+        set_last_error();
+        return true;
+    }
+
+    return read(record, value);
+}
+
+bool DatabaseBlockLog::get(const uint32_t seq_no, cs::Bytes *value) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!index_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    if (value == nullptr) {
+        return false;
+    }
+
+    return read(seq_no, value);
+}
+
+bool DatabaseBlockLog::remove(const cs::Bytes &key) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!index_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    uint32_t record = 0;
+    if (!find(key, record)) {
+        set_last_error(NotFound);
+        return false;
+    }
+
+    IndexEntry entry{};
+    const bool exists = read_entry(record, entry);
+
+    bool ok = true;
+    if (record == records_) {
+        // the last block is cut off together with the gaps before it
+        IndexEntry previous{};
+        do {
+            --records_;
+        } while (records_ > 0 && !read_entry(records_, previous));
+
+        ok = index_->truncate(uint64_t(records_) * sizeof(IndexEntry));
+
+        if (ok && exists && entry.segment == segments_.size() - 1 && uint64_t(entry.offset) + entry.size == segments_.back()->size()) {
+            ok = segments_.back()->truncate(entry.offset);
+        }
+    }
+    else {
+        const IndexEntry removed{kNoSegment, 0, 0, 0};
+        ok = index_->write_at(uint64_t(record - 1) * sizeof(IndexEntry), &removed, sizeof(removed));
+    }
+
+    const uint32_t no_record = 0;
+    const uint16_t key_size = static_cast<uint16_t>(key.size());
+    ok = ok && hashes_->append(&no_record, sizeof(no_record)) && hashes_->append(&key_size, sizeof(key_size)) && hashes_->append(key.data(), key.size());
+
+    if (!ok) {
+        set_last_error(IOError, "BlockLog error: cannot remove record %u", record);
+        return false;
+    }
+
+    hash_records_.erase(to_string(key));
+
+    if (!flush()) {
+        return false;
+    }
+
+    set_last_error();
+    return true;
+}
+
+/* Locks lock_ itself, 0 - no more records */
+uint32_t DatabaseBlockLog::next_record(uint32_t record, bool forward) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!forward) {
+        record = std::min<uint32_t>(record, records_ + 1);
+    }
+
+    IndexEntry entry{};
+    do {
+        record = forward ? record + 1 : record - 1;
+    } while (record > 0 && record <= records_ && !read_entry(record, entry));
+
+    return record <= records_ ? record : 0;
+}
+
+class DatabaseBlockLog::Iterator final : public Database::Iterator {
+public:
+    explicit Iterator(DatabaseBlockLog *db)
+    : db_(db) {
+    }
+
+    bool is_valid() const final {
+        return record_ != 0;
+    }
+
+    void seek_to_first() final {
+        record_ = db_->next_record(0, true);
+    }
+
+    void seek_to_last() final {
+        record_ = db_->next_record(std::numeric_limits<uint32_t>::max(), false);
+    }
+
+    // the key is the record number in big endian, seeks the first record not less than it
+    void seek(const cs::Bytes &key) final {
+        if (key.size() != sizeof(uint32_t)) {
+            record_ = 0;
+            return;
+        }
+
+        const uint32_t record = (uint32_t(key[0]) << 24) | (uint32_t(key[1]) << 16) | (uint32_t(key[2]) << 8) | uint32_t(key[3]);
+        record_ = record > 0 ? db_->next_record(record - 1, true) : db_->next_record(0, true);
+    }
+
+    void next() final {
+        if (record_ != 0) {
+            record_ = db_->next_record(record_, true);
+        }
+    }
+
+    void prev() final {
+        if (record_ != 0) {
+            record_ = db_->next_record(record_, false);
+        }
+    }
+
+    cs::Bytes key() const final {
+        return is_valid() ? encode_record(record_) : cs::Bytes{};
+    }
+
+    cs::Bytes value() const final {
+        cs::Bytes result;
+        if (is_valid()) {
+            static_cast<Database *>(db_)->get(record_, &result);
+        }
+        return result;
+    }
+
+private:
+    DatabaseBlockLog *db_;
+    uint32_t record_ = 0;
+};
+
+DatabaseBlockLog::IteratorPtr DatabaseBlockLog::new_iterator() {
+    if (!index_) {
+        set_last_error(NotOpen);
+        return nullptr;
+    }
+
+    return Database::IteratorPtr(new DatabaseBlockLog::Iterator(this));
+}
+
+bool DatabaseBlockLog::update_index(const ItemList &items, const std::vector<cs::Bytes> &removed) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!index_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    std::vector<uint8_t> batch(kAddressBatchHeaderSize);
+    auto add = [&batch](uint8_t op, const cs::Bytes &key, const cs::Bytes &value) {
+        const uint16_t key_size = static_cast<uint16_t>(key.size());
+        const uint16_t value_size = static_cast<uint16_t>(value.size());
+        batch.push_back(op);
+        batch.insert(batch.end(), reinterpret_cast<const uint8_t *>(&key_size), reinterpret_cast<const uint8_t *>(&key_size) + sizeof(key_size));
+        batch.insert(batch.end(), key.begin(), key.end());
+        batch.insert(batch.end(), reinterpret_cast<const uint8_t *>(&value_size), reinterpret_cast<const uint8_t *>(&value_size) + sizeof(value_size));
+        batch.insert(batch.end(), value.begin(), value.end());
+    };
+
+    for (const auto &key : removed) {
+        if (key.size() > std::numeric_limits<uint16_t>::max()) {
+            set_last_error(InvalidArgument, "BlockLog error: too long index key");
+            return false;
+        }
+        add(kAddressRemove, key, cs::Bytes{});
+    }
+
+    for (const auto &item : items) {
+        if (item.first.size() > std::numeric_limits<uint16_t>::max() || item.second.size() > std::numeric_limits<uint16_t>::max()) {
+            set_last_error(InvalidArgument, "BlockLog error: too long index item");
+            return false;
+        }
+        add(kAddressPut, item.first, item.second);
+    }
+
+    const uint32_t payload = static_cast<uint32_t>(batch.size() - kAddressBatchHeaderSize);
+    const uint32_t crc = checksum(batch.data() + kAddressBatchHeaderSize, payload);
+    std::memcpy(batch.data(), &payload, sizeof(payload));
+    std::memcpy(batch.data() + sizeof(payload), &crc, sizeof(crc));
+
+    if (!addresses_->append(batch.data(), batch.size()) || !addresses_->flush()) {
+        set_last_error(IOError, "BlockLog error: cannot write %s", addresses_->name().c_str());
+        return false;
+    }
+
+    for (const auto &key : removed) {
+        address_journal_[to_string(key)] = JournalValue{false, std::string()};
+    }
+
+    for (const auto &item : items) {
+        address_journal_[to_string(item.first)] = JournalValue{true, to_string(item.second)};
+    }
+
+    // the batch is written already, if the merge fails the journal is merged on the next update or open
+    if (address_journal_.size() > options_.index_journal_size) {
+        compact_address_index();
+    }
+
+    set_last_error();
+    return true;
+}
+
+bool DatabaseBlockLog::index_range(const cs::Bytes &from, const cs::Bytes &to, bool reverse, size_t limit, ItemList *items) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!index_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    items->clear();
+
+    const std::string first_key = to_string(from);
+    const std::string last_key = std::max(first_key, to_string(to));
+
+    // the run is read a block at a time and merged with the journal, whose changes win
+    auto journal_first = address_journal_.lower_bound(first_key);
+    auto journal_last = address_journal_.lower_bound(last_key);
+
+    size_t block = find_run_block(reverse ? last_key : first_key, !reverse);
+    std::vector<IndexItem> run;
+    if (!read_run_block(block, run)) {
+        return false;
+    }
+
+    auto key_less = [](const IndexItem &item, const std::string &key) { return item.first < key; };
+    size_t pos = static_cast<size_t>(std::lower_bound(run.begin(), run.end(), reverse ? last_key : first_key, key_less) - run.begin());
+
+    auto add = [items](const std::string &key, const std::string &value) {
+        items->emplace_back(cs::Bytes(key.begin(), key.end()), cs::Bytes(value.begin(), value.end()));
+    };
+
+    while (limit == 0 || items->size() < limit) {
+        // the next run item in the range, if any
+        while (reverse ? (pos == 0 && block > 0) : (pos == run.size() && block + 1 < address_blocks_.size())) {
+            if (!read_run_block(reverse ? --block : ++block, run)) {
+                return false;
+            }
+            pos = reverse ? run.size() : 0;
+        }
+
+        const IndexItem *run_item = nullptr;
+        if (reverse ? (pos > 0 && run[pos - 1].first >= first_key) : (pos < run.size() && run[pos].first < last_key)) {
+            run_item = &run[reverse ? pos - 1 : pos];
+        }
+
+        const bool has_journal = reverse ? journal_last != journal_first : journal_first != journal_last;
+        if (run_item == nullptr && !has_journal) {
+            break;
+        }
+
+        if (has_journal) {
+            const auto journal = reverse ? std::prev(journal_last) : journal_first;
+            const bool journal_next = run_item == nullptr || (reverse ? journal->first >= run_item->first : journal->first <= run_item->first);
+
+            if (journal_next) {
+                if (run_item != nullptr && run_item->first == journal->first) {
+                    pos = reverse ? pos - 1 : pos + 1;
+                }
+                if (journal->second.put) {
+                    add(journal->first, journal->second.value);
+                }
+                if (reverse) {
+                    --journal_last;
+                }
+                else {
+                    ++journal_first;
+                }
+                continue;
+            }
+        }
+
+        add(run_item->first, run_item->second);
+        pos = reverse ? pos - 1 : pos + 1;
+    }
+
+    set_last_error();
+    return true;
+}
+
+bool DatabaseBlockLog::clear_index() {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!index_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    // the journal goes first: the old run alone is still a whole index, the journal over an empty run is not
+    if (!addresses_->truncate(0) || !address_run_->truncate(0)) {
+        set_last_error(IOError, "BlockLog error: cannot truncate %s", path_.c_str());
+        return false;
+    }
+
+    address_blocks_.clear();
+    address_run_size_ = 0;
+    address_journal_.clear();
+
+    set_last_error();
+    return true;
+}
+
+#ifdef TRANSACTIONS_INDEX
+bool DatabaseBlockLog::putToTransIndex(const cs::Bytes &key, const cs::Bytes &value) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!index_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    const uint16_t key_size = static_cast<uint16_t>(key.size());
+    const uint32_t value_size = static_cast<uint32_t>(value.size());
+
+    if (!trans_index_->append(&key_size, sizeof(key_size)) || !trans_index_->append(key.data(), key.size()) || !trans_index_->append(&value_size, sizeof(value_size)) ||
+        !trans_index_->append(value.data(), value.size()) || !trans_index_->flush()) {
+        set_last_error(IOError, "BlockLog error: cannot write %s", trans_index_->name().c_str());
+        return false;
+    }
+
+    trans_index_values_[to_string(key)] = value;
+    set_last_error();
+    return true;
+}
+
+bool DatabaseBlockLog::getFromTransIndex(const cs::Bytes &key, cs::Bytes *value) {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    if (!index_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    auto it = trans_index_values_.find(to_string(key));
+    if (it == trans_index_values_.end()) {
+        set_last_error(NotFound);
+        return false;
+    }
+
+    *value = it->second;
+    set_last_error();
+    return true;
+}
+#endif
+
+}  // namespace csdb
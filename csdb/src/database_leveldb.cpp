@@ -0,0 +1,496 @@
+#include "csdb/database_leveldb.hpp"
+
+#include <algorithm>
+
+#include <leveldb/cache.h>
+#include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
+#include <leveldb/write_batch.h>
+
+namespace csdb {
+
+namespace {
+// the blocks are stored by record number (sequence + 1) in big endian, so they are iterated in the chain order
+constexpr char kBlockPrefix = 'b';
+constexpr char kBlockEnd = kBlockPrefix + 1;
+constexpr char kHashPrefix = 'h';
+constexpr char kAddressPrefix = 'a';
+#ifdef TRANSACTIONS_INDEX
+constexpr char kIndexPrefix = 'i';
+#endif
+constexpr size_t kRecordSize = sizeof(uint32_t);
+
+std::string block_key(uint32_t record) {
+    std::string result(1 + kRecordSize, kBlockPrefix);
+    for (size_t i = kRecordSize; i > 0; --i, record >>= 8) {
+        result[i] = static_cast<char>(record & 0xFF);
+    }
+    return result;
+}
+
+std::string prefixed_key(char prefix, const cs::Bytes &key) {
+    std::string result(1, prefix);
+    result.append(key.begin(), key.end());
+    return result;
+}
+
+std::string encode_record(uint32_t record) {
+    return block_key(record).substr(1);
+}
+
+bool decode_record(const leveldb::Slice &data, uint32_t &record) {
+    if (data.size() != kRecordSize) {
+        return false;
+    }
+
+    record = 0;
+    for (size_t i = 0; i < kRecordSize; ++i) {
+        record = (record << 8) | static_cast<uint8_t>(data[i]);
+    }
+    return true;
+}
+
+bool is_block_key(const leveldb::Slice &key) {
+    return key.size() == 1 + kRecordSize && key[0] == kBlockPrefix;
+}
+
+leveldb::Slice to_slice(const cs::Bytes &data) {
+    return leveldb::Slice(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
+cs::Bytes to_bytes(const leveldb::Slice &data) {
+    auto begin = reinterpret_cast<const uint8_t *>(data.data());
+    return cs::Bytes(begin, begin + data.size());
+}
+}  // namespace
+
+DatabaseLevelDB::DatabaseLevelDB() = default;
+
+DatabaseLevelDB::~DatabaseLevelDB() = default;
+
+void DatabaseLevelDB::set_last_error_from_leveldb(const leveldb::Status &status) {
+    Error err = UnknownError;
+    if (status.ok()) {
+        err = NoError;
+    }
+    else if (status.IsNotFound()) {
+        err = NotFound;
+    }
+    else if (status.IsCorruption()) {
+        err = Corruption;
+    }
+    else if (status.IsNotSupportedError()) {
+        err = NotSupported;
+    }
+    else if (status.IsInvalidArgument()) {
+        err = InvalidArgument;
+    }
+    else if (status.IsIOError()) {
+        err = IOError;
+    }
+    if (NoError == err) {
+        set_last_error(err);
+    }
+    else {
+        set_last_error(err, "LevelDB error: %s", status.ToString().c_str());
+    }
+}
+
+bool DatabaseLevelDB::open(const std::string &path) {
+    return open(path, Options{});
+}
+
+bool DatabaseLevelDB::open(const std::string &path, const Options &options) {
+    db_.reset(nullptr);
+    cache_.reset(options.cache_size ? leveldb::NewLRUCache(options.cache_size) : nullptr);
+    filter_.reset(options.bloom_bits > 0 ? leveldb::NewBloomFilterPolicy(options.bloom_bits) : nullptr);
+
+    leveldb::Options db_options;
+    db_options.create_if_missing = true;
+    db_options.write_buffer_size = options.write_buffer_size;
+    db_options.block_cache = cache_.get();
+    db_options.filter_policy = filter_.get();
+    db_options.compression = options.compression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
+
+    leveldb::DB *db = nullptr;
+    leveldb::Status status = leveldb::DB::Open(db_options, path, &db);
+    if (!status.ok()) {
+        set_last_error_from_leveldb(status);
+        return false;
+    }
+    db_.reset(db);
+
+    std::lock_guard<std::mutex> lock(write_lock_);
+    if (!read_last_record()) {
+        db_.reset(nullptr);
+        return false;
+    }
+
+    set_last_error();
+    return true;
+}
+
+bool DatabaseLevelDB::is_open() const {
+    return static_cast<bool>(db_);
+}
+
+/* Assuming write_lock_ has been locked */
+bool DatabaseLevelDB::read_last_record() {
+    std::unique_ptr<leveldb::Iterator> it(db_->NewIterator(leveldb::ReadOptions()));
+
+    it->Seek(std::string(1, kBlockEnd));
+    if (it->Valid()) {
+        it->Prev();
+    }
+    else {
+        it->SeekToLast();
+    }
+
+    last_record_ = 0;
+    if (it->Valid() && is_block_key(it->key())) {
+        decode_record(leveldb::Slice(it->key().data() + 1, kRecordSize), last_record_);
+    }
+
+    if (!it->status().ok()) {
+        set_last_error_from_leveldb(it->status());
+        return false;
+    }
+
+    return true;
+}
+
+bool DatabaseLevelDB::put(const cs::Bytes &key, uint32_t seq_no, const cs::Bytes &value) {
+    return put(PoolItemList{PoolItem{key, seq_no, value}});
+}
+
+bool DatabaseLevelDB::put(const PoolItemList &items) {
+    if (!db_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    leveldb::WriteBatch batch;
+    uint32_t last_record = 0;
+
+    for (const auto &item : items) {
+        const uint32_t record = item.seq_no + 1;
+        batch.Put(block_key(record), to_slice(item.value));
+        batch.Put(prefixed_key(kHashPrefix, item.key), encode_record(record));
+        last_record = std::max(last_record, record);
+    }
+
+    std::lock_guard<std::mutex> lock(write_lock_);
+
+    leveldb::Status status = db_->Write(leveldb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        set_last_error_from_leveldb(status);
+        return false;
+    }
+
+    last_record_ = std::max(last_record_, last_record);
+    set_last_error();
+    return true;
+}
+
+bool DatabaseLevelDB::get(const cs::Bytes &key, cs::Bytes *value) {
+    if (!db_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    std::string record;
+    leveldb::Status status = db_->Get(leveldb::ReadOptions(), prefixed_key(kHashPrefix, key), &record);
+    if (!status.ok()) {
+        set_last_error_from_leveldb(status);
+        return false;
+    }
+
+    if (value == nullptr) {
+        set_last_error();
+        return true;
+    }
+
+    uint32_t seq_no = 0;
+    if (!decode_record(record, seq_no)) {
+        set_last_error(Corruption, "LevelDB error: bad record number for a block hash");
+        return false;
+    }
+
+    return get(seq_no, value);
+}
+
+bool DatabaseLevelDB::get(const uint32_t seq_no, cs::Bytes *value) {
+    if (!db_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    if (value == nullptr) {
+        return false;
+    }
+
+    std::string data;
+    leveldb::Status status = db_->Get(leveldb::ReadOptions(), block_key(seq_no), &data);
+    if (!status.ok()) {
+        set_last_error_from_leveldb(status);
+        return false;
+    }
+
+    value->assign(data.begin(), data.end());
+    set_last_error();
+    return true;
+}
+
+bool DatabaseLevelDB::remove(const cs::Bytes &key) {
+    if (!db_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    const std::string hash_key = prefixed_key(kHashPrefix, key);
+
+    std::lock_guard<std::mutex> lock(write_lock_);
+
+    std::string record;
+    leveldb::Status status = db_->Get(leveldb::ReadOptions(), hash_key, &record);
+    if (!status.ok()) {
+        set_last_error_from_leveldb(status);
+        return false;
+    }
+
+    uint32_t seq_no = 0;
+    if (!decode_record(record, seq_no)) {
+        set_last_error(Corruption, "LevelDB error: bad record number for a block hash");
+        return false;
+    }
+
+    leveldb::WriteBatch batch;
+    batch.Delete(hash_key);
+    batch.Delete(block_key(seq_no));
+
+    status = db_->Write(leveldb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        set_last_error_from_leveldb(status);
+        return false;
+    }
+
+    if (seq_no == last_record_ && !read_last_record()) {
+        return false;
+    }
+
+    set_last_error();
+    return true;
+}
+
+bool DatabaseLevelDB::write_batch(const ItemList &items) {
+    if (!db_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    // items are (hash, block) pairs, the blocks are appended after the last record as with DB_APPEND in BerkeleyDB
+    std::lock_guard<std::mutex> lock(write_lock_);
+
+    leveldb::WriteBatch batch;
+    uint32_t record = last_record_;
+
+    for (const auto &item : items) {
+        ++record;
+        batch.Put(block_key(record), to_slice(item.second));
+        batch.Put(prefixed_key(kHashPrefix, item.first), encode_record(record));
+    }
+
+    leveldb::Status status = db_->Write(leveldb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        set_last_error_from_leveldb(status);
+        return false;
+    }
+
+    last_record_ = record;
+    set_last_error();
+    return true;
+}
+
+class DatabaseLevelDB::Iterator final : public Database::Iterator {
+public:
+    explicit Iterator(leveldb::Iterator *it)
+    : it_(it) {
+    }
+
+    bool is_valid() const final {
+        return it_->Valid() && is_block_key(it_->key());
+    }
+
+    void seek_to_first() final {
+        it_->Seek(std::string(1, kBlockPrefix));
+    }
+
+    void seek_to_last() final {
+        it_->Seek(std::string(1, kBlockEnd));
+        if (it_->Valid()) {
+            it_->Prev();
+        }
+        else {
+            it_->SeekToLast();
+        }
+    }
+
+    void seek(const cs::Bytes &key) final {
+        it_->Seek(prefixed_key(kBlockPrefix, key));
+    }
+
+    void next() final {
+        if (it_->Valid()) {
+            it_->Next();
+        }
+    }
+
+    void prev() final {
+        if (it_->Valid()) {
+            it_->Prev();
+        }
+    }
+
+    // the record number in big endian
+    cs::Bytes key() const final {
+        if (!is_valid()) {
+            return cs::Bytes{};
+        }
+        return to_bytes(leveldb::Slice(it_->key().data() + 1, kRecordSize));
+    }
+
+    cs::Bytes value() const final {
+        if (!is_valid()) {
+            return cs::Bytes{};
+        }
+        return to_bytes(it_->value());
+    }
+
+private:
+    std::unique_ptr<leveldb::Iterator> it_;
+};
+
+DatabaseLevelDB::IteratorPtr DatabaseLevelDB::new_iterator() {
+    if (!db_) {
+        set_last_error(NotOpen);
+        return nullptr;
+    }
+
+    leveldb::ReadOptions options;
+    options.fill_cache = false;  // a full scan should not evict the hot blocks
+
+    return Database::IteratorPtr(new DatabaseLevelDB::Iterator(db_->NewIterator(options)));
+}
+
+bool DatabaseLevelDB::update_index(const ItemList &items, const std::vector<cs::Bytes> &removed) {
+    if (!db_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    leveldb::WriteBatch batch;
+
+    for (const auto &key : removed) {
+        batch.Delete(prefixed_key(kAddressPrefix, key));
+    }
+
+    for (const auto &item : items) {
+        batch.Put(prefixed_key(kAddressPrefix, item.first), to_slice(item.second));
+    }
+
+    leveldb::Status status = db_->Write(leveldb::WriteOptions(), &batch);
+    if (!status.ok()) {
+        set_last_error_from_leveldb(status);
+        return false;
+    }
+
+    set_last_error();
+    return true;
+}
+
+bool DatabaseLevelDB::index_range(const cs::Bytes &from, const cs::Bytes &to, bool reverse, size_t limit, ItemList *items) {
+    if (!db_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    items->clear();
+
+    const std::string first = prefixed_key(kAddressPrefix, from);
+    const std::string last = prefixed_key(kAddressPrefix, to);
+    std::unique_ptr<leveldb::Iterator> it(db_->NewIterator(leveldb::ReadOptions()));
+
+    auto add = [&]() {
+        items->emplace_back(to_bytes(leveldb::Slice(it->key().data() + 1, it->key().size() - 1)), to_bytes(it->value()));
+        return limit == 0 || items->size() < limit;
+    };
+
+    if (reverse) {
+        it->Seek(last);
+        if (it->Valid()) {
+            it->Prev();
+        }
+        else {
+            it->SeekToLast();
+        }
+
+        for (; it->Valid() && it->key().compare(first) >= 0 && it->key().compare(last) < 0; it->Prev()) {
+            if (!add()) {
+                break;
+            }
+        }
+    }
+    else {
+        for (it->Seek(first); it->Valid() && it->key().compare(last) < 0; it->Next()) {
+            if (!add()) {
+                break;
+            }
+        }
+    }
+
+    if (!it->status().ok()) {
+        set_last_error_from_leveldb(it->status());
+        return false;
+    }
+
+    set_last_error();
+    return true;
+}
+
+#ifdef TRANSACTIONS_INDEX
+bool DatabaseLevelDB::putToTransIndex(const cs::Bytes &key, const cs::Bytes &value) {
+    if (!db_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    leveldb::Status status = db_->Put(leveldb::WriteOptions(), prefixed_key(kIndexPrefix, key), to_slice(value));
+    if (!status.ok()) {
+        set_last_error_from_leveldb(status);
+        return false;
+    }
+
+    set_last_error();
+    return true;
+}
+
+bool DatabaseLevelDB::getFromTransIndex(const cs::Bytes &key, cs::Bytes *value) {
+    if (!db_) {
+        set_last_error(NotOpen);
+        return false;
+    }
+
+    std::string data;
+    leveldb::Status status = db_->Get(leveldb::ReadOptions(), prefixed_key(kIndexPrefix, key), &data);
+    if (!status.ok()) {
+        set_last_error_from_leveldb(status);
+        return false;
+    }
+
+    value->assign(data.begin(), data.end());
+    set_last_error();
+    return true;
+}
+#endif
+
+}  // namespace csdb
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <iomanip>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <utility>
 
@@ -126,8 +127,9 @@ class Pool::priv : public ::csdb::internal::shared_data {
         os.put(user_fields_);
         os.put(roundCost_);
 
-        os.put(static_cast<uint32_t>(transactions_.size()));
-        for (const auto& it : transactions_) {
+        const auto& transactions = all_transactions();
+        os.put(static_cast<uint32_t>(transactions.size()));
+        for (const auto& it : transactions) {
             os.put(it);
         }
 
@@ -181,8 +183,9 @@ class Pool::priv : public ::csdb::internal::shared_data {
         os.put(user_fields_);
         os.put(roundCost_);
 
-        os.put(static_cast<uint32_t>(transactions_.size()));
-        for (const auto& it : transactions_) {
+        const auto& transactions = all_transactions();
+        os.put(static_cast<uint32_t>(transactions.size()));
+        for (const auto& it : transactions) {
             os.put(it);
         }
 
@@ -245,6 +248,86 @@ class Pool::priv : public ::csdb::internal::shared_data {
         hash_ = PoolHash::calc_from_data(data);
     }
 
+    // only the offsets of the transactions are read, they are decoded on access
+    bool indexTransactions(::csdb::priv::ibstream& is, size_t cnt, size_t binarySize) {
+        transaction_offsets_.clear();
+        transaction_offsets_.reserve(cnt);
+        for (size_t i = 0; i < cnt; ++i) {
+            transaction_offsets_.push_back(static_cast<uint32_t>(binarySize - is.size()));
+            if (!Transaction::skip(is)) {
+                return false;
+            }
+        }
+        lazy_ = true;
+        return true;
+    }
+
+    Transaction decodeTransaction(size_t index) const {
+        const size_t offset = transaction_offsets_[index];
+        ::csdb::priv::ibstream is(binary_representation_.data() + offset, binary_representation_.size() - offset);
+
+        Transaction tran;
+        if (!is.get(tran)) {
+            return Transaction{};
+        }
+
+        tran.d->_update_id(hash_, index);
+        return tran;
+    }
+
+    // the readers may share a lazy pool, the first one to need all the transactions decodes them
+    const ::std::vector<Transaction>& all_transactions() const {
+        if (!lazy_) {
+            return transactions_;
+        }
+
+        auto decoded = std::atomic_load(&decoded_.transactions);
+        if (decoded) {
+            return *decoded;
+        }
+
+        auto result = std::make_shared<::std::vector<Transaction>>();
+        result->reserve(transaction_offsets_.size());
+        for (size_t i = 0; i < transaction_offsets_.size(); ++i) {
+            result->push_back(decodeTransaction(i));
+        }
+
+        std::shared_ptr<const ::std::vector<Transaction>> expected;
+        decoded = result;
+        if (!std::atomic_compare_exchange_strong(&decoded_.transactions, &expected, decoded)) {
+            decoded = expected;
+        }
+
+        return *decoded;
+    }
+
+    Transaction transaction(size_t index) const {
+        if (!lazy_) {
+            return transactions_.size() > index ? transactions_[index] : Transaction{};
+        }
+
+        if (transaction_offsets_.size() <= index) {
+            return Transaction{};
+        }
+
+        const auto decoded = std::atomic_load(&decoded_.transactions);
+        return decoded ? (*decoded)[index] : decodeTransaction(index);
+    }
+
+    size_t transactions_count() const {
+        return lazy_ ? transaction_offsets_.size() : transactions_.size();
+    }
+
+    // a lazy pool becomes an ordinary one before it is changed
+    void materialize() {
+        if (lazy_) {
+            transactions_ = all_transactions();
+            transaction_offsets_.clear();
+            decoded_.transactions.reset();
+            lazy_ = false;
+        }
+    }
+
     bool getTransactions(::csdb::priv::ibstream& is, size_t cnt) {
         transactions_.clear();
         transactions_.reserve(cnt);
@@ -382,7 +465,8 @@ class Pool::priv : public ::csdb::internal::shared_data {
         return true;
     }
 
-    bool get(::csdb::priv::ibstream& is) {
+    // binarySize is not 0 for a lazy read, the transactions are indexed then
+    bool get(::csdb::priv::ibstream& is, size_t binarySize = 0) {
         size_t cnt;
 
         if (!get_meta(is, cnt)) {
@@ -390,7 +474,7 @@ class Pool::priv : public ::csdb::internal::shared_data {
             return false;
         }
 
-        if (!getTransactions(is, cnt)) {
+        if (binarySize > 0 ? !indexTransactions(is, cnt, binarySize) : !getTransactions(is, cnt)) {
             csmeta(cswarning) << "get transactions is failed";
             return false;
         }
@@ -448,6 +532,7 @@ class Pool::priv : public ::csdb::internal::shared_data {
             return;
         }
 
+        materialize();
         update_binary_representation();
         update_transactions();
     }
@@ -467,6 +552,7 @@ class Pool::priv : public ::csdb::internal::shared_data {
 
         updateHash();
 
+        // the lazy ones get the id when decoded
         for (size_t idx = 0; idx < transactions_.size(); ++idx) {
             transactions_[idx].d->_update_id(hash_, idx);
         }
@@ -498,8 +584,9 @@ class Pool::priv : public ::csdb::internal::shared_data {
         result.hashingLength_ = hashingLength_;
         result.roundCost_ = roundCost_;
 
-        result.transactions_.reserve(transactions_.size());
-        for (auto& t : transactions_) {
+        const auto& transactions = all_transactions();
+        result.transactions_.reserve(transactions.size());
+        for (auto& t : transactions) {
             result.transactions_.push_back(t.clone());
         }
 
@@ -547,6 +634,24 @@ class Pool::priv : public ::csdb::internal::shared_data {
     cs::Bytes binary_representation_;
     ::csdb::Storage::WeakPtr storage_;
 
+    // lazy read: transactions_ is empty, the transactions are in binary_representation_ at these offsets
+    bool lazy_ = false;
+    std::vector<uint32_t> transaction_offsets_;
+    struct Decoded {
+        std::shared_ptr<const ::std::vector<Transaction>> transactions;
+
+        Decoded() = default;
+        // a shared pool is copied on detach while its other readers may be decoding it
+        Decoded(const Decoded& other)
+        : transactions(std::atomic_load(&other.transactions)) {
+        }
+        Decoded& operator=(const Decoded& other) {
+            std::atomic_store(&transactions, std::atomic_load(&other.transactions));
+            return *this;
+        }
+    };
+    mutable Decoded decoded_;
+
     static cs::PublicKey zero_writer_public_key_;
     friend class Pool;
 };
@@ -592,7 +697,7 @@ Storage Pool::storage() const noexcept {
 }
 
 Transaction Pool::transaction(size_t index) const {
-    return (d->transactions_.size() > index) ? d->transactions_[index] : Transaction{};
+    return d->transaction(index);
 }
 
 uint8_t Pool::numberTrusted() const noexcept {
@@ -616,10 +721,10 @@ const std::vector<cs::Signature>& Pool::roundConfirmations() const noexcept {
 }
 
 Transaction Pool::transaction(TransactionID id) const {
-    if ((!d->is_valid_) || (!d->read_only_) || (!id.is_valid()) || (id.pool_hash() != d->hash_) || (d->transactions_.size() <= id.d->index_)) {
+    if ((!d->is_valid_) || (!d->read_only_) || (!id.is_valid()) || (id.pool_hash() != d->hash_) || (d->transactions_count() <= id.d->index_)) {
         return Transaction{};
     }
-    return d->transactions_[id.d->index_];
+    return d->transaction(id.d->index_);
 }
 
 Transaction Pool::get_last_by_source(const Address& source) const noexcept {
@@ -629,8 +734,9 @@ Transaction Pool::get_last_by_source(const Address& source) const noexcept {
         return Transaction{};
     }
 
-    auto it_rend = data->transactions_.rend();
-    for (auto it = data->transactions_.rbegin(); it != it_rend; ++it) {
+    const auto& transactions = data->all_transactions();
+    auto it_rend = transactions.rend();
+    for (auto it = transactions.rbegin(); it != it_rend; ++it) {
         const auto& t = *it;
 
         if (t.source() == source) {
@@ -648,8 +754,9 @@ Transaction Pool::get_last_by_target(const Address& target) const noexcept {
         return Transaction{};
     }
 
-    auto it_rend = data->transactions_.rend();
-    for (auto it = data->transactions_.rbegin(); it != it_rend; ++it) {
+    const auto& transactions = data->all_transactions();
+    auto it_rend = transactions.rend();
+    for (auto it = transactions.rbegin(); it != it_rend; ++it) {
         const auto t = *it;
 
         if (t.target() == target) {
@@ -689,11 +796,11 @@ bool Pool::add_transaction(Transaction transaction
 
 size_t Pool::transactions_count() const noexcept {
     // return d->transactionsCount_; // bad work
-    return d->transactions_.size();
+    return d->transactions_count();
 }
 
 void Pool::recount() noexcept {
-    d->transactionsCount_ = static_cast<uint32_t>(d->transactions_.size());
+    d->transactionsCount_ = static_cast<uint32_t>(d->transactions_count());
 }
 
 cs::Sequence Pool::sequence() const noexcept {
@@ -843,11 +950,13 @@ void Pool::set_storage(const Storage& storage) noexcept {
 }
 
 Pool::Transactions& Pool::transactions() {
-    return d->transactions_;
+    priv* data = d.data();
+    data->materialize();
+    return data->transactions_;
 }
 
 const Pool::Transactions& Pool::transactions() const {
-    return d->transactions_;
+    return d->all_transactions();
 }
 
 Pool::NewWallets* Pool::newWallets() noexcept {
@@ -917,6 +1026,22 @@ Pool Pool::from_binary(cs::Bytes&& data) {
     return Pool(p.release());
 }
 
+Pool Pool::lazy_from_binary(cs::Bytes&& data) {
+    std::unique_ptr<priv> p{new priv()};
+    ::csdb::priv::ibstream is(data.data(), data.size());
+    if (data.empty() || !p->get(is, data.size())) {
+        return Pool();
+    }
+    p->update_binary_representation(std::move(data));
+    p->update_transactions();
+    return Pool(p.release());
+}
+
+cs::BytesView Pool::binary_view() const noexcept {
+    const priv* data = d.constData();
+    return cs::BytesView(data->binary_representation_.data(), data->binary_representation_.size());
+}
+
 Pool Pool::meta_from_binary(cs::Bytes&& data, size_t& cnt) {
     std::unique_ptr<priv> p(new priv());
     ::csdb::priv::ibstream is(data.data(), data.size());
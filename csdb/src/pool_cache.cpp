@@ -0,0 +1,201 @@
+#include "pool_cache.hpp"
+
+#include <algorithm>
+
+namespace csdb {
+namespace priv {
+
+namespace {
+// a decoded transaction takes about this much more memory than its binary
+constexpr size_t transaction_overhead = 256;
+}  // namespace
+
+pool_cache::pool_cache(size_t capacity, size_t shards)
+: shard_capacity_(capacity / std::max<size_t>(shards, 1)) {
+    shards = std::max<size_t>(shards, 1);
+
+    for (size_t i = 0; i < shards; ++i) {
+        shards_.emplace_back(new shard);
+        sequences_.emplace_back(new sequence_shard);
+    }
+}
+
+pool_cache::shard& pool_cache::shard_of(const PoolHash& hash) {
+    // the hash bytes are uniform already
+    const cs::Bytes bytes = hash.to_binary();
+    size_t index = 0;
+
+    for (size_t i = 0; i < std::min(bytes.size(), sizeof(size_t)); ++i) {
+        index = (index << 8) | bytes[i];
+    }
+
+    return *shards_[index % shards_.size()];
+}
+
+pool_cache::sequence_shard& pool_cache::sequence_shard_of(cs::Sequence sequence) {
+    return *sequences_[static_cast<size_t>(sequence % sequences_.size())];
+}
+
+bool pool_cache::get(const PoolHash& hash, Pool& pool) {
+    shard& s = shard_of(hash);
+    std::lock_guard<std::mutex> lock(s.lock);
+
+    const auto it = s.by_hash.find(hash);
+    if (it == s.by_hash.end()) {
+        ++s.misses;
+        return false;
+    }
+
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    ++s.hits;
+
+    pool = it->second->pool;
+    return true;
+}
+
+bool pool_cache::get(cs::Sequence sequence, Pool& pool) {
+    sequence_shard& ss = sequence_shard_of(sequence);
+    PoolHash hash;
+
+    {
+        std::lock_guard<std::mutex> lock(ss.lock);
+        const auto it = ss.hashes.find(sequence);
+
+        if (it != ss.hashes.end()) {
+            hash = it->second;
+        }
+    }
+
+    if (hash.is_empty()) {
+        shard& s = *shards_[static_cast<size_t>(sequence % shards_.size())];
+        std::lock_guard<std::mutex> lock(s.lock);
+        ++s.misses;
+        return false;
+    }
+
+    if (get(hash, pool)) {
+        return true;
+    }
+
+    // the pool has been evicted
+    std::lock_guard<std::mutex> lock(ss.lock);
+    const auto it = ss.hashes.find(sequence);
+
+    if (it != ss.hashes.end() && it->second == hash) {
+        ss.hashes.erase(it);
+    }
+
+    return false;
+}
+
+void pool_cache::put(const Pool& pool, size_t encoded_size) {
+    const size_t size = sizeof(entry) + encoded_size + pool.transactions_count() * transaction_overhead;
+
+    // such a pool would evict the whole shard
+    if (size > shard_capacity_) {
+        return;
+    }
+
+    const PoolHash hash = pool.hash();
+    const cs::Sequence sequence = pool.sequence();
+    std::vector<entry> evicted;
+
+    {
+        shard& s = shard_of(hash);
+        std::lock_guard<std::mutex> lock(s.lock);
+
+        const auto it = s.by_hash.find(hash);
+        if (it != s.by_hash.end()) {
+            // another reader has put it already
+            s.lru.splice(s.lru.begin(), s.lru, it->second);
+            return;
+        }
+
+        s.lru.push_front(entry{hash, sequence, pool, size});
+        s.by_hash.emplace(hash, s.lru.begin());
+        s.bytes += size;
+
+        while (s.bytes > shard_capacity_) {
+            entry& last = s.lru.back();
+            s.bytes -= last.size;
+            s.by_hash.erase(last.hash);
+            evicted.push_back(std::move(last));
+            s.lru.pop_back();
+            ++s.evictions;
+        }
+    }
+
+    {
+        sequence_shard& ss = sequence_shard_of(sequence);
+        std::lock_guard<std::mutex> lock(ss.lock);
+        ss.hashes[sequence] = hash;
+    }
+
+    // the evicted pools are released out of the shard lock
+    forget_sequences(evicted);
+}
+
+void pool_cache::remove(const PoolHash& hash) {
+    std::vector<entry> removed;
+
+    {
+        shard& s = shard_of(hash);
+        std::lock_guard<std::mutex> lock(s.lock);
+
+        const auto it = s.by_hash.find(hash);
+        if (it == s.by_hash.end()) {
+            return;
+        }
+
+        s.bytes -= it->second->size;
+        removed.push_back(std::move(*it->second));
+        s.lru.erase(it->second);
+        s.by_hash.erase(it);
+    }
+
+    forget_sequences(removed);
+}
+
+void pool_cache::forget_sequences(const std::vector<entry>& evicted) {
+    for (const auto& e : evicted) {
+        sequence_shard& ss = sequence_shard_of(e.sequence);
+        std::lock_guard<std::mutex> lock(ss.lock);
+
+        const auto it = ss.hashes.find(e.sequence);
+        if (it != ss.hashes.end() && it->second == e.hash) {
+            ss.hashes.erase(it);
+        }
+    }
+}
+
+void pool_cache::clear() {
+    for (auto& s : shards_) {
+        std::lock_guard<std::mutex> lock(s->lock);
+        s->by_hash.clear();
+        s->lru.clear();
+        s->bytes = 0;
+    }
+
+    for (auto& ss : sequences_) {
+        std::lock_guard<std::mutex> lock(ss->lock);
+        ss->hashes.clear();
+    }
+}
+
+pool_cache::stats pool_cache::get_stats() const {
+    stats result;
+
+    for (const auto& s : shards_) {
+        std::lock_guard<std::mutex> lock(s->lock);
+        result.hits += s->hits;
+        result.misses += s->misses;
+        result.evictions += s->evictions;
+        result.pools += s->lru.size();
+        result.bytes += s->bytes;
+    }
+
+    return result;
+}
+
+}  // namespace priv
+}  // namespace csdb
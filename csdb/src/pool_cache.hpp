@@ -0,0 +1,84 @@
+/**
+ * @file pool_cache.hpp
+ */
+
+#pragma once
+#ifndef _CREDITS_CSDB_PRIVATE_POOL_CACHE_H_INCLUDED_
+#define _CREDITS_CSDB_PRIVATE_POOL_CACHE_H_INCLUDED_
+
+#include <cinttypes>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "csdb/pool.hpp"
+
+namespace csdb {
+namespace priv {
+
+// Decoded pools recently read from the database, least recently used ones are evicted when their
+// approximate size in memory goes over the capacity. Sharded by the hash so the readers of different
+// pools do not wait for each other; a pool is found by the hash or by the sequence.
+class pool_cache {
+public:
+    struct stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t pools = 0;
+        size_t bytes = 0;
+    };
+
+    explicit pool_cache(size_t capacity, size_t shards = 16);
+
+    bool get(const PoolHash& hash, Pool& pool);
+    bool get(cs::Sequence sequence, Pool& pool);
+
+    // the pool must be valid, encoded_size is the size of its binary
+    void put(const Pool& pool, size_t encoded_size);
+    void remove(const PoolHash& hash);
+    void clear();
+
+    stats get_stats() const;
+
+private:
+    struct entry {
+        PoolHash hash;
+        cs::Sequence sequence;
+        Pool pool;
+        size_t size;
+    };
+
+    struct shard {
+        mutable std::mutex lock;
+        std::list<entry> lru;  // the most recently used first
+        std::map<PoolHash, std::list<entry>::iterator> by_hash;
+        size_t bytes = 0;
+
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    // sequence -> hash, may point to an evicted pool, get() checks and drops such ones
+    struct sequence_shard {
+        std::mutex lock;
+        std::unordered_map<cs::Sequence, PoolHash> hashes;
+    };
+
+    shard& shard_of(const PoolHash& hash);
+    sequence_shard& sequence_shard_of(cs::Sequence sequence);
+    void forget_sequences(const std::vector<entry>& evicted);
+
+    const size_t shard_capacity_;
+    std::vector<std::unique_ptr<shard>> shards_;
+    std::vector<std::unique_ptr<sequence_shard>> sequences_;
+};
+
+}  // namespace priv
+}  // namespace csdb
+
+#endif  // _CREDITS_CSDB_PRIVATE_POOL_CACHE_H_INCLUDED_
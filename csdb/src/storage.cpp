@@ -1,10 +1,13 @@
 #include "csdb/storage.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
 #include <cstdarg>
 #include <deque>
+#include <iterator>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
@@ -21,6 +24,7 @@
 #include "csdb/internal/utils.hpp"
 #include "csdb/pool.hpp"
 #include "csdb/wallet.hpp"
+#include "pool_cache.hpp"
 
 namespace {
 struct last_error_struct {
@@ -104,6 +108,208 @@ void update_heads_and_tails(heads_t& heads, tails_t& tails, const PoolHash& cur_
     }
 }
 
+// the address index keys, see Storage::address_index_add
+constexpr uint8_t kAddressTransactions = 't';  // public key, sequence, index -> roles
+constexpr uint8_t kAddressInnerIds = 'n';      // source public key, inner id -> sequence, index
+constexpr uint8_t kAddressMarker = 'm';        // -> the last sequence indexed
+
+constexpr uint8_t kRoleSource = 1;
+constexpr uint8_t kRoleTarget = 2;
+
+constexpr size_t kPositionSize = 2 * sizeof(uint32_t);
+
+// big endian, so the keys of an address are ordered by the position
+void put_big_endian(cs::Bytes& bytes, uint64_t value, size_t size) {
+    for (size_t i = size; i > 0; --i) {
+        bytes.push_back(static_cast<uint8_t>(value >> ((i - 1) * 8)));
+    }
+}
+
+uint64_t get_big_endian(const uint8_t* data, size_t size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+cs::Bytes address_key(uint8_t prefix, const cs::PublicKey& key) {
+    cs::Bytes result{prefix};
+    result.insert(result.end(), key.begin(), key.end());
+    return result;
+}
+
+cs::Bytes position(cs::Sequence sequence, size_t index) {
+    cs::Bytes result;
+    put_big_endian(result, sequence, sizeof(uint32_t));
+    put_big_endian(result, index, sizeof(uint32_t));
+    return result;
+}
+
+cs::Bytes transaction_key(const cs::PublicKey& key, cs::Sequence sequence, size_t index) {
+    cs::Bytes result = address_key(kAddressTransactions, key);
+    const cs::Bytes pos = position(sequence, index);
+    result.insert(result.end(), pos.begin(), pos.end());
+    return result;
+}
+
+// follows every transaction key of the public key
+cs::Bytes transactions_end(const cs::PublicKey& key) {
+    cs::Bytes result = address_key(kAddressTransactions, key);
+    result.insert(result.end(), kPositionSize + 1, 0xFF);
+    return result;
+}
+
+cs::Bytes inner_id_key(const cs::PublicKey& key, int64_t innerId) {
+    cs::Bytes result = address_key(kAddressInnerIds, key);
+    put_big_endian(result, static_cast<uint64_t>(innerId), sizeof(uint64_t));
+    return result;
+}
+
+// reads the blocks sequentially, decodes and hashes them on a pool of workers and hands them out in the reading order
+class block_reader {
+public:
+    explicit block_reader(Database::IteratorPtr it)
+    : it_(std::move(it)) {
+        it_->seek_to_first();
+
+        const size_t cores = std::thread::hardware_concurrency();
+        const size_t workers = cores > 2 ? cores - 1 : 1;
+        max_chunks_ = workers * 4;
+
+        reader_ = std::thread(&block_reader::read, this);
+        for (size_t i = 0; i < workers; ++i) {
+            workers_.emplace_back(&block_reader::decode, this);
+        }
+    }
+
+    ~block_reader() {
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            quit_ = true;
+        }
+
+        cond_var_.notify_all();
+
+        reader_.join();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    // false after the last block, the pools that failed to decode are returned invalid
+    bool next(Pool& pool) {
+        if (!current_ || pos_ == current_->pools.size()) {
+            std::unique_lock<std::mutex> lock(lock_);
+            cond_var_.wait(lock, [this]() { return chunks_.empty() ? read_done_ : chunks_.front()->decoded; });
+
+            if (chunks_.empty()) {
+                return false;
+            }
+
+            current_ = std::move(chunks_.front());
+            chunks_.pop_front();
+            pos_ = 0;
+
+            lock.unlock();
+            cond_var_.notify_all();
+        }
+
+        pool = std::move(current_->pools[pos_++]);
+        return true;
+    }
+
+private:
+    static constexpr size_t chunk_size = 64;
+
+    struct chunk {
+        std::vector<cs::Bytes> raw;
+        std::vector<Pool> pools;
+        bool decoded = false;
+    };
+    using chunk_ptr = std::shared_ptr<chunk>;
+
+    void read() {
+        bool done = false;
+
+        while (!done) {
+            auto c = std::make_shared<chunk>();
+            c->raw.reserve(chunk_size);
+
+            for (; c->raw.size() < chunk_size && it_->is_valid(); it_->next()) {
+                c->raw.push_back(it_->value());
+            }
+
+            done = !it_->is_valid();
+
+            std::unique_lock<std::mutex> lock(lock_);
+            cond_var_.wait(lock, [this]() { return quit_ || chunks_.size() < max_chunks_; });
+
+            if (quit_) {
+                return;
+            }
+
+            if (!c->raw.empty()) {
+                chunks_.push_back(c);
+                to_decode_.push_back(std::move(c));
+            }
+
+            read_done_ = done;
+
+            lock.unlock();
+            cond_var_.notify_all();
+        }
+    }
+
+    void decode() {
+        while (true) {
+            std::unique_lock<std::mutex> lock(lock_);
+            cond_var_.wait(lock, [this]() { return quit_ || read_done_ || !to_decode_.empty(); });
+
+            if (quit_ || to_decode_.empty()) {
+                return;
+            }
+
+            chunk_ptr c = std::move(to_decode_.front());
+            to_decode_.pop_front();
+
+            lock.unlock();
+
+            c->pools.reserve(c->raw.size());
+            for (auto& raw : c->raw) {
+                c->pools.push_back(Pool::from_binary(std::move(raw)));
+                if (c->pools.back().is_valid()) {
+                    c->pools.back().hash();
+                }
+            }
+            c->raw.clear();
+
+            lock.lock();
+            c->decoded = true;
+            lock.unlock();
+
+            cond_var_.notify_all();
+        }
+    }
+
+    Database::IteratorPtr it_;
+
+    std::thread reader_;
+    std::vector<std::thread> workers_;
+
+    std::mutex lock_;
+    std::condition_variable cond_var_;
+    bool quit_ = false;
+    bool read_done_ = false;
+    size_t max_chunks_;
+
+    std::deque<chunk_ptr> chunks_;     // read, in order, bounded by max_chunks_
+    std::deque<chunk_ptr> to_decode_;  // read, not taken by a worker yet
+
+    chunk_ptr current_;
+    size_t pos_ = 0;
+};
+
 }  // namespace
 
 class Storage::priv {
@@ -113,17 +319,37 @@ public:
     }
 
     ~priv() {
-        if (write_thread.joinable()) {
-            quit = true;
-            write_cond_var.notify_one();
-            write_thread.join();
-        }
+        stop_writer();
     }
 
 private:
     bool rescan(Storage::OpenCallback callback);
+
+    // group commit: pool_save queues the pools, the writer puts everything queued by the moment in one transaction
+    static constexpr size_t max_write_queue = 1024;
+    static constexpr size_t max_write_batch = 256;
+    static constexpr size_t max_write_retries = 3;  // a batch failed this many times more is dropped
+
+    void start_writer();
+    void stop_writer();
     void write_routine();
 
+    bool enqueue(const Pool& pool);
+    bool hold(const Pool& pool);
+
+    // the writer has no last error of its own, the caller thread takes it over
+    void report_write_error();
+
+    // a run of pools continuing the last record goes through write_batch(), anything else through put()
+    bool put_pools(Database::PoolItemList& items);
+    void forget_record(const cs::Sequence sequence);
+
+    // a pool leaves the pending ones after it is committed, so the readers look here before the database
+    bool find_pending(const PoolHash& hash, Pool& pool) const;
+    bool find_pending(const cs::Sequence record, Pool& pool) const;
+    void forget_pending(const Pool& pool);
+    void account_commit(const size_t pools, const uint64_t microseconds, const bool success);
+
     std::shared_ptr<Database> db = nullptr;
     PoolHash last_hash;     // Хеш последнего пула
     size_t count_pool = 0;  // Количество пулов транзакций в хранилище (первоночально заполняется в check)
@@ -136,15 +362,39 @@ private:
 
     std::mutex data_lock;
 
+    // pools not written yet: in the order of pool_save and indexed for the readers, the latter include the batch being written
     std::deque<Pool> write_queue;
-    std::mutex write_lock;
-    std::condition_variable write_cond_var;
+    std::map<PoolHash, Pool> pending;
+    std::map<cs::Sequence, PoolHash> pending_records;  // record number in the database is sequence + 1
+    size_t writing = 0;
+    size_t write_failures = 0;  // in a row, pool_save does not wait for space while the database fails
+    std::string write_error;    // the last batch dropped by the writer, not reported yet
+
+    // pools saved between begin_batch() and commit_batch(), they are pending too
+    bool batching = false;
+    std::vector<Pool> held;
+
+    mutable std::mutex write_lock;
+    std::condition_variable write_cond_var;  // the writer waits for pools
+    std::condition_variable space_cond_var;  // pool_save and flush wait for the writer
+
+    Storage::WriteStats write_stats;
+
+    // the record number of a pool is its sequence + 1, write_batch() appends after the last one
+    std::mutex put_lock;
+    uint32_t last_record = 0;
+    bool last_record_known = true;
+
+    // decoded pools read from the database, nullptr if OpenOptions::cache_size is 0
+    std::unique_ptr<::csdb::priv::pool_cache> cache;
+
+    // the last sequence in the address index, -1 if the index is empty
+    std::atomic<int64_t> address_index_last{-1};
+    std::mutex address_index_lock;
 
 private signals:
     ReadBlockSignal read_block_event;
 
-    // TODO: Добавить кеш для хранения последних вычитанных пулов транзакций
-
     friend class ::csdb::Storage;
 };
 
@@ -186,6 +436,8 @@ void Storage::priv::set_last_error(Storage::Error error, const char* message, ..
 bool Storage::priv::rescan(Storage::OpenCallback callback) {
     last_hash = {};
     count_pool = 0;
+    last_record = 0;
+    last_record_known = true;
 
     heads_t heads;
     tails_t tails;
@@ -193,11 +445,13 @@ bool Storage::priv::rescan(Storage::OpenCallback callback) {
     Database::IteratorPtr it = db->new_iterator();
     assert(it);
 
-    Storage::OpenProgress progress{0};
-    for (it->seek_to_first(); it->is_valid(); it->next()) {
-        cs::Bytes v = it->value();
+    block_reader reader(std::move(it));
 
-        Pool p = Pool::from_binary(std::move(v));
+    const auto start = std::chrono::steady_clock::now();
+    auto report_time = start;
+
+    Storage::OpenProgress progress{0};
+    for (Pool p; reader.next(p);) {
         if (!p.is_valid()) {
             set_last_error(Storage::DataIntegrityError, "Data integrity error: Corrupted pool for key'.");
             return false;
@@ -213,6 +467,7 @@ bool Storage::priv::rescan(Storage::OpenCallback callback) {
         }
 
         update_heads_and_tails(heads, tails, p.hash(), p.previous_hash());
+        last_record = std::max(last_record, static_cast<uint32_t>(p.sequence() + 1));
         count_pool++;
         progress.poolsProcessed++;
 
@@ -222,8 +477,19 @@ bool Storage::priv::rescan(Storage::OpenCallback callback) {
                 return false;
             }
         }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - report_time > std::chrono::seconds(10)) {
+            const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(now - start).count();
+            csdebug() << "Storage> " << progress.poolsProcessed << " pools read, " << progress.poolsProcessed / static_cast<uint64_t>(seconds) << " pools/s";
+            report_time = now;
+        }
     }
 
+    const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    cslog() << "Storage> " << progress.poolsProcessed << " pools read in " << milliseconds << " ms, "
+            << (milliseconds > 0 ? progress.poolsProcessed * 1000 / static_cast<uint64_t>(milliseconds) : progress.poolsProcessed) << " pools/s";
+
     // Посмотрим, сколько у нас завершённых цепочек.
     if ([this, &heads]() -> bool {
             for (const auto it : heads) {
@@ -259,24 +525,271 @@ bool Storage::priv::rescan(Storage::OpenCallback callback) {
     return false;
 }
 
+void Storage::priv::start_writer() {
+    stop_writer();
+
+    quit = false;
+    write_thread = std::thread(&Storage::priv::write_routine, this);
+}
+
+void Storage::priv::stop_writer() {
+    if (!write_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(write_lock);
+        quit = true;
+    }
+
+    write_cond_var.notify_one();
+    write_thread.join();
+}
+
 void Storage::priv::write_routine() {
+    Database::PoolItemList items;
+    std::vector<Pool> batch;
+
     std::unique_lock<std::mutex> lock(write_lock);
-    while (!quit) {
-        write_cond_var.wait(lock);
-        while (!write_queue.empty()) {
-            Pool& pool = write_queue.front();
-            if (!pool.is_read_only()) {
-                if (!pool.compose()) {
-                    set_last_error(Storage::DataIntegrityError, "Pool passed to storage is not composed and failed to compose now");
-                }
+
+    while (true) {
+        write_cond_var.wait(lock, [this]() { return quit || !write_queue.empty(); });
+
+        if (write_queue.empty()) {
+            break;  // quit, everything is written
+        }
+
+        const size_t count = std::min(write_queue.size(), max_write_batch);
+        batch.assign(std::make_move_iterator(write_queue.begin()), std::make_move_iterator(write_queue.begin() + static_cast<ptrdiff_t>(count)));
+        write_queue.erase(write_queue.begin(), write_queue.begin() + static_cast<ptrdiff_t>(count));
+        writing = count;
+
+        lock.unlock();
+
+        items.clear();
+        items.reserve(count);
+
+        for (auto& pool : batch) {
+            if (!pool.is_read_only() && !pool.compose()) {
+                set_last_error(Storage::DataIntegrityError, "Pool passed to storage is not composed and failed to compose now");
+            }
+
+            items.push_back(Database::PoolItem{pool.hash().to_binary(), static_cast<uint32_t>(pool.sequence()), pool.to_binary()});
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const bool success = put_pools(items);
+        const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+        std::string message;
+
+        if (!success) {
+            message = db->last_error_message();
+            cserror() << "Storage> failed to write " << count << " pools: " << message;
+        }
+
+        lock.lock();
+
+        account_commit(count, static_cast<uint64_t>(microseconds), success);
+        writing = 0;
+
+        if (success) {
+            write_failures = 0;
+
+            for (const auto& pool : batch) {
+                forget_pending(pool);
+            }
+        }
+        else if (++write_failures > max_write_retries) {
+            cserror() << "Storage> " << count << " pools are dropped after " << write_failures << " attempts";
+
+            write_stats.lost += count;
+            write_error = "failed to write " + std::to_string(count) + " pools from sequence " + std::to_string(batch.front().sequence()) + ": " + message;
+            write_failures = 0;
+
+            for (const auto& pool : batch) {
+                forget_pending(pool);
+            }
+        }
+        else if (!quit) {
+            // the pools stay readable, the next attempt is after a pause
+            write_queue.insert(write_queue.begin(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+            write_cond_var.wait_for(lock, std::chrono::seconds(1), [this]() { return quit; });
+        }
+        else {
+            cserror() << "Storage> " << count << " pools are lost on exit";
+
+            for (const auto& pool : batch) {
+                forget_pending(pool);
             }
-            const PoolHash hash = pool.hash();
+        }
+
+        batch.clear();
+        space_cond_var.notify_all();
+    }
+}
+
+bool Storage::priv::enqueue(const Pool& pool) {
+    std::unique_lock<std::mutex> lock(write_lock);
+
+    if (pending.size() >= max_write_queue) {
+        ++write_stats.stalls;
+
+        // a failing writer frees no space until it drops the batch, so the caller is not kept waiting
+        space_cond_var.wait(lock, [this]() { return pending.size() < max_write_queue || quit || write_failures > 0; });
+
+        if (pending.size() >= max_write_queue) {
+            ++write_stats.rejected;
+            return false;
+        }
+    }
+
+    write_queue.push_back(pool);
+    pending.emplace(pool.hash(), pool);
+    pending_records[pool.sequence() + 1] = pool.hash();
+
+    lock.unlock();
+    write_cond_var.notify_one();
+    return true;
+}
+
+void Storage::priv::report_write_error() {
+    std::string message;
+
+    {
+        std::lock_guard<std::mutex> lock(write_lock);
+        message.swap(write_error);
+    }
+
+    if (message.empty()) {
+        set_last_error();
+    }
+    else {
+        set_last_error(Storage::DatabaseError, message);
+    }
+}
+
+bool Storage::priv::put_pools(Database::PoolItemList& items) {
+    std::lock_guard<std::mutex> lock(put_lock);
+
+    bool run = last_record_known && !items.empty() && items.front().seq_no == last_record;
+
+    for (size_t i = 1; run && i < items.size(); ++i) {
+        run = items[i].seq_no == items[i - 1].seq_no + 1;
+    }
+
+    bool success = false;
+
+    if (run) {
+        Database::ItemList batch;
+        batch.reserve(items.size());
+
+        for (auto& item : items) {
+            batch.emplace_back(std::move(item.key), std::move(item.value));
+        }
+
+        success = db->write_batch(batch);
+    }
+    else {
+        success = db->put(items);
+    }
 
-            db->put(hash.to_binary(), static_cast<uint32_t>(pool.sequence()), pool.to_binary());
+    if (success) {
+        for (const auto& item : items) {
+            last_record = std::max(last_record, item.seq_no + 1);
+        }
+    }
+
+    return success;
+}
+
+void Storage::priv::forget_record(const cs::Sequence sequence) {
+    std::lock_guard<std::mutex> lock(put_lock);
+
+    if (sequence + 1 != last_record) {
+        return;
+    }
+
+    // the database appends after the highest record left, which is the previous one unless there is a gap
+    cs::Bytes previous;
+    last_record_known = --last_record == 0 || db->get(last_record, &previous);
+}
+
+bool Storage::priv::hold(const Pool& pool) {
+    std::lock_guard<std::mutex> lock(write_lock);
+
+    if (!batching) {
+        return false;
+    }
+
+    // no backpressure here: the batch is bounded by the caller and is written by the caller itself
+    held.push_back(pool);
+    pending.emplace(pool.hash(), pool);
+    pending_records[pool.sequence() + 1] = pool.hash();
+
+    return true;
+}
+
+bool Storage::priv::find_pending(const PoolHash& hash, Pool& pool) const {
+    std::lock_guard<std::mutex> lock(write_lock);
+
+    const auto it = pending.find(hash);
+
+    if (it == pending.end()) {
+        return false;
+    }
+
+    pool = it->second;
+    return true;
+}
+
+bool Storage::priv::find_pending(const cs::Sequence record, Pool& pool) const {
+    std::lock_guard<std::mutex> lock(write_lock);
+
+    const auto it = pending_records.find(record);
+
+    if (it == pending_records.end()) {
+        return false;
+    }
 
-            write_queue.pop_front();
+    pool = pending.at(it->second);
+    return true;
+}
+
+/* Assuming write_lock has been locked */
+void Storage::priv::forget_pending(const Pool& pool) {
+    const PoolHash hash = pool.hash();
+    const auto it = pending_records.find(pool.sequence() + 1);
+
+    if (it != pending_records.end() && it->second == hash) {
+        pending_records.erase(it);
+    }
+
+    pending.erase(hash);
+}
+
+/* Assuming write_lock has been locked */
+void Storage::priv::account_commit(const size_t pools, const uint64_t microseconds, const bool success) {
+    auto bucket = [](uint64_t value) {
+        size_t result = 0;
+
+        while (value > 1 && result + 1 < Storage::WriteStats::Buckets) {
+            value >>= 1;
+            ++result;
         }
+
+        return result;
+    };
+
+    if (!success) {
+        ++write_stats.failures;
+        return;
     }
+
+    ++write_stats.commits;
+    write_stats.pools += pools;
+    ++write_stats.latency[bucket(microseconds)];
+    ++write_stats.batch_size[bucket(pools)];
 }
 
 Storage::Storage()
@@ -358,6 +871,25 @@ bool Storage::open(const OpenOptions& opt, OpenCallback callback) {
         return false;
     }
 
+    if (opt.cache_size > 0) {
+        d->cache = std::make_unique<::csdb::priv::pool_cache>(opt.cache_size);
+    }
+
+    d->address_index_last = -1;
+    Database::ItemList marker;
+    if (d->db->index_range(cs::Bytes{kAddressMarker}, cs::Bytes{kAddressMarker, 0}, false, 1, &marker) && !marker.empty() &&
+        marker.front().second.size() == sizeof(uint32_t)) {
+        d->address_index_last = static_cast<int64_t>(get_big_endian(marker.front().second.data(), sizeof(uint32_t)));
+    }
+
+    // the blocks indexed last have not reached the disk
+    if (d->address_index_last + 1 > static_cast<int64_t>(d->count_pool)) {
+        cswarning() << "Storage> the address index is ahead of the blocks, dropping it";
+        address_index_reset();
+    }
+
+    d->start_writer();
+
     d->set_last_error();
     return true;
 }
@@ -371,12 +903,22 @@ bool Storage::open(const ::std::string& path_to_base, OpenCallback callback) {
     auto db{::std::make_shared<::csdb::DatabaseBerkeleyDB>()};
     db->open(path);
 
-    d->write_thread = std::thread(&Storage::priv::write_routine, d.get());
-
     return open(OpenOptions{db}, callback);
 }
 
 void Storage::close() {
+    if (isOpen()) {
+        commit_batch();
+    }
+
+    d->stop_writer();
+
+    if (d->cache) {
+        const auto stats = d->cache->get_stats();
+        csdebug() << "Storage> pool cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evictions";
+        d->cache.reset();
+    }
+
     d->db.reset();
     d->set_last_error();
 }
@@ -407,19 +949,26 @@ bool Storage::pool_save(Pool pool) {
     }
 
     const PoolHash hash = pool.hash();
+    Pool pending;
 
-    if (d->db->get(hash.to_binary())) {
+    if (d->find_pending(hash, pending) || d->db->get(hash.to_binary())) {
         d->set_last_error(InvalidParameter, "%s: Pool already pressent [hash: %s]", funcName(), hash.to_string().c_str());
         return false;
     }
-    /*
-      {
-        std::unique_lock<std::mutex> lock(d->write_lock);
-        d->write_queue.push_back(pool);
-        d->write_cond_var.notify_one();
-      }
-    */
-    d->db->put(hash.to_binary(), static_cast<uint32_t>(pool.sequence()), pool.to_binary());
+
+    if (d->hold(pool)) {
+        // written by commit_batch()
+    }
+    else if (d->write_thread.joinable()) {
+        if (!d->enqueue(pool)) {
+            d->set_last_error(DatabaseError, "%s: Write queue is full, the database fails: %s", funcName(), d->db->last_error_message().c_str());
+            return false;
+        }
+    }
+    else {
+        Database::PoolItemList items{Database::PoolItem{hash.to_binary(), static_cast<uint32_t>(pool.sequence()), pool.to_binary()}};
+        d->put_pools(items);
+    }
 
     {
         std::unique_lock<std::mutex> lock(d->data_lock);
@@ -429,10 +978,118 @@ bool Storage::pool_save(Pool pool) {
         }
     }
 
-    d->set_last_error();
+    d->report_write_error();
     return true;
 }
 
+Storage::WriteStats Storage::write_stats() const {
+    std::lock_guard<std::mutex> lock(d->write_lock);
+
+    WriteStats result = d->write_stats;
+    result.queued = d->pending.size();
+
+    return result;
+}
+
+Storage::CacheStats Storage::cache_stats() const {
+    CacheStats result;
+
+    if (d->cache) {
+        const auto stats = d->cache->get_stats();
+        result.hits = stats.hits;
+        result.misses = stats.misses;
+        result.evictions = stats.evictions;
+        result.pools = stats.pools;
+        result.bytes = stats.bytes;
+    }
+
+    return result;
+}
+
+void Storage::flush() {
+    {
+        std::unique_lock<std::mutex> lock(d->write_lock);
+        d->space_cond_var.wait(lock, [this]() { return d->pending.size() == d->held.size() || !d->write_thread.joinable(); });
+    }
+
+    d->report_write_error();
+}
+
+void Storage::begin_batch() {
+    std::lock_guard<std::mutex> lock(d->write_lock);
+    d->batching = true;
+}
+
+bool Storage::commit_batch() {
+    if (!isOpen()) {
+        d->set_last_error(NotOpen);
+        return false;
+    }
+
+    // the pools queued before the batch go first
+    flush();
+
+    std::vector<Pool> pools;
+
+    {
+        std::lock_guard<std::mutex> lock(d->write_lock);
+        d->batching = false;
+        pools.swap(d->held);
+    }
+
+    if (pools.empty()) {
+        d->set_last_error();
+        return true;
+    }
+
+    Database::PoolItemList items;
+    items.reserve(pools.size());
+
+    for (auto& pool : pools) {
+        if (!pool.is_read_only() && !pool.compose()) {
+            d->set_last_error(DataIntegrityError, "Pool passed to storage is not composed and failed to compose now");
+        }
+
+        items.push_back(Database::PoolItem{pool.hash().to_binary(), static_cast<uint32_t>(pool.sequence()), pool.to_binary()});
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool success = d->put_pools(items);
+    const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::unique_lock<std::mutex> lock(d->write_lock);
+    d->account_commit(pools.size(), static_cast<uint64_t>(microseconds), success);
+
+    if (success) {
+        for (const auto& pool : pools) {
+            d->forget_pending(pool);
+        }
+
+        lock.unlock();
+        d->space_cond_var.notify_all();
+
+        d->set_last_error();
+        return true;
+    }
+
+    cserror() << "Storage> failed to write batch of " << pools.size() << " pools: " << d->db->last_error_message();
+
+    if (d->write_thread.joinable()) {
+        // the pools stay readable and the writer retries them
+        d->write_queue.insert(d->write_queue.end(), std::make_move_iterator(pools.begin()), std::make_move_iterator(pools.end()));
+        lock.unlock();
+        d->write_cond_var.notify_one();
+    }
+    else {
+        for (const auto& pool : pools) {
+            d->forget_pending(pool);
+        }
+    }
+
+    d->set_last_error(DatabaseError, "%s: %s", funcName(), d->db->last_error_message().c_str());
+    return false;
+}
+
 Pool Storage::pool_load_internal(const PoolHash& hash, const bool metaOnly, size_t& trxCnt) const {
     if (!isOpen()) {
         d->set_last_error(NotOpen);
@@ -448,23 +1105,17 @@ Pool Storage::pool_load_internal(const PoolHash& hash, const bool metaOnly, size
     bool needParseData = true;
     cs::Bytes data;
 
-    if (!d->db->get(hash.to_binary(), &data)) {
-        {
-            std::unique_lock<std::mutex> lock2(d->write_lock);
-            for (auto& poolToWrite : d->write_queue) {
-                if (poolToWrite.hash() == hash) {
-                    res = poolToWrite;
-                    needParseData = false;
-                    trxCnt = res.transactions().size();
-                    break;
-                }
-            }
-        }
-
-        if (needParseData && !d->db->get(hash.to_binary(), &data)) {
-            d->set_last_error(DatabaseError);
-            return Pool{};
-        }
+    if (d->find_pending(hash, res)) {
+        needParseData = false;
+        trxCnt = res.transactions().size();
+    }
+    else if (d->cache && d->cache->get(hash, res)) {
+        needParseData = false;
+        trxCnt = res.transactions_count();
+    }
+    else if (!d->db->get(hash.to_binary(), &data)) {
+        d->set_last_error(DatabaseError);
+        return Pool{};
     }
 
     if (needParseData) {
@@ -472,7 +1123,12 @@ Pool Storage::pool_load_internal(const PoolHash& hash, const bool metaOnly, size
             res = Pool::meta_from_binary(std::move(data), trxCnt);
         }
         else {
-            res = Pool::from_binary(std::move(data));
+            const size_t size = data.size();
+            res = Pool::lazy_from_binary(std::move(data));
+
+            if (d->cache && res.is_valid()) {
+                d->cache->put(res, size);
+            }
         }
     }
 
@@ -488,28 +1144,35 @@ Pool Storage::pool_load_internal(const PoolHash& hash, const bool metaOnly, size
 }
 
 bool Storage::write_queue_search(const PoolHash& hash, Pool& res_pool) const {
-    std::unique_lock<std::mutex> lock(d->write_lock, std::defer_lock);
-
-    if (!d->write_queue.empty() && lock.try_lock()) {
-        auto pos = std::find_if(d->write_queue.begin(), d->write_queue.end(), [&](Pool& pool) { return hash == pool.hash(); });
-
-        if (pos != d->write_queue.cend()) {
-            res_pool = *pos;
-            return true;
-        }
-    }
-    return false;
+    return d->find_pending(hash, res_pool);
 }
 
 bool Storage::write_queue_pop(Pool& res_pool) {
+    const PoolHash hash = last_hash();
     std::unique_lock<std::mutex> lock(d->write_lock);
 
-    if (!d->write_queue.empty()) {
-        res_pool = d->write_queue.back();
-        d->write_queue.pop_back();
+    // the last pool is taken back only if it has not been passed to the writer yet
+    if (!d->held.empty()) {
+        if (d->held.back().hash() != hash) {
+            return false;
+        }
+
+        res_pool = d->held.back();
+        d->held.pop_back();
+        d->forget_pending(res_pool);
+
         return true;
     }
-    return false;
+
+    if (d->write_queue.empty() || d->write_queue.back().hash() != hash) {
+        return false;
+    }
+
+    res_pool = d->write_queue.back();
+    d->write_queue.pop_back();
+    d->forget_pending(res_pool);
+
+    return true;
 }
 
 Pool Storage::pool_load(const PoolHash& hash) const {
@@ -527,26 +1190,25 @@ Pool Storage::pool_load(const cs::Sequence sequence) const {
     bool needParseData = true;
     cs::Bytes data;
 
-    if (!d->db->get(static_cast<uint32_t>(sequence), &data)) {
-        {
-            std::unique_lock<std::mutex> lock2(d->write_lock);
-            for (auto& poolToWrite : d->write_queue) {
-                if (poolToWrite.sequence() == sequence) {
-                    res = poolToWrite;
-                    needParseData = false;
-                    break;
-                }
-            }
-        }
-
-        if (needParseData && !d->db->get(static_cast<uint32_t>(sequence), &data)) {
-            d->set_last_error(DatabaseError);
-            return Pool{};
-        }
+    // the parameter is the record number in the database, i.e. sequence + 1
+    if (d->find_pending(sequence, res)) {
+        needParseData = false;
+    }
+    else if (d->cache && sequence > 0 && d->cache->get(sequence - 1, res)) {
+        needParseData = false;
+    }
+    else if (!d->db->get(static_cast<uint32_t>(sequence), &data)) {
+        d->set_last_error(DatabaseError);
+        return Pool{};
     }
 
     if (needParseData) {
-        res = Pool::from_binary(std::move(data));
+        const size_t size = data.size();
+        res = Pool::lazy_from_binary(std::move(data));
+
+        if (d->cache && res.is_valid()) {
+            d->cache->put(res, size);
+        }
     }
 
     if (!res.is_valid()) {
@@ -571,8 +1233,9 @@ Pool Storage::pool_load_meta(const PoolHash& hash, size_t& cnt) const {
     }
 
     Pool res{};
-    bool found = write_queue_search(hash, res);
+    bool found = write_queue_search(hash, res) || (d->cache && d->cache->get(hash, res));
     if (found) {
+        cnt = res.transactions_count();
         return res;
     }
 
@@ -603,10 +1266,19 @@ Pool Storage::pool_remove_last() {
     bool found = write_queue_pop(res);
 
     if (found) {
+        if (d->cache) {
+            d->cache->remove(res.hash());
+        }
+
+        std::unique_lock<std::mutex> lock(d->data_lock);
+        --d->count_pool;
         d->last_hash = res.previous_hash();
         return res;
     }
 
+    // the last pool may be in the batch being written
+    flush();
+
     if (last_hash().is_empty()) {
         d->set_last_error(InvalidParameter, "%s: Empty hash passed", funcName());
         return Pool{};
@@ -626,7 +1298,13 @@ Pool Storage::pool_remove_last() {
         d->set_last_error();
     }
 
-    d->db->remove(last_hash().to_binary());
+    if (d->db->remove(last_hash().to_binary())) {
+        d->forget_record(res.sequence());
+    }
+
+    if (d->cache) {
+        d->cache->remove(last_hash());
+    }
 
     --d->count_pool;
     d->last_hash = res.previous_hash();
@@ -639,6 +1317,26 @@ Wallet Storage::wallet(const Address& addr) const {
 }
 
 bool Storage::get_from_blockchain(const Address& addr /*input*/, const int64_t& innerId /*input*/, Transaction& trx /*output*/) const {
+    if (addr.is_public_key() && address_index_ready()) {
+        const cs::Bytes key = inner_id_key(addr.public_key(), innerId);
+        cs::Bytes end = key;
+        end.push_back(0);
+
+        Database::ItemList items;
+        if (!d->db->index_range(key, end, false, 1, &items) || items.empty()) {
+            return false;
+        }
+
+        Pool pool;
+        const Transaction found = address_index_load(items.front().second, pool);
+        if (!found.is_valid() || found.innerID() != innerId) {
+            return false;
+        }
+
+        trx = found;
+        return true;
+    }
+
     Pool curPool;
     cs::Sequence curIdx = cs::numeric_cast<cs::Sequence>(innerId);
     bool is_in_blockchain = false;
@@ -692,6 +1390,34 @@ std::vector<Transaction> Storage::transactions(const Address& addr, size_t limit
     std::vector<Transaction> res;
     res.reserve(limit);
 
+    if (addr.is_public_key() && address_index_ready()) {
+        const cs::PublicKey& key = addr.public_key();
+        cs::Bytes end = transactions_end(key);
+
+        if (offset.is_valid()) {
+            const Pool pool = pool_load(offset.pool_hash());
+            if (!pool.is_valid() || offset.index() >= pool.transactions_count()) {
+                return res;
+            }
+            end = transaction_key(key, pool.sequence(), offset.index());
+        }
+
+        Database::ItemList items;
+        if (limit == 0 || !d->db->index_range(address_key(kAddressTransactions, key), end, true, limit, &items)) {
+            return res;
+        }
+
+        Pool pool;
+        for (const auto& item : items) {
+            Transaction t = address_index_load(item.first, pool);
+            if (t.is_valid()) {
+                res.push_back(std::move(t));
+            }
+        }
+
+        return res;
+    }
+
     Pool curPool;
     cs::Sequence curIdx = 0;
 
@@ -758,6 +1484,10 @@ Transaction Storage::transaction(const TransactionID& id) const {
 }
 
 Transaction Storage::get_last_by_source(Address source) const noexcept {
+    if (source.is_public_key() && address_index_ready()) {
+        return address_index_last(source, kRoleSource);
+    }
+
     Pool curr = pool_load(last_hash());
 
     while (curr.is_valid()) {
@@ -772,6 +1502,10 @@ Transaction Storage::get_last_by_source(Address source) const noexcept {
 }
 
 Transaction Storage::get_last_by_target(Address target) const noexcept {
+    if (target.is_public_key() && address_index_ready()) {
+        return address_index_last(target, kRoleTarget);
+    }
+
     Pool curr = pool_load(last_hash());
 
     while (curr.is_valid()) {
@@ -786,6 +1520,188 @@ Transaction Storage::get_last_by_target(Address target) const noexcept {
     return Transaction{};
 }
 
+bool Storage::address_index_ready() const noexcept {
+    return d->address_index_last.load() + 1 == static_cast<int64_t>(size());
+}
+
+cs::Sequence Storage::address_index_next() const noexcept {
+    return static_cast<cs::Sequence>(d->address_index_last.load() + 1);
+}
+
+bool Storage::address_index_add(const Pool& pool, const AddressResolver& resolver) {
+    return address_index_update(pool, resolver, true);
+}
+
+bool Storage::address_index_remove(const Pool& pool, const AddressResolver& resolver) {
+    return address_index_update(pool, resolver, false);
+}
+
+bool Storage::address_index_update(const Pool& pool, const AddressResolver& resolver, bool add) {
+    if (!isOpen()) {
+        d->set_last_error(NotOpen);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(d->address_index_lock);
+
+    const int64_t last = d->address_index_last.load();
+    const int64_t sequence = static_cast<int64_t>(pool.sequence());
+
+    if (!pool.is_valid() || sequence != (add ? last + 1 : last)) {
+        d->set_last_error(InvalidParameter, "%s: pool %lld does not follow the address index at %lld", __func__, static_cast<long long>(sequence),
+                          static_cast<long long>(last));
+        return false;
+    }
+
+    auto to_key = [&resolver](const Address& address) { return resolver ? resolver(address) : address; };
+
+    Database::ItemList items;
+    std::vector<cs::Bytes> removed;
+
+    auto put = [&](cs::Bytes&& key, cs::Bytes&& value) {
+        if (add) {
+            items.emplace_back(std::move(key), std::move(value));
+        }
+        else {
+            removed.push_back(std::move(key));
+        }
+    };
+
+    const auto& transactions = pool.transactions();
+    for (size_t i = 0; i < transactions.size(); ++i) {
+        const Address source = to_key(transactions[i].source());
+        const Address target = to_key(transactions[i].target());
+
+        if (source.is_public_key() && source == target) {
+            put(transaction_key(source.public_key(), pool.sequence(), i), cs::Bytes{kRoleSource | kRoleTarget});
+        }
+        else {
+            if (source.is_public_key()) {
+                put(transaction_key(source.public_key(), pool.sequence(), i), cs::Bytes{kRoleSource});
+            }
+            if (target.is_public_key()) {
+                put(transaction_key(target.public_key(), pool.sequence(), i), cs::Bytes{kRoleTarget});
+            }
+        }
+
+        if (source.is_public_key()) {
+            put(inner_id_key(source.public_key(), transactions[i].innerID()), position(pool.sequence(), i));
+        }
+    }
+
+    // the marker goes in the same batch, so it never points past the indexed pools
+    const int64_t indexed = add ? sequence : sequence - 1;
+    if (indexed >= 0) {
+        cs::Bytes value;
+        put_big_endian(value, static_cast<uint64_t>(indexed), sizeof(uint32_t));
+        items.emplace_back(cs::Bytes{kAddressMarker}, std::move(value));
+    }
+    else {
+        removed.push_back(cs::Bytes{kAddressMarker});
+    }
+
+    if (!d->db->update_index(items, removed)) {
+        d->set_last_error(DatabaseError, "%s: %s", __func__, d->db->last_error_message().c_str());
+        return false;
+    }
+
+    d->address_index_last = indexed;
+    d->set_last_error();
+    return true;
+}
+
+bool Storage::address_index_reset() {
+    if (!isOpen()) {
+        d->set_last_error(NotOpen);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(d->address_index_lock);
+
+    if (!d->db->clear_index()) {
+        d->set_last_error(DatabaseError, "%s: %s", __func__, d->db->last_error_message().c_str());
+        return false;
+    }
+
+    d->address_index_last = -1;
+    d->set_last_error();
+    return true;
+}
+
+// the position is at the end of a transaction key or is an inner id value, the pool is reused for the next position
+Transaction Storage::address_index_load(const cs::Bytes& position, Pool& pool) const {
+    if (position.size() < kPositionSize) {
+        return Transaction{};
+    }
+
+    const uint8_t* data = position.data() + position.size() - kPositionSize;
+    const cs::Sequence sequence = static_cast<cs::Sequence>(get_big_endian(data, sizeof(uint32_t)));
+    const size_t index = static_cast<size_t>(get_big_endian(data + sizeof(uint32_t), sizeof(uint32_t)));
+
+    if (!pool.is_valid() || pool.sequence() != sequence) {
+        pool = pool_load(sequence + 1);
+    }
+
+    if (!pool.is_valid() || index >= pool.transactions_count()) {
+        return Transaction{};
+    }
+
+    return pool.transaction(index);
+}
+
+Transaction Storage::address_index_last(const Address& addr, uint8_t role) const {
+    constexpr size_t batch_size = 256;
+
+    const cs::Bytes begin = address_key(kAddressTransactions, addr.public_key());
+    cs::Bytes end = transactions_end(addr.public_key());
+    Database::ItemList items;
+    Pool pool;
+
+    do {
+        if (!d->db->index_range(begin, end, true, batch_size, &items)) {
+            return Transaction{};
+        }
+
+        for (const auto& item : items) {
+            if (!item.second.empty() && (item.second.front() & role)) {
+                return address_index_load(item.first, pool);
+            }
+        }
+
+        if (!items.empty()) {
+            end = items.back().first;
+        }
+    } while (items.size() == batch_size);
+
+    return Transaction{};
+}
+
+bool Storage::address_transactions(const Address& key, size_t skip, size_t limit, std::vector<Transaction>& result) const {
+    if (!isOpen() || !key.is_public_key() || !address_index_ready()) {
+        return false;
+    }
+
+    if (limit == 0) {
+        return true;
+    }
+
+    Database::ItemList items;
+    if (!d->db->index_range(address_key(kAddressTransactions, key.public_key()), transactions_end(key.public_key()), true, skip + limit, &items)) {
+        d->set_last_error(DatabaseError, "%s: %s", __func__, d->db->last_error_message().c_str());
+        return false;
+    }
+
+    Pool pool;
+    for (size_t i = skip; i < items.size(); ++i) {
+        Transaction t = address_index_load(items[i].first, pool);
+        if (t.is_valid()) {
+            result.push_back(std::move(t));
+        }
+    }
+
+    return true;
+}
+
 #ifdef TRANSACTIONS_INDEX
 cs::Bytes Storage::get_trans_index_key(const Address& addr, const PoolHash& ph) {
     ::csdb::priv::obstream os;
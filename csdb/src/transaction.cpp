@@ -421,6 +421,34 @@ bool Transaction::get(::csdb::priv::ibstream& is) {
     return is.get(data->signature_) && is.get(data->counted_fee_);
 }
 
+bool Transaction::skip(::csdb::priv::ibstream& is) {
+    uint16_t lo = 0;
+    uint32_t hi = 0;
+
+    if (!is.get(lo) || !is.get(hi)) {
+        return false;
+    }
+
+    internal::WalletId id;
+    cs::PublicKey key;
+
+    if (!((hi & 0x80000000) ? is.get(id) : is.get(key))) {
+        return false;
+    }
+
+    if (!((hi & 0x40000000) ? is.get(id) : is.get(key))) {
+        return false;
+    }
+
+    Amount amount;
+    AmountCommission fee;
+    uint8_t currency;
+    ::std::map<::csdb::user_field_id_t, ::csdb::UserField> user_fields;
+    cs::Signature signature;
+
+    return is.get(amount) && is.get(fee) && is.get(currency) && is.get(user_fields) && is.get(signature) && is.get(fee);
+}
+
 void Transaction::set_time(const uint64_t ts) {
     d->time_ = ts;
 }
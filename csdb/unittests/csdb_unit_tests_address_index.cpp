@@ -0,0 +1,136 @@
+#include "csdb/storage.hpp"
+#include "csdb/amount_commission.hpp"
+#include "csdb/currency.hpp"
+#include "csdb/database_blocklog.hpp"
+#include "csdb/pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+using namespace csdb;
+
+class AddressIndexTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    path_ = (boost::filesystem::temp_directory_path() / "csdb_address_index_unittests").string();
+    boost::filesystem::remove_all(path_);
+    reopen();
+  }
+
+  void TearDown() override
+  {
+    storage_.close();
+    boost::filesystem::remove_all(path_);
+  }
+
+  void reopen()
+  {
+    storage_.close();
+    auto db = std::make_shared<DatabaseBlockLog>();
+    ASSERT_TRUE(db->open(path_));
+    ASSERT_TRUE(storage_.open(Storage::OpenOptions{db}));
+  }
+
+  static Address key(uint8_t n)
+  {
+    cs::PublicKey key{};
+    key.fill(n);
+    return Address::from_public_key(key);
+  }
+
+  // the wallet id 1 stands for the key 1
+  static Address resolve(const Address& address)
+  {
+    return address == Address::from_wallet_id(1) ? key(1) : address;
+  }
+
+  Pool add_pool(const std::vector<std::pair<Address, Address>>& transfers)
+  {
+    Pool pool(storage_.last_hash(), storage_.size());
+    for (const auto& transfer : transfers) {
+      EXPECT_TRUE(pool.add_transaction(Transaction(next_inner_id_++, transfer.first, transfer.second, Currency(1), Amount(1), AmountCommission(0.1),
+                                                   AmountCommission(0.1), cs::Signature{}), true));
+    }
+    EXPECT_TRUE(pool.compose());
+    EXPECT_TRUE(pool.save(storage_));
+    EXPECT_TRUE(storage_.address_index_add(pool, resolve));
+    return pool;
+  }
+
+  std::string path_;
+  Storage storage_;
+  int64_t next_inner_id_ = 0;
+};
+
+TEST_F(AddressIndexTest, FindsTransactions)
+{
+  // the pools stay in memory: a previous hash of the unit test build is too short to be read back
+  storage_.begin_batch();
+  add_pool({{key(1), key(2)}});
+  add_pool({{key(2), key(1)}, {Address::from_wallet_id(1), key(3)}});
+  add_pool({});
+  EXPECT_EQ(storage_.address_index_next(), 3u);
+
+  const auto transactions = storage_.transactions(key(1), 10);
+  ASSERT_EQ(transactions.size(), 3u);
+  EXPECT_EQ(transactions[0].innerID(), 2);
+  EXPECT_EQ(transactions[1].innerID(), 1);
+  EXPECT_EQ(transactions[2].innerID(), 0);
+
+  // the offset is excluded
+  const auto older = storage_.transactions(key(1), 10, transactions[0].id());
+  ASSERT_EQ(older.size(), 2u);
+  EXPECT_EQ(older[0].innerID(), 1);
+
+  EXPECT_EQ(storage_.get_last_by_source(key(1)).innerID(), 2);
+  EXPECT_EQ(storage_.get_last_by_target(key(1)).innerID(), 1);
+  EXPECT_FALSE(storage_.get_last_by_source(key(3)).id().is_valid());
+
+  Transaction found;
+  EXPECT_TRUE(storage_.get_from_blockchain(key(1), 2, found));
+  EXPECT_EQ(found.target(), key(3));
+  EXPECT_FALSE(storage_.get_from_blockchain(key(1), 1, found));
+
+  std::vector<Transaction> page;
+  EXPECT_TRUE(storage_.address_transactions(key(1), 1, 1, page));
+  ASSERT_EQ(page.size(), 1u);
+  EXPECT_EQ(page[0].innerID(), 1);
+  EXPECT_FALSE(storage_.address_transactions(Address::from_wallet_id(1), 0, 1, page));
+}
+
+TEST_F(AddressIndexTest, FollowsTheChain)
+{
+  const Pool first = add_pool({{key(1), key(2)}});
+  EXPECT_FALSE(storage_.address_index_add(first, resolve));
+
+  storage_.begin_batch();
+  add_pool({{key(1), key(2)}});
+  const Pool last = storage_.pool_remove_last();
+  ASSERT_TRUE(last.is_valid());
+
+  // the index is not used until it follows the blocks again
+  std::vector<Transaction> page;
+  EXPECT_FALSE(storage_.address_transactions(key(1), 0, 10, page));
+  EXPECT_FALSE(storage_.address_index_remove(first, resolve));
+  EXPECT_TRUE(storage_.address_index_remove(last, resolve));
+  EXPECT_EQ(storage_.address_index_next(), 1u);
+
+  EXPECT_TRUE(storage_.address_transactions(key(1), 0, 10, page));
+  ASSERT_EQ(page.size(), 1u);
+  EXPECT_EQ(page[0].innerID(), 0);
+
+  storage_.flush();
+  reopen();
+  EXPECT_EQ(storage_.address_index_next(), 1u);
+  EXPECT_EQ(storage_.get_last_by_target(key(2)).innerID(), 0);
+
+  EXPECT_TRUE(storage_.address_index_reset());
+  EXPECT_EQ(storage_.address_index_next(), 0u);
+  EXPECT_FALSE(storage_.address_transactions(key(1), 0, 10, page));
+
+  // and the lookups scan the chain meanwhile
+  EXPECT_EQ(storage_.get_last_by_target(key(2)).innerID(), 0);
+}
@@ -0,0 +1,93 @@
+#include "csdb/database_berkeleydb.hpp"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+class DatabaseBerkeleyDBTest : public ::testing::Test
+{
+protected:
+  void SetUp() override final
+  {
+    path_to_db_ = (boost::filesystem::temp_directory_path() / database_name_).string();
+    boost::filesystem::remove_all(path_to_db_);
+
+    reopen();
+  }
+
+  void TearDown() override final
+  {
+    db_.reset(nullptr);
+    EXPECT_TRUE(boost::filesystem::exists(path_to_db_));
+    boost::filesystem::remove_all(path_to_db_);
+  }
+
+  void reopen()
+  {
+    db_.reset(nullptr);
+    ::csdb::DatabaseBerkeleyDB* db{new ::csdb::DatabaseBerkeleyDB};
+    ASSERT_TRUE(db->open(path_to_db_));
+    db_.reset(db);
+  }
+
+protected:
+  std::unique_ptr<::csdb::Database> db_;
+  std::string path_to_db_;
+  static constexpr const char* database_name_ = "csdb_berkeleydb_unittests";
+};
+
+TEST_F(DatabaseBerkeleyDBTest, WriteBatch)
+{
+  EXPECT_TRUE(db_->write_batch({}));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
+
+  // the record number of a block put is its sequence + 1, a batch appends after the last one
+  EXPECT_TRUE(db_->put({0,0,0}, 0, {0xFF,0xFF,0xFF}));
+  EXPECT_TRUE(db_->write_batch({{{1,1,1}, {2,2,2}}, {{2,2,2}, {3,3,3}}, {{4,4,4}, {5,5,5}}}));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
+
+  cs::Bytes result;
+  EXPECT_TRUE(db_->get(1u, &result));
+  EXPECT_EQ(result, cs::Bytes({0xFF,0xFF,0xFF}));
+  EXPECT_TRUE(db_->get(2u, &result));
+  EXPECT_EQ(result, cs::Bytes({2,2,2}));
+  EXPECT_TRUE(db_->get(4u, &result));
+  EXPECT_EQ(result, cs::Bytes({5,5,5}));
+  EXPECT_FALSE(db_->get(5u, &result));
+
+  EXPECT_TRUE(db_->get(cs::Bytes{2,2,2}, &result));
+  EXPECT_EQ(result, cs::Bytes({3,3,3}));
+  EXPECT_TRUE(db_->get(cs::Bytes{4,4,4}));
+
+  // the batch is durable and the next one goes after it
+  reopen();
+  EXPECT_TRUE(db_->write_batch({{{5,5,5}, {6,6,6}}}));
+  EXPECT_TRUE(db_->get(5u, &result));
+  EXPECT_EQ(result, cs::Bytes({6,6,6}));
+  EXPECT_TRUE(db_->get(cs::Bytes{1,1,1}, &result));
+  EXPECT_EQ(result, cs::Bytes({2,2,2}));
+
+  // and after the highest record, not into a gap
+  EXPECT_TRUE(db_->put({7,7,7}, 9, {8,8,8}));
+  EXPECT_TRUE(db_->write_batch({{{8,8,8}, {9,9,9}}}));
+  EXPECT_FALSE(db_->get(6u, &result));
+  EXPECT_TRUE(db_->get(11u, &result));
+  EXPECT_EQ(result, cs::Bytes({9,9,9}));
+}
+
+TEST_F(DatabaseBerkeleyDBTest, WriteBatchAfterRemove)
+{
+  EXPECT_TRUE(db_->write_batch({{{0,0,0}, {1,1,1}}, {{1,1,1}, {2,2,2}}}));
+  EXPECT_TRUE(db_->remove({1,1,1}));
+
+  cs::Bytes result;
+  EXPECT_FALSE(db_->get(2u, &result));
+
+  // the removed last record is taken again
+  EXPECT_TRUE(db_->write_batch({{{2,2,2}, {3,3,3}}}));
+  EXPECT_TRUE(db_->get(2u, &result));
+  EXPECT_EQ(result, cs::Bytes({3,3,3}));
+  EXPECT_FALSE(db_->get(cs::Bytes{1,1,1}));
+}
@@ -0,0 +1,432 @@
+#include "csdb/database_blocklog.hpp"
+
+#include <memory>
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+class DatabaseBlockLogTest : public ::testing::Test
+{
+protected:
+  void SetUp() override final
+  {
+    path_to_db_ = (boost::filesystem::temp_directory_path() / database_name_).string();
+    boost::filesystem::remove_all(path_to_db_);
+
+    reopen();
+  }
+
+  void TearDown() override final
+  {
+    db_.reset(nullptr);
+    EXPECT_TRUE(boost::filesystem::exists(path_to_db_));
+    boost::filesystem::remove_all(path_to_db_);
+  }
+
+  void reopen(size_t segment_size = 256 << 20, size_t index_journal_size = 1 << 18)
+  {
+    db_.reset(nullptr);
+    ::csdb::DatabaseBlockLog::Options options;
+    options.segment_size = segment_size;
+    options.index_journal_size = index_journal_size;
+    ::csdb::DatabaseBlockLog* db{new ::csdb::DatabaseBlockLog};
+    ASSERT_TRUE(db->open(path_to_db_, options));
+    db_.reset(db);
+  }
+
+  void append_to(const char* name, const std::string& data)
+  {
+    std::ofstream file((boost::filesystem::path(path_to_db_) / name).string(), std::ios::binary | std::ios::app);
+    file << data;
+  }
+
+  void patch_last(const char* name, char byte)
+  {
+    std::fstream file((boost::filesystem::path(path_to_db_) / name).string(), std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(-1, std::ios::end);
+    file.put(byte);
+  }
+
+protected:
+  std::unique_ptr<::csdb::Database> db_;
+  std::string path_to_db_;
+  static constexpr const char* database_name_ = "csdb_blocklog_unittests";
+};
+
+class DatabaseBlockLogTestNotOpen : public ::testing::Test
+{
+};
+
+TEST_F(DatabaseBlockLogTestNotOpen, FailedCreation)
+{
+  std::unique_ptr<::csdb::DatabaseBlockLog> db{new ::csdb::DatabaseBlockLog};
+  EXPECT_FALSE(db->open("/dev/null"));
+  EXPECT_EQ(db->last_error(), ::csdb::Database::IOError);
+}
+
+TEST_F(DatabaseBlockLogTest, Create)
+{
+  EXPECT_TRUE(db_->is_open());
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
+}
+
+TEST_F(DatabaseBlockLogTestNotOpen, FailedGetPut)
+{
+  std::unique_ptr<::csdb::Database> db{new ::csdb::DatabaseBlockLog};
+  EXPECT_FALSE(db->put({1,1,1}, 0, {2,2,2}));
+  EXPECT_EQ(db->last_error(), ::csdb::Database::NotOpen);
+
+  cs::Bytes result;
+  EXPECT_FALSE(db->get(cs::Bytes{1,1,1}, &result));
+  EXPECT_EQ(db->last_error(), ::csdb::Database::NotOpen);
+
+  EXPECT_FALSE(db->get(1u, &result));
+  EXPECT_EQ(db->last_error(), ::csdb::Database::NotOpen);
+}
+
+TEST_F(DatabaseBlockLogTest, GetPut)
+{
+  EXPECT_TRUE(db_->put({1,1,1}, 0, {2,2,2}));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
+  EXPECT_TRUE(db_->put({2,2,2}, 1, {3,3,3}));
+  EXPECT_TRUE(db_->put({4,4,4}, 3, {5,5,5}));
+  EXPECT_TRUE(db_->put({0,0,0}, 2, {0xFF,0xFF,0xFF}));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
+
+  EXPECT_TRUE(db_->get(cs::Bytes{0,0,0}));
+  EXPECT_TRUE(db_->get(cs::Bytes{4,4,4}));
+  EXPECT_FALSE(db_->get(cs::Bytes{3,3,3}));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
+
+  cs::Bytes result;
+  EXPECT_TRUE(db_->get(cs::Bytes{0,0,0}, &result));
+  EXPECT_EQ(result, cs::Bytes({0xFF,0xFF,0xFF}));
+
+  // record number is sequence + 1
+  EXPECT_TRUE(db_->get(1u, &result));
+  EXPECT_EQ(result, cs::Bytes({2,2,2}));
+  EXPECT_TRUE(db_->get(3u, &result));
+  EXPECT_EQ(result, cs::Bytes({0xFF,0xFF,0xFF}));
+  EXPECT_FALSE(db_->get(5u, &result));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
+
+  // an overwritten block is read back after reopening
+  EXPECT_TRUE(db_->put({5,5,5}, 1, {6,6,6,6}));
+  reopen();
+  EXPECT_TRUE(db_->get(2u, &result));
+  EXPECT_EQ(result, cs::Bytes({6,6,6,6}));
+  EXPECT_TRUE(db_->get(cs::Bytes{4,4,4}, &result));
+  EXPECT_EQ(result, cs::Bytes({5,5,5}));
+}
+
+TEST_F(DatabaseBlockLogTest, Remove)
+{
+  EXPECT_TRUE(db_->put({1,1,1}, 0, {2,2,2}));
+  EXPECT_TRUE(db_->put({2,2,2}, 1, {3,3,3}));
+  EXPECT_TRUE(db_->put({4,4,4}, 2, {5,5,5}));
+
+  EXPECT_TRUE(db_->remove({2,2,2}));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
+  EXPECT_FALSE(db_->remove({3,3,3}));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
+
+  // the last block is cut off and its record is free for the next one
+  EXPECT_TRUE(db_->remove({4,4,4}));
+  EXPECT_TRUE(db_->write_batch({{{5,5,5}, {6,6,6}}}));
+
+  reopen();
+
+  cs::Bytes result;
+  EXPECT_TRUE(db_->get(cs::Bytes{1,1,1}, &result));
+  EXPECT_EQ(result, cs::Bytes({2,2,2}));
+  EXPECT_FALSE(db_->get(cs::Bytes{2,2,2}, &result));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
+  EXPECT_FALSE(db_->get(cs::Bytes{4,4,4}, &result));
+  EXPECT_TRUE(db_->get(cs::Bytes{5,5,5}, &result));
+  EXPECT_EQ(result, cs::Bytes({6,6,6}));
+  EXPECT_TRUE(db_->get(2u, &result));
+  EXPECT_EQ(result, cs::Bytes({6,6,6}));
+}
+
+TEST_F(DatabaseBlockLogTest, WriteBatch)
+{
+  EXPECT_TRUE(db_->write_batch({}));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
+  EXPECT_TRUE(db_->write_batch({{{0,0,0}, {0xFF,0xFF,0xFF}}}));
+  EXPECT_TRUE(db_->write_batch({{{1,1,1}, {2,2,2}}, {{2,2,2}, {3,3,3}}, {{4,4,4}, {5,5,5}}}));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
+
+  cs::Bytes result;
+  EXPECT_TRUE(db_->get(1u, &result));
+  EXPECT_EQ(result, cs::Bytes({0xFF,0xFF,0xFF}));
+  EXPECT_TRUE(db_->get(3u, &result));
+  EXPECT_EQ(result, cs::Bytes({3,3,3}));
+
+  // and after the records found on open, in a new segment
+  reopen(4);
+  EXPECT_TRUE(db_->write_batch({{{5,5,5}, {6,6,6}}, {{6,6,6}, {7,7,7}}}));
+  EXPECT_TRUE(db_->get(6u, &result));
+  EXPECT_EQ(result, cs::Bytes({7,7,7}));
+  EXPECT_TRUE(db_->get(cs::Bytes{0,0,0}, &result));
+  EXPECT_EQ(result, cs::Bytes({0xFF,0xFF,0xFF}));
+  EXPECT_TRUE(boost::filesystem::exists(boost::filesystem::path(path_to_db_) / "blocks.000002.log"));
+}
+
+TEST_F(DatabaseBlockLogTest, Recover)
+{
+  EXPECT_TRUE(db_->write_batch({{{0,0,0}, {1,1,1}}, {{1,1,1}, {2,2,2}}}));
+  db_.reset(nullptr);
+
+  // a crash after the data and a part of the index entry are written
+  append_to("blocks.000000.log", "\x03\x03\x03");
+  append_to("index.dat", std::string(7, '\0'));
+  reopen();
+
+  cs::Bytes result;
+  EXPECT_TRUE(db_->get(2u, &result));
+  EXPECT_EQ(result, cs::Bytes({2,2,2}));
+  EXPECT_FALSE(db_->get(3u, &result));
+
+  // the torn data is not read as a part of the next block
+  EXPECT_TRUE(db_->write_batch({{{2,2,2}, {4,4,4}}}));
+  reopen();
+  EXPECT_TRUE(db_->get(cs::Bytes{2,2,2}, &result));
+  EXPECT_EQ(result, cs::Bytes({4,4,4}));
+  EXPECT_EQ(boost::filesystem::file_size(boost::filesystem::path(path_to_db_) / "blocks.000000.log"), 9u);
+
+  // a whole index entry whose data is damaged, only that block is dropped
+  db_.reset(nullptr);
+  patch_last("blocks.000000.log", '\x7F');
+  reopen();
+  EXPECT_FALSE(db_->get(3u, &result));
+  EXPECT_TRUE(db_->get(1u, &result));
+  EXPECT_EQ(result, cs::Bytes({1,1,1}));
+  EXPECT_TRUE(db_->get(2u, &result));
+  EXPECT_EQ(result, cs::Bytes({2,2,2}));
+  EXPECT_EQ(boost::filesystem::file_size(boost::filesystem::path(path_to_db_) / "blocks.000000.log"), 6u);
+
+  // and whose data is missing
+  db_.reset(nullptr);
+  boost::filesystem::resize_file(boost::filesystem::path(path_to_db_) / "blocks.000000.log", 3);
+  reopen();
+  EXPECT_FALSE(db_->get(2u, &result));
+  EXPECT_TRUE(db_->get(1u, &result));
+  EXPECT_EQ(result, cs::Bytes({1,1,1}));
+  EXPECT_EQ(boost::filesystem::file_size(boost::filesystem::path(path_to_db_) / "blocks.000000.log"), 3u);
+}
+
+TEST_F(DatabaseBlockLogTestNotOpen, FailedWriteBatch)
+{
+  std::unique_ptr<::csdb::Database> db{new ::csdb::DatabaseBlockLog};
+  EXPECT_FALSE(db->write_batch({{{0,0,0}, {0xFF,0xFF,0xFF}}}));
+  EXPECT_EQ(db->last_error(), ::csdb::Database::NotOpen);
+}
+
+TEST_F(DatabaseBlockLogTest, Iterator)
+{
+  ::csdb::Database::PoolItemList list{{{3,3,3}, 300, {4,4,4}}, {{4,4,4}, 2, {5,5,5}}, {{2,2,2}, 255, {3,3,3}},
+                                      {{0,0,0}, 0, {1,1,1}}, {{1,1,1}, 70000, {2,2,2}}};
+  EXPECT_TRUE(db_->put(list));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
+
+  auto db_it = db_->new_iterator();
+  EXPECT_TRUE(db_it);
+  EXPECT_FALSE(db_it->is_valid());
+
+  // the gaps between the blocks are skipped
+  std::sort(list.begin(), list.end(), [](const auto& l, const auto& r) { return l.seq_no < r.seq_no; });
+
+  auto it = list.begin();
+  db_it->seek_to_first();
+  for (; it != list.end(); ++it, db_it->next()) {
+    EXPECT_TRUE(db_it->is_valid());
+    EXPECT_EQ(it->value, db_it->value());
+  }
+  EXPECT_FALSE(db_it->is_valid());
+
+  it = list.end() - 1;
+  db_it->seek_to_last();
+  while(true) {
+    EXPECT_TRUE(db_it->is_valid());
+    EXPECT_EQ(it->value, db_it->value());
+    if (list.begin() == it) {
+      break;
+    }
+    --it;
+    db_it->prev();
+  };
+
+  it = list.begin() + (list.size() / 2);
+  const uint32_t record = it->seq_no + 1;
+  db_it->seek(cs::Bytes{uint8_t(record >> 24), uint8_t(record >> 16), uint8_t(record >> 8), uint8_t(record)});
+  EXPECT_EQ(db_it->key(), cs::Bytes({uint8_t(record >> 24), uint8_t(record >> 16), uint8_t(record >> 8), uint8_t(record)}));
+  for (; it != list.end(); ++it, db_it->next()) {
+    EXPECT_TRUE(db_it->is_valid());
+    EXPECT_EQ(it->value, db_it->value());
+  }
+}
+
+TEST_F(DatabaseBlockLogTestNotOpen, FailedIterator)
+{
+  std::unique_ptr<::csdb::Database> db{new ::csdb::DatabaseBlockLog};
+  EXPECT_FALSE(db->new_iterator());
+  EXPECT_EQ(db->last_error(), ::csdb::Database::NotOpen);
+}
+
+TEST_F(DatabaseBlockLogTest, Index)
+{
+  EXPECT_TRUE(db_->update_index({{{1,1}, {1}}, {{1,2}, {2}}, {{1,3}, {3}}, {{2,1}, {4}}}, {}));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
+
+  ::csdb::Database::ItemList items;
+  EXPECT_TRUE(db_->index_range({1}, {2}, false, 0, &items));
+  ASSERT_EQ(items.size(), 3u);
+  EXPECT_EQ(items.front().first, cs::Bytes({1,1}));
+  EXPECT_EQ(items.back().second, cs::Bytes({3}));
+
+  EXPECT_TRUE(db_->index_range({1}, {1,3}, true, 1, &items));
+  ASSERT_EQ(items.size(), 1u);
+  EXPECT_EQ(items.front().first, cs::Bytes({1,2}));
+
+  // the removed keys go before the items put
+  EXPECT_TRUE(db_->update_index({{{1,2}, {5}}}, {{1,1}, {1,2}, {3,3}}));
+  reopen();
+
+  EXPECT_TRUE(db_->index_range({}, {0xFF}, true, 0, &items));
+  ASSERT_EQ(items.size(), 3u);
+  EXPECT_EQ(items[0].first, cs::Bytes({2,1}));
+  EXPECT_EQ(items[1].first, cs::Bytes({1,3}));
+  EXPECT_EQ(items[2].first, cs::Bytes({1,2}));
+  EXPECT_EQ(items[2].second, cs::Bytes({5}));
+}
+
+TEST_F(DatabaseBlockLogTest, IndexRecover)
+{
+  EXPECT_TRUE(db_->update_index({{{1,1}, {1}}}, {}));
+  db_.reset(nullptr);
+
+  // a batch written partly is dropped as a whole
+  append_to("addresses.dat", std::string("\x10\x00\x00\x00\x01\x02\x00\x02\x02", 9));
+  reopen();
+
+  ::csdb::Database::ItemList items;
+  EXPECT_TRUE(db_->index_range({}, {0xFF}, false, 0, &items));
+  ASSERT_EQ(items.size(), 1u);
+  EXPECT_EQ(items.front().first, cs::Bytes({1,1}));
+
+  EXPECT_TRUE(db_->update_index({{{2,2}, {2}}}, {}));
+  reopen();
+  EXPECT_TRUE(db_->index_range({}, {0xFF}, false, 0, &items));
+  EXPECT_EQ(items.size(), 2u);
+}
+
+TEST_F(DatabaseBlockLogTest, IndexBatchChecksum)
+{
+  EXPECT_TRUE(db_->update_index({{{1,1}, {1}}}, {}));
+  db_.reset(nullptr);
+
+  // the length of the batch fits, the checksum does not
+  append_to("addresses.dat", std::string("\x08\x00\x00\x00\x00\x00\x00\x00\x01\x01\x00\x02\x01\x00\x02\x00", 16));
+  reopen();
+
+  ::csdb::Database::ItemList items;
+  EXPECT_TRUE(db_->index_range({}, {0xFF}, false, 0, &items));
+  ASSERT_EQ(items.size(), 1u);
+  EXPECT_EQ(items.front().first, cs::Bytes({1,1}));
+  EXPECT_EQ(boost::filesystem::file_size(boost::filesystem::path(path_to_db_) / "addresses.dat"), 0u);
+}
+
+TEST_F(DatabaseBlockLogTest, IndexCompact)
+{
+  reopen(256 << 20, 100);
+
+  // the journal is merged into the run many times over, the map is what the index must hold
+  std::map<cs::Bytes, cs::Bytes> expected;
+  for (uint8_t i = 0; i < 200; ++i) {
+    ::csdb::Database::ItemList items;
+    std::vector<cs::Bytes> removed;
+    for (uint8_t j = 0; j < 5; ++j) {
+      const cs::Bytes key{uint8_t(j * 37 + i), uint8_t(i % 7)};
+      if ((i + j) % 4 == 0) {
+        removed.push_back(key);
+        expected.erase(key);
+      }
+      else {
+        items.emplace_back(key, cs::Bytes{i, j});
+      }
+    }
+    for (const auto& item : items) {
+      expected[item.first] = item.second;
+    }
+    ASSERT_TRUE(db_->update_index(items, removed));
+  }
+
+  auto check = [this, &expected](const cs::Bytes& from, const cs::Bytes& to, bool reverse, size_t limit) {
+    ::csdb::Database::ItemList items;
+    ASSERT_TRUE(db_->index_range(from, to, reverse, limit, &items));
+
+    ::csdb::Database::ItemList wanted;
+    for (auto it = expected.lower_bound(from); it != expected.end() && it->first < to; ++it) {
+      wanted.emplace_back(it->first, it->second);
+    }
+    if (reverse) {
+      std::reverse(wanted.begin(), wanted.end());
+    }
+    if (limit != 0 && wanted.size() > limit) {
+      wanted.resize(limit);
+    }
+    EXPECT_EQ(items, wanted);
+  };
+
+  for (int pass = 0; pass < 2; ++pass) {
+    check({}, {0xFF}, false, 0);
+    check({}, {0xFF}, true, 0);
+    check({40}, {200}, false, 70);
+    check({40}, {200}, true, 70);
+    check({100, 3}, {100, 4}, true, 1);
+    check({77}, {77}, false, 0);
+
+    // the journal is merged on open
+    reopen(256 << 20, 100);
+    EXPECT_EQ(boost::filesystem::file_size(boost::filesystem::path(path_to_db_) / "addresses.dat"), 0u);
+  }
+}
+
+TEST_F(DatabaseBlockLogTest, IndexClear)
+{
+  reopen(256 << 20, 2);
+  EXPECT_TRUE(db_->update_index({{{1,1}, {1}}, {{1,2}, {2}}, {{1,3}, {3}}}, {}));
+  EXPECT_TRUE(db_->update_index({{{2,1}, {4}}}, {}));
+
+  EXPECT_TRUE(db_->clear_index());
+  ::csdb::Database::ItemList items;
+  EXPECT_TRUE(db_->index_range({}, {0xFF}, false, 0, &items));
+  EXPECT_TRUE(items.empty());
+
+  reopen();
+  EXPECT_TRUE(db_->index_range({}, {0xFF}, false, 0, &items));
+  EXPECT_TRUE(items.empty());
+}
+
+TEST_F(DatabaseBlockLogTest, IndexDamagedRun)
+{
+  reopen(256 << 20, 1);
+  EXPECT_TRUE(db_->update_index({{{1,1}, {1}}, {{1,2}, {2}}}, {}));
+  db_.reset(nullptr);
+
+  // the run is not repaired, the index is dropped to be built anew
+  {
+    std::fstream file((boost::filesystem::path(path_to_db_) / "addresses.run").string(), std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(2);
+    file.put('\x7F');
+  }
+  reopen();
+
+  ::csdb::Database::ItemList items;
+  EXPECT_TRUE(db_->index_range({}, {0xFF}, false, 0, &items));
+  EXPECT_TRUE(items.empty());
+}
@@ -1,4 +1,4 @@
-#include "csdb/database_leveldb.h"
+#include "csdb/database_leveldb.hpp"
 
 #include <memory>
 #include <algorithm>
@@ -7,7 +7,6 @@
 
 #include "leveldb/db.h"
 #include "leveldb/env.h"
-#include "csdb/internal/utils.h"
 
 class DatabaseLeveDBTest : public ::testing::Test
 {
@@ -22,9 +21,7 @@ protected:
       EXPECT_TRUE(leveldb::DestroyDB(path_to_db_, leveldb::Options()).ok());
     }
 
-    ::csdb::DatabaseLevelDB* db{new ::csdb::DatabaseLevelDB};
-    ASSERT_TRUE(db->open(path_to_db_));
-    db_.reset(db);
+    reopen();
   }
 
   void TearDown() override final
@@ -34,6 +31,14 @@ protected:
     EXPECT_TRUE(leveldb::DestroyDB(path_to_db_, leveldb::Options()).ok());
   }
 
+  void reopen()
+  {
+    db_.reset(nullptr);
+    ::csdb::DatabaseLevelDB* db{new ::csdb::DatabaseLevelDB};
+    ASSERT_TRUE(db->open(path_to_db_));
+    db_.reset(db);
+  }
+
 protected:
   std::unique_ptr<::csdb::Database> db_;
   std::string path_to_db_;
@@ -60,57 +65,74 @@ TEST_F(DatabaseLeveDBTest, Create)
 TEST_F(DatabaseLeveDBTestNotOpen, FailedGetPut)
 {
   std::unique_ptr<::csdb::Database> db{new ::csdb::DatabaseLevelDB};
-  EXPECT_FALSE(db->put({1,1,1}, {2,2,2}));
+  EXPECT_FALSE(db->put({1,1,1}, 0, {2,2,2}));
   EXPECT_EQ(db->last_error(), ::csdb::Database::NotOpen);
 
-  EXPECT_FALSE(db->get({1,1,1}));
+  EXPECT_FALSE(db->get(cs::Bytes{1,1,1}));
   EXPECT_EQ(db->last_error(), ::csdb::Database::NotOpen);
 
-  ::csdb::internal::byte_array result;
-  EXPECT_FALSE(db->get({1,1,1}, &result));
+  cs::Bytes result;
+  EXPECT_FALSE(db->get(cs::Bytes{1,1,1}, &result));
+  EXPECT_EQ(db->last_error(), ::csdb::Database::NotOpen);
+
+  EXPECT_FALSE(db->get(1u, &result));
   EXPECT_EQ(db->last_error(), ::csdb::Database::NotOpen);
 }
 
 TEST_F(DatabaseLeveDBTest, GetPut)
 {
   EXPECT_TRUE(db_->is_open());
-  EXPECT_TRUE(db_->put({1,1,1}, {2,2,2}));
+  EXPECT_TRUE(db_->put({1,1,1}, 0, {2,2,2}));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_TRUE(db_->put({2,2,2}, {3,3,3}));
+  EXPECT_TRUE(db_->put({2,2,2}, 1, {3,3,3}));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_TRUE(db_->put({4,4,4}, {5,5,5}));
+  EXPECT_TRUE(db_->put({4,4,4}, 3, {5,5,5}));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_TRUE(db_->put({0,0,0}, {0xFF,0xFF,0xFF}));
+  EXPECT_TRUE(db_->put({0,0,0}, 2, {0xFF,0xFF,0xFF}));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
 
-  EXPECT_TRUE(db_->get({0,0,0}));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_TRUE(db_->get({1,1,1}));
+  EXPECT_TRUE(db_->get(cs::Bytes{0,0,0}));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_TRUE(db_->get({2,2,2}));
+  EXPECT_TRUE(db_->get(cs::Bytes{1,1,1}));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_TRUE(db_->get({4,4,4}));
+  EXPECT_TRUE(db_->get(cs::Bytes{4,4,4}));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
 
-  EXPECT_FALSE(db_->get({3,3,3}));
+  EXPECT_FALSE(db_->get(cs::Bytes{3,3,3}));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
 
-  ::csdb::internal::byte_array result;
-  EXPECT_TRUE(db_->get({0,0,0}, &result));
+  cs::Bytes result;
+  EXPECT_TRUE(db_->get(cs::Bytes{0,0,0}, &result));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_EQ(result, ::csdb::internal::byte_array({0xFF,0xFF,0xFF}));
-  EXPECT_TRUE(db_->get({1,1,1}, &result));
+  EXPECT_EQ(result, cs::Bytes({0xFF,0xFF,0xFF}));
+  EXPECT_TRUE(db_->get(cs::Bytes{4,4,4}, &result));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_EQ(result, ::csdb::internal::byte_array({2,2,2}));
-  EXPECT_TRUE(db_->get({2,2,2}, &result));
+  EXPECT_EQ(result, cs::Bytes({5,5,5}));
+
+  // record number is sequence + 1
+  EXPECT_TRUE(db_->get(1u, &result));
+  EXPECT_EQ(result, cs::Bytes({2,2,2}));
+  EXPECT_TRUE(db_->get(3u, &result));
+  EXPECT_EQ(result, cs::Bytes({0xFF,0xFF,0xFF}));
+
+  EXPECT_FALSE(db_->get(cs::Bytes{3,3,3}, &result));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
+  EXPECT_FALSE(db_->get(5u, &result));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
+}
+
+TEST_F(DatabaseLeveDBTest, PutItems)
+{
+  EXPECT_TRUE(db_->put(::csdb::Database::PoolItemList{}));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_EQ(result, ::csdb::internal::byte_array({3,3,3}));
-  EXPECT_TRUE(db_->get({4,4,4}, &result));
+  EXPECT_TRUE(db_->put(::csdb::Database::PoolItemList{{{1,1,1}, 0, {2,2,2}}, {{2,2,2}, 1, {3,3,3}}}));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_EQ(result, ::csdb::internal::byte_array({5,5,5}));
 
-  EXPECT_FALSE(db_->get({3,3,3}, &result));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
+  cs::Bytes result;
+  EXPECT_TRUE(db_->get(cs::Bytes{2,2,2}, &result));
+  EXPECT_EQ(result, cs::Bytes({3,3,3}));
+  EXPECT_TRUE(db_->get(1u, &result));
+  EXPECT_EQ(result, cs::Bytes({2,2,2}));
 }
 
 TEST_F(DatabaseLeveDBTestNotOpen, FailedRemove)
@@ -123,34 +145,24 @@ TEST_F(DatabaseLeveDBTestNotOpen, FailedRemove)
 TEST_F(DatabaseLeveDBTest, Remove)
 {
   EXPECT_TRUE(db_->is_open());
-  EXPECT_TRUE(db_->put({1,1,1}, {2,2,2}));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_TRUE(db_->put({2,2,2}, {3,3,3}));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_TRUE(db_->put({4,4,4}, {5,5,5}));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_TRUE(db_->put({0,0,0}, {0xFF,0xFF,0xFF}));
+  EXPECT_TRUE(db_->put({1,1,1}, 0, {2,2,2}));
+  EXPECT_TRUE(db_->put({2,2,2}, 1, {3,3,3}));
+  EXPECT_TRUE(db_->put({4,4,4}, 2, {5,5,5}));
 
   EXPECT_TRUE(db_->remove({2,2,2}));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_TRUE(db_->remove({3,3,3}));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_TRUE(db_->remove({4,4,4}));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
+  EXPECT_FALSE(db_->remove({3,3,3}));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
 
-  ::csdb::internal::byte_array result;
-  EXPECT_TRUE(db_->get({0,0,0}, &result));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_EQ(result, ::csdb::internal::byte_array({0xFF,0xFF,0xFF}));
-  EXPECT_TRUE(db_->get({1,1,1}, &result));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_EQ(result, ::csdb::internal::byte_array({2,2,2}));
+  cs::Bytes result;
+  EXPECT_TRUE(db_->get(cs::Bytes{1,1,1}, &result));
+  EXPECT_EQ(result, cs::Bytes({2,2,2}));
+  EXPECT_TRUE(db_->get(cs::Bytes{4,4,4}, &result));
+  EXPECT_EQ(result, cs::Bytes({5,5,5}));
 
-  EXPECT_FALSE(db_->get({2,2,2}, &result));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
-  EXPECT_FALSE(db_->get({3,3,3}, &result));
+  EXPECT_FALSE(db_->get(cs::Bytes{2,2,2}, &result));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
-  EXPECT_FALSE(db_->get({3,3,3}, &result));
+  EXPECT_FALSE(db_->get(2u, &result));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
 }
 
@@ -164,21 +176,25 @@ TEST_F(DatabaseLeveDBTest, WriteBatch)
   EXPECT_TRUE(db_->write_batch({{{1,1,1}, {2,2,2}}, {{2,2,2}, {3,3,3}}, {{4,4,4}, {5,5,5}}}));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
 
-  ::csdb::internal::byte_array result;
-  EXPECT_TRUE(db_->get({0,0,0}, &result));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_EQ(result, ::csdb::internal::byte_array({0xFF,0xFF,0xFF}));
-  EXPECT_TRUE(db_->get({1,1,1}, &result));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_EQ(result, ::csdb::internal::byte_array({2,2,2}));
-  EXPECT_TRUE(db_->get({2,2,2}, &result));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_EQ(result, ::csdb::internal::byte_array({3,3,3}));
-  EXPECT_TRUE(db_->get({4,4,4}, &result));
-  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
-  EXPECT_EQ(result, ::csdb::internal::byte_array({5,5,5}));
-
-  EXPECT_FALSE(db_->get({3,3,3}, &result));
+  cs::Bytes result;
+  EXPECT_TRUE(db_->get(cs::Bytes{0,0,0}, &result));
+  EXPECT_EQ(result, cs::Bytes({0xFF,0xFF,0xFF}));
+  EXPECT_TRUE(db_->get(cs::Bytes{4,4,4}, &result));
+  EXPECT_EQ(result, cs::Bytes({5,5,5}));
+
+  // the items are appended in order
+  EXPECT_TRUE(db_->get(1u, &result));
+  EXPECT_EQ(result, cs::Bytes({0xFF,0xFF,0xFF}));
+  EXPECT_TRUE(db_->get(3u, &result));
+  EXPECT_EQ(result, cs::Bytes({3,3,3}));
+
+  // and after the records found on open
+  reopen();
+  EXPECT_TRUE(db_->write_batch({{{5,5,5}, {6,6,6}}}));
+  EXPECT_TRUE(db_->get(5u, &result));
+  EXPECT_EQ(result, cs::Bytes({6,6,6}));
+
+  EXPECT_FALSE(db_->get(cs::Bytes{3,3,3}, &result));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NotFound);
 }
 
@@ -192,33 +208,33 @@ TEST_F(DatabaseLeveDBTestNotOpen, FailedWriteBatch)
 TEST_F(DatabaseLeveDBTest, Iterator)
 {
   EXPECT_TRUE(db_->is_open());
-  ::csdb::Database::ItemList list{{{3,3,3}, {4,4,4}}, {{4,4,4}, {5,5,5}}, {{2,2,2}, {3,3,3}},
-                                  {{0,0,0}, {1,1,1}}, {{1,1,1}, {2,2,2}}};
-  EXPECT_TRUE(db_->write_batch(list));
+  ::csdb::Database::PoolItemList list{{{3,3,3}, 300, {4,4,4}}, {{4,4,4}, 2, {5,5,5}}, {{2,2,2}, 255, {3,3,3}},
+                                      {{0,0,0}, 0, {1,1,1}}, {{1,1,1}, 70000, {2,2,2}}};
+  EXPECT_TRUE(db_->put(list));
   EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
 
   auto db_it = db_->new_iterator();
   EXPECT_TRUE(db_it);
   EXPECT_FALSE(db_it->is_valid());
 
-  std::sort(list.begin(), list.end());
+  // the blocks are iterated in the sequence order
+  std::sort(list.begin(), list.end(), [](const auto& l, const auto& r) { return l.seq_no < r.seq_no; });
 
   // Forward
   auto it = list.begin();
   db_it->seek_to_first();
   for (; it != list.end(); ++it, db_it->next()) {
     EXPECT_TRUE(db_it->is_valid());
-    EXPECT_EQ(it->first, db_it->key());
-    EXPECT_EQ(it->second, db_it->value());
+    EXPECT_EQ(it->value, db_it->value());
   }
+  EXPECT_FALSE(db_it->is_valid());
 
   // Reverse
   it = list.end() - 1;
   db_it->seek_to_last();
   while(true) {
     EXPECT_TRUE(db_it->is_valid());
-    EXPECT_EQ(it->first, db_it->key());
-    EXPECT_EQ(it->second, db_it->value());
+    EXPECT_EQ(it->value, db_it->value());
     if (list.begin() == it) {
       break;
     }
@@ -226,28 +242,15 @@ TEST_F(DatabaseLeveDBTest, Iterator)
     db_it->prev();
   };
 
-  // Forward from center
+  // Forward from center, the key is the record number in big endian
   it = list.begin() + (list.size() / 2);
-  db_it->seek(it->first);
+  const uint32_t record = it->seq_no + 1;
+  db_it->seek(cs::Bytes{uint8_t(record >> 24), uint8_t(record >> 16), uint8_t(record >> 8), uint8_t(record)});
+  EXPECT_EQ(db_it->key(), cs::Bytes({uint8_t(record >> 24), uint8_t(record >> 16), uint8_t(record >> 8), uint8_t(record)}));
   for (; it != list.end(); ++it, db_it->next()) {
     EXPECT_TRUE(db_it->is_valid());
-    EXPECT_EQ(it->first, db_it->key());
-    EXPECT_EQ(it->second, db_it->value());
+    EXPECT_EQ(it->value, db_it->value());
   }
-
-  // Reverse from center
-  it = list.begin() + (list.size() / 2);
-  db_it->seek(it->first);
-  while(true) {
-    EXPECT_TRUE(db_it->is_valid());
-    EXPECT_EQ(it->first, db_it->key());
-    EXPECT_EQ(it->second, db_it->value());
-    if (list.begin() == it) {
-      break;
-    }
-    --it;
-    db_it->prev();
-  };
 }
 
 TEST_F(DatabaseLeveDBTestNotOpen, FailedIterator)
@@ -256,3 +259,34 @@ TEST_F(DatabaseLeveDBTestNotOpen, FailedIterator)
   EXPECT_FALSE(db->new_iterator());
   EXPECT_EQ(db->last_error(), ::csdb::Database::NotOpen);
 }
+
+TEST_F(DatabaseLeveDBTest, Index)
+{
+  EXPECT_TRUE(db_->write_batch({{{0,0,0}, {1,1,1}}}));
+  EXPECT_TRUE(db_->update_index({{{1,1}, {1}}, {{1,2}, {2}}, {{1,3}, {3}}, {{2,1}, {4}}}, {}));
+  EXPECT_EQ(db_->last_error(), ::csdb::Database::NoError);
+
+  ::csdb::Database::ItemList items;
+  EXPECT_TRUE(db_->index_range({1}, {2}, false, 0, &items));
+  ASSERT_EQ(items.size(), 3u);
+  EXPECT_EQ(items.front().first, cs::Bytes({1,1}));
+  EXPECT_EQ(items.back().second, cs::Bytes({3}));
+
+  EXPECT_TRUE(db_->index_range({1}, {1,3}, true, 1, &items));
+  ASSERT_EQ(items.size(), 1u);
+  EXPECT_EQ(items.front().first, cs::Bytes({1,2}));
+
+  EXPECT_TRUE(db_->update_index({{{1,2}, {5}}}, {{1,1}, {1,2}, {3,3}}));
+  reopen();
+
+  // the index does not mix with the blocks
+  EXPECT_TRUE(db_->index_range({}, {0xFF}, true, 0, &items));
+  ASSERT_EQ(items.size(), 3u);
+  EXPECT_EQ(items[0].first, cs::Bytes({2,1}));
+  EXPECT_EQ(items[2].second, cs::Bytes({5}));
+  EXPECT_TRUE(db_->write_batch({{{1,1,1}, {2,2,2}}}));
+
+  cs::Bytes result;
+  EXPECT_TRUE(db_->get(2u, &result));
+  EXPECT_EQ(result, cs::Bytes({2,2,2}));
+}
@@ -675,4 +675,44 @@ TEST_F(PoolTest, GetTransactionByTarget)
   // Case if target appears multiple times, should return last transaction
 
   EXPECT_EQ(pool.get_last_by_target(addr2).amount(), 32_c);
-}
\ No newline at end of file
+}
+
+TEST_F(PoolTest, LazyFromBinary)
+{
+  Pool src{PoolHash{}, 0};
+  const Address source = Address::from_wallet_id(1);
+  const Address target = Address::from_wallet_id(2);
+
+  for (int64_t i = 0; i < 3; ++i) {
+    EXPECT_TRUE(src.add_transaction(Transaction(i, source, target, Currency(1), Amount(static_cast<int32_t>(i + 1)), AmountCommission(0.1), AmountCommission(0.1), cs::Signature{}), true));
+  }
+  EXPECT_TRUE(src.compose());
+
+  Pool dst = Pool::lazy_from_binary(src.to_binary());
+  EXPECT_TRUE(dst.is_valid());
+  EXPECT_TRUE(dst.is_read_only());
+  EXPECT_EQ(dst.hash(), src.hash());
+  EXPECT_EQ(dst.transactions_count(), static_cast<size_t>(3));
+
+  // the original bytes are kept as they are
+  const cs::Bytes binary = src.to_binary();
+  EXPECT_EQ(cs::Bytes(dst.binary_view().begin(), dst.binary_view().end()), binary);
+
+  // the transactions are decoded one by one or all at once
+  Transaction t = dst.transaction(1);
+  EXPECT_TRUE(t.is_valid());
+  EXPECT_EQ(t.innerID(), 1);
+  EXPECT_EQ(t.amount(), Amount(2));
+  EXPECT_EQ(t.id(), src.transaction(1).id());
+  EXPECT_FALSE(dst.transaction(3).id().is_valid());
+  EXPECT_EQ(dst.get_last_by_target(target).innerID(), 2);
+
+  const Pool& constDst = dst;
+  EXPECT_EQ(constDst.transactions().size(), static_cast<size_t>(3));
+  EXPECT_EQ(constDst.transactions()[2].id(), src.transaction(2).id());
+
+  EXPECT_FALSE(Pool::lazy_from_binary({}).is_valid());
+  cs::Bytes invalid(binary);
+  invalid.resize(invalid.size() - 1);
+  EXPECT_FALSE(Pool::lazy_from_binary(std::move(invalid)).is_valid());
+}
@@ -0,0 +1,92 @@
+#include "pool_cache.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace csdb;
+
+class PoolCacheTest : public ::testing::Test
+{
+protected:
+  static Pool make_pool(cs::Sequence sequence)
+  {
+    Pool pool(PoolHash::calc_from_data({uint8_t(sequence), uint8_t(sequence >> 8)}), sequence);
+    EXPECT_TRUE(pool.compose());
+    return pool;
+  }
+};
+
+TEST_F(PoolCacheTest, GetByHashAndSequence)
+{
+  priv::pool_cache cache(1 << 20, 4);
+  const Pool pool = make_pool(10);
+  cache.put(pool, 100);
+
+  Pool result;
+  EXPECT_TRUE(cache.get(pool.hash(), result));
+  EXPECT_EQ(result.hash(), pool.hash());
+  EXPECT_TRUE(cache.get(cs::Sequence(10), result));
+  EXPECT_EQ(result.hash(), pool.hash());
+  EXPECT_FALSE(cache.get(cs::Sequence(11), result));
+  EXPECT_FALSE(cache.get(make_pool(11).hash(), result));
+
+  const auto stats = cache.get_stats();
+  EXPECT_EQ(stats.hits, 2u);
+  EXPECT_EQ(stats.misses, 2u);
+  EXPECT_EQ(stats.pools, 1u);
+}
+
+TEST_F(PoolCacheTest, Remove)
+{
+  priv::pool_cache cache(1 << 20, 4);
+  const Pool pool = make_pool(10);
+  cache.put(pool, 100);
+  cache.remove(pool.hash());
+
+  Pool result;
+  EXPECT_FALSE(cache.get(pool.hash(), result));
+  EXPECT_FALSE(cache.get(cs::Sequence(10), result));
+  EXPECT_EQ(cache.get_stats().bytes, 0u);
+
+  // another pool of the same sequence replaces it
+  const Pool other(PoolHash::calc_from_data({1, 2, 3}), 10);
+  Pool composed = other;
+  EXPECT_TRUE(composed.compose());
+  cache.put(composed, 100);
+  EXPECT_TRUE(cache.get(cs::Sequence(10), result));
+  EXPECT_EQ(result.hash(), composed.hash());
+}
+
+TEST_F(PoolCacheTest, EvictsLeastRecentlyUsed)
+{
+  // one shard for a predictable order, room for about three pools
+  priv::pool_cache cache(4000, 1);
+  const Pool first = make_pool(1);
+  const Pool second = make_pool(2);
+  const Pool third = make_pool(3);
+
+  cache.put(first, 1000);
+  cache.put(second, 1000);
+
+  Pool result;
+  EXPECT_TRUE(cache.get(first.hash(), result));
+
+  cache.put(third, 1000);
+  cache.put(make_pool(4), 1000);
+
+  EXPECT_TRUE(cache.get(first.hash(), result));
+  EXPECT_FALSE(cache.get(second.hash(), result));
+  EXPECT_FALSE(cache.get(cs::Sequence(2), result));
+  EXPECT_GE(cache.get_stats().evictions, 1u);
+  EXPECT_LE(cache.get_stats().bytes, 4000u);
+}
+
+TEST_F(PoolCacheTest, TooLargePoolIsNotCached)
+{
+  priv::pool_cache cache(1000, 1);
+  const Pool pool = make_pool(1);
+  cache.put(pool, 2000);
+
+  Pool result;
+  EXPECT_FALSE(cache.get(pool.hash(), result));
+  EXPECT_EQ(cache.get_stats().pools, 0u);
+}
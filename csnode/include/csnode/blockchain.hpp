@@ -1,6 +1,7 @@
 #ifndef BLOCKCHAIN_HPP
 #define BLOCKCHAIN_HPP
 
+#include <atomic>
 #include <list>
 #include <map>
 #include <memory>
@@ -10,6 +11,7 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 
 #include <boost/dynamic_bitset.hpp>
 
@@ -30,12 +32,16 @@
 #include <condition_variable>
 #include <mutex>
 
+struct DatabaseData;
+
 namespace cs {
 class BlockHashes;
 class WalletsIds;
 class Fee;
 class TransactionsPacket;
 class BlockValidator;
+class WalletsSnapshot;
+class DataStream;
 
 /** @brief   The new block signal emits when finalizeBlock() occurs just before recordBlock() */
 using StoreBlockSignal = cs::Signal<void(const csdb::Pool&)>;
@@ -61,9 +67,12 @@ public:
     explicit BlockChain(csdb::Address genesisAddress, csdb::Address startAddress);
     ~BlockChain();
 
-    bool init(const std::string& path);
+    bool init(const std::string& path, const DatabaseData& settings);
     bool isGood() const;
 
+    // opens the database of the engine from the settings, nullptr if the engine is unknown or the database is not opened
+    static std::shared_ptr<csdb::Database> openDatabase(const std::string& path, const DatabaseData& settings);
+
     // return unique id of database if at least one unique block has written, otherwise (only genesis block) 0
     uint64_t uuid() const;
 
@@ -170,6 +179,24 @@ public:
 
     void testCachedBlocks();
 
+    /**
+     * @fn    void BlockChain::beginBatch();
+     *
+     * @brief Starts a bulk ingest: blocks flushed to storage until commitBatch() are written in one transaction
+     */
+
+    void beginBatch();
+
+    /**
+     * @fn    bool BlockChain::commitBatch();
+     *
+     * @brief Writes the blocks flushed to storage since beginBatch()
+     *
+     * @return    True if it succeeds, false if it fails.
+     */
+
+    bool commitBatch();
+
 public signals:
 
     /** @brief The new block event. Raised when the next incoming block is finalized and just before stored into chain */
@@ -188,12 +215,15 @@ public slots:
     // prototype is void (csdb::Transaction)
     // subscription is placed in SmartContracts constructor
     void onPayableContractReplenish(const csdb::Transaction& starter) {
+        std::lock_guard lock(cacheMutex_);
         this->walletsCacheUpdater_->invokeReplenishPayableContract(starter);
     }
     void onPayableContractTimeout(const csdb::Transaction& starter) {
+        std::lock_guard lock(cacheMutex_);
         this->walletsCacheUpdater_->rollbackReplenishPayableContract(starter);
     }
     void onContractEmittedAccepted(const csdb::Transaction& emitted, const csdb::Transaction& starter) {
+        std::lock_guard lock(cacheMutex_);
         this->walletsCacheUpdater_->smartSourceTransactionReleased(emitted, starter);
     }
 
@@ -205,7 +235,7 @@ public:
     csdb::Pool loadBlock(const cs::Sequence sequence) const;
     csdb::Pool loadBlockMeta(const csdb::PoolHash&, size_t& cnt) const;
     csdb::Transaction loadTransaction(const csdb::TransactionID&) const;
-    void iterateOverWallets(const std::function<bool(const cs::WalletsCache::WalletData::Address&, const cs::WalletsCache::WalletData&)>);
+    void iterateOverWallets(const std::function<bool(const cs::WalletsCache::WalletData::Address&, const cs::WalletsCache::WalletHead&)>);
     csdb::Pool getLastBlock() const {
         return loadBlock(getLastSequence());
     }
@@ -223,6 +253,8 @@ public:
     bool findWalletData(const csdb::Address&, WalletData& wallData, WalletId& id) const;
     bool findWalletData(WalletId id, WalletData& wallData) const;
     bool findWalletId(const WalletAddress& address, WalletId& id) const;
+    // the public keys of the addresses under one lock, an unknown wallet id gets a zeroed key and makes it return false
+    bool findPublicKeys(const std::vector<csdb::Address>& addresses, std::vector<cs::PublicKey>& keys) const;
     // wallet transactions: pools cache + db search
     void getTransactions(Transactions& transactions, csdb::Address address, uint64_t offset, uint64_t limit);
     // wallets modified by last new block
@@ -230,7 +262,7 @@ public:
 
 #ifdef MONITOR_NODE
     void iterateOverWriters(const std::function<bool(const cs::WalletsCache::WalletData::Address&, const cs::WalletsCache::TrustedData&)>);
-    void applyToWallet(const csdb::Address&, const std::function<void(const cs::WalletsCache::WalletData&)>); 
+    void applyToWallet(const csdb::Address&, const std::function<void(const cs::WalletsCache::WalletHead&)>); 
 #endif
 	uint32_t getTransactionsCount(const csdb::Address&);
 
@@ -250,6 +282,12 @@ public:
 private:
     bool findAddrByWalletId(const WalletId id, csdb::Address& addr) const;
 
+    // the public key the address index knows the wallet by
+    csdb::Address addressIndexKey(const csdb::Address& address) const;
+    // indexes the stored blocks the address index is behind, runs in addressIndexThread_
+    void buildAddressIndex();
+    void stopAddressIndexing();
+
     void writeGenesisBlock();
 #ifdef TRANSACTIONS_INDEX
     void createTransactionsIndex(csdb::Pool&);
@@ -263,6 +301,11 @@ private:
     void onReadFromDB(csdb::Pool block, bool* shouldStop);
     bool postInitFromDB();
 
+    bool loadSnapshot(csdb::Database& db);
+    bool applySnapshot(cs::DataStream& stream);
+    // Thread unsafe, cacheMutex_ must be locked
+    void saveSnapshot(cs::Sequence sequence, const csdb::PoolHash& hash);
+
     template <typename WalletCacheProcessor>
     bool updateWalletIds(const csdb::Pool& pool, WalletCacheProcessor& proc);
     bool insertNewWalletId(const csdb::Address& newWallAddress, WalletId newWalletId, cs::WalletsCache::Initer& initer);
@@ -298,6 +341,16 @@ private:
     std::unique_ptr<cs::WalletsPools> walletsPools_;
     mutable cs::SpinLock cacheMutex_{ATOMIC_FLAG_INIT};
 
+    bool addressIndex_ = false;
+    std::thread addressIndexThread_;
+    std::atomic<bool> addressIndexQuit_{false};
+
+    // destroyed before the state it serializes
+    std::unique_ptr<cs::WalletsSnapshot> snapshot_;
+    cs::Sequence snapshotInterval_ = 0;
+    // the blocks up to it are already in the wallets state loaded from the snapshot, they are only checked while the chain is read
+    std::optional<cs::Sequence> snapshotSequence_;
+
 #ifdef TRANSACTIONS_INDEX
     uint64_t total_transactions_count_ = 0;
 
@@ -2,9 +2,17 @@
 #define BLOCKHASHES_HPP
 
 #include <csdb/pool.hpp>
+#include <csnode/walletsstorage.hpp>
+#include <lib/system/common.hpp>
+#include <functional>
+#include <memory>
 #include <vector>
 
 namespace cs {
+class DataStream;
+
+// Hashes of the whole chain: a flat array of fixed size hashes by sequence and
+// an open addressing hash -> sequence index over it
 class BlockHashes {
 public:
     struct DbStructure {
@@ -20,7 +28,11 @@ public:
     }
 
     bool empty() const {
-        return hashes_.empty();
+        return hashes_.size() == 0;
+    }
+
+    size_t size() const {
+        return hashes_.size();
     }
 
     void initStart();
@@ -30,16 +42,40 @@ public:
 
     csdb::PoolHash find(cs::Sequence seq) const;
 
+    // returns 0 if the hash is not found
     cs::Sequence find(csdb::PoolHash hash) const;
 
     csdb::PoolHash removeLast();
 
     csdb::PoolHash getLast() const;
 
-    const std::vector<csdb::PoolHash>& getHashes() const;
+    // the wallets state snapshot part, see WalletsSnapshot
+    void serialize(cs::DataStream& stream) const;
+    bool deserialize(cs::DataStream& stream);
+    // serializes the hashes as they are now, along with the writer, see FrozenEntries
+    std::function<void(cs::DataStream&)> freeze();
 
 private:
-    std::vector<csdb::PoolHash> hashes_;
+    // an empty slot has position 0, the others keep position + 1 and a part of the hash
+    struct Slot {
+        uint32_t tag;
+        uint32_t position;
+    };
+
+    static bool toHash(const csdb::PoolHash& poolHash, cs::Hash& hash);
+    static csdb::PoolHash toPoolHash(const cs::Hash& hash);
+    static uint64_t keyOf(const cs::Hash& hash);
+
+    bool append(const csdb::PoolHash& poolHash);
+    void insertIndex(size_t position);
+    void eraseIndex(size_t position);
+    void rebuildIndex(size_t slotsCount);
+
+    // the pages never move, so a frozen view reads the hashes in place
+    WalletsStorage<cs::Hash> hashes_;
+    std::vector<std::shared_ptr<FrozenEntries<cs::Hash>>> frozen_;
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
 
     DbStructure db_;
     bool isDbInited_;
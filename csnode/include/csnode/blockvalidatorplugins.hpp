@@ -111,9 +111,6 @@ public:
     : ValidationPlugin(bv) {
     }
     ErrorType validateBlock(const csdb::Pool&) override;
-
-private:
-    bool checkSignature(const csdb::Transaction&);
 };
 }  // namespace cs
 #endif  // BLOCK_VALIDATOR_PLUGINS_HPP
@@ -64,8 +64,9 @@ public:
     ///
     /// @brief Adds transactions packet received by network.
     /// @param packet Created from network transactions packet.
+    /// @return Returns true if the packet is new to the conveyer.
     ///
-    void addTransactionsPacket(const cs::TransactionsPacket& packet);
+    bool addTransactionsPacket(const cs::TransactionsPacket& packet);
 
     ///
     /// @brief Returns current round transactions packet hash table.
@@ -410,7 +410,7 @@ public:
         size_t size = parseValue<size_t>();
 
         if (isAvailable(size)) {
-            bytesView = cs::BytesView(reinterpret_cast<cs::Byte*>(data_), size);
+            bytesView = cs::BytesView(reinterpret_cast<cs::Byte*>(data_ + index_), size);
             index_ += size;
         }
         else {
@@ -701,6 +701,14 @@ inline DataStream& operator<<(DataStream& stream, const csdb::PoolHash& hash) {
 }
 
 inline DataStream& operator<<(DataStream& stream, const csdb::Pool& pool) {
+    // the pools read from the storage are written as they are, without detaching a shared one
+    const cs::BytesView view = pool.binary_view();
+
+    if (!view.empty()) {
+        stream.addBytesView(view);
+        return stream;
+    }
+
     uint32_t bSize;
     auto dataPtr = const_cast<csdb::Pool&>(pool).to_byte_stream(bSize);
     stream << cs::Bytes(dataPtr, dataPtr + bSize);
@@ -27,7 +27,9 @@ private:
 
     void checkSignaturesSmartSource(SolverContext&, Packets& smartContractsPackets);
     void checkTransactionsSignatures(SolverContext& context, const Transactions& transactions, Bytes& characteristicMask, Packets& smartsPackets);
-    bool checkTransactionSignature(SolverContext& context, const csdb::Transaction& transaction);
+    // the transactions of the wallets are signed by their sources, the smart contract ones follow the rules below
+    bool isSignedBySource(SolverContext& context, const csdb::Transaction& transaction);
+    bool checkSmartTransactionSignature(const csdb::Transaction& transaction);
 
     bool deployAdditionalCheck(SolverContext& context, size_t trxInd, const csdb::Transaction& transaction);
 
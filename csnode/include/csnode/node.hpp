@@ -117,7 +117,7 @@ public:
     void startConsensus();
 
     void prepareRoundTable(cs::RoundTable& roundTable, const cs::PoolMetaInfo& poolMetaInfo, cs::StageThree& st3);
-    bool receivingSignatures(const cs::Bytes& sigBytes, const cs::Bytes& roundBytes, const cs::RoundNumber rNum, const cs::Bytes& trustedMask,
+    bool receivingSignatures(const cs::BytesView& sigBytes, const cs::BytesView& roundBytes, const cs::RoundNumber rNum, const cs::Bytes& trustedMask,
                              const cs::ConfidantsKeys& newConfidants, cs::Signatures& poolSignatures);
     void addRoundSignature(const cs::StageThree& st3);
     // smart-contracts consensus stages sending and getting
@@ -200,6 +200,9 @@ public:
         return solver_;
     }
 
+    // the link telemetry of the neighbours at the moment of the call, thread safe
+    std::vector<Neighbourhood::NeighbourMetrics> getNeighboursMetrics() const;
+
 #ifdef NODE_API
     csconnector::connector* getConnector() {
         return api_.get();
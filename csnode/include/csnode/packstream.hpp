@@ -621,6 +621,14 @@ inline cs::OPackStream& cs::OPackStream::operator<<(const csdb::Transaction& tra
 
 template <>
 inline cs::OPackStream& cs::OPackStream::operator<<(const csdb::Pool& pool) {
+    const cs::BytesView view = pool.binary_view();
+
+    if (!view.empty()) {
+        (*this) << view.size();
+        insertBytes(view.data(), static_cast<uint32_t>(view.size()));
+        return *this;
+    }
+
     uint32_t bSize;
     auto dataPtr = const_cast<csdb::Pool&>(pool).to_byte_stream(bSize);
 
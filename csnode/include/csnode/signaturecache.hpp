@@ -0,0 +1,62 @@
+#ifndef SIGNATURE_CACHE_HPP
+#define SIGNATURE_CACHE_HPP
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include <lib/system/common.hpp>
+
+namespace cs {
+struct SignatureItem;
+
+// The signatures found right, so a transaction signature is verified once: when its packet comes in, and the
+// characteristic and the block validation find it here later. An entry is the hash of the signed bytes,
+// the signature and the key. Sharded by the hash, a full shard forgets its oldest entries
+class SignatureCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t size = 0;
+    };
+
+    // the cache of the node
+    static SignatureCache& instance();
+
+    explicit SignatureCache(size_t capacity, size_t shards = 16);
+
+    static cs::Hash key(const SignatureItem& item);
+
+    bool contains(const cs::Hash& key);
+    void insert(const cs::Hash& key);
+    void clear();
+
+    Stats stats() const;
+
+private:
+    struct Hasher {
+        size_t operator()(const cs::Hash& hash) const noexcept;
+    };
+
+    struct Shard {
+        mutable std::mutex lock;
+        std::unordered_set<cs::Hash, Hasher> keys;
+        std::deque<cs::Hash> order;  // the oldest first
+
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    Shard& shardOf(const cs::Hash& key);
+
+    const size_t shardCapacity_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+}  // namespace cs
+
+#endif  // SIGNATURE_CACHE_HPP
@@ -0,0 +1,98 @@
+#ifndef SIGNATURE_VERIFIER_HPP
+#define SIGNATURE_VERIFIER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <csdb/transaction.hpp>
+#include <lib/system/common.hpp>
+
+namespace cs {
+class SignatureCache;
+
+// a signature to check, the buffers belong to the caller
+struct SignatureItem {
+    const cs::Byte* signature;
+    const cs::Byte* publicKey;
+    const cs::Byte* data;
+    size_t size;
+};
+
+using SignatureItems = std::vector<SignatureItem>;
+
+// the items of transactions signed by their sources, holds the signed bytes and the keys the items point to
+class TransactionsSignatures {
+public:
+    // the key of the source, see BlockChain::findPublicKeys
+    void add(const csdb::Transaction& transaction, const cs::PublicKey& key);
+
+    const SignatureItems& items() const {
+        return items_;
+    }
+
+private:
+    std::deque<cs::Bytes> messages_;
+    std::deque<cs::Signature> signatures_;
+    std::deque<cs::PublicKey> keys_;
+    SignatureItems items_;
+};
+
+// Checks many ed25519 signatures at once: the items are cut into chunks, the workers and the calling thread
+// take the chunks until none is left. Few items are checked on the calling thread only
+class SignatureVerifier {
+public:
+    // the verifier of the node, a worker per core besides the calling thread
+    static SignatureVerifier& instance();
+
+    // gets the results of verifyAsync() as verify() gives them
+    using Handler = std::function<void(const cs::Bytes& results)>;
+
+    explicit SignatureVerifier(size_t workers);
+    ~SignatureVerifier();
+
+    SignatureVerifier(const SignatureVerifier&) = delete;
+    SignatureVerifier& operator=(const SignatureVerifier&) = delete;
+
+    // checks every item, results[i] is 1 if items[i] is signed right and 0 otherwise;
+    // the signatures found in the cache are not checked again, the right ones are put there
+    void verify(const SignatureItems& items, cs::Bytes& results, SignatureCache* cache = nullptr);
+
+    // stops at a wrong signature, invalid gets the lowest index of a wrong one
+    bool verifyAll(const SignatureItems& items, size_t* invalid = nullptr, SignatureCache* cache = nullptr);
+
+    // checks every item on the workers, the calling thread does not wait: the worker checking the last chunk calls the handler.
+    // The holder keeps the buffers the items point to till then. Without workers the items are checked on the calling thread
+    void verifyAsync(const SignatureItems& items, std::shared_ptr<const void> holder, Handler handler, SignatureCache* cache = nullptr);
+
+    // checks count items in one call, the chunks of every batch come through here,
+    // so a batch kernel confirming a whole chunk can take the place of the loop, which stays as its fallback
+    static void verifyChunk(const SignatureItem* items, size_t count, cs::Byte* results);
+
+    size_t workers() const {
+        return threads_.size();
+    }
+
+private:
+    struct Batch;
+
+    static std::shared_ptr<Batch> makeBatch(const SignatureItem* items, size_t count, cs::Byte* results, SignatureCache* cache);
+    bool run(const SignatureItems& items, cs::Byte* results, bool stopOnInvalid, size_t* invalid, SignatureCache* cache);
+    static void verifyChunk(const SignatureItem* items, size_t count, cs::Byte* results, SignatureCache& cache);
+    void work();
+    static void process(Batch& batch);
+
+    std::vector<std::thread> threads_;
+
+    std::mutex lock_;
+    std::condition_variable newBatch_;
+    std::deque<std::shared_ptr<Batch>> batches_;
+    bool quit_ = false;
+};
+}  // namespace cs
+
+#endif  // SIGNATURE_VERIFIER_HPP
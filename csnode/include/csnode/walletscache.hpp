@@ -9,9 +9,17 @@
 #include <csdb/transaction.hpp>
 #include <csnode/nodecore.hpp>
 #include <csnode/transactionstail.hpp>
+#include <csnode/walletsstorage.hpp>
+#include <atomic>
+#include <cstring>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include <lib/system/common.hpp>
@@ -25,6 +33,7 @@ class Transaction;
 
 namespace cs {
 class WalletsIds;
+class DataStream;
 
 constexpr size_t InitialWalletsNum = 1 * 512 * 1024;
 
@@ -38,17 +47,26 @@ public:
     };
 
 public:
-    struct WalletData {
+    // the fields the scans over all the wallets read, they are stored apart from the tails
+    struct WalletHead {
         using Address = cs::PublicKey;
 
         Address address_;
         csdb::Amount balance_;
-        TransactionsTail trxTail_;
-		uint64_t transNum_ = 0;
+        uint64_t transNum_ = 0;
 
 #ifdef MONITOR_NODE
-        uint64_t createTime_ = 0;        
+        uint64_t createTime_ = 0;
 #endif
+    };
+
+    // the fields read for one wallet at a time
+    struct WalletTail {
+        TransactionsTail trxTail_;
+    };
+
+    // a copy of the whole wallet
+    struct WalletData : WalletHead, WalletTail {
 #ifdef TRANSACTIONS_INDEX
         csdb::TransactionID lastTransaction_;
 #endif
@@ -60,11 +78,228 @@ public:
         csdb::Amount totalFee;
     };
 
+    // The wallets by id. One writer stores them while the readers copy them out: a wallet has a seqlock,
+    // a reader copies it again if the writer has stored it meanwhile, so the readers wait neither
+    // for the writer nor for each other
+    class Wallets {
+    public:
+        static_assert(std::is_trivially_copyable_v<WalletHead> && std::is_trivially_copyable_v<WalletTail>, "the readers copy the wallets as bytes");
+
+        using Frozen = FrozenEntries<std::optional<WalletData>>;
+
+        // the ids below are either wallets or free
+        size_t size() const {
+            return versions_.size();
+        }
+
+        // for the readers, a part is not copied if its pointer is nullptr
+        bool read(WalletId id, WalletHead* head, WalletTail* tail) const {
+            const Version* version = versions_.find(id);
+            if (!version) {
+                return false;
+            }
+
+            for (;;) {
+                const uint32_t before = version->value.load(std::memory_order_acquire);
+                if (before == 0) {
+                    return false;
+                }
+
+                // odd while the writer stores the wallet, it is a copy of a few bytes long
+                if (before % 2 == 0) {
+                    if (head) {
+                        std::memcpy(head, heads_.find(id), sizeof(WalletHead));
+                    }
+                    if (tail) {
+                        std::memcpy(tail, tails_.find(id), sizeof(WalletTail));
+                    }
+
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (version->value.load(std::memory_order_relaxed) == before) {
+                        return true;
+                    }
+                }
+
+                std::this_thread::yield();
+            }
+        }
+
+        // for the readers, func gets the copies of the heads and stops the iteration returning false
+        template <typename Func>
+        void forEach(Func func) const {
+            WalletHead head;
+            for (WalletId id = 0; id < size(); ++id) {
+                if (read(id, &head, nullptr) && !func(head)) {
+                    break;
+                }
+            }
+        }
+
+        // for the reader of the frozen wallets, see freeze()
+        std::optional<WalletData> read(Frozen& frozen, WalletId id) const {
+            return frozen.read(id, [this, id] { return find(id); });
+        }
+
+        // the rest is for the writer
+
+        // the wallets as they are now for a reader along with the writer, see FrozenEntries
+        std::shared_ptr<Frozen> freeze() {
+            frozen_.push_back(std::make_shared<Frozen>(size()));
+            return frozen_.back();
+        }
+
+        bool contains(WalletId id) const {
+            const Version* version = versions_.find(id);
+            return version && version->value.load(std::memory_order_relaxed) != 0;
+        }
+
+        size_t count() const {
+            return count_;
+        }
+
+        void reserve(size_t count) {
+            heads_.reserve(count);
+            tails_.reserve(count);
+#ifdef TRANSACTIONS_INDEX
+            lastTransactions_.reserve(count);
+#endif
+            versions_.reserve(count);
+        }
+
+        // the new ids are free
+        void resize(size_t count) {
+            for (size_t id = count; id < size(); ++id) {
+                keepFrozen(static_cast<WalletId>(id));
+            }
+
+            heads_.resize(count);
+            tails_.resize(count);
+#ifdef TRANSACTIONS_INDEX
+            lastTransactions_.resize(count);
+#endif
+            // the readers see the wallets up to the versions
+            versions_.resize(count);
+        }
+
+        bool load(WalletId id, WalletData& wallet) const {
+            if (!contains(id)) {
+                return false;
+            }
+
+            static_cast<WalletHead&>(wallet) = heads_[id];
+            static_cast<WalletTail&>(wallet) = tails_[id];
+#ifdef TRANSACTIONS_INDEX
+            wallet.lastTransaction_ = lastTransactions_[id];
+#endif
+            return true;
+        }
+
+        void store(WalletId id, const WalletData& wallet) {
+            if (id >= size()) {
+                resize(id + 1);
+            }
+            keepFrozen(id);
+
+            std::atomic<uint32_t>& version = versions_[id].value;
+            const uint32_t before = version.load(std::memory_order_relaxed);
+
+            version.store(before + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            heads_[id] = wallet;
+            tails_[id] = wallet;
+            // 0 stays for the free ids when the version wraps
+            version.store(before + 2 == 0 ? 2 : before + 2, std::memory_order_release);
+
+#ifdef TRANSACTIONS_INDEX
+            lastTransactions_[id] = wallet.lastTransaction_;
+#endif
+            if (before == 0) {
+                ++count_;
+            }
+        }
+
+        // not along with the readers
+        void erase(WalletId id) {
+            if (!contains(id)) {
+                return;
+            }
+            keepFrozen(id);
+
+            heads_[id] = WalletHead{};
+            tails_[id] = WalletTail{};
+#ifdef TRANSACTIONS_INDEX
+            lastTransactions_[id] = csdb::TransactionID{};
+#endif
+            versions_[id].value.store(0, std::memory_order_relaxed);
+            --count_;
+        }
+
+#ifdef TRANSACTIONS_INDEX
+        // the readers take the lock of the writer for it, it is not a copy of bytes
+        const csdb::TransactionID* findLastTransaction(WalletId id) const {
+            return contains(id) ? &lastTransactions_[id] : nullptr;
+        }
+#endif
+
+        size_t memory() const {
+            size_t result = heads_.memory() + tails_.memory() + versions_.memory();
+#ifdef TRANSACTIONS_INDEX
+            result += lastTransactions_.memory();
+#endif
+            return result;
+        }
+
+    private:
+        // 0 if there is no wallet, odd while the writer stores it
+        struct Version {
+            std::atomic<uint32_t> value{0};
+
+            Version() = default;
+            Version(const Version& other)
+            : value(other.value.load(std::memory_order_relaxed)) {
+            }
+            Version& operator=(const Version& other) {
+                value.store(other.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                return *this;
+            }
+        };
+
+        // for the writer, or for a reader the writer waits for, see FrozenEntries
+        std::optional<WalletData> find(WalletId id) const {
+            const Version* version = versions_.find(id);
+            if (!version || version->value.load(std::memory_order_relaxed) == 0) {
+                return std::nullopt;
+            }
+
+            WalletData wallet;
+            static_cast<WalletHead&>(wallet) = *heads_.find(id);
+            static_cast<WalletTail&>(wallet) = *tails_.find(id);
+#ifdef TRANSACTIONS_INDEX
+            wallet.lastTransaction_ = *lastTransactions_.find(id);
+#endif
+            return wallet;
+        }
+
+        void keepFrozen(WalletId id) {
+            saveFrozen(frozen_, id, [this, id] { return find(id); });
+        }
+
+        WalletsStorage<WalletHead> heads_;
+        WalletsStorage<WalletTail> tails_;
+#ifdef TRANSACTIONS_INDEX
+        WalletsStorage<csdb::TransactionID> lastTransactions_;
+#endif
+        WalletsStorage<Version> versions_;
+        size_t count_ = 0;
+        std::vector<std::shared_ptr<Frozen>> frozen_;
+    };
+
 public:
     static void convert(const csdb::Address& address, WalletData::Address& walletAddress);
     static void convert(const WalletData::Address& walletAddress, csdb::Address& address);
 
-    void iterateOverWallets(const std::function<bool(const WalletData::Address&, const WalletData&)>);
+    // along with the writer, see Wallets
+    void iterateOverWallets(const std::function<bool(const WalletData::Address&, const WalletHead&)>);
 
 #ifdef MONITOR_NODE
     void iterateOverWriters(const std::function<bool(const WalletData::Address&, const TrustedData&)>);
@@ -75,8 +310,6 @@ public:
     }
 
 private:
-    using Data = std::vector<WalletData*>;
-
     class ProcessorBase {
     public:
         ProcessorBase(WalletsCache& data)
@@ -92,7 +325,11 @@ private:
         double loadTrxForSource(const csdb::Transaction& tr, const BlockChain& blockchain);
         void fundConfidantsWalletsWithFee(const csdb::Amount& totalFee, const cs::ConfidantsKeys& confidants, const std::vector<uint8_t>& realTrusted);
         void loadTrxForTarget(const csdb::Transaction& tr);
-        virtual WalletData& getWalletData(WalletId id, const csdb::Address& address) = 0;
+        // a copy of the wallet to change, the readers see the changes after commit()
+        WalletData& getWalletData(WalletId id, const csdb::Address& address);
+        void commit();
+        // the wallets the id belongs to
+        virtual Wallets& getWallets(WalletId id) = 0;
         virtual void setModified(WalletId id) = 0;
         void invokeReplenishPayableContract(const csdb::Transaction&);
         void rollbackReplenishPayableContract(const csdb::Transaction&, const csdb::Amount& execFee = 0);
@@ -107,13 +344,18 @@ private:
         #endif*/
 
     protected:
-        static WalletData& getWalletData(Data& wallets, WalletId id, const csdb::Address& address);
 #ifdef MONITOR_NODE
         bool setWalletTime(const WalletData::Address& address, const uint64_t& p_timeStamp);
 #endif
 
     protected:
         WalletsCache& data_;
+
+    private:
+        void rollbackReplenish(const csdb::Transaction& transaction, const csdb::Amount& execFee);
+
+        // the wallets changed since the last commit
+        std::unordered_map<WalletId, WalletData> changed_;
     };
 
 public:
@@ -128,11 +370,11 @@ public:
 
     protected:
         bool findWalletId(const csdb::Address& address, WalletId& id) override;
-        WalletData& getWalletData(WalletId id, const csdb::Address& address) override;
+        Wallets& getWallets(WalletId id) override;
         void setModified(WalletId id) override;
 
     protected:
-        Data walletsSpecial_;
+        Wallets walletsSpecial_;
     };
 
     class Updater : protected ProcessorBase {
@@ -142,14 +384,22 @@ public:
         using ProcessorBase::smartSourceTransactionReleased;
         Updater(WalletsCache& data);
         void loadNextBlock(csdb::Pool& curr, const cs::ConfidantsKeys& confidants, const BlockChain& blockchain);
-        const WalletData* findWallet(WalletId id) const;
+
+        // the copies for the readers along with the writer, the last transaction is not copied
+        bool findWallet(WalletId id, WalletHead& head) const;
+        bool findWallet(WalletId id, WalletData& wallet) const;
+#ifdef TRANSACTIONS_INDEX
+        // under the lock the writer takes
+        const csdb::TransactionID* findLastTransaction(WalletId id) const;
+#endif
+
         const Mask& getModified() const {
             return modified_;
         }
 
     protected:
         bool findWalletId(const csdb::Address& address, WalletId& id) override;
-        WalletData& getWalletData(WalletId id, const csdb::Address& address) override;
+        Wallets& getWallets(WalletId id) override;
         void setModified(WalletId id) override;
 
     protected:
@@ -170,7 +420,19 @@ public:
     std::unique_ptr<Initer> createIniter();
     std::unique_ptr<Updater> createUpdater();
 
+    // the wallets state snapshot part, see WalletsSnapshot
+    void serialize(cs::DataStream& stream) const;
+    bool deserialize(cs::DataStream& stream);
+    // serializes the state as it is now, along with the writer, see FrozenEntries
+    std::function<void(cs::DataStream&)> freeze();
+
 private:
+    using TrustedInfo = std::map<WalletData::Address, TrustedData>;
+
+    // the state besides the wallets
+    static void serializeRest(cs::DataStream& stream, const std::list<csdb::Transaction>& smartPayableTransactions, const std::list<csdb::Transaction>& closedSmarts,
+                              const TrustedInfo& trustedInfo);
+
     const Config config_;
     WalletsIds& walletsIds_;
     const csdb::Address genesisAddress_;
@@ -179,10 +441,10 @@ private:
     std::list<csdb::Transaction> closedSmarts_;
 
 #ifdef MONITOR_NODE
-    std::map<WalletData::Address, TrustedData> trusted_info_;
+    TrustedInfo trusted_info_;
 #endif
 
-    Data wallets_;
+    Wallets wallets_;
 };
 
 }  // namespace cs
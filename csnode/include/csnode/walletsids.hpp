@@ -2,12 +2,18 @@
 #define WALLET_IDS_HPP
 
 #include <csdb/address.hpp>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <type_traits>
-#include <unordered_map>
+#include <vector>
 #include "csdb/internal/types.hpp"
 
+#include <csnode/walletsstorage.hpp>
+
 namespace cs {
+class DataStream;
 
 class WalletsIds {
 public:
@@ -75,9 +81,71 @@ public:
         return *norm_;
     }
 
+    // the wallets state snapshot part, see WalletsSnapshot
+    void serialize(cs::DataStream& stream) const;
+    bool deserialize(cs::DataStream& stream);
+    // serializes the ids as they are now, along with the writer, see FrozenEntries
+    std::function<void(cs::DataStream&)> freeze();
+
+    // the ids kept, either normal or special
+    size_t size() const {
+        return count_;
+    }
+
+    void reserve(size_t count);
+    // the allocated bytes, the replaced tables included
+    size_t memory() const;
+
 private:
-    using Data = std::unordered_map<WalletAddress, WalletId>;
-    Data data_;
+    using Key = cs::PublicKey;
+
+    // Open addressing with linear probing. A slot holds the id and a tag of the key hash, the key itself
+    // is compared in the keys by id, so a probe mostly reads one cache line of the slots and one of the keys.
+    // One writer changes the ids, the readers find them meanwhile without a lock: a key is put in place
+    // before its slot, and a full table is replaced by a twice larger one. When only the removed slots
+    // are dropped, the table replaced before at the same capacity is refilled instead of a new one,
+    // so there are at most two tables of a capacity; a reader checks the version of the table it went through
+    struct Table {
+        explicit Table(size_t capacity);
+
+        const size_t mask;
+        const std::unique_ptr<std::atomic<uint64_t>[]> entries;
+        // odd while the table is refilled
+        std::atomic<uint64_t> version{0};
+    };
+
+    // the key of a kept id, nullopt for a free or removed one
+    using Entry = std::optional<Key>;
+
+    uint64_t hash(const Key& key) const;
+    const Key* findKey(WalletId id) const;
+    // for the readers along with the writer
+    bool findId(const Key& key, uint64_t hash, WalletId& id) const;
+    Entry findEntry(WalletId id) const;
+    // the slot of the key, nullptr if there is none; for the writer
+    std::atomic<uint64_t>* findSlot(const Key& key, uint64_t hash) const;
+
+    // the rest is for the writer
+    void emplace(const Key& key, uint64_t hash, WalletId id);
+    void assign(std::atomic<uint64_t>& slot, const Key& key, uint64_t hash, WalletId id);
+    void setKey(WalletId id, const Key& key);
+    // before the id is given to another key or removed
+    void keepFrozen(WalletId id);
+    void grow(size_t capacity);
+    void swap(WalletsIds& other);
+
+    std::vector<std::unique_ptr<Table>> tables_;
+    std::atomic<const Table*> table_{nullptr};
+    // by the normal ids and by the special ones
+    WalletsStorage<Key> keys_;
+    WalletsStorage<Key> specialKeys_;
+    std::vector<std::shared_ptr<FrozenEntries<Entry>>> frozenKeys_;
+    std::vector<std::shared_ptr<FrozenEntries<Entry>>> frozenSpecialKeys_;
+    uint64_t seed_;
+    size_t count_ = 0;
+    // the ids and the removed ones, the last are dropped when the table grows
+    size_t used_ = 0;
+
     WalletId nextId_;
     std::unique_ptr<Special> special_;
     std::unique_ptr<Normal> norm_;
@@ -0,0 +1,68 @@
+#ifndef WALLETS_SNAPSHOT_HPP
+#define WALLETS_SNAPSHOT_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <csdb/pool.hpp>
+#include <lib/system/common.hpp>
+
+namespace cs {
+class DataStream;
+
+// Checksummed files with the wallets state after some block, so the node replays only the blocks after it on restart.
+// The files are written by a background thread, a few newest ones are kept in case the newest does not match the chain
+class WalletsSnapshot {
+public:
+    // gets the state of a valid snapshot, returns true if the state is accepted
+    using LoadHandler = std::function<bool(cs::Sequence, const csdb::PoolHash&, cs::DataStream&)>;
+    // writes the state, it is called by the background thread
+    using Serializer = std::function<void(cs::DataStream&)>;
+
+    explicit WalletsSnapshot(const std::string& path, size_t keep = 2);
+    ~WalletsSnapshot();
+
+    WalletsSnapshot(const WalletsSnapshot&) = delete;
+    WalletsSnapshot& operator=(const WalletsSnapshot&) = delete;
+
+    // queues the state after the block for writing, a state queued earlier and not written yet is dropped
+    void save(cs::Sequence sequence, const csdb::PoolHash& hash, cs::Bytes&& state);
+    // the same, the state is serialized by the background thread
+    void save(cs::Sequence sequence, const csdb::PoolHash& hash, Serializer&& serializer);
+
+    // offers the valid snapshots from the newest one until the handler accepts one
+    bool load(const LoadHandler& handler) const;
+
+private:
+    struct Snapshot {
+        cs::Sequence sequence = 0;
+        csdb::PoolHash hash;
+        cs::Bytes state;
+        Serializer serializer;
+    };
+
+    void writeRoutine();
+    bool write(const Snapshot& snapshot) const;
+    void removeOld() const;
+
+    std::string fileName(cs::Sequence sequence) const;
+    std::vector<cs::Sequence> list() const;
+
+    const std::string path_;
+    const size_t keep_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    Snapshot queued_;
+    bool hasQueued_ = false;
+    bool stop_ = false;
+
+    std::thread writer_;
+};
+}  // namespace cs
+
+#endif  // WALLETS_SNAPSHOT_HPP
@@ -7,6 +7,7 @@
 #include <csdb/internal/types.hpp>
 #include <csnode/transactionstail.hpp>
 #include <csnode/walletscache.hpp>
+#include <csnode/walletsstorage.hpp>
 #include <unordered_map>
 #include <vector>
 
@@ -43,7 +44,6 @@ private:
     class WalletsExisting {
     public:
         explicit WalletsExisting(const BlockChain& blockchain, size_t initialWalletsNum = InitialWalletsNum);
-        ~WalletsExisting();
 
         void updateFromSource();
         WalletData* getData(const WalletId& id);
@@ -54,7 +54,7 @@ private:
 
     private:
         const BlockChain& blockchain_;
-        using Storage = std::vector<WalletData*>;
+        using Storage = WalletsStorage<WalletData>;
         Storage storage_;
         Mask toCopy_;
         Mask modified_;
@@ -0,0 +1,228 @@
+#ifndef WALLETS_STORAGE_HPP
+#define WALLETS_STORAGE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace cs {
+// The entries of the wallets by their ids. They are kept in fixed size pages instead of
+// separate heap blocks, so a scan walks through memory in order, and the pages never move:
+// a reference to an entry stays valid while the storage grows.
+// One writer changes the storage, the readers may find the entries meanwhile, see find()
+template <typename T, size_t PageBits = 12>
+class WalletsStorage {
+public:
+    static constexpr size_t PageSize = size_t(1) << PageBits;
+
+    WalletsStorage() = default;
+
+    // not along with the readers
+    WalletsStorage(WalletsStorage&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    WalletsStorage& operator=(WalletsStorage&& other) noexcept {
+        pages_ = std::move(other.pages_);
+        directories_ = std::move(other.directories_);
+        directory_.store(other.directory_.exchange(nullptr));
+        size_.store(other.size_.exchange(0));
+        return *this;
+    }
+
+    size_t size() const {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    void reserve(size_t count) {
+        pages_.reserve(pagesFor(count));
+    }
+
+    // the new entries are value initialized, the dropped ones are reset
+    void resize(size_t count) {
+        for (size_t i = count; i < size(); ++i) {
+            (*this)[i] = T{};
+        }
+
+        while (pages_.size() < pagesFor(count)) {
+            pages_.push_back(std::make_unique<Page>());
+            publish(pages_.size() - 1);
+        }
+
+        // the readers see the pages before the size
+        size_.store(count, std::memory_order_release);
+    }
+
+    // not along with the readers
+    void clear() {
+        // releases the memory too
+        std::vector<std::unique_ptr<Page>>().swap(pages_);
+        std::vector<std::unique_ptr<Directory>>().swap(directories_);
+        directory_.store(nullptr);
+        size_.store(0);
+    }
+
+    T& operator[](size_t index) {
+        return (*pages_[index >> PageBits])[index & (PageSize - 1)];
+    }
+
+    const T& operator[](size_t index) const {
+        return (*pages_[index >> PageBits])[index & (PageSize - 1)];
+    }
+
+    // for the readers working along with the writer, nullptr if the index is out of the storage
+    const T* find(size_t index) const {
+        if (index >= size_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        const Directory* directory = directory_.load(std::memory_order_acquire);
+        return &(*directory->pages[index >> PageBits].load(std::memory_order_relaxed))[index & (PageSize - 1)];
+    }
+
+    // the allocated bytes, the page pointers included
+    size_t memory() const {
+        size_t result = pages_.capacity() * sizeof(std::unique_ptr<Page>) + pages_.size() * sizeof(Page);
+
+        for (const auto& directory : directories_) {
+            result += directory->capacity * sizeof(std::atomic<const Page*>);
+        }
+
+        return result;
+    }
+
+private:
+    using Page = std::array<T, PageSize>;
+
+    // the page pointers the readers go through, a twice larger one takes the place of a full one
+    struct Directory {
+        explicit Directory(size_t count)
+        : capacity(count)
+        , pages(new std::atomic<const Page*>[count]()) {
+        }
+
+        const size_t capacity;
+        const std::unique_ptr<std::atomic<const Page*>[]> pages;
+    };
+
+    static size_t pagesFor(size_t count) {
+        return (count + PageSize - 1) >> PageBits;
+    }
+
+    void publish(size_t page) {
+        const Directory* directory = directory_.load(std::memory_order_relaxed);
+
+        if (!directory || directory->capacity <= page) {
+            auto next = std::make_unique<Directory>(std::max<size_t>(16, page * 2));
+
+            for (size_t i = 0; i < page; ++i) {
+                next->pages[i].store(pages_[i].get(), std::memory_order_relaxed);
+            }
+
+            // the replaced ones stay, a reader may still go through them
+            directories_.push_back(std::move(next));
+            directory = directories_.back().get();
+        }
+
+        directory->pages[page].store(pages_[page].get(), std::memory_order_relaxed);
+        directory_.store(directory, std::memory_order_release);
+    }
+
+    std::vector<std::unique_ptr<Page>> pages_;
+    std::vector<std::unique_ptr<Directory>> directories_;
+    std::atomic<const Directory*> directory_{nullptr};
+    std::atomic<size_t> size_{0};
+};
+
+// The entries below a size as they were when it was made, for one reader going through them once along with
+// the writer, so the whole is not copied under the lock of the writer. The writer saves an entry before it
+// changes the entry the first time; the reader takes the saved one or reads the entry in place, the writer
+// waits for it meanwhile
+template <typename T>
+class FrozenEntries {
+public:
+    explicit FrozenEntries(size_t size)
+    : size_(size)
+    , states_(new std::atomic<uint8_t>[size]()) {
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    // for the writer before it changes the entry, load gives the entry as it is
+    template <typename Load>
+    void save(size_t index, Load load) {
+        if (index >= size_) {
+            return;
+        }
+
+        std::atomic<uint8_t>& state = states_[index];
+        uint8_t current = state.load(std::memory_order_acquire);
+
+        if (current == Live) {
+            // the reader finds the saved entry after the lock
+            std::lock_guard lock(mutex_);
+            if (state.compare_exchange_strong(current, Saved, std::memory_order_acq_rel)) {
+                saved_.emplace(index, load());
+                return;
+            }
+        }
+
+        while (current == Reading) {
+            std::this_thread::yield();
+            current = state.load(std::memory_order_acquire);
+        }
+    }
+
+    // for the reader, once for an index below size(); load reads the entry in place
+    template <typename Load>
+    T read(size_t index, Load load) {
+        std::atomic<uint8_t>& state = states_[index];
+        uint8_t expected = Live;
+
+        if (state.compare_exchange_strong(expected, Reading, std::memory_order_acq_rel)) {
+            T result = load();
+            state.store(Read, std::memory_order_release);
+            return result;
+        }
+
+        std::lock_guard lock(mutex_);
+        auto it = saved_.find(index);
+        T result = std::move(it->second);
+        saved_.erase(it);
+        return result;
+    }
+
+private:
+    enum : uint8_t {
+        Live,
+        Reading,
+        Read,
+        Saved
+    };
+
+    const size_t size_;
+    const std::unique_ptr<std::atomic<uint8_t>[]> states_;
+    std::mutex mutex_;
+    std::unordered_map<size_t, T> saved_;
+};
+
+// for the writer before it changes an entry, the frozen entries the readers have released are dropped
+template <typename T, typename Load>
+void saveFrozen(std::vector<std::shared_ptr<FrozenEntries<T>>>& frozen, size_t index, Load load) {
+    frozen.erase(std::remove_if(frozen.begin(), frozen.end(), [](const auto& entries) { return entries.use_count() == 1; }), frozen.end());
+
+    for (auto& entries : frozen) {
+        entries->save(index, load);
+    }
+}
+}  // namespace cs
+
+#endif  // WALLETS_STORAGE_HPP
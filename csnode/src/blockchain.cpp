@@ -3,6 +3,7 @@
 #include <lib/system/hash.hpp>
 #include <lib/system/logger.hpp>
 #include <lib/system/utils.hpp>
+#include <chrono>
 #include <limits>
 
 #include <csnode/blockchain.hpp>
@@ -12,10 +13,18 @@
 #include <csnode/datastream.hpp>
 #include <csnode/fee.hpp>
 #include <csnode/nodeutils.hpp>
+#include <csnode/walletssnapshot.hpp>
 #include <solver/smartcontracts.hpp>
 
 #include <client/config.hpp>
 
+#include <csdb/database_berkeleydb.hpp>
+#include <csdb/database_blocklog.hpp>
+#include <csdb/internal/utils.hpp>
+#ifdef CSDB_LEVELDB
+#include <csdb/database_leveldb.hpp>
+#endif
+
 //#define RECREATE_INDEX
 
 using namespace cs;
@@ -36,10 +45,53 @@ BlockChain::BlockChain(csdb::Address genesisAddress, csdb::Address startAddress)
 }
 
 BlockChain::~BlockChain() {
+    stopAddressIndexing();
+}
+
+std::shared_ptr<csdb::Database> BlockChain::openDatabase(const std::string& path, const DatabaseData& settings) {
+    if (settings.engine == "leveldb") {
+#ifdef CSDB_LEVELDB
+        csdb::DatabaseLevelDB::Options options;
+        options.cache_size = size_t(settings.cacheSize) << 20;
+        options.write_buffer_size = size_t(settings.writeBufferSize) << 20;
+        options.bloom_bits = settings.bloomBits;
+        options.compression = settings.compression;
+
+        auto leveldb = std::make_shared<csdb::DatabaseLevelDB>();
+        if (leveldb->open(path, options)) {
+            return leveldb;
+        }
+#else
+        cserror() << "The node is built without LevelDB support, rebuild it with CSDB_LEVELDB";
+        return nullptr;
+#endif
+    }
+    else if (settings.engine == "berkeleydb") {
+        auto berkeleydb = std::make_shared<csdb::DatabaseBerkeleyDB>();
+        if (berkeleydb->open(path)) {
+            return berkeleydb;
+        }
+    }
+    else if (settings.engine == "blocklog") {
+        csdb::DatabaseBlockLog::Options options;
+        options.segment_size = std::max<size_t>(settings.segmentSize, 1) << 20;
+
+        auto blocklog = std::make_shared<csdb::DatabaseBlockLog>();
+        if (blocklog->open(path, options)) {
+            return blocklog;
+        }
+    }
+    else {
+        cserror() << "Unknown database engine " << settings.engine;
+        return nullptr;
+    }
+
+    cserror() << "Couldn't open " << settings.engine << " database at " << path;
+    return nullptr;
 }
 
-bool BlockChain::init(const std::string& path) {
-    cslog() << "Trying to open DB...";
+bool BlockChain::init(const std::string& path, const DatabaseData& settings) {
+    cslog() << "Trying to open " << settings.engine << " DB...";
 
     size_t totalLoaded = 0;
     csdb::Storage::OpenCallback progress = [&](const csdb::Storage::OpenProgress& progress) {
@@ -50,7 +102,22 @@ bool BlockChain::init(const std::string& path) {
         return false;
     };
 
-    if (!storage_.open(path, progress)) {
+    std::shared_ptr<csdb::Database> db = openDatabase(path, settings);
+    if (!db) {
+        return false;
+    }
+
+    if (settings.snapshotInterval > 0) {
+        snapshot_ = std::make_unique<cs::WalletsSnapshot>(csdb::internal::path_add_separator(path) + "snapshots");
+        snapshotInterval_ = settings.snapshotInterval;
+        loadSnapshot(*db);
+    }
+
+    const bool opened = storage_.open(csdb::Storage::OpenOptions{db, size_t(settings.blockCacheSize) << 20}, progress);
+    const auto loadedSnapshot = snapshotSequence_;
+    snapshotSequence_.reset();
+
+    if (!opened) {
         cserror() << "Couldn't open database at " << path;
         return false;
     }
@@ -72,6 +139,31 @@ bool BlockChain::init(const std::string& path) {
         std::cout << "Done\n";
     }
 
+    // the next restart should not replay the chain read now
+    if (snapshot_ && getLastSequence() >= loadedSnapshot.value_or(0) + snapshotInterval_) {
+        std::lock_guard lock(cacheMutex_);
+        saveSnapshot(getLastSequence(), getLastHash());
+    }
+
+    addressIndex_ = settings.addressIndex;
+
+    if (addressIndex_) {
+        if (settings.rebuildAddressIndex && !storage_.address_index_reset()) {
+            cserror() << "Couldn't drop the address index: " << storage_.last_error_message();
+            return false;
+        }
+
+        if (storage_.address_index_next() < storage_.size()) {
+            cslog() << "Blockchain: indexing the addresses of blocks #" << storage_.address_index_next() << "-" << storage_.size() - 1 << " in the background";
+            addressIndexQuit_ = false;
+            addressIndexThread_ = std::thread(&BlockChain::buildAddressIndex, this);
+        }
+    }
+    else if (storage_.address_index_next() > 0) {
+        // it would be stale when turned on again
+        storage_.address_index_reset();
+    }
+
 #if defined(TRANSACTIONS_INDEX) && defined(RECREATE_INDEX)
     for (uint32_t seq = 0; seq <= getLastSequence(); ++seq) {
         auto pool = loadBlock(seq);
@@ -105,35 +197,99 @@ void BlockChain::onReadFromDB(csdb::Pool block, bool* shouldStop) {
         *shouldStop = true;
         return;
     }
-    if (!updateWalletIds(block, *walletsCacheUpdater_.get())) {
+    if (snapshotSequence_ && block.sequence() <= *snapshotSequence_) {
+        // the wallets state already includes the block
+        if (blockHashes_->find(block.sequence()) != block.hash()) {
+            cserror() << "Blockchain: block #" << block.sequence() << " differs from the wallets snapshot";
+            *shouldStop = true;
+            return;
+        }
+    }
+    else if (!updateWalletIds(block, *walletsCacheUpdater_.get())) {
         cserror() << "Blockchain: updateWalletIds() failed on block #" << block.sequence();
         *shouldStop = true;
+        return;
     }
     else {
         walletsCacheUpdater_->loadNextBlock(block, block.confidants(), *this);
         if (!blockHashes_->initFromPrevBlock(block)) {
             cserror() << "Blockchain: blockHashes_->initFromPrevBlock(block) failed on block #" << block.sequence();
             *shouldStop = true;
+            return;
         }
-        else {
+    }
+
 #ifdef TRANSACTIONS_INDEX
-            const auto cnt_tr = block.transactions_count();
-            if (cnt_tr > 0) {
-                total_transactions_count_ += cnt_tr;
+    const auto cnt_tr = block.transactions_count();
+    if (cnt_tr > 0) {
+        total_transactions_count_ += cnt_tr;
 
-                if (lastNonEmptyBlock_.transCount && block.hash() != lastNonEmptyBlock_.hash) {
-                    previousNonEmpty_[block.hash()] = lastNonEmptyBlock_;
-                }
-                lastNonEmptyBlock_.hash = block.hash();
-                lastNonEmptyBlock_.transCount = static_cast<uint32_t>(block.transactions().size());
-            }
+        if (lastNonEmptyBlock_.transCount && block.hash() != lastNonEmptyBlock_.hash) {
+            previousNonEmpty_[block.hash()] = lastNonEmptyBlock_;
+        }
+        lastNonEmptyBlock_.hash = block.hash();
+        lastNonEmptyBlock_.transCount = static_cast<uint32_t>(block.transactions().size());
+    }
 #endif
+}
+
+bool BlockChain::loadSnapshot(csdb::Database& db) {
+    return snapshot_->load([this, &db](cs::Sequence sequence, const csdb::PoolHash& hash, cs::DataStream& stream) {
+        // the snapshot belongs to this chain if the chain has the same block at its sequence
+        cs::Bytes data;
+        if (!db.get(static_cast<uint32_t>(sequence + 1), &data) || csdb::Pool::from_binary(std::move(data)).hash() != hash) {
+            return false;
         }
+
+        if (!applySnapshot(stream)) {
+            return false;
+        }
+
+        snapshotSequence_ = sequence;
+        return true;
+    });
+}
+
+bool BlockChain::applySnapshot(cs::DataStream& stream) {
+    auto blockHashes = std::make_unique<cs::BlockHashes>();
+    auto walletIds = std::make_unique<cs::WalletsIds>();
+    auto walletsCache = std::make_unique<cs::WalletsCache>(WalletsCache::Config(), genesisAddress_, startAddress_, *walletIds);
+
+    if (!blockHashes->deserialize(stream) || !walletIds->deserialize(stream) || !walletsCache->deserialize(stream) || stream.isAvailable(1)) {
+        return false;
     }
+
+    std::lock_guard lock(cacheMutex_);
+
+    walletsCacheUpdater_.reset();
+    walletsPools_ = std::make_unique<cs::WalletsPools>(genesisAddress_, startAddress_, *walletIds);
+    walletsCacheStorage_ = std::move(walletsCache);
+    walletIds_ = std::move(walletIds);
+    blockHashes_ = std::move(blockHashes);
+    walletsCacheUpdater_ = walletsCacheStorage_->createUpdater();
+    return true;
+}
+
+void BlockChain::saveSnapshot(cs::Sequence sequence, const csdb::PoolHash& hash) {
+    if (blockHashes_->getLast() != hash) {
+        csdebug() << "Blockchain: the wallets state does not match block #" << sequence << ", no snapshot";
+        return;
+    }
+
+    // only the views are taken under the lock, the state is serialized by the snapshot thread along with the next blocks
+    auto serializeHashes = blockHashes_->freeze();
+    auto serializeIds = walletIds_->freeze();
+    auto serializeWallets = walletsCacheStorage_->freeze();
+
+    snapshot_->save(sequence, hash, [serializeHashes, serializeIds, serializeWallets](cs::DataStream& stream) {
+        serializeHashes(stream);
+        serializeIds(stream);
+        serializeWallets(stream);
+    });
 }
 
 bool BlockChain::postInitFromDB() {
-    auto func = [](const WalletData::Address&, const WalletData& wallet) {
+    auto func = [](const WalletData::Address&, const cs::WalletsCache::WalletHead& wallet) {
         double bal = wallet.balance_.to_double();
         if (bal < -std::numeric_limits<double>::min()) {
             csdebug() << "Wallet with negative balance (" << bal << ") detected: " << cs::Utils::byteStreamToHex(wallet.address_.data(), wallet.address_.size()) << " ("
@@ -237,8 +393,7 @@ void BlockChain::writeGenesisBlock() {
     genesis.to_byte_stream(bSize);
 }
 
-void BlockChain::iterateOverWallets(const std::function<bool(const cs::WalletsCache::WalletData::Address&, const cs::WalletsCache::WalletData&)> func) {
-    std::lock_guard lock(cacheMutex_);
+void BlockChain::iterateOverWallets(const std::function<bool(const cs::WalletsCache::WalletData::Address&, const cs::WalletsCache::WalletHead&)> func) {
     walletsCacheStorage_->iterateOverWallets(func);
 }
 
@@ -248,15 +403,16 @@ void BlockChain::iterateOverWriters(const std::function<bool(const cs::WalletsCa
     walletsCacheStorage_->iterateOverWriters(func);
 }
 
-void BlockChain::applyToWallet(const csdb::Address& addr, const std::function<void(const cs::WalletsCache::WalletData&)> func) {
-    std::lock_guard lock(cacheMutex_);
+void BlockChain::applyToWallet(const csdb::Address& addr, const std::function<void(const cs::WalletsCache::WalletHead&)> func) {
     WalletId id;
     if (!walletIds_->normal().find(addr, id)) {
         return;
     }
-    auto wd = walletsCacheUpdater_->findWallet(id);
 
-    func(*wd);
+    WalletsCache::WalletHead wallet;
+    if (walletsCacheUpdater_->findWallet(id, wallet)) {
+        func(wallet);
+    }
 }
 #endif
 
@@ -343,6 +499,10 @@ void BlockChain::removeLastBlock() {
         }
         else {
             pool = storage_.pool_remove_last();
+
+            if (pool.is_valid() && addressIndex_ && storage_.address_index_next() == pool.sequence() + 1) {
+                storage_.address_index_remove(pool, [this](const csdb::Address& address) { return addressIndexKey(address); });
+            }
         }
     }
 
@@ -366,8 +526,7 @@ void BlockChain::removeLastBlock() {
     else {
         csmeta(cserror) << "Error! Last pool hash mismatch";
         const auto findSequence = blockHashes_->find(poolHash);
-        const auto& bh = blockHashes_->getHashes();
-        csmeta(cserror) << "Block hashes size: " << bh.size() << ", Pool sequence: " << pool.sequence() << ", in Block hashes sequence: " << findSequence
+        csmeta(cserror) << "Block hashes size: " << blockHashes_->size() << ", Pool sequence: " << pool.sequence() << ", in Block hashes sequence: " << findSequence
                         << (findSequence != 0 ? "" : " (hash not found)");
         // if (findSequence == 0) {
         //  for (std::size_t i = 0; i < bh.size(); ++i) {
@@ -541,10 +700,8 @@ csdb::PoolHash BlockChain::getHashBySequence(cs::Sequence seq) const {
 }
 
 uint64_t BlockChain::getWalletsCountWithBalance() {
-    std::lock_guard lock(cacheMutex_);
-
     uint64_t count = 0;
-    auto proc = [&](const WalletData::Address& addr, const WalletData& wallet) {
+    auto proc = [&](const WalletData::Address& addr, const cs::WalletsCache::WalletHead& wallet) {
         constexpr csdb::Amount zero_balance(0);
         if (!addr.empty() && wallet.balance_ >= zero_balance) {
             count++;
@@ -612,6 +769,49 @@ private:
 };
 
 void BlockChain::getTransactions(Transactions& transactions, csdb::Address address, uint64_t offset, uint64_t limit) {
+    if (addressIndex_ && limit > 0) {
+        const csdb::Address key = addressIndexKey(address);
+        cs::Lock lock(dbLock_);
+
+        if (key.is_public_key() && storage_.address_index_next() == storage_.size()) {
+            // the deferred block is not stored, so not indexed yet
+            if (deferredBlock_.is_valid()) {
+                const auto& blockTransactions = deferredBlock_.transactions();
+
+                for (auto it = blockTransactions.rbegin(); it != blockTransactions.rend() && limit > 0; ++it) {
+                    if (!isEqual(it->source(), key) && !isEqual(it->target(), key)) {
+                        continue;
+                    }
+
+                    if (offset > 0) {
+                        --offset;
+                        continue;
+                    }
+
+                    transactions.push_back(*it);
+                    transactions.back().set_time(deferredBlock_.get_time());
+                    --limit;
+                }
+            }
+
+            std::vector<csdb::Transaction> stored;
+            if (limit == 0 || storage_.address_transactions(key, static_cast<size_t>(offset), static_cast<size_t>(limit), stored)) {
+                csdb::Pool pool;
+
+                for (auto& transaction : stored) {
+                    if (pool.hash() != transaction.id().pool_hash()) {
+                        pool = loadBlock(transaction.id().pool_hash());
+                    }
+
+                    transaction.set_time(pool.get_time());
+                    transactions.push_back(std::move(transaction));
+                }
+
+                return;
+            }
+        }
+    }
+
     for (auto trIt = TransactionsIterator(*this, address); trIt.isValid(); trIt.next()) {
         if (offset > 0) {
             --offset;
@@ -632,13 +832,12 @@ bool BlockChain::findDataForTransactions(csdb::Address address, csdb::Address& w
     if (address.is_wallet_id()) {
         id = address.wallet_id();
 
-        const WalletData* wallDataPtr = walletsCacheUpdater_->findWallet(id);
-
-        if (!wallDataPtr) {
+        WalletsCache::WalletHead wallet;
+        if (!walletsCacheUpdater_->findWallet(id, wallet)) {
             return false;
         }
 
-        WalletsCache::convert(wallDataPtr->address_, wallPubKey);
+        WalletsCache::convert(wallet.address_, wallPubKey);
     }
     else
     {
@@ -808,13 +1007,70 @@ void BlockChain::addNewWalletsToPool(csdb::Pool& pool) {
 }
 
 void BlockChain::close() {
+    stopAddressIndexing();
+
     cs::Lock lock(dbLock_);
     storage_.close();
 }
 
 bool BlockChain::getTransaction(const csdb::Address& addr, const int64_t& innerId, csdb::Transaction& result) const {
+    // the address index knows the sources by their public keys
+    const csdb::Address key = addressIndex_ ? addressIndexKey(addr) : addr;
+
     cs::Lock lock(dbLock_);
-    return storage_.get_from_blockchain(addr, innerId, result);
+    return storage_.get_from_blockchain(key, innerId, result);
+}
+
+csdb::Address BlockChain::addressIndexKey(const csdb::Address& address) const {
+    if (address.is_public_key()) {
+        return address;
+    }
+
+    std::lock_guard lock(cacheMutex_);
+    return getAddressByType(address, AddressType::PublicKey);
+}
+
+void BlockChain::buildAddressIndex() {
+    // short enough not to hold the new blocks back
+    constexpr cs::Sequence kBlocksPerLock = 64;
+
+    const auto resolver = [this](const csdb::Address& address) { return addressIndexKey(address); };
+    auto reported = std::chrono::steady_clock::now();
+
+    while (!addressIndexQuit_) {
+        cs::Lock lock(dbLock_);
+
+        const cs::Sequence size = storage_.size();
+        cs::Sequence next = storage_.address_index_next();
+
+        if (next >= size) {
+            cslog() << "Blockchain: the address index is built up to block #" << size - 1;
+            return;
+        }
+
+        for (const cs::Sequence end = std::min(next + kBlocksPerLock, size); next < end; ++next) {
+            // the record numbers start from 1
+            const csdb::Pool pool = storage_.pool_load(next + 1);
+
+            if (!pool.is_valid() || !storage_.address_index_add(pool, resolver)) {
+                cserror() << "Blockchain: couldn't index the addresses of block #" << next << ", the address index is not used";
+                return;
+            }
+        }
+
+        if (std::chrono::steady_clock::now() - reported > std::chrono::seconds(10)) {
+            reported = std::chrono::steady_clock::now();
+            cslog() << "Blockchain: the address index is built up to block #" << next - 1 << " of " << size - 1;
+        }
+    }
+}
+
+void BlockChain::stopAddressIndexing() {
+    addressIndexQuit_ = true;
+
+    if (addressIndexThread_.joinable()) {
+        addressIndexThread_.join();
+    }
 }
 
 bool BlockChain::updateFromNextBlock(csdb::Pool& nextPool) {
@@ -833,6 +1089,9 @@ bool BlockChain::updateFromNextBlock(csdb::Pool& nextPool) {
         if (!blockHashes_->loadNextBlock(nextPool)) {
             cslog() << "Error writing DB structure";
         }
+        else if (snapshot_ && nextPool.sequence() % snapshotInterval_ == 0) {
+            saveSnapshot(nextPool.sequence(), nextPool.hash());
+        }
     }
     catch (std::exception& e) {
         cserror() << "Exc=" << e.what();
@@ -851,8 +1110,6 @@ bool BlockChain::findWalletData(const csdb::Address& address, WalletData& wallDa
         return findWalletData(address.wallet_id(), wallData);
     }
 
-    std::lock_guard lock(cacheMutex_);
-
     if (!walletIds_->normal().find(address, id)) {
         return false;
     }
@@ -861,19 +1118,34 @@ bool BlockChain::findWalletData(const csdb::Address& address, WalletData& wallDa
 }
 
 bool BlockChain::findWalletData(WalletId id, WalletData& wallData) const {
-    std::lock_guard lock(cacheMutex_);
     return findWalletData_Unsafe(id, wallData);
 }
 
 bool BlockChain::findWalletData_Unsafe(WalletId id, WalletData& wallData) const {
-    const WalletData* wallDataPtr = walletsCacheUpdater_->findWallet(id);
+    return walletsCacheUpdater_->findWallet(id, wallData);
+}
 
-    if (wallDataPtr) {
-        wallData = *wallDataPtr;
-        return true;
+bool BlockChain::findPublicKeys(const std::vector<csdb::Address>& addresses, std::vector<cs::PublicKey>& keys) const {
+    keys.resize(addresses.size());
+    bool found = true;
+    WalletsCache::WalletHead wallet;
+
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        if (!addresses[i].is_wallet_id()) {
+            keys[i] = addresses[i].public_key();
+            continue;
+        }
+
+        if (walletsCacheUpdater_->findWallet(addresses[i].wallet_id(), wallet)) {
+            keys[i] = wallet.address_;
+        }
+        else {
+            keys[i].fill(0);
+            found = false;
+        }
     }
 
-    return false;
+    return found;
 }
 
 bool BlockChain::getModifiedWallets(Mask& dest) const {
@@ -893,7 +1165,6 @@ bool BlockChain::findWalletId(const WalletAddress& address, WalletId& id) const
         return true;
     }
     else if (address.is_public_key()) {
-        std::lock_guard lock(cacheMutex_);
         return walletIds_->normal().find(address, id);
     }
 
@@ -948,6 +1219,13 @@ std::optional<csdb::Pool> BlockChain::recordBlock(csdb::Pool& pool, bool isTrust
 
             if (deferredBlock_.save()) {
                 flushed_block_seq = deferredBlock_.sequence();
+
+                // the background indexing picks the block up otherwise
+                if (addressIndex_ && storage_.address_index_next() == flushed_block_seq &&
+                    !storage_.address_index_add(deferredBlock_, [this](const csdb::Address& address) { return addressIndexKey(address); })) {
+                    cswarning() << "Blockchain: couldn't index the addresses of block #" << flushed_block_seq;
+                }
+
                 if (uuid_ == 0 && flushed_block_seq == 1) {
                     uuid_ = uuidFromBlock(deferredBlock_);
                     csdebug() << "Blockchain: UUID = " << uuid_;
@@ -1126,6 +1404,22 @@ void BlockChain::testCachedBlocks() {
     }
 }
 
+void BlockChain::beginBatch() {
+    cs::Lock lock(dbLock_);
+    storage_.begin_batch();
+}
+
+bool BlockChain::commitBatch() {
+    cs::Lock lock(dbLock_);
+
+    if (!storage_.commit_batch()) {
+        cserror() << "BLOCKCHAIN> failed to write blocks batch: " << storage_.last_error_message();
+        return false;
+    }
+
+    return true;
+}
+
 const cs::ReadBlockSignal& BlockChain::readBlockEvent() const {
     return storage_.readBlockEvent();
 }
@@ -1223,7 +1517,6 @@ bool BlockChain::isEqual(const csdb::Address& laddr, const csdb::Address& raddr)
 }
 
 uint32_t BlockChain::getTransactionsCount(const csdb::Address& addr) {
-    std::lock_guard lock(cacheMutex_);
     WalletId id;
 
     if (addr.is_wallet_id()) {
@@ -1234,13 +1527,12 @@ uint32_t BlockChain::getTransactionsCount(const csdb::Address& addr) {
         return 0;
     }
 
-    const WalletData* wallDataPtr = walletsCacheUpdater_->findWallet(id);
-
-    if (!wallDataPtr) {
+    WalletsCache::WalletHead wallet;
+    if (!walletsCacheUpdater_->findWallet(id, wallet)) {
         return 0;
     }
 
-    return static_cast<uint32_t>(wallDataPtr->transNum_);
+    return static_cast<uint32_t>(wallet.transNum_);
 }
 
 //uint64_t BlockChain::initUuid() const {
@@ -1274,13 +1566,13 @@ csdb::TransactionID BlockChain::getLastTransaction(const csdb::Address& addr) {
         return csdb::TransactionID();
     }
 
-    const WalletData* wallDataPtr = walletsCacheUpdater_->findWallet(id);
+    const csdb::TransactionID* lastTransaction = walletsCacheUpdater_->findLastTransaction(id);
 
-    if (!wallDataPtr) {
+    if (!lastTransaction) {
         return csdb::TransactionID();
     }
 
-    return wallDataPtr->lastTransaction_;
+    return *lastTransaction;
 }
 
 csdb::PoolHash BlockChain::getPreviousPoolHash(const csdb::Address& addr, const csdb::PoolHash& ph) {
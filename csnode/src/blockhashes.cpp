@@ -1,7 +1,25 @@
 #include <csnode/blockhashes.hpp>
+#include <csnode/datastream.hpp>
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <lib/system/logger.hpp>
+#include <lib/system/utils.hpp>
+
+namespace {
+constexpr size_t kMinSlotsCount = 1024;
+
+// the same layout as std::vector<csdb::PoolHash>
+template <typename Get>
+void serializeHashes(cs::DataStream& stream, size_t size, Get get) {
+    stream << size;
+
+    for (size_t i = 0; i < size; ++i) {
+        const cs::Hash hash = get(i);
+        stream << cs::BytesView(hash.data(), hash.size());
+    }
+}
+}  // namespace
 
 namespace cs {
 BlockHashes::BlockHashes()
@@ -22,21 +40,18 @@ bool BlockHashes::initFromPrevBlock(csdb::Pool prevBlock) {
         isDbInited_ = true;
     }
 
-    hashes_.emplace_back(prevBlock.hash());
-    return true;
+    return append(prevBlock.hash());
 }
 
 void BlockHashes::initFinish() {
-    if (hashes_.size() >= 2) {
-        size_t lh = 0;
-        size_t rh = hashes_.size() - 1;
-        while (lh < rh) {
-            std::swap(hashes_[lh++], hashes_[rh--]);
-        }
+    const size_t size = hashes_.size();
+    for (size_t i = 0; i < size / 2; ++i) {
+        std::swap(hashes_[i], hashes_[size - 1 - i]);
     }
+    rebuildIndex(slots_.size());
 
-    for (const auto& hash : hashes_) {
-        cslog() << "READ> " << hash.to_string();
+    for (size_t i = 0; i < size; ++i) {
+        cslog() << "READ> " << cs::Utils::byteStreamToHex(hashes_[i].data(), hashes_[i].size());
     }
 }
 
@@ -57,7 +72,10 @@ bool BlockHashes::loadNextBlock(csdb::Pool nextBlock) {
         return false;  // see BlockChain::putBlock
     }
 
-    hashes_.emplace_back(nextBlock.hash());
+    if (!append(nextBlock.hash())) {
+        return false;
+    }
+
     db_.last_ = seq;
     return true;
 }
@@ -70,38 +88,186 @@ csdb::PoolHash BlockHashes::find(cs::Sequence seq) const {
     if (seq < range.first_ || range.last_ < seq) {
         return csdb::PoolHash();
     }
-    return hashes_[seq];
+    return toPoolHash(hashes_[seq]);
 }
 
-cs::Sequence BlockHashes::find(csdb::PoolHash hash) const {
-    const auto result = std::find(hashes_.cbegin(), hashes_.cend(), hash);
+cs::Sequence BlockHashes::find(csdb::PoolHash poolHash) const {
+    cs::Hash hash;
+    if (slots_.empty() || !toHash(poolHash, hash)) {
+        return 0;
+    }
+
+    const uint64_t key = keyOf(hash);
+    const uint32_t tag = static_cast<uint32_t>(key >> 32);
+
+    for (size_t pos = key & mask_; slots_[pos].position != 0; pos = (pos + 1) & mask_) {
+        const Slot& slot = slots_[pos];
 
-    if (result != hashes_.cend()) {
-        return std::distance(hashes_.cbegin(), result);
+        if (slot.tag == tag && hashes_[slot.position - 1] == hash) {
+            return slot.position - 1;
+        }
     }
 
     return 0;
 }
 
 csdb::PoolHash BlockHashes::removeLast() {
-    if (hashes_.empty()) {
+    if (empty()) {
         return csdb::PoolHash{};
     }
-    const auto result = hashes_.back();
-    hashes_.pop_back();
+    const size_t last = hashes_.size() - 1;
+    eraseIndex(last);
+    const auto result = toPoolHash(hashes_[last]);
+    saveFrozen(frozen_, last, [this, last] { return hashes_[last]; });
+    hashes_.resize(last);
     --db_.last_;
     return result;
 }
 
 csdb::PoolHash BlockHashes::getLast() const {
-    if (hashes_.empty()) {
+    if (empty()) {
         return csdb::PoolHash{};
     }
-    return hashes_.back();
+    return toPoolHash(hashes_[hashes_.size() - 1]);
+}
+
+void BlockHashes::serialize(cs::DataStream& stream) const {
+    serializeHashes(stream, hashes_.size(), [this](size_t i) { return hashes_[i]; });
+}
+
+bool BlockHashes::deserialize(cs::DataStream& stream) {
+    std::size_t size = 0;
+    stream >> size;
+
+    WalletsStorage<cs::Hash> hashes;
+
+    for (std::size_t i = 0; i < size && stream.isValid(); ++i) {
+        cs::BytesView view;
+        stream >> view;
+
+        hashes.resize(i + 1);
+        if (view.size() != hashes[i].size()) {
+            return false;
+        }
+
+        std::copy(view.begin(), view.end(), hashes[i].begin());
+    }
+
+    if (!stream.isValid()) {
+        return false;
+    }
+
+    hashes_ = std::move(hashes);
+    rebuildIndex(0);
+    db_.first_ = 0;
+    db_.last_ = empty() ? 0 : cs::Sequence(hashes_.size() - 1);
+    isDbInited_ = !empty();
+    return true;
+}
+
+std::function<void(cs::DataStream&)> BlockHashes::freeze() {
+    auto frozen = std::make_shared<FrozenEntries<cs::Hash>>(hashes_.size());
+    frozen_.push_back(frozen);
+
+    return [this, frozen](cs::DataStream& stream) {
+        serializeHashes(stream, frozen->size(), [this, &frozen](size_t i) { return frozen->read(i, [this, i] { return *hashes_.find(i); }); });
+    };
+}
+
+bool BlockHashes::toHash(const csdb::PoolHash& poolHash, cs::Hash& hash) {
+    const cs::Bytes bytes = poolHash.to_binary();
+
+    if (bytes.size() != hash.size()) {
+        return false;
+    }
+
+    std::copy(bytes.begin(), bytes.end(), hash.begin());
+    return true;
+}
+
+csdb::PoolHash BlockHashes::toPoolHash(const cs::Hash& hash) {
+    return csdb::PoolHash::from_binary(cs::Bytes(hash.begin(), hash.end()));
+}
+
+uint64_t BlockHashes::keyOf(const cs::Hash& hash) {
+    // the hash is uniform already
+    uint64_t key;
+    std::memcpy(&key, hash.data(), sizeof(key));
+    return key;
+}
+
+bool BlockHashes::append(const csdb::PoolHash& poolHash) {
+    cs::Hash hash;
+
+    if (!toHash(poolHash, hash)) {
+        cserror() << "BlockHashes: block hash of invalid size " << poolHash.size();
+        return false;
+    }
+
+    const size_t position = hashes_.size();
+    hashes_.resize(position + 1);
+    hashes_[position] = hash;
+
+    // the load factor stays below 1/2
+    if (hashes_.size() * 2 > slots_.size()) {
+        rebuildIndex(slots_.size() * 2);
+    }
+    else {
+        insertIndex(position);
+    }
+
+    return true;
+}
+
+void BlockHashes::insertIndex(size_t position) {
+    const uint64_t key = keyOf(hashes_[position]);
+
+    size_t pos = key & mask_;
+    while (slots_[pos].position != 0) {
+        pos = (pos + 1) & mask_;
+    }
+
+    slots_[pos] = Slot{static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(position + 1)};
 }
 
-const std::vector<csdb::PoolHash>& BlockHashes::getHashes() const {
-    return hashes_;
+void BlockHashes::eraseIndex(size_t position) {
+    if (slots_.empty()) {
+        return;
+    }
+
+    size_t hole = keyOf(hashes_[position]) & mask_;
+    while (slots_[hole].position != position + 1) {
+        if (slots_[hole].position == 0) {
+            return;
+        }
+        hole = (hole + 1) & mask_;
+    }
+
+    // backward shift deletion keeps the probe sequences without tombstones
+    for (size_t pos = (hole + 1) & mask_; slots_[pos].position != 0; pos = (pos + 1) & mask_) {
+        const size_t home = keyOf(hashes_[slots_[pos].position - 1]) & mask_;
+
+        if (((pos - home) & mask_) >= ((pos - hole) & mask_)) {
+            slots_[hole] = slots_[pos];
+            hole = pos;
+        }
+    }
+
+    slots_[hole].position = 0;
+}
+
+void BlockHashes::rebuildIndex(size_t slotsCount) {
+    slotsCount = std::max(slotsCount, kMinSlotsCount);
+    while (slotsCount < hashes_.size() * 2) {
+        slotsCount *= 2;
+    }
+
+    slots_.assign(slotsCount, Slot{0, 0});
+    mask_ = slotsCount - 1;
+
+    for (size_t i = 0; i < hashes_.size(); ++i) {
+        insertIndex(i);
+    }
 }
 
 }  // namespace cs
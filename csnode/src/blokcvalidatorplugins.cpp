@@ -10,6 +10,8 @@
 #include <lib/system/common.hpp>
 #include <csnode/walletsstate.hpp>
 #include <csnode/walletscache.hpp>
+#include <csnode/signaturecache.hpp>
+#include <csnode/signatureverifier.hpp>
 #include <csdb/amount_commission.hpp>
 #include <csdb/pool.hpp>
 #include <cscrypto/cscrypto.hpp>
@@ -106,20 +108,21 @@ ValidationPlugin::ErrorType BlockSignaturesValidator::validateBlock(const csdb::
 
   size_t checkingSignature = 0;
   auto signedData = cscrypto::calculateHash(block.to_binary().data(), block.hashingLength());
+  SignatureItems items;
   for (size_t i = 0; i < confidants.size(); ++i) {
     if (realTrustedMask & (1ull << i)) {
-      if (!cscrypto::verifySignature(signatures[checkingSignature],
-                                     confidants[i],
-                                     signedData.data(),
-                                     cscrypto::kHashSize)) {
-        cserror() << kLogPrefix << "block " << block.sequence()
-                  << " has invalid signatures";
-        return ErrorType::error;
-      }
+      items.push_back(SignatureItem{signatures[checkingSignature].data(), confidants[i].data(),
+                                    signedData.data(), cscrypto::kHashSize});
       ++checkingSignature;
     }
   }
 
+  if (!SignatureVerifier::instance().verifyAll(items)) {
+    cserror() << kLogPrefix << "block " << block.sequence()
+              << " has invalid signatures";
+    return ErrorType::error;
+  }
+
   return ErrorType::noError;
 }
 
@@ -153,7 +156,14 @@ bool SmartSourceSignaturesValidator::checkSignatures(const SmartSignatures& sigs
     return false;
   }
 
-  for (const auto& pack : smartPacks) {
+  // the signatures of all the packs are checked at once, the init pools hold the confidants' keys till then
+  std::vector<csdb::Pool> initPools;
+  initPools.reserve(smartPacks.size());
+  SignatureItems items;
+  std::vector<std::pair<size_t, cs::Byte>> signers;  // the pack and the confidant of every item
+
+  for (size_t i = 0; i < smartPacks.size(); ++i) {
+    const auto& pack = smartPacks[i];
     auto it = std::find_if(sigs.begin(), sigs.end(),
                            [&pack] (const csdb::Pool::SmartSignature& s) {
                            return pack.transactions()[0].source().public_key() == s.smartKey; });
@@ -164,7 +174,8 @@ bool SmartSourceSignaturesValidator::checkSignatures(const SmartSignatures& sigs
       return false;
     }
 
-    auto initPool = getBlockChain().loadBlock(it->smartConsensusPool);
+    initPools.push_back(getBlockChain().loadBlock(it->smartConsensusPool));
+    const auto& initPool = initPools.back();
     const auto& confidants = initPool.confidants();
     const auto& smartSignatures = it->signatures;
     for (const auto& s : smartSignatures) {
@@ -173,15 +184,21 @@ bool SmartSourceSignaturesValidator::checkSignatures(const SmartSignatures& sigs
                   << s.first << " in init pool with sequence " << initPool.sequence();
         return false;
       }
-      if (!cscrypto::verifySignature(s.second, confidants[s.first], pack.hash().toBinary().data(), cscrypto::kHashSize)) {
-        cserror() << kLogPrefix << "incorrect signature of smart "
-                  << pack.transactions()[0].source().to_string() << " of confidant " << s.first
-                  << " from init pool with sequence " << initPool.sequence();
-        return false;
-      }
+      items.push_back(SignatureItem{s.second.data(), confidants[s.first].data(),
+                                    pack.hash().toBinary().data(), cscrypto::kHashSize});
+      signers.emplace_back(i, s.first);
     }
   }
 
+  size_t invalid = 0;
+  if (!SignatureVerifier::instance().verifyAll(items, &invalid)) {
+    const auto& signer = signers[invalid];
+    cserror() << kLogPrefix << "incorrect signature of smart "
+              << smartPacks[signer.first].transactions()[0].source().to_string() << " of confidant " << int(signer.second)
+              << " from init pool with sequence " << initPools[signer.first].sequence();
+    return false;
+  }
+
   return true;
 }
 
@@ -254,7 +271,10 @@ ValidationPlugin::ErrorType BalanceChecker::validateBlock(const csdb::Pool&) {
 ValidationPlugin::ErrorType TransactionsChecker::validateBlock(const csdb::Pool& block) {
   const auto& trxs = block.transactions();
   std::set<csdb::Address> newStates;
-  for (const auto& t : trxs) {
+  std::vector<size_t> checked;
+  std::vector<csdb::Address> sources;
+  for (size_t i = 0; i < trxs.size(); ++i) {
+    const auto& t = trxs[i];
     if (SmartContracts::is_new_state(t)) {
       // already checked by another plugin
       newStates.insert(t.source());
@@ -266,30 +286,39 @@ ValidationPlugin::ErrorType TransactionsChecker::validateBlock(const csdb::Pool&
       continue;
     }
 
-    if (!checkSignature(t)) {
-      cserror() << kLogPrefix << " in pool " << block.sequence()
-                << " transaction from " << t.source().to_string()
-                << ", with innerID " << t.innerID()
-                << " has incorrect signature";
-      return ErrorType::error;
-    }
+    checked.push_back(i);
+    sources.push_back(t.source());
   }
-  return ErrorType::noError;
-}
 
-bool TransactionsChecker::checkSignature(const csdb::Transaction& t) {
-  if (t.source().is_wallet_id()) {
-    const auto& bc = getBlockChain();
-    BlockChain::WalletData dataToFetchPublicKey;
-    if (!bc.findWalletData(t.source().wallet_id(), dataToFetchPublicKey)) {
-      cserror() << kLogPrefix << "no public key for id "
-                << t.source().wallet_id() << " in blockchain";
-      return false;
+  // the wallet ids are resolved under one lock
+  std::vector<cs::PublicKey> keys;
+  if (!getBlockChain().findPublicKeys(sources, keys)) {
+    for (size_t i = 0; i < sources.size(); ++i) {
+      if (sources[i].is_wallet_id() && keys[i] == cs::PublicKey{}) {
+        cserror() << kLogPrefix << "no public key for id "
+                  << sources[i].wallet_id() << " in blockchain";
+        break;
+      }
     }
-    return t.verify_signature(dataToFetchPublicKey.address_);
-  } else {
-    return t.verify_signature(t.source().public_key());
+    return ErrorType::error;
   }
+
+  TransactionsSignatures signatures;
+  for (size_t i = 0; i < checked.size(); ++i) {
+    signatures.add(trxs[checked[i]], keys[i]);
+  }
+
+  // most of them are verified already, when their packets came in or a replayed block was checked
+  size_t invalid = 0;
+  if (!SignatureVerifier::instance().verifyAll(signatures.items(), &invalid, &SignatureCache::instance())) {
+    const auto& t = trxs[checked[invalid]];
+    cserror() << kLogPrefix << " in pool " << block.sequence()
+              << " transaction from " << t.source().to_string()
+              << ", with innerID " << t.innerID()
+              << " has incorrect signature";
+    return ErrorType::error;
+  }
+  return ErrorType::noError;
 }
 
 } // namespace cs
@@ -104,16 +104,17 @@ void cs::ConveyerBase::addSeparatePacket(const cs::TransactionsPacket& packet) {
     pimpl_->packetQueue.push(packet);
 }
 
-void cs::ConveyerBase::addTransactionsPacket(const cs::TransactionsPacket& packet) {
+bool cs::ConveyerBase::addTransactionsPacket(const cs::TransactionsPacket& packet) {
     cs::TransactionsPacketHash hash = packet.hash();
     cs::Lock lock(sharedMutex_);
 
     if (auto iterator = pimpl_->packetsTable.find(hash); iterator == pimpl_->packetsTable.end()) {
         pimpl_->packetsTable.emplace(std::move(hash), packet);
+        return true;
     }
-    else {
-        csdebug() << csname() << "Same hash already exists at table: " << hash.toString();
-    }
+
+    csdebug() << csname() << "Same hash already exists at table: " << hash.toString();
+    return false;
 }
 
 const cs::TransactionsPacketTable& cs::ConveyerBase::transactionsPacketTable() const {
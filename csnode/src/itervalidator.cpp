@@ -1,7 +1,10 @@
 #include <csnode/itervalidator.hpp>
 
+#include <algorithm>
 #include <cstring>
 
+#include <csnode/signaturecache.hpp>
+#include <csnode/signatureverifier.hpp>
 #include <csnode/walletsstate.hpp>
 #include <smartcontracts.hpp>
 #include <solvercontext.hpp>
@@ -166,19 +169,45 @@ bool IterValidator::deployAdditionalCheck(SolverContext& context, size_t trxInd,
 
 void IterValidator::checkTransactionsSignatures(SolverContext& context, const Transactions& transactions, cs::Bytes& characteristicMask, Packets& smartsPackets) {
     checkSignaturesSmartSource(context, smartsPackets);
-    size_t transactionsCount = transactions.size();
-    size_t maskSize = characteristicMask.size();
+    const size_t count = std::min(transactions.size(), characteristicMask.size());
+    cs::Bytes correct(count, kInvalidMarker);
+
+    std::vector<size_t> signedBySources;
+    std::vector<csdb::Address> sources;
+    for (size_t i = 0; i < count; ++i) {
+        if (isSignedBySource(context, transactions[i])) {
+            signedBySources.push_back(i);
+            sources.push_back(transactions[i].source());
+        }
+        else {
+            correct[i] = checkSmartTransactionSignature(transactions[i]) ? kValidMarker : kInvalidMarker;
+        }
+    }
+
+    // an unknown wallet id gets a zeroed key, so its signature is rejected
+    std::vector<cs::PublicKey> keys;
+    context.blockchain().findPublicKeys(sources, keys);
+
+    TransactionsSignatures signatures;
+    for (size_t i = 0; i < signedBySources.size(); ++i) {
+        signatures.add(transactions[signedBySources[i]], keys[i]);
+    }
+
+    // the packets put the right signatures in the cache when they came in
+    cs::Bytes results;
+    SignatureVerifier::instance().verify(signatures.items(), results, &SignatureCache::instance());
+    for (size_t i = 0; i < signedBySources.size(); ++i) {
+        correct[signedBySources[i]] = results[i] ? kValidMarker : kInvalidMarker;
+    }
+
     size_t rejectedCounter = 0;
-    for (size_t i = 0; i < transactionsCount; ++i) {
-        if (i < maskSize) {
-            bool correctSignature = checkTransactionSignature(context, transactions[i]);
-            if (!correctSignature) {
-                characteristicMask[i] = kInvalidMarker;
-                rejectedCounter++;
-                cslog() << kLogPrefix << "transaction[" << i << "] rejected, incorrect signature.";
-                if (SmartContracts::is_new_state(transactions[i])) {
-                    pTransval_->addRejectedNewState(context.smart_contracts().absolute_address(transactions[i].source()));
-                }
+    for (size_t i = 0; i < count; ++i) {
+        if (correct[i] == kInvalidMarker) {
+            characteristicMask[i] = kInvalidMarker;
+            rejectedCounter++;
+            cslog() << kLogPrefix << "transaction[" << i << "] rejected, incorrect signature.";
+            if (SmartContracts::is_new_state(transactions[i])) {
+                pTransval_->addRejectedNewState(context.smart_contracts().absolute_address(transactions[i].source()));
             }
         }
     }
@@ -187,9 +216,7 @@ void IterValidator::checkTransactionsSignatures(SolverContext& context, const Tr
     }
 }
 
-bool IterValidator::checkTransactionSignature(SolverContext& context, const csdb::Transaction& transaction) {
-    BlockChain::WalletData data_to_fetch_pulic_key;
-    csdb::Address src = transaction.source();
+bool IterValidator::isSignedBySource(SolverContext& context, const csdb::Transaction& transaction) {
     // TODO: is_known_smart_contract() does not recognize not yet deployed contract, so all transactions emitted in constructor
     // currently will be rejected
     bool smartSourceTransaction = false;
@@ -197,26 +224,21 @@ bool IterValidator::checkTransactionSignature(SolverContext& context, const csdb
     if (!isSmart) {
         smartSourceTransaction = context.smart_contracts().is_known_smart_contract(transaction.source());
     }
-    if (!SmartContracts::is_new_state(transaction) && !smartSourceTransaction) {
-        if (src.is_wallet_id()) {
-            context.blockchain().findWalletData(src.wallet_id(), data_to_fetch_pulic_key);
-            return transaction.verify_signature(data_to_fetch_pulic_key.address_);
-        }
-        return transaction.verify_signature(src.public_key());
+    return !SmartContracts::is_new_state(transaction) && !smartSourceTransaction;
+}
+
+bool IterValidator::checkSmartTransactionSignature(const csdb::Transaction& transaction) {
+    // special rule for new_state transactions
+    if (SmartContracts::is_new_state(transaction) && transaction.source() != transaction.target()) {
+        csdebug() << kLogPrefix << "smart state transaction has different source and target";
+        return false;
     }
-    else {
-        // special rule for new_state transactions
-        if (SmartContracts::is_new_state(transaction) && src != transaction.target()) {
-            csdebug() << kLogPrefix << "smart state transaction has different source and target";
-            return false;
-        }
-        auto it = smartSourceInvalidSignatures_.find(transaction.source());
-        if (it != smartSourceInvalidSignatures_.end()) {
-            csdebug() << kLogPrefix << "smart contract transaction has invalid signature";
-            return false;
-        }
-        return true;
+    auto it = smartSourceInvalidSignatures_.find(transaction.source());
+    if (it != smartSourceInvalidSignatures_.end()) {
+        csdebug() << kLogPrefix << "smart contract transaction has invalid signature";
+        return false;
     }
+    return true;
 }
 
 void IterValidator::checkSignaturesSmartSource(SolverContext& context, cs::Packets& smartContractsPackets) {
@@ -248,16 +270,17 @@ void IterValidator::checkSignaturesSmartSource(SolverContext& context, cs::Packe
 
             const auto& confidants = poolWithInitTr.confidants();
             const auto& signatures = smartContractPacket.signatures();
-            size_t correctSignaturesCounter = 0;
+            const cs::Byte* signedHash = smartContractPacket.hash().toBinary().data();
+            SignatureItems items;
             for (const auto& signature : signatures) {
                 if (signature.first < confidants.size()) {
-                    const auto& confidantPublicKey = confidants[signature.first];
-                    const cs::Byte* signedHash = smartContractPacket.hash().toBinary().data();
-                    if (cscrypto::verifySignature(signature.second, confidantPublicKey, signedHash, cscrypto::kHashSize)) {
-                        ++correctSignaturesCounter;
-                    }
+                    items.push_back(SignatureItem{signature.second.data(), confidants[signature.first].data(), signedHash, cscrypto::kHashSize});
                 }
             }
+
+            cs::Bytes results;
+            SignatureVerifier::instance().verify(items, results);
+            const size_t correctSignaturesCounter = static_cast<size_t>(std::count(results.begin(), results.end(), kValidMarker));
             if (correctSignaturesCounter < confidants.size() / 2U + 1U) {
                 cslog() << kLogPrefix << "is not enough valid signatures";
                 smartSourceInvalidSignatures_.insert(transaction.source());
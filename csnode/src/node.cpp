@@ -3,6 +3,7 @@
 #include <numeric>
 #include <sstream>
 
+#include <solver/smartcontracts.hpp>
 #include <solver/solvercore.hpp>
 
 #include <csnode/conveyer.hpp>
@@ -11,6 +12,8 @@
 #include <csnode/nodecore.hpp>
 #include <csnode/nodeutils.hpp>
 #include <csnode/poolsynchronizer.hpp>
+#include <csnode/signaturecache.hpp>
+#include <csnode/signatureverifier.hpp>
 
 #include <lib/system/logger.hpp>
 #include <lib/system/progressbar.hpp>
@@ -78,7 +81,7 @@ bool Node::init(const Config& config) {
     cs::Connector::connect(&blockChain_.storeBlockEvent, api_.get(), &csconnector::connector::onStoreBlock);
 #endif  // NODE_API
 
-    if (!blockChain_.init(config.getPathToDB())) {
+    if (!blockChain_.init(config.getPathToDB(), config.getDatabaseSettings())) {
         return false;
     }
     cslog() << "Blockchain is ready, contains " << WithDelimiters(stat_.total_transactions()) << " transactions";
@@ -736,7 +739,43 @@ void Node::processPacketsReply(cs::Packets&& packets, const cs::RoundNumber roun
 }
 
 void Node::processTransactionsPacket(cs::TransactionsPacket&& packet) {
-    cs::Conveyer::instance().addTransactionsPacket(packet);
+    // the signatures are verified ahead of the consensus by the verifier workers, off the network thread;
+    // the characteristic and the block validation find them in the cache
+    const auto& transactions = packet.transactions();
+    std::vector<csdb::Address> sources;
+    sources.reserve(transactions.size());
+
+    for (const auto& transaction : transactions) {
+        sources.push_back(transaction.source());
+    }
+
+    std::vector<cs::PublicKey> keys;
+    blockChain_.findPublicKeys(sources, keys);
+
+    auto signatures = std::make_shared<cs::TransactionsSignatures>();
+
+    for (size_t i = 0; i < transactions.size(); ++i) {
+        // the new states are checked by the signatures of the confidants, an unknown wallet can not be checked yet
+        if (!SmartContracts::is_new_state(transactions[i]) && keys[i] != cs::PublicKey{}) {
+            signatures->add(transactions[i], keys[i]);
+        }
+    }
+
+    // the conveyer gets the packet once it is checked, a packet with a wrong signature is dropped;
+    // a round needing it requests it from the writer then
+    auto handler = [packet = std::move(packet)](const cs::Bytes& results) {
+        const auto wrong = std::count(results.begin(), results.end(), cs::Byte(0));
+
+        if (wrong != 0) {
+            cswarning() << "NODE> transactions packet " << packet.hash().toString() << " has " << wrong << " wrong signatures, dropped";
+            return;
+        }
+
+        cs::Conveyer::instance().addTransactionsPacket(packet);
+    };
+
+    const auto& items = signatures->items();
+    cs::SignatureVerifier::instance().verifyAsync(items, std::move(signatures), std::move(handler), &cs::SignatureCache::instance());
 }
 
 void Node::reviewConveyerHashes() {
@@ -766,6 +805,10 @@ std::optional<cs::TrustedConfirmation> Node::getConfirmation(cs::RoundNumber rou
     return confirmationList_.find(round);
 }
 
+std::vector<Neighbourhood::NeighbourMetrics> Node::getNeighboursMetrics() const {
+    return transport_->getNeighboursMetrics();
+}
+
 void Node::processTimer() {
     cs::Conveyer& conveyer = cs::Conveyer::instance();
     const auto round = conveyer.currentRoundNumber();
@@ -1150,7 +1193,14 @@ void Node::sendBroadcastImpl(const MsgTypes& msgType, const cs::RoundNumber roun
 }
 
 RegionPtr Node::compressPoolsBlock(const cs::PoolsBlock& poolsBlock, std::size_t& realBinSize) {
+    // the stored pools are copied into the stream as they are, without decoding their transactions
+    std::size_t reserved = sizeof(std::size_t);
+    for (const auto& pool : poolsBlock) {
+        reserved += sizeof(std::size_t) + pool.binary_view().size();
+    }
+
     cs::Bytes bytes;
+    bytes.reserve(reserved);
     cs::DataStream stream(bytes);
 
     stream << poolsBlock;
@@ -1182,14 +1232,20 @@ cs::PoolsBlock Node::decompressPoolsBlock(const uint8_t* data, const size_t size
     std::uint32_t compressSize = 0;
     istream_ >> compressSize;
 
-    RegionPtr memPtr = allocator_.allocateNext(compressSize);
-    istream_ >> memPtr;
+    // decompress right from the message data, without a staging copy
+    const char* compressed = reinterpret_cast<const char*>(istream_.getCurrentPtr());
+    istream_.safeSkip<cs::Byte>(compressSize);
+
+    if (!istream_.good()) {
+        csmeta(cserror) << "Malformed pools block";
+        return cs::PoolsBlock();
+    }
 
     cs::Bytes bytes;
     bytes.resize(realBinSize);
     char* bytesData = reinterpret_cast<char*>(bytes.data());
 
-    const int uncompressedSize = LZ4_decompress_safe(static_cast<char*>(memPtr.get()), bytesData, cs::numeric_cast<int>(compressSize), cs::numeric_cast<int>(realBinSize));
+    const int uncompressedSize = LZ4_decompress_safe(compressed, bytesData, cs::numeric_cast<int>(compressSize), cs::numeric_cast<int>(realBinSize));
 
     if (uncompressedSize < 0) {
         csmeta(cserror) << "Decompress poools block error";
@@ -2174,7 +2230,7 @@ void Node::prepareRoundTable(cs::RoundTable& roundTable, const cs::PoolMetaInfo&
 
     st3.print();
 }
-bool Node::receivingSignatures(const cs::Bytes& sigBytes, const cs::Bytes& roundBytes, const cs::RoundNumber rNum, const cs::Bytes& trustedMask,
+bool Node::receivingSignatures(const cs::BytesView& sigBytes, const cs::BytesView& roundBytes, const cs::RoundNumber rNum, const cs::Bytes& trustedMask,
                                const cs::ConfidantsKeys& newConfidants, cs::Signatures& poolSignatures) {
     cs::Conveyer& conveyer = cs::Conveyer::instance();
     cs::ConfidantsKeys currentConfidants = conveyer.confidants();
@@ -2248,7 +2304,8 @@ void Node::getRoundTable(const uint8_t* data, const size_t size, const cs::Round
         return;
     }
 
-    cs::Bytes roundBytes;
+    // views into the message data, the round table is not copied out of it
+    cs::BytesView roundBytes;
     istream_ >> roundBytes;
 
     if (!istream_.good()) {
@@ -2256,7 +2313,7 @@ void Node::getRoundTable(const uint8_t* data, const size_t size, const cs::Round
         return;
     }
 
-    cs::Bytes bytes;
+    cs::BytesView bytes;
     istream_ >> bytes;
 
     if (!istream_.good()) {
@@ -2540,8 +2597,8 @@ void Node::onRoundStart(const cs::RoundTable& roundTable) {
     csdebug() << " Node key " << cs::Utils::byteStreamToHex(nodeIdKey_);
     cslog() << " Last written sequence = " << WithDelimiters(blockChain_.getLastSequence()) << ", neighbours = " << transport_->getNeighboursCount();
 
-    if (Transport::cntCorruptedFragments > 0 || Transport::cntDirtyAllocs > 0 || Transport::cntExtraLargeNotSent > 0) {
-        cslog() << " ! " << Transport::cntDirtyAllocs << " / " << Transport::cntCorruptedFragments << " / " << Transport::cntExtraLargeNotSent;
+    if (Transport::cntExtraLargeNotSent > 0) {
+        cslog() << " ! " << Transport::cntExtraLargeNotSent;
     }
 
     std::ostringstream line2;
@@ -2570,6 +2627,13 @@ void Node::onRoundStart(const cs::RoundTable& roundTable) {
     stat_.onRoundStart(cs::Conveyer::instance().currentRoundNumber());
     csdebug() << line2.str();
 
+    if (cs::Conveyer::instance().currentRoundNumber() % 100 == 0) {
+        const auto stats = cs::SignatureCache::instance().stats();
+        const uint64_t lookups = std::max<uint64_t>(stats.hits + stats.misses, 1);
+        csdebug() << "NODE> signature cache: " << stats.size << " signatures, " << stats.hits << " hits, " << stats.misses << " misses ("
+                  << stats.hits * 100 / lookups << "% hit rate), " << stats.evictions << " evictions";
+    }
+
     solver_->nextRound();
 
     if (!sendingTimer_.isRunning()) {
@@ -1,5 +1,7 @@
 #include "poolsynchronizer.hpp"
 
+#include <chrono>
+
 #include <lib/system/logger.hpp>
 #include <lib/system/progressbar.hpp>
 #include <lib/system/utils.hpp>
@@ -137,6 +139,10 @@ void cs::PoolSynchronizer::getBlockReply(cs::PoolsBlock&& poolsBlock, std::size_
     // TODO Think, do really need this here?!
     // refreshNeighbours();
 
+    // the whole reply goes to the database in one transaction
+    const auto start = std::chrono::steady_clock::now();
+    blockChain_->beginBatch();
+
     for (auto& pool : poolsBlock) {
         const auto sequence = pool.sequence();
 
@@ -157,6 +163,15 @@ void cs::PoolSynchronizer::getBlockReply(cs::PoolsBlock&& poolsBlock, std::size_
         }
     }
 
+    blockChain_->commitBatch();
+
+    if (lastWrittenSequence > oldLastWrittenSequence) {
+        const auto written = lastWrittenSequence - oldLastWrittenSequence;
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        csdebug() << "SYNC> " << written << " blocks written in " << elapsed << " us, "
+                  << (elapsed > 0 ? written * 1000000 / static_cast<uint64_t>(elapsed) : written) << " blocks/s";
+    }
+
     if (oldCachedBlocksSize != blockChain_->getCachedBlocksSize() || oldLastWrittenSequence != lastWrittenSequence) {
         const bool isFinished = showSyncronizationProgress(lastWrittenSequence);
         if (isFinished) {
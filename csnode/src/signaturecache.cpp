@@ -0,0 +1,107 @@
+#include <csnode/signaturecache.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <csnode/signatureverifier.hpp>
+#include <lib/system/hash.hpp>
+
+namespace {
+// about 25 MB, several full blocks of transactions
+constexpr size_t kCapacity = 1 << 18;
+}  // namespace
+
+namespace cs {
+
+SignatureCache& SignatureCache::instance() {
+    static SignatureCache cache(kCapacity);
+    return cache;
+}
+
+SignatureCache::SignatureCache(size_t capacity, size_t shards)
+: shardCapacity_(std::max<size_t>(capacity / std::max<size_t>(shards, 1), 1)) {
+    shards = std::max<size_t>(shards, 1);
+
+    for (size_t i = 0; i < shards; ++i) {
+        shards_.emplace_back(new Shard);
+    }
+}
+
+cs::Hash SignatureCache::key(const SignatureItem& item) {
+    thread_local cs::Bytes buffer;
+    buffer.resize(item.size + cscrypto::kSignatureSize + cscrypto::kPublicKeySize);
+
+    std::memcpy(buffer.data(), item.data, item.size);
+    std::memcpy(buffer.data() + item.size, item.signature, cscrypto::kSignatureSize);
+    std::memcpy(buffer.data() + item.size + cscrypto::kSignatureSize, item.publicKey, cscrypto::kPublicKeySize);
+
+    return generateHash(buffer.data(), buffer.size());
+}
+
+size_t SignatureCache::Hasher::operator()(const cs::Hash& hash) const noexcept {
+    // the hash is already uniform
+    size_t result;
+    std::memcpy(&result, hash.data(), sizeof(result));
+    return result;
+}
+
+SignatureCache::Shard& SignatureCache::shardOf(const cs::Hash& key) {
+    // the bytes past the ones Hasher takes, so a shard still has its keys spread over the buckets
+    uint64_t index;
+    std::memcpy(&index, key.data() + sizeof(index), sizeof(index));
+    return *shards_[static_cast<size_t>(index % shards_.size())];
+}
+
+bool SignatureCache::contains(const cs::Hash& key) {
+    Shard& shard = shardOf(key);
+    std::lock_guard lock(shard.lock);
+
+    if (shard.keys.count(key)) {
+        ++shard.hits;
+        return true;
+    }
+
+    ++shard.misses;
+    return false;
+}
+
+void SignatureCache::insert(const cs::Hash& key) {
+    Shard& shard = shardOf(key);
+    std::lock_guard lock(shard.lock);
+
+    if (!shard.keys.insert(key).second) {
+        return;
+    }
+
+    shard.order.push_back(key);
+
+    while (shard.order.size() > shardCapacity_) {
+        shard.keys.erase(shard.order.front());
+        shard.order.pop_front();
+        ++shard.evictions;
+    }
+}
+
+void SignatureCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard lock(shard->lock);
+        shard->keys.clear();
+        shard->order.clear();
+    }
+}
+
+SignatureCache::Stats SignatureCache::stats() const {
+    Stats result;
+
+    for (const auto& shard : shards_) {
+        std::lock_guard lock(shard->lock);
+        result.hits += shard->hits;
+        result.misses += shard->misses;
+        result.evictions += shard->evictions;
+        result.size += shard->keys.size();
+    }
+
+    return result;
+}
+
+}  // namespace cs
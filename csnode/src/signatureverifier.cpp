@@ -0,0 +1,261 @@
+#include <csnode/signatureverifier.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+#include <cscrypto/cscrypto.hpp>
+#include <csnode/signaturecache.hpp>
+
+namespace {
+// a chunk takes about half a millisecond to check
+constexpr size_t kChunkSize = 8;
+}  // namespace
+
+namespace cs {
+
+void TransactionsSignatures::add(const csdb::Transaction& transaction, const cs::PublicKey& key) {
+    // the deques keep the elements in place while growing
+    messages_.push_back(transaction.to_byte_stream_for_sig());
+    signatures_.push_back(transaction.signature());
+    keys_.push_back(key);
+
+    items_.push_back(SignatureItem{signatures_.back().data(), keys_.back().data(), messages_.back().data(), messages_.back().size()});
+}
+
+struct SignatureVerifier::Batch {
+    const SignatureItem* items = nullptr;
+    cs::Byte* results = nullptr;
+    size_t count = 0;
+    size_t chunks = 0;
+    bool stopOnInvalid = false;
+    SignatureCache* cache = nullptr;
+
+    std::atomic<size_t> next{0};     // the next chunk to take
+    std::atomic<size_t> invalid{0};  // the lowest index of a wrong signature found so far, count if none
+    std::atomic<size_t> done{0};     // the chunks checked or skipped
+
+    std::mutex lock;
+    std::condition_variable finished;
+
+    // a batch of verifyAsync() owns the items and the results, the handler takes the place of the waiting caller
+    SignatureItems ownItems;
+    cs::Bytes ownResults;
+    std::shared_ptr<const void> holder;
+    Handler handler;
+};
+
+SignatureVerifier& SignatureVerifier::instance() {
+    static SignatureVerifier verifier(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    return verifier;
+}
+
+SignatureVerifier::SignatureVerifier(size_t workers) {
+    for (size_t i = 0; i < workers; ++i) {
+        threads_.emplace_back(&SignatureVerifier::work, this);
+    }
+}
+
+SignatureVerifier::~SignatureVerifier() {
+    {
+        std::lock_guard lock(lock_);
+        quit_ = true;
+    }
+
+    newBatch_.notify_all();
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void SignatureVerifier::verify(const SignatureItems& items, cs::Bytes& results, SignatureCache* cache) {
+    results.assign(items.size(), 0);
+    run(items, results.data(), false, nullptr, cache);
+}
+
+bool SignatureVerifier::verifyAll(const SignatureItems& items, size_t* invalid, SignatureCache* cache) {
+    cs::Bytes results(items.size(), 0);
+    return run(items, results.data(), true, invalid, cache);
+}
+
+void SignatureVerifier::verifyChunk(const SignatureItem* items, size_t count, cs::Byte* results) {
+    for (size_t i = 0; i < count; ++i) {
+        results[i] = cscrypto::verifySignature(items[i].signature, items[i].publicKey, items[i].data, items[i].size) ? 1 : 0;
+    }
+}
+
+void SignatureVerifier::verifyChunk(const SignatureItem* items, size_t count, cs::Byte* results, SignatureCache& cache) {
+    cs::Hash keys[kChunkSize];
+    SignatureItem missed[kChunkSize];
+    size_t missedIndexes[kChunkSize];
+    size_t missedCount = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] = SignatureCache::key(items[i]);
+
+        if (cache.contains(keys[i])) {
+            results[i] = 1;
+        }
+        else {
+            missed[missedCount] = items[i];
+            missedIndexes[missedCount] = i;
+            ++missedCount;
+        }
+    }
+
+    cs::Byte missedResults[kChunkSize];
+    verifyChunk(missed, missedCount, missedResults);
+
+    for (size_t i = 0; i < missedCount; ++i) {
+        const size_t index = missedIndexes[i];
+        results[index] = missedResults[i];
+
+        if (missedResults[i]) {
+            cache.insert(keys[index]);
+        }
+    }
+}
+
+void SignatureVerifier::verifyAsync(const SignatureItems& items, std::shared_ptr<const void> holder, Handler handler, SignatureCache* cache) {
+    if (items.empty() || threads_.empty()) {
+        cs::Bytes results;
+        verify(items, results, cache);
+        handler(results);
+        return;
+    }
+
+    auto batch = makeBatch(nullptr, items.size(), nullptr, cache);
+    batch->ownItems = items;
+    batch->ownResults.assign(items.size(), 0);
+    batch->items = batch->ownItems.data();
+    batch->results = batch->ownResults.data();
+    batch->holder = std::move(holder);
+    batch->handler = std::move(handler);
+
+    {
+        std::lock_guard lock(lock_);
+        batches_.push_back(batch);
+    }
+
+    newBatch_.notify_all();
+}
+
+std::shared_ptr<SignatureVerifier::Batch> SignatureVerifier::makeBatch(const SignatureItem* items, size_t count, cs::Byte* results, SignatureCache* cache) {
+    auto batch = std::make_shared<Batch>();
+    batch->items = items;
+    batch->results = results;
+    batch->count = count;
+    batch->chunks = (count + kChunkSize - 1) / kChunkSize;
+    batch->cache = cache;
+    batch->invalid = count;
+    return batch;
+}
+
+bool SignatureVerifier::run(const SignatureItems& items, cs::Byte* results, bool stopOnInvalid, size_t* invalid, SignatureCache* cache) {
+    if (items.empty()) {
+        return true;
+    }
+
+    auto batch = makeBatch(items.data(), items.size(), results, cache);
+    batch->stopOnInvalid = stopOnInvalid;
+
+    if (batch->chunks > 1 && !threads_.empty()) {
+        {
+            std::lock_guard lock(lock_);
+            batches_.push_back(batch);
+        }
+
+        newBatch_.notify_all();
+    }
+
+    // the calling thread takes the chunks as well, so it never waits for the workers doing other batches
+    process(*batch);
+
+    {
+        std::unique_lock lock(batch->lock);
+        batch->finished.wait(lock, [&batch]() { return batch->done == batch->chunks; });
+    }
+
+    const size_t found = batch->invalid;
+    if (found == items.size()) {
+        return true;
+    }
+
+    if (invalid) {
+        *invalid = found;
+    }
+
+    return false;
+}
+
+void SignatureVerifier::work() {
+    while (true) {
+        std::shared_ptr<Batch> batch;
+
+        {
+            std::unique_lock lock(lock_);
+            newBatch_.wait(lock, [this]() { return quit_ || !batches_.empty(); });
+
+            if (quit_) {
+                return;
+            }
+
+            batch = batches_.front();
+
+            // all its chunks are taken, the caller may have returned already
+            if (batch->next >= batch->chunks) {
+                batches_.pop_front();
+                continue;
+            }
+        }
+
+        process(*batch);
+    }
+}
+
+void SignatureVerifier::process(Batch& batch) {
+    while (true) {
+        const size_t chunk = batch.next++;
+
+        if (chunk >= batch.chunks) {
+            return;
+        }
+
+        const size_t begin = chunk * kChunkSize;
+        const size_t end = std::min(begin + kChunkSize, batch.count);
+
+        // a wrong signature before the chunk decides the result already
+        if (!batch.stopOnInvalid || begin < batch.invalid) {
+            if (batch.cache) {
+                verifyChunk(batch.items + begin, end - begin, batch.results + begin, *batch.cache);
+            }
+            else {
+                verifyChunk(batch.items + begin, end - begin, batch.results + begin);
+            }
+
+            for (size_t i = begin; i < end; ++i) {
+                if (batch.results[i]) {
+                    continue;
+                }
+
+                size_t current = batch.invalid;
+                while (i < current && !batch.invalid.compare_exchange_weak(current, i)) {
+                }
+
+                break;
+            }
+        }
+
+        if (++batch.done == batch.chunks) {
+            if (batch.handler) {
+                batch.handler(batch.ownResults);
+                return;
+            }
+
+            std::lock_guard lock(batch.lock);
+            batch.finished.notify_all();
+        }
+    }
+}
+
+}  // namespace cs
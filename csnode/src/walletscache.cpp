@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <blockchain.hpp>
 #include <csdb/amount_commission.hpp>
+#include <csnode/datastream.hpp>
 #include <csnode/walletscache.hpp>
 #include <csnode/walletsids.hpp>
 #include <lib/system/logger.hpp>
@@ -11,6 +12,59 @@ using namespace std;
 namespace {
 const uint8_t kUntrustedMarker = 255;
 
+// the tail is a fixed size bit heap, it is written as is
+static_assert(std::is_trivially_copyable_v<cs::TransactionsTail>, "TransactionsTail is expected to be trivially copyable");
+
+void serializeTransactions(cs::DataStream& stream, const std::list<csdb::Transaction>& transactions) {
+    stream << transactions.size();
+
+    for (const auto& transaction : transactions) {
+        stream << transaction.to_byte_stream();
+    }
+}
+
+bool deserializeTransactions(cs::DataStream& stream, std::list<csdb::Transaction>& transactions) {
+    std::size_t size = 0;
+    stream >> size;
+
+    for (std::size_t i = 0; i < size && stream.isValid(); ++i) {
+        cs::Bytes bytes;
+        stream >> bytes;
+
+        auto transaction = csdb::Transaction::from_byte_stream(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        if (!transaction.is_valid()) {
+            return false;
+        }
+
+        transactions.push_back(std::move(transaction));
+    }
+
+    return stream.isValid();
+}
+
+// the wallets by id, get gives a wallet if there is one
+template <typename Get>
+void serializeWallets(cs::DataStream& stream, size_t size, Get get) {
+    stream << size;
+
+    for (cs::WalletsCache::WalletId id = 0; id < size; ++id) {
+        const std::optional<cs::WalletsCache::WalletData> wallet = get(id);
+        stream << static_cast<uint8_t>(wallet.has_value());
+        if (!wallet) {
+            continue;
+        }
+
+        stream << wallet->address_ << wallet->balance_;
+        stream.addValue(wallet->trxTail_);
+        stream << wallet->transNum_;
+#ifdef MONITOR_NODE
+        stream << wallet->createTime_;
+#endif
+#ifdef TRANSACTIONS_INDEX
+        stream << wallet->lastTransaction_.pool_hash() << wallet->lastTransaction_.index();
+#endif
+    }
+}
 }  // namespace
 
 namespace cs {
@@ -30,10 +84,7 @@ WalletsCache::WalletsCache(const Config& config, csdb::Address genesisAddress, c
     wallets_.reserve(config.initialWalletsNum_);
 }
 
-WalletsCache::~WalletsCache() {
-    for (auto el : wallets_)
-        delete el;
-}
+WalletsCache::~WalletsCache() = default;
 
 std::unique_ptr<WalletsCache::Initer> WalletsCache::createIniter() {
     return std::unique_ptr<Initer>(new Initer(*this));
@@ -43,6 +94,108 @@ std::unique_ptr<WalletsCache::Updater> WalletsCache::createUpdater() {
     return std::unique_ptr<Updater>(new Updater(*this));
 }
 
+void WalletsCache::serialize(cs::DataStream& stream) const {
+    serializeWallets(stream, wallets_.size(), [this](WalletId id) {
+        WalletData wallet;
+        return wallets_.load(id, wallet) ? std::make_optional(wallet) : std::nullopt;
+    });
+
+#ifdef MONITOR_NODE
+    serializeRest(stream, smartPayableTransactions_, closedSmarts_, trusted_info_);
+#else
+    serializeRest(stream, smartPayableTransactions_, closedSmarts_, TrustedInfo{});
+#endif
+}
+
+std::function<void(cs::DataStream&)> WalletsCache::freeze() {
+    // the rest is short, it is copied
+    TrustedInfo trustedInfo;
+#ifdef MONITOR_NODE
+    trustedInfo = trusted_info_;
+#endif
+
+    return [this, wallets = wallets_.freeze(), smartPayableTransactions = smartPayableTransactions_, closedSmarts = closedSmarts_,
+            trustedInfo = std::move(trustedInfo)](cs::DataStream& stream) {
+        serializeWallets(stream, wallets->size(), [this, &wallets](WalletId id) { return wallets_.read(*wallets, id); });
+        serializeRest(stream, smartPayableTransactions, closedSmarts, trustedInfo);
+    };
+}
+
+void WalletsCache::serializeRest(cs::DataStream& stream, const std::list<csdb::Transaction>& smartPayableTransactions, const std::list<csdb::Transaction>& closedSmarts,
+                                 [[maybe_unused]] const TrustedInfo& trustedInfo) {
+    serializeTransactions(stream, smartPayableTransactions);
+    serializeTransactions(stream, closedSmarts);
+
+#ifdef MONITOR_NODE
+    stream << trustedInfo.size();
+    for (const auto& [address, data] : trustedInfo) {
+        stream << address << data.times << data.times_trusted << data.totalFee;
+    }
+#endif
+}
+
+bool WalletsCache::deserialize(cs::DataStream& stream) {
+    std::size_t size = 0;
+    stream >> size;
+
+    Wallets wallets;
+    wallets.reserve(std::max(size, config_.initialWalletsNum_));
+    wallets.resize(size);
+
+    for (std::size_t i = 0; i < size && stream.isValid(); ++i) {
+        uint8_t exists = 0;
+        stream >> exists;
+        if (!exists) {
+            continue;
+        }
+
+        WalletData wallet;
+        stream >> wallet.address_ >> wallet.balance_;
+        wallet.trxTail_ = stream.parseValue<TransactionsTail>();
+        stream >> wallet.transNum_;
+#ifdef MONITOR_NODE
+        stream >> wallet.createTime_;
+#endif
+#ifdef TRANSACTIONS_INDEX
+        csdb::PoolHash hash;
+        cs::Sequence index = 0;
+        stream >> hash >> index;
+        if (!hash.is_empty()) {
+            wallet.lastTransaction_ = csdb::TransactionID(hash, index);
+        }
+#endif
+        wallets.store(static_cast<WalletId>(i), wallet);
+    }
+
+    std::list<csdb::Transaction> smartPayableTransactions;
+    std::list<csdb::Transaction> closedSmarts;
+    if (!stream.isValid() || !deserializeTransactions(stream, smartPayableTransactions) || !deserializeTransactions(stream, closedSmarts)) {
+        return false;
+    }
+
+#ifdef MONITOR_NODE
+    TrustedInfo trustedInfo;
+    stream >> size;
+    for (std::size_t i = 0; i < size && stream.isValid(); ++i) {
+        WalletData::Address address{};
+        TrustedData data;
+        stream >> address >> data.times >> data.times_trusted >> data.totalFee;
+        trustedInfo.emplace(address, data);
+    }
+
+    if (!stream.isValid()) {
+        return false;
+    }
+
+    trusted_info_ = std::move(trustedInfo);
+#endif
+
+    wallets_ = std::move(wallets);
+    smartPayableTransactions_ = std::move(smartPayableTransactions);
+    closedSmarts_ = std::move(closedSmarts);
+    return true;
+}
+
 // Initer
 WalletsCache::Initer::Initer(WalletsCache& data)
 : ProcessorBase(data) {
@@ -90,6 +243,8 @@ void WalletsCache::ProcessorBase::invokeReplenishPayableContract(const csdb::Tra
         sourceWallData.balance_ += csdb::Amount(transaction.counted_fee().to_double()) - csdb::Amount(transaction.max_fee().to_double());
         setModified(sourceId);
     }
+
+    commit();
 }
 
 void WalletsCache::ProcessorBase::smartSourceTransactionReleased(const csdb::Transaction& smartSourceTrx, const csdb::Transaction& initTrx) {
@@ -113,9 +268,15 @@ void WalletsCache::ProcessorBase::smartSourceTransactionReleased(const csdb::Tra
 
     setModified(smartId);
     setModified(initId);
+    commit();
 }
 
 void WalletsCache::ProcessorBase::rollbackReplenishPayableContract(const csdb::Transaction& transaction, const csdb::Amount& execFee) {
+    rollbackReplenish(transaction, execFee);
+    commit();
+}
+
+void WalletsCache::ProcessorBase::rollbackReplenish(const csdb::Transaction& transaction, const csdb::Amount& execFee) {
     csdb::Address wallAddress = transaction.source();
     if (wallAddress == data_.genesisAddress_ || wallAddress == data_.startAddress_) {
         return;
@@ -194,16 +355,18 @@ void WalletsCache::ProcessorBase::load(csdb::Pool& pool, const cs::ConfidantsKey
 #ifdef MONITOR_NODE
     setWalletTime(wrWall, timeStamp);
 #endif
+
+    commit();
 }
 #ifdef MONITOR_NODE
 bool WalletsCache::ProcessorBase::setWalletTime(const WalletData::Address& address, const uint64_t& p_timeStamp) {
-    for (auto& it : data_.wallets_) {
-        if (it != nullptr && it->address_ == address) {
-            it->createTime_ = p_timeStamp;
-            return true;
-        }
+    const csdb::Address wallAddress = csdb::Address::from_public_key(address);
+    WalletId id{};
+    if (!data_.walletsIds_.normal().find(wallAddress, id) || (!changed_.count(id) && !data_.wallets_.contains(id))) {
+        return false;
     }
-    return false;
+    getWalletData(id, wallAddress).createTime_ = p_timeStamp;
+    return true;
 }
 #endif
 
@@ -359,7 +522,7 @@ double WalletsCache::ProcessorBase::loadTrxForSource(const csdb::Transaction& tr
 
 		++wallData.transNum_;
 #ifdef MONITOR_NODE        
-        setWalletTime(wallData.address_, tr.get_time());
+        wallData.createTime_ = tr.get_time();
 #endif
 
 #ifdef TRANSACTIONS_INDEX
@@ -391,7 +554,7 @@ void WalletsCache::ProcessorBase::checkClosedSmart(const csdb::Transaction& tran
 
 void WalletsCache::ProcessorBase::checkSmartWaitingForMoney(const csdb::Transaction& initTransaction, const csdb::Transaction& newStateTransaction) {
     if (newStateTransaction.user_field(trx_uf::new_state::Value).value<std::string>().empty()) {
-        return rollbackReplenishPayableContract(initTransaction, csdb::Amount(newStateTransaction.user_field(trx_uf::new_state::Fee).value<csdb::Amount>()));
+        return rollbackReplenish(initTransaction, csdb::Amount(newStateTransaction.user_field(trx_uf::new_state::Fee).value<csdb::Amount>()));
     }
     bool waitingSmart = false;
     for (auto it = data_.smartPayableTransactions_.begin(); it != data_.smartPayableTransactions_.end(); it++) {
@@ -481,7 +644,7 @@ void WalletsCache::ProcessorBase::loadTrxForTarget(const csdb::Transaction& tr)
         ++wallData.transNum_;
 
 #ifdef MONITOR_NODE
-    setWalletTime(wallData.address_, tr.get_time());
+    wallData.createTime_ = tr.get_time();
 #endif
 
 #ifdef TRANSACTIONS_INDEX
@@ -501,39 +664,40 @@ bool WalletsCache::Updater::findWalletId(const csdb::Address& address, WalletId&
     return true;
 }
 
-WalletsCache::WalletData& WalletsCache::ProcessorBase::getWalletData(Data& wallets, WalletId id, const csdb::Address& address) {
-    id = WalletsIds::Special::makeNormal(id);
+WalletsCache::WalletData& WalletsCache::ProcessorBase::getWalletData(WalletId id, const csdb::Address& address) {
+    auto [it, inserted] = changed_.try_emplace(id);
 
-    if (id >= wallets.size())
-        wallets.resize(id + 1);
+    if (inserted && !getWallets(id).load(WalletsIds::Special::makeNormal(id), it->second)) {
+        convert(address, it->second.address_);
+    }
 
-    if (!wallets[id]) {
-        wallets[id] = new WalletData{};
-        convert(address, wallets[id]->address_);
+    return it->second;
+}
+
+void WalletsCache::ProcessorBase::commit() {
+    for (const auto& [id, wallet] : changed_) {
+        getWallets(id).store(WalletsIds::Special::makeNormal(id), wallet);
     }
 
-    return *wallets[id];
+    changed_.clear();
 }
 
-WalletsCache::WalletData& WalletsCache::Initer::getWalletData(WalletId id, const csdb::Address& address) {
-    if (WalletsIds::Special::isSpecial(id))
-        return ProcessorBase::getWalletData(walletsSpecial_, id, address);
-    else
-        return ProcessorBase::getWalletData(data_.wallets_, id, address);
+WalletsCache::Wallets& WalletsCache::Initer::getWallets(WalletId id) {
+    return WalletsIds::Special::isSpecial(id) ? walletsSpecial_ : data_.wallets_;
 }
 
-WalletsCache::WalletData& WalletsCache::Updater::getWalletData(WalletId id, const csdb::Address& address) {
-    return ProcessorBase::getWalletData(data_.wallets_, id, address);
+WalletsCache::Wallets& WalletsCache::Updater::getWallets(WalletId) {
+    return data_.wallets_;
 }
 
 void WalletsCache::Initer::setModified(WalletId) {
 }
 
 void WalletsCache::Updater::setModified(WalletId id) {
-    modified_.resize(data_.wallets_.size());
-    if (id >= modified_.size()) {
-        cserror() << "id >= modified_.size: id=" << id << " modified_.size=" << modified_.size();
-        return;
+    // a new wallet is stored by the commit
+    const size_t size = std::max<size_t>(data_.wallets_.size(), id + 1);
+    if (modified_.size() < size) {
+        modified_.resize(size);
     }
     modified_.set(id);
 }
@@ -543,50 +707,45 @@ bool WalletsCache::Initer::moveData(WalletId srcIdSpecial, WalletId destIdNormal
         return false;
     srcIdSpecial = WalletsIds::Special::makeNormal(srcIdSpecial);
 
-    if (srcIdSpecial >= walletsSpecial_.size())
-        return false;
-    if (!walletsSpecial_[srcIdSpecial]) {
+    WalletData wallet;
+    if (!walletsSpecial_.load(srcIdSpecial, wallet)) {
         cserror() << "Src wallet data should not be empty";
         return false;
     }
 
-    if (destIdNormal >= data_.wallets_.size())
-        data_.wallets_.resize(destIdNormal + 1);
-    if (data_.wallets_[destIdNormal]) {
+    if (data_.wallets_.contains(destIdNormal)) {
         cserror() << "Dest wallet data should be empty";
         //        return false; // examine it
     }
-    data_.wallets_[destIdNormal] = walletsSpecial_[srcIdSpecial];
-    walletsSpecial_[srcIdSpecial] = nullptr;
+    data_.wallets_.store(destIdNormal, wallet);
+    walletsSpecial_.erase(srcIdSpecial);
     return true;
 }
 
 bool WalletsCache::Initer::isFinishedOk() const {
-    for (const auto& ptr : walletsSpecial_) {
-        if (ptr) {
-            cserror() << "Some new wallet was not added to block";
-            return false;
-        }
+    if (walletsSpecial_.count() != 0) {
+        cserror() << "Some new wallet was not added to block";
+        return false;
     }
     return true;
 }
 
-const WalletsCache::WalletData* WalletsCache::Updater::findWallet(WalletId id) const {
-    if (id >= data_.wallets_.size())
-        return nullptr;
-    return data_.wallets_[id];
+bool WalletsCache::Updater::findWallet(WalletId id, WalletHead& head) const {
+    return data_.wallets_.read(id, &head, nullptr);
 }
 
-void WalletsCache::iterateOverWallets(const std::function<bool(const WalletData::Address&, const WalletData&)> func) {
-    /*for (const auto& wdp : data_) {
-      if (!func(wdp.first, wdp.second))
-        break;
-    }*/
+bool WalletsCache::Updater::findWallet(WalletId id, WalletData& wallet) const {
+    return data_.wallets_.read(id, &wallet, &wallet);
+}
 
-    for (const auto& wdp : wallets_) {
-        if (wdp != nullptr && !func(wdp->address_, *wdp))
-            break;
-    }
+#ifdef TRANSACTIONS_INDEX
+const csdb::TransactionID* WalletsCache::Updater::findLastTransaction(WalletId id) const {
+    return data_.wallets_.findLastTransaction(id);
+}
+#endif
+
+void WalletsCache::iterateOverWallets(const std::function<bool(const WalletData::Address&, const WalletHead&)> func) {
+    wallets_.forEach([&func](const WalletHead& head) { return func(head.address_, head); });
 }
 
 #ifdef MONITOR_NODE
@@ -1,16 +1,341 @@
+#include <csnode/datastream.hpp>
 #include <csnode/walletsids.hpp>
 #include <lib/system/logger.hpp>
 #include <lib/system/utils.hpp>
+#include <cstring>
 #include <limits>
+#include <random>
 
 using namespace std;
 
 namespace cs {
 
+namespace {
+// a slot is the tag of the key hash and the id, the tag is never 0
+constexpr uint64_t emptySlot = 0;
+constexpr uint64_t removedSlot = 1;
+constexpr size_t minCapacity = 1024;
+
+uint32_t slotTag(uint64_t hash) {
+    return static_cast<uint32_t>(hash >> 32) | 1u;
+}
+
+uint64_t makeSlot(uint64_t hash, WalletsIds::WalletId id) {
+    return (static_cast<uint64_t>(slotTag(hash)) << 32) | id;
+}
+
+// at most 3/4 of the slots are used
+size_t capacityFor(size_t count) {
+    size_t capacity = minCapacity;
+    while (capacity / 4 * 3 < count) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// the kept ids by id, get gives the key of an id if it is kept
+template <typename Get>
+void serializeIds(cs::DataStream& stream, WalletsIds::WalletId nextId, size_t normalCount, size_t specialCount, Get get) {
+    std::vector<std::pair<cs::PublicKey, WalletsIds::WalletId>> kept;
+
+    for (size_t i = 0; i < normalCount + specialCount; ++i) {
+        const auto id = static_cast<WalletsIds::WalletId>(i < normalCount ? i : WalletsIds::Special::makeSpecial(static_cast<WalletsIds::WalletId>(i - normalCount)));
+        if (const auto key = get(id)) {
+            kept.emplace_back(*key, id);
+        }
+    }
+
+    stream << nextId << kept.size();
+    for (const auto& [key, id] : kept) {
+        stream << key << id;
+    }
+}
+}  // namespace
+
+WalletsIds::Table::Table(size_t capacity)
+: mask(capacity - 1)
+, entries(new std::atomic<uint64_t>[capacity]()) {
+}
+
 WalletsIds::WalletsIds()
-: nextId_(0) {
+: seed_(std::random_device{}())
+, nextId_(0) {
     special_.reset(new Special(*this));
     norm_.reset(new Normal(*this));
+    grow(minCapacity);
+}
+
+uint64_t WalletsIds::hash(const Key& key) const {
+    // the keys are chosen by the users, so the hash is seeded
+    uint64_t result = seed_;
+    for (size_t i = 0; i < key.size(); i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, key.data() + i, sizeof(word));
+        result = (result ^ word) * 0x9e3779b97f4a7c15ull;
+        result ^= result >> 29;
+    }
+    return result * 0xbf58476d1ce4e5b9ull;
+}
+
+const WalletsIds::Key* WalletsIds::findKey(WalletId id) const {
+    if (Special::isSpecial(id)) {
+        return specialKeys_.find(Special::makeNormal(id));
+    }
+    return keys_.find(id);
+}
+
+WalletsIds::Entry WalletsIds::findEntry(WalletId id) const {
+    // the key of the id is checked, the id may be removed or given to another key
+    const Key* key = findKey(id);
+    if (!key) {
+        return std::nullopt;
+    }
+
+    const Key copy = *key;
+    WalletId found = 0;
+    if (findId(copy, hash(copy), found) && found == id) {
+        return copy;
+    }
+    return std::nullopt;
+}
+
+bool WalletsIds::findId(const Key& key, uint64_t hash, WalletId& id) const {
+    const uint32_t tag = slotTag(hash);
+
+    while (true) {
+        const Table* table = table_.load(std::memory_order_acquire);
+        const uint64_t version = table->version.load(std::memory_order_acquire);
+        uint64_t found = emptySlot;
+
+        // a table refilled meanwhile may have no empty slot on the way, so the probes are limited
+        size_t i = hash & table->mask;
+        for (size_t probes = 0; (version & 1) == 0 && probes <= table->mask; ++probes, i = (i + 1) & table->mask) {
+            const uint64_t value = table->entries[i].load(std::memory_order_acquire);
+
+            if (value == emptySlot) {
+                break;
+            }
+
+            if (static_cast<uint32_t>(value >> 32) == tag) {
+                const Key* candidate = findKey(static_cast<WalletId>(value));
+                if (candidate && *candidate == key) {
+                    found = value;
+                    break;
+                }
+            }
+        }
+
+        // the table was replaced and refilled while the reader went through it, the current one is read again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((version & 1) == 0 && table->version.load(std::memory_order_relaxed) == version) {
+            if (found == emptySlot) {
+                return false;
+            }
+
+            id = static_cast<WalletId>(found);
+            return true;
+        }
+    }
+}
+
+std::atomic<uint64_t>* WalletsIds::findSlot(const Key& key, uint64_t hash) const {
+    const Table* table = table_.load(std::memory_order_acquire);
+    const uint32_t tag = slotTag(hash);
+
+    for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+        std::atomic<uint64_t>& slot = table->entries[i];
+        const uint64_t value = slot.load(std::memory_order_acquire);
+
+        if (value == emptySlot) {
+            return nullptr;
+        }
+
+        if (static_cast<uint32_t>(value >> 32) == tag) {
+            const Key* found = findKey(static_cast<WalletId>(value));
+            if (found && *found == key) {
+                return &slot;
+            }
+        }
+    }
+}
+
+void WalletsIds::emplace(const Key& key, uint64_t hash, WalletId id) {
+    const Table* table = table_.load(std::memory_order_relaxed);
+    if (used_ + 1 > (table->mask + 1) / 4 * 3) {
+        // the same capacity drops the removed ones only
+        grow(capacityFor(count_ + 1));
+        table = table_.load(std::memory_order_relaxed);
+    }
+
+    size_t i = hash & table->mask;
+    while (table->entries[i].load(std::memory_order_relaxed) != emptySlot) {
+        i = (i + 1) & table->mask;
+    }
+
+    assign(table->entries[i], key, hash, id);
+    ++used_;
+    ++count_;
+}
+
+void WalletsIds::assign(std::atomic<uint64_t>& slot, const Key& key, uint64_t hash, WalletId id) {
+    const uint64_t value = slot.load(std::memory_order_relaxed);
+    if (value != emptySlot && value != removedSlot) {
+        keepFrozen(static_cast<WalletId>(value));
+    }
+    keepFrozen(id);
+
+    // the readers see the key before the slot
+    setKey(id, key);
+    slot.store(makeSlot(hash, id), std::memory_order_release);
+}
+
+void WalletsIds::setKey(WalletId id, const Key& key) {
+    WalletsStorage<Key>& keys = Special::isSpecial(id) ? specialKeys_ : keys_;
+    const WalletId index = Special::makeNormal(id);
+
+    if (index >= keys.size()) {
+        keys.resize(index + 1);
+    }
+    keys[index] = key;
+}
+
+void WalletsIds::keepFrozen(WalletId id) {
+    const auto load = [this, id] { return findEntry(id); };
+
+    if (Special::isSpecial(id)) {
+        saveFrozen(frozenSpecialKeys_, Special::makeNormal(id), load);
+    }
+    else {
+        saveFrozen(frozenKeys_, id, load);
+    }
+}
+
+void WalletsIds::grow(size_t capacity) {
+    const Table* table = table_.load(std::memory_order_relaxed);
+    Table* next = nullptr;
+
+    for (const auto& replaced : tables_) {
+        if (replaced.get() != table && replaced->mask + 1 == capacity) {
+            next = replaced.get();
+            break;
+        }
+    }
+
+    // a reader still going through the replaced table sees the version change, see findId()
+    const bool refill = next != nullptr;
+    const uint64_t version = refill ? next->version.load(std::memory_order_relaxed) : 0;
+    if (refill) {
+        next->version.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i <= next->mask; ++i) {
+            next->entries[i].store(emptySlot, std::memory_order_relaxed);
+        }
+    }
+    else {
+        tables_.push_back(std::make_unique<Table>(capacity));
+        next = tables_.back().get();
+    }
+
+    if (table) {
+        for (size_t i = 0; i <= table->mask; ++i) {
+            const uint64_t value = table->entries[i].load(std::memory_order_relaxed);
+            if (value == emptySlot || value == removedSlot) {
+                continue;
+            }
+
+            const uint64_t keyHash = hash(*findKey(static_cast<WalletId>(value)));
+            size_t j = keyHash & next->mask;
+            while (next->entries[j].load(std::memory_order_relaxed) != emptySlot) {
+                j = (j + 1) & next->mask;
+            }
+            next->entries[j].store(value, std::memory_order_relaxed);
+        }
+    }
+
+    if (refill) {
+        next->version.store(version + 2, std::memory_order_release);
+    }
+
+    // the replaced one stays, a reader may still go through it
+    table_.store(next, std::memory_order_release);
+    used_ = count_;
+}
+
+// not along with the readers
+void WalletsIds::swap(WalletsIds& other) {
+    std::swap(tables_, other.tables_);
+    const Table* table = table_.load();
+    table_.store(other.table_.load());
+    other.table_.store(table);
+    std::swap(keys_, other.keys_);
+    std::swap(specialKeys_, other.specialKeys_);
+    std::swap(seed_, other.seed_);
+    std::swap(count_, other.count_);
+    std::swap(used_, other.used_);
+    std::swap(nextId_, other.nextId_);
+}
+
+void WalletsIds::reserve(size_t count) {
+    const size_t capacity = capacityFor(count);
+    if (capacity > table_.load(std::memory_order_relaxed)->mask + 1) {
+        grow(capacity);
+    }
+    keys_.reserve(count);
+}
+
+size_t WalletsIds::memory() const {
+    size_t result = keys_.memory() + specialKeys_.memory();
+    for (const auto& table : tables_) {
+        result += (table->mask + 1) * sizeof(std::atomic<uint64_t>);
+    }
+    return result;
+}
+
+void WalletsIds::serialize(cs::DataStream& stream) const {
+    serializeIds(stream, nextId_, keys_.size(), specialKeys_.size(), [this](WalletId id) { return findEntry(id); });
+}
+
+std::function<void(cs::DataStream&)> WalletsIds::freeze() {
+    auto keys = std::make_shared<FrozenEntries<Entry>>(keys_.size());
+    auto specialKeys = std::make_shared<FrozenEntries<Entry>>(specialKeys_.size());
+    frozenKeys_.push_back(keys);
+    frozenSpecialKeys_.push_back(specialKeys);
+
+    return [this, nextId = nextId_, keys, specialKeys](cs::DataStream& stream) {
+        serializeIds(stream, nextId, keys->size(), specialKeys->size(), [&](WalletId id) {
+            const auto load = [this, id] { return findEntry(id); };
+            return Special::isSpecial(id) ? specialKeys->read(Special::makeNormal(id), load) : keys->read(id, load);
+        });
+    };
+}
+
+bool WalletsIds::deserialize(cs::DataStream& stream) {
+    WalletId nextId = 0;
+    std::size_t size = 0;
+    stream >> nextId >> size;
+
+    WalletsIds ids;
+    ids.reserve(size);
+
+    for (std::size_t i = 0; i < size && stream.isValid(); ++i) {
+        cs::PublicKey key{};
+        WalletId id = 0;
+        stream >> key >> id;
+
+        const uint64_t keyHash = ids.hash(key);
+        if (!ids.findSlot(key, keyHash)) {
+            ids.emplace(key, keyHash, id);
+        }
+    }
+
+    if (!stream.isValid()) {
+        return false;
+    }
+
+    ids.nextId_ = nextId;
+    swap(ids);
+    return true;
 }
 
 WalletsIds::Normal::Normal(WalletsIds& norm)
@@ -25,14 +350,20 @@ bool WalletsIds::Normal::insert(const WalletAddress& address, WalletId id) {
         return false;
     }
     else if (address.is_public_key()) {
-        std::pair<Data::const_iterator, bool> res = norm_.data_.insert(std::make_pair(address, id));
-        if (res.second && id >= norm_.nextId_) {
+        const Key& key = address.public_key();
+        const uint64_t keyHash = norm_.hash(key);
+        if (norm_.findSlot(key, keyHash)) {
+            return false;
+        }
+
+        if (id >= norm_.nextId_) {
             if (id >= numeric_limits<WalletId>::max() / 2)
                 throw runtime_error("idNormal >= numeric_limits<WalletId>::max() / 2");
 
             norm_.nextId_ = id + 1;
         }
-        return res.second;
+        norm_.emplace(key, keyHash, id);
+        return true;
     }
     cserror() << "Wrong address";
     return false;
@@ -44,27 +375,18 @@ bool WalletsIds::Normal::find(const WalletAddress& address, WalletId& id) const
         return true;
     }
     else if (address.is_public_key()) {
-        Data::const_iterator it = norm_.data_.find(address);
-        if (it == norm_.data_.end())
-            return false;
-        id = it->second;
-        return true;
+        const Key& key = address.public_key();
+        return norm_.findId(key, norm_.hash(key), id);
     }
     cserror() << "Wrong address";
     return false;
 }
 
 bool WalletsIds::Normal::findaddr(const WalletId& id, WalletAddress& address) const {
-    bool flgfind = false;
-    for (auto& it : norm_.data_) {
-        if (it.second == id) {
-            flgfind = true;
-            address = it.first;
-            break;
-        }
-    }
-    if (flgfind)
+    if (const Entry key = norm_.findEntry(id)) {
+        address = csdb::Address::from_public_key(*key);
         return true;
+    }
 
     cserror() << "Wrong WalletId";
     return false;
@@ -76,14 +398,19 @@ bool WalletsIds::Normal::get(const WalletAddress& address, WalletId& id) {
         return false;
     }
     else if (address.is_public_key()) {
-        std::pair<Data::const_iterator, bool> res = norm_.data_.insert(std::make_pair(address, norm_.nextId_));
-        if (res.second) {
-            if (norm_.nextId_ >= numeric_limits<WalletId>::max() / 2)
-                throw runtime_error("nextId_ >= numeric_limits<WalletId>::max() / 2");
-            ++norm_.nextId_;
+        const Key& key = address.public_key();
+        const uint64_t keyHash = norm_.hash(key);
+        const std::atomic<uint64_t>* slot = norm_.findSlot(key, keyHash);
+        if (slot) {
+            id = static_cast<WalletId>(slot->load(std::memory_order_relaxed));
+            return false;
         }
-        id = res.first->second;
-        return res.second;
+
+        if (norm_.nextId_ >= numeric_limits<WalletId>::max() / 2)
+            throw runtime_error("nextId_ >= numeric_limits<WalletId>::max() / 2");
+        id = norm_.nextId_++;
+        norm_.emplace(key, keyHash, id);
+        return true;
     }
     cserror() << "Wrong address";
     return false;
@@ -94,18 +421,21 @@ bool WalletsIds::Normal::remove(const WalletAddress& address) {
         cserror() << __func__ << ": wrong address type";
         return false;
     }
-    csdebug() << "Keys before erasing address " << address.to_string();
-    for (auto& it : norm_.data_) {
-        csdebug() << it.second << " - " << it.first.to_string();
+
+    const Key& key = address.public_key();
+    std::atomic<uint64_t>* slot = norm_.findSlot(key, norm_.hash(key));
+    if (slot) {
+        const WalletId id = static_cast<WalletId>(slot->load(std::memory_order_relaxed));
+        csdebug() << "Erasing address " << address.to_string() << ", id " << id;
+        norm_.keepFrozen(id);
+        // the slot stays in the probe sequences of the others
+        slot->store(removedSlot, std::memory_order_release);
+        --norm_.count_;
     }
-    norm_.data_.erase(address);
+
     if (norm_.nextId_ > 0) {
         --norm_.nextId_;
     }
-    csdebug() << "Keys after erasing";
-    for (auto& it : norm_.data_) {
-        csdebug() << it.second << " - " << it.first.to_string();
-    }
     return true;
 }
 
@@ -136,16 +466,15 @@ bool WalletsIds::Special::insertNormal(const WalletAddress& address, WalletId id
         return false;
     }
     else if (address.is_public_key()) {
-        std::pair<Data::iterator, bool> res = norm_.data_.insert(std::make_pair(address, idNormal));
-
-        const bool isInserted = res.second;
-        auto& value = res.first->second;
+        const Key& key = address.public_key();
+        const uint64_t keyHash = norm_.hash(key);
+        std::atomic<uint64_t>* slot = norm_.findSlot(key, keyHash);
 
-        if (!isInserted) {
+        if (slot) {
+            const WalletId value = static_cast<WalletId>(slot->load(std::memory_order_relaxed));
             if (!isSpecial(value))
                 return false;
             idSpecial = value;
-            value = idNormal;
         }
 
         if (idNormal >= norm_.nextId_) {
@@ -154,6 +483,13 @@ bool WalletsIds::Special::insertNormal(const WalletAddress& address, WalletId id
 
             norm_.nextId_ = idNormal + 1;
         }
+
+        if (slot) {
+            norm_.assign(*slot, key, keyHash, idNormal);
+        }
+        else {
+            norm_.emplace(key, keyHash, idNormal);
+        }
         return true;
     }
     cserror() << "Wrong address";
@@ -166,13 +502,18 @@ bool WalletsIds::Special::findAnyOrInsertSpecial(const WalletAddress& address, W
         return true;
     }
     else if (address.is_public_key()) {
-        std::pair<Data::const_iterator, bool> res = norm_.data_.insert(std::make_pair(address, nextIdSpecial_));
-        if (res.second) {
-            if (nextIdSpecial_ == numeric_limits<WalletId>::max())
-                throw runtime_error("nextIdSpecial_ == numeric_limits<WalletId>::max()");
-            ++nextIdSpecial_;
+        const Key& key = address.public_key();
+        const uint64_t keyHash = norm_.hash(key);
+        const std::atomic<uint64_t>* slot = norm_.findSlot(key, keyHash);
+        if (slot) {
+            id = static_cast<WalletId>(slot->load(std::memory_order_relaxed));
+            return true;
         }
-        id = res.first->second;
+
+        if (nextIdSpecial_ == numeric_limits<WalletId>::max())
+            throw runtime_error("nextIdSpecial_ == numeric_limits<WalletId>::max()");
+        id = nextIdSpecial_++;
+        norm_.emplace(key, keyHash, id);
         return true;
     }
     cserror() << "Wrong address";
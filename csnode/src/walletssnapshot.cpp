@@ -0,0 +1,259 @@
+#include <csnode/walletssnapshot.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#ifdef _MSC_VER
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <csnode/datastream.hpp>
+#include <lib/system/hash.hpp>
+#include <lib/system/logger.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace {
+const char* const kPrefix = "wallets.";
+const char* const kExtension = ".snapshot";
+
+constexpr uint32_t kMagic = 0x53575343;  // "CSWS"
+
+// the state layout depends on the build options, a snapshot of another build is not loaded
+constexpr uint32_t kFormat = 1
+#ifdef MONITOR_NODE
+                             | (1u << 16)
+#endif
+#ifdef TRANSACTIONS_INDEX
+                             | (1u << 17)
+#endif
+    ;
+
+// header: magic, format, sequence, block hash, state checksum; then the state till the end of the file
+cs::Bytes makeHeader(cs::Sequence sequence, const csdb::PoolHash& hash, const cs::Hash& checksum) {
+    cs::Bytes header;
+    cs::DataStream stream(header);
+    stream << kMagic << kFormat << sequence << hash << checksum;
+    return header;
+}
+
+bool readFile(const std::string& name, cs::Bytes& data) {
+    std::ifstream file(name, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())));
+}
+
+// the bytes reach the disk before the function returns
+bool writeFile(const std::string& name, const cs::Bytes& header, const cs::Bytes& state) {
+    std::FILE* file = std::fopen(name.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    bool result = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+    result = result && std::fwrite(state.data(), 1, state.size(), file) == state.size();
+    result = result && std::fflush(file) == 0;
+#ifdef _MSC_VER
+    result = result && _commit(_fileno(file)) == 0;
+#else
+    result = result && fsync(fileno(file)) == 0;
+#endif
+
+    return std::fclose(file) == 0 && result;
+}
+}  // namespace
+
+namespace cs {
+WalletsSnapshot::WalletsSnapshot(const std::string& path, size_t keep)
+: path_(path)
+, keep_(std::max<size_t>(keep, 1)) {
+    boost::system::error_code error;
+    fs::create_directories(path_, error);
+    if (error) {
+        cserror() << "Snapshot> cannot create " << path_ << ": " << error.message();
+    }
+
+    writer_ = std::thread(&WalletsSnapshot::writeRoutine, this);
+}
+
+WalletsSnapshot::~WalletsSnapshot() {
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+
+    condition_.notify_one();
+    writer_.join();
+}
+
+void WalletsSnapshot::save(cs::Sequence sequence, const csdb::PoolHash& hash, cs::Bytes&& state) {
+    {
+        std::lock_guard lock(mutex_);
+        queued_.sequence = sequence;
+        queued_.hash = hash;
+        queued_.state = std::move(state);
+        queued_.serializer = nullptr;
+        hasQueued_ = true;
+    }
+
+    condition_.notify_one();
+}
+
+void WalletsSnapshot::save(cs::Sequence sequence, const csdb::PoolHash& hash, Serializer&& serializer) {
+    {
+        std::lock_guard lock(mutex_);
+        queued_.sequence = sequence;
+        queued_.hash = hash;
+        queued_.state.clear();
+        queued_.serializer = std::move(serializer);
+        hasQueued_ = true;
+    }
+
+    condition_.notify_one();
+}
+
+bool WalletsSnapshot::load(const LoadHandler& handler) const {
+    for (const auto sequence : list()) {
+        const std::string name = fileName(sequence);
+
+        cs::Bytes data;
+        if (!readFile(name, data)) {
+            cswarning() << "Snapshot> cannot read " << name;
+            continue;
+        }
+
+        cs::DataStream stream(data.data(), data.size());
+
+        uint32_t magic = 0;
+        uint32_t format = 0;
+        cs::Sequence storedSequence = 0;
+        csdb::PoolHash hash;
+        cs::Hash checksum{};
+        stream >> magic >> format >> storedSequence >> hash >> checksum;
+
+        if (!stream.isValid() || magic != kMagic || format != kFormat || storedSequence != sequence) {
+            cswarning() << "Snapshot> " << name << " is made by another build or damaged, skipped";
+            continue;
+        }
+
+        const size_t headerSize = makeHeader(sequence, hash, checksum).size();
+        if (generateHash(data.data() + headerSize, data.size() - headerSize) != checksum) {
+            cswarning() << "Snapshot> " << name << " has a wrong checksum, skipped";
+            continue;
+        }
+
+        cs::DataStream state(data.data() + headerSize, data.size() - headerSize);
+        if (handler(sequence, hash, state)) {
+            cslog() << "Snapshot> wallets state after block #" << sequence << " is loaded";
+            return true;
+        }
+
+        cswarning() << "Snapshot> " << name << " does not match the chain, skipped";
+    }
+
+    return false;
+}
+
+void WalletsSnapshot::writeRoutine() {
+    std::unique_lock lock(mutex_);
+
+    while (true) {
+        condition_.wait(lock, [this] { return stop_ || hasQueued_; });
+        if (!hasQueued_) {
+            break;
+        }
+
+        Snapshot snapshot = std::move(queued_);
+        queued_ = Snapshot{};
+        hasQueued_ = false;
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        if (snapshot.serializer) {
+            cs::DataStream stream(snapshot.state);
+            snapshot.serializer(stream);
+            // the state it reads along with the writer is released
+            snapshot.serializer = nullptr;
+        }
+
+        if (write(snapshot)) {
+            removeOld();
+            const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            csdebug() << "Snapshot> wallets state after block #" << snapshot.sequence << " (" << snapshot.state.size() << " bytes) saved in " << ms << " ms";
+        }
+
+        lock.lock();
+    }
+}
+
+bool WalletsSnapshot::write(const Snapshot& snapshot) const {
+    const cs::Bytes header = makeHeader(snapshot.sequence, snapshot.hash, generateHash(snapshot.state.data(), snapshot.state.size()));
+
+    // a crash while writing must not leave a damaged snapshot under the final name
+    const std::string name = fileName(snapshot.sequence);
+    const std::string temporary = name + ".tmp";
+
+    // the file is synced before the rename, so the final name never gets the bytes still in the cache
+    if (!writeFile(temporary, header, snapshot.state)) {
+        cserror() << "Snapshot> cannot write " << temporary;
+        boost::system::error_code error;
+        fs::remove(temporary, error);
+        return false;
+    }
+
+    boost::system::error_code error;
+    fs::rename(temporary, name, error);
+    if (error) {
+        cserror() << "Snapshot> cannot rename " << temporary << ": " << error.message();
+        return false;
+    }
+
+    return true;
+}
+
+void WalletsSnapshot::removeOld() const {
+    const auto sequences = list();
+
+    for (size_t i = keep_; i < sequences.size(); ++i) {
+        boost::system::error_code error;
+        fs::remove(fileName(sequences[i]), error);
+    }
+}
+
+std::string WalletsSnapshot::fileName(cs::Sequence sequence) const {
+    return (fs::path(path_) / (kPrefix + std::to_string(sequence) + kExtension)).string();
+}
+
+// newest first
+std::vector<cs::Sequence> WalletsSnapshot::list() const {
+    std::vector<cs::Sequence> result;
+
+    boost::system::error_code error;
+    for (fs::directory_iterator it(path_, error), end; !error && it != end; it.increment(error)) {
+        const std::string name = it->path().filename().string();
+        if (name.size() <= std::strlen(kPrefix) + std::strlen(kExtension) || name.compare(0, std::strlen(kPrefix), kPrefix) != 0 || it->path().extension() != kExtension) {
+            continue;
+        }
+
+        const std::string number = name.substr(std::strlen(kPrefix), name.size() - std::strlen(kPrefix) - std::strlen(kExtension));
+        if (std::all_of(number.begin(), number.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            result.push_back(std::stoull(number));
+        }
+    }
+
+    std::sort(result.begin(), result.end(), std::greater<cs::Sequence>());
+    return result;
+}
+}  // namespace cs
@@ -14,14 +14,6 @@ WalletsState::WalletsExisting::WalletsExisting(const BlockChain& blockchain, siz
 : blockchain_(blockchain) {
     modified_.resize(initialWalletsNum, true);
     storage_.resize(initialWalletsNum);
-    for (auto& el : storage_)
-        el = new WalletData{};
-}
-
-WalletsState::WalletsExisting::~WalletsExisting() {
-    for (auto& el : storage_)
-        delete el;
-    storage_.clear();
 }
 
 void WalletsState::WalletsExisting::updateFromSource() {
@@ -42,14 +34,7 @@ bool WalletsState::WalletsExisting::updateFromSource(const WalletId& id) {
     if (!blockchain_.findWalletData(id, walletData))
         return false;
 
-    if (storage_[id]) {
-        storage_[id]->lastTrxInd_ = noInd_;
-        storage_[id]->balance_ = walletData.balance_;
-        storage_[id]->trxTail_ = walletData.trxTail_;
-    }
-    else {
-        storage_[id] = new WalletData{noInd_, walletData.balance_, walletData.trxTail_};
-    }
+    storage_[id] = WalletData{noInd_, walletData.balance_, walletData.trxTail_};
     toCopy_.reset(id);
     return true;
 }
@@ -59,7 +44,7 @@ WalletsState::WalletData* WalletsState::WalletsExisting::getData(const WalletId&
         return nullptr;
     if (toCopy_[id] && !updateFromSource(id))
         return nullptr;
-    return storage_[id];
+    return &storage_[id];
 }
 
 void WalletsState::WalletsExisting::setModified(const WalletId& id) {
@@ -272,6 +272,28 @@ public:
         activePage_->usedSize.fetch_sub(diff, std::memory_order_acq_rel);
     }
 
+    /* Same as shrinkLast but for any region allocated by this thread
+       and still in use (e.g. a batch of receive buffers). The tail of
+       a region that is not the last one is not reused until its page
+       becomes empty, only the usage counter is corrected */
+    void shrink(RegionPtr& ptr, const uint32_t size) {
+        Region* region = ptr.ptr_;
+
+        if (region == lastReg_) {
+            shrinkLast(size);
+            return;
+        }
+
+        assert(region->size_ >= size);
+        int32_t prevSize = region->size_ + sizeof(Region);
+        prevSize += (-prevSize) & 0x3f;
+        int32_t newSize = size + sizeof(Region);
+        newSize += (-newSize) & 0x3f;
+
+        region->size_ = size;
+        region->page_->usedSize.fetch_sub(prevSize - newSize, std::memory_order_acq_rel);
+    }
+
 #ifdef TESTING
     uint32_t getPagesNum() const {
         return pagesNum_;
@@ -3,7 +3,9 @@
 #define QUEUES_HPP
 #include <atomic>
 #include <cstdint>
+#include <new>
 #include <thread>
+#include <utility>
 
 #include "cache.hpp"
 #include "logger.hpp"
@@ -99,4 +101,126 @@ private:
     __cacheline_aligned std::atomic<Element*> writingBarrier_ = {elements};
 };
 
+/* SpscRing is a bounded lock-free ring for exactly one producer and
+   one consumer. Slots are allocated once, elements are constructed in
+   place and nothing is allocated on push / pop.
+   Producer: emplace() -> fill -> publish() (or discard()).
+   Consumer: front() -> use -> pop() */
+template <typename T, std::size_t Capacity>
+class SpscRing {
+public:
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity should be a power of two");
+
+    SpscRing()
+    : elements_(reinterpret_cast<T*>(new uint8_t[sizeof(T) * Capacity])) {
+    }
+
+    ~SpscRing() {
+        while (reserved_ != head_.load(std::memory_order_relaxed)) {
+            discard();
+        }
+
+        while (front()) {
+            pop();
+        }
+
+        delete[] reinterpret_cast<uint8_t*>(elements_);
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing(SpscRing&&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+    SpscRing& operator=(SpscRing&&) = delete;
+
+    // producer: constructs an element behind the already reserved ones, nullptr if the ring is full
+    template <typename... Args>
+    T* emplace(Args&&... args) {
+        if (reserved_ - cachedTail_ == Capacity) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+
+            if (reserved_ - cachedTail_ == Capacity) {
+                return nullptr;
+            }
+        }
+
+        return new (elements_ + (reserved_++ & Mask)) T(std::forward<Args>(args)...);
+    }
+
+    // producer: element reserved by emplace() and not published yet
+    T& reserved(const std::size_t index) {
+        return elements_[(head_.load(std::memory_order_relaxed) + index) & Mask];
+    }
+
+    std::size_t reservedCount() const {
+        return reserved_ - head_.load(std::memory_order_relaxed);
+    }
+
+    // producer: makes count of the reserved elements visible to the consumer
+    void publish(const std::size_t count = 1) {
+        head_.store(head_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // producer: destroys the last reserved element
+    void discard() {
+        elements_[--reserved_ & Mask].~T();
+    }
+
+    // consumer: the oldest published element, nullptr if there is none
+    T* front() {
+        if (tail_.load(std::memory_order_relaxed) == cachedHead_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+
+            if (tail_.load(std::memory_order_relaxed) == cachedHead_) {
+                return nullptr;
+            }
+        }
+
+        return elements_ + (tail_.load(std::memory_order_relaxed) & Mask);
+    }
+
+    // consumer: the published element index places behind front(), nullptr if there is none
+    T* peek(const std::size_t index) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+        if (cachedHead_ - tail <= index) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+
+            if (cachedHead_ - tail <= index) {
+                return nullptr;
+            }
+        }
+
+        return elements_ + ((tail + index) & Mask);
+    }
+
+    // consumer: destroys the element returned by front()
+    void pop() {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        elements_[tail & Mask].~T();
+        tail_.store(tail + 1, std::memory_order_release);
+    }
+
+    std::size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    static constexpr std::size_t capacity() {
+        return Capacity;
+    }
+
+private:
+    static constexpr std::size_t Mask = Capacity - 1;
+
+    T* elements_;
+
+    // producer side
+    __cacheline_aligned std::atomic<std::size_t> head_ = {0};
+    std::size_t reserved_ = 0;
+    std::size_t cachedTail_ = 0;
+
+    // consumer side
+    __cacheline_aligned std::atomic<std::size_t> tail_ = {0};
+    std::size_t cachedHead_ = 0;
+};
+
 #endif  // QUEUES_HPP
@@ -1,6 +1,7 @@
 /* Send blaming letters to @yrtimd */
 #ifndef STRUCTURES_HPP
 #define STRUCTURES_HPP
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
@@ -134,6 +135,15 @@ public:
         return size_;
     }
 
+    // position in the storage, it does not change until the element is overwritten
+    uint32_t indexOf(const T* ptr) const {
+        return static_cast<uint32_t>(ptr - elements_);
+    }
+
+    T* atIndex(const uint32_t index) const {
+        return elements_ + index;
+    }
+
 private:
     T* incrementPtr(T* ptr) const {
         if (++ptr == end_) {
@@ -214,17 +224,20 @@ private:
 };
 
 /* A simple queue-like counting hash-map of fixed size. Not
-   thread-safe. */
+   thread-safe.
+   Elements live in a circular buffer and the oldest one is evicted
+   when the map is full. The index is an open-addressing table with
+   linear probing over a power of two number of slots, load factor
+   stays below 1/2. getHashIndex<IndexType>(key) gives the key hash,
+   it is mixed before use, so any well distributed part of the key
+   will do. */
 template <typename ResultType, typename ArgType>
 inline ResultType getHashIndex(const ArgType&);
 
-template <typename KeyType, typename ArgType, typename IndexType = uint16_t, uint32_t MaxSize = 100000>
+template <typename KeyType, typename ArgType, typename IndexType = uint64_t, uint32_t MaxSize = 100000>
 class FixedHashMap {
 public:
     struct Element {
-        Element *up, *down = nullptr;
-        Element** bucket;
-
         KeyType key;
         ArgType data = {};
 
@@ -232,56 +245,73 @@ public:
             return data;
         }
 
-        Element(const KeyType& _key, Element** _bucket)
-        : bucket(_bucket)
-        , key(_key) {
+        Element(const KeyType& _key)
+        : key(_key) {
         }
     };
     using ElementPtr = Element*;
 
-    FixedHashMap() {
-        static_assert(MaxSize >= 2, "Your member is too small");
+    struct Stats {
+        uint32_t size;
+        uint32_t slots;
+        double loadFactor;
+        double averageProbe;  // slots looked through by a lookup, on average since the start
+        uint32_t maxProbe;    // the longest distance of a stored key from its home slot
+    };
 
-        const size_t bucketsSize = 1 << (sizeof(IndexType) * 8);
-        buckets_ = new ElementPtr[bucketsSize];
-        std::memset(buckets_, 0, bucketsSize * sizeof(ElementPtr));
+    FixedHashMap()
+    : slots_(new Slot[SlotsCount]) {
+        static_assert(MaxSize >= 2, "Your member is too small");
+        std::fill(slots_, slots_ + SlotsCount, Slot{0, EmptySlot});
     }
 
     FixedHashMap(const FixedHashMap&) = delete;
     FixedHashMap(FixedHashMap&& rhs)
     : buffer_(std::move(rhs.buffer_))
-    , buckets_(rhs.buckets_) {
-        rhs.buckets_ = nullptr;
+    , slots_(rhs.slots_)
+    , lookups_(rhs.lookups_)
+    , probes_(rhs.probes_) {
+        rhs.slots_ = nullptr;
     }
 
     ~FixedHashMap() {
-        delete[] buckets_;
+        delete[] slots_;
     }
 
     ArgType& tryStore(const KeyType& key) {
-        Element** myBucket;
-        auto foundElement = getElt(key, &myBucket);
+        const uint64_t hash = mix(static_cast<uint64_t>(getHashIndex<IndexType, KeyType>(key)));
+        uint32_t pos = 0;
 
-        if (foundElement) {
-            return foundElement->data;
+        if (Element* element = lookup(key, hash, pos)) {
+            return element->data;
         }
 
         // Element not found, add a new one
         if (buffer_.size() == MaxSize) {
             preparePopLeft();
-        }
 
-        Element& newComer = buffer_.emplace(key, myBucket);
-        newComer.up = *myBucket;
+            // the eviction may have shifted a run of slots into this position
+            pos = static_cast<uint32_t>(hash) & Mask;
 
-        if (newComer.up) {
-            newComer.up->down = &newComer;
+            while (slots_[pos].index != EmptySlot) {
+                pos = (pos + 1) & Mask;
+            }
         }
 
-        *myBucket = &newComer;
+        Element& newComer = buffer_.emplace(key);
+        slots_[pos] = Slot{static_cast<uint32_t>(hash), buffer_.indexOf(&newComer)};
+
         return newComer.data;
     }
 
+    // nullptr if there is no such key, nothing is added or evicted
+    ArgType* find(const KeyType& key) {
+        const uint64_t hash = mix(static_cast<uint64_t>(getHashIndex<IndexType, KeyType>(key)));
+        uint32_t pos = 0;
+        Element* element = lookup(key, hash, pos);
+        return element ? &element->data : nullptr;
+    }
+
     auto begin() {
         return buffer_.begin();
     }
@@ -289,40 +319,112 @@ public:
         return buffer_.end();
     }
 
+    uint32_t size() const {
+        return buffer_.size();
+    }
+
+    Stats getStats() const {
+        Stats stats{};
+        stats.size = buffer_.size();
+        stats.slots = SlotsCount;
+        stats.loadFactor = static_cast<double>(stats.size) / SlotsCount;
+        stats.averageProbe = lookups_ ? static_cast<double>(probes_) / lookups_ : 0;
+
+        for (uint32_t pos = 0; pos < SlotsCount; ++pos) {
+            if (slots_[pos].index != EmptySlot) {
+                stats.maxProbe = std::max(stats.maxProbe, distance(pos));
+            }
+        }
+
+        return stats;
+    }
+
 private:
-    Element* getElt(const KeyType& key, Element*** bucket) {
-        const IndexType idx = getHashIndex<IndexType, KeyType>(key);
-        *bucket = buckets_ + idx;
-
-        Element* eltInBucket = **bucket;
-        while (eltInBucket) {
-            if (eltInBucket->key == key) {
-                return eltInBucket;
+    struct Slot {
+        uint32_t hash;
+        uint32_t index;
+    };
+
+    static constexpr uint32_t EmptySlot = UINT32_MAX;
+
+    static constexpr uint32_t getSlotsCount() {
+        uint32_t count = 1;
+
+        while (count < MaxSize * 2) {
+            count <<= 1;
+        }
+
+        return count;
+    }
+
+    static constexpr uint32_t SlotsCount = getSlotsCount();
+    static constexpr uint32_t Mask = SlotsCount - 1;
+
+    // murmur3 finalizer
+    static uint64_t mix(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+    // the element of the key, otherwise nullptr and pos is the empty slot the key would take
+    Element* lookup(const KeyType& key, const uint64_t hash, uint32_t& pos) {
+        pos = static_cast<uint32_t>(hash) & Mask;
+
+        ++lookups_;
+
+        for (;; pos = (pos + 1) & Mask) {
+            ++probes_;
+            const Slot& slot = slots_[pos];
+
+            if (slot.index == EmptySlot) {
+                return nullptr;
             }
 
-            eltInBucket = eltInBucket->up;
+            if (slot.hash == static_cast<uint32_t>(hash)) {
+                Element* element = buffer_.atIndex(slot.index);
+
+                if (element->key == key) {
+                    return element;
+                }
+            }
         }
+    }
 
-        return nullptr;
+    uint32_t distance(const uint32_t pos) const {
+        return (pos - slots_[pos].hash) & Mask;
     }
 
+    // removes the oldest element from the index, the buffer destroys it on the next emplace
     void preparePopLeft() {
-        auto toRemove = buffer_.frontPtr();
+        const uint32_t index = buffer_.indexOf(buffer_.frontPtr());
+        const uint64_t hash = mix(static_cast<uint64_t>(getHashIndex<IndexType, KeyType>(buffer_.frontPtr()->key)));
 
-        if (toRemove->down) {
-            toRemove->down->up = toRemove->up;
-        }
-        else {
-            *(toRemove->bucket) = toRemove->up;
+        uint32_t hole = static_cast<uint32_t>(hash) & Mask;
+
+        while (slots_[hole].index != index) {
+            hole = (hole + 1) & Mask;
         }
 
-        if (toRemove->up) {
-            toRemove->up->down = toRemove->down;
+        // backward shift deletion keeps the probe sequences without tombstones
+        for (uint32_t pos = (hole + 1) & Mask; slots_[pos].index != EmptySlot; pos = (pos + 1) & Mask) {
+            if (distance(pos) >= ((pos - hole) & Mask)) {
+                slots_[hole] = slots_[pos];
+                hole = pos;
+            }
         }
+
+        slots_[hole].index = EmptySlot;
     }
 
     FixedCircularBuffer<Element, MaxSize> buffer_;
-    Element** buckets_;
+    Slot* slots_;
+
+    uint64_t lookups_ = 0;
+    uint64_t probes_ = 0;
 };
 
 class CallsQueue {
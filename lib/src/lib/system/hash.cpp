@@ -0,0 +1,196 @@
+#include "lib/system/hash.hpp"
+
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define HASH_MULTI_BUFFER
+#include <immintrin.h>
+#endif
+
+#ifdef HASH_MULTI_BUFFER
+namespace {
+/* BLAKE2b with a 32 byte digest and no key, the hash cscrypto::calculateHash gives,
+   over four buffers at once: every 64-bit word of the state holds the four lanes */
+constexpr size_t Lanes = 4;
+constexpr size_t BlockSize = 128;
+
+constexpr uint64_t Iv[8] = {0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+                            0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL};
+
+constexpr uint8_t Sigma[12][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}, {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4}, {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13}, {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11}, {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5}, {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}, {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3}};
+
+__attribute__((target("avx2"))) inline __m256i rotr32(__m256i x) {
+    return _mm256_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+__attribute__((target("avx2"))) inline __m256i rotr24(__m256i x) {
+    const __m256i mask = _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+    return _mm256_shuffle_epi8(x, mask);
+}
+
+__attribute__((target("avx2"))) inline __m256i rotr16(__m256i x) {
+    const __m256i mask = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+    return _mm256_shuffle_epi8(x, mask);
+}
+
+__attribute__((target("avx2"))) inline __m256i rotr63(__m256i x) {
+    return _mm256_xor_si256(_mm256_srli_epi64(x, 63), _mm256_add_epi64(x, x));
+}
+
+__attribute__((target("avx2"))) inline void mix(__m256i* v, int a, int b, int c, int d, __m256i x, __m256i y) {
+    v[a] = _mm256_add_epi64(_mm256_add_epi64(v[a], v[b]), x);
+    v[d] = rotr32(_mm256_xor_si256(v[d], v[a]));
+    v[c] = _mm256_add_epi64(v[c], v[d]);
+    v[b] = rotr24(_mm256_xor_si256(v[b], v[c]));
+    v[a] = _mm256_add_epi64(_mm256_add_epi64(v[a], v[b]), y);
+    v[d] = rotr16(_mm256_xor_si256(v[d], v[a]));
+    v[c] = _mm256_add_epi64(v[c], v[d]);
+    v[b] = rotr63(_mm256_xor_si256(v[b], v[c]));
+}
+
+// word i of the message of every lane goes to m[i]
+__attribute__((target("avx2"))) inline void loadMessages(const uint8_t* const* blocks, __m256i* m) {
+    for (int j = 0; j < 4; ++j) {
+        const __m256i l0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[0] + 32 * j));
+        const __m256i l1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[1] + 32 * j));
+        const __m256i l2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[2] + 32 * j));
+        const __m256i l3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[3] + 32 * j));
+
+        const __m256i t0 = _mm256_unpacklo_epi64(l0, l1);
+        const __m256i t1 = _mm256_unpackhi_epi64(l0, l1);
+        const __m256i t2 = _mm256_unpacklo_epi64(l2, l3);
+        const __m256i t3 = _mm256_unpackhi_epi64(l2, l3);
+
+        m[4 * j + 0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+        m[4 * j + 1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+        m[4 * j + 2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+        m[4 * j + 3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+    }
+}
+
+__attribute__((target("avx2"))) void hashLanes(const uint8_t* const* data, const size_t* lengths, cs::Hash* hashes) {
+    // a lane with fewer blocks keeps its state while the others go on
+    alignas(32) uint8_t tails[Lanes][BlockSize];
+    alignas(32) static const uint8_t empty[BlockSize] = {};
+
+    size_t blocks[Lanes];
+    size_t maxBlocks = 0;
+
+    for (size_t lane = 0; lane < Lanes; ++lane) {
+        blocks[lane] = std::max<size_t>(1, (lengths[lane] + BlockSize - 1) / BlockSize);
+        maxBlocks = std::max(maxBlocks, blocks[lane]);
+
+        const size_t full = (blocks[lane] - 1) * BlockSize;
+        std::memset(tails[lane], 0, BlockSize);
+        if (lengths[lane] > full) {
+            std::memcpy(tails[lane], data[lane] + full, lengths[lane] - full);
+        }
+    }
+
+    __m256i h[8];
+    for (int i = 0; i < 8; ++i) {
+        h[i] = _mm256_set1_epi64x(static_cast<long long>(Iv[i]));
+    }
+    // the parameter block: the digest of 32 bytes, no key, fanout and depth 1
+    h[0] = _mm256_xor_si256(h[0], _mm256_set1_epi64x(0x01010000 | sizeof(cs::Hash)));
+
+    for (size_t block = 0; block < maxBlocks; ++block) {
+        const uint8_t* current[Lanes];
+        alignas(32) uint64_t counters[Lanes];
+        alignas(32) uint64_t finals[Lanes];
+        alignas(32) uint64_t idle[Lanes];
+
+        for (size_t lane = 0; lane < Lanes; ++lane) {
+            const bool last = block + 1 == blocks[lane];
+            const bool past = block >= blocks[lane];
+
+            current[lane] = past ? empty : (last ? tails[lane] : data[lane] + block * BlockSize);
+            counters[lane] = last ? lengths[lane] : (block + 1) * BlockSize;
+            finals[lane] = last ? ~0ULL : 0;
+            idle[lane] = past ? ~0ULL : 0;
+        }
+
+        __m256i m[16];
+        loadMessages(current, m);
+
+        __m256i v[16];
+        for (int i = 0; i < 8; ++i) {
+            v[i] = h[i];
+            v[i + 8] = _mm256_set1_epi64x(static_cast<long long>(Iv[i]));
+        }
+        v[12] = _mm256_xor_si256(v[12], _mm256_load_si256(reinterpret_cast<const __m256i*>(counters)));
+        v[14] = _mm256_xor_si256(v[14], _mm256_load_si256(reinterpret_cast<const __m256i*>(finals)));
+
+        for (int round = 0; round < 12; ++round) {
+            const uint8_t* s = Sigma[round];
+            mix(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+            mix(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+            mix(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+            mix(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+            mix(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+            mix(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+            mix(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+            mix(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+        }
+
+        const __m256i keep = _mm256_load_si256(reinterpret_cast<const __m256i*>(idle));
+        for (int i = 0; i < 8; ++i) {
+            const __m256i next = _mm256_xor_si256(h[i], _mm256_xor_si256(v[i], v[i + 8]));
+            h[i] = _mm256_blendv_epi8(next, h[i], keep);
+        }
+    }
+
+    alignas(32) uint64_t words[4][Lanes];
+    for (int i = 0; i < 4; ++i) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), h[i]);
+    }
+
+    for (size_t lane = 0; lane < Lanes; ++lane) {
+        for (int i = 0; i < 4; ++i) {
+            std::memcpy(hashes[lane].data() + i * sizeof(uint64_t), &words[i][lane], sizeof(uint64_t));
+        }
+    }
+}
+
+bool hasMultiBuffer() {
+    static const bool result = __builtin_cpu_supports("avx2");
+    return result;
+}
+}  // namespace
+#endif
+
+void generateHashes(const void* const* data, const size_t* lengths, cs::Hash* hashes, const size_t count) {
+    size_t i = 0;
+
+#ifdef HASH_MULTI_BUFFER
+    // a lane hashes slower than a single buffer does, so fewer than two are left to the loop
+    if (hasMultiBuffer()) {
+        for (; i + 2 <= count; i += Lanes) {
+            const size_t size = std::min(Lanes, count - i);
+            const uint8_t* lanes[Lanes];
+            size_t sizes[Lanes];
+            cs::Hash results[Lanes];
+
+            for (size_t lane = 0; lane < Lanes; ++lane) {
+                lanes[lane] = static_cast<const uint8_t*>(data[i + std::min(lane, size - 1)]);
+                sizes[lane] = lengths[i + std::min(lane, size - 1)];
+            }
+
+            hashLanes(lanes, sizes, results);
+            std::copy(results, results + size, hashes + i);
+        }
+
+        i = std::min(i, count);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        hashes[i] = generateHash(data[i], lengths[i]);
+    }
+}
@@ -0,0 +1,108 @@
+/* Send blaming letters to @yrtimd */
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <lz4.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <lib/system/common.hpp>
+
+struct NetworkData;
+
+/* Decides which outgoing packets are worth compressing.
+   A packet is compressed when its payload is big enough, its message type
+   is enabled and the running gain estimate of the type still pays for the
+   CPU. A type which stopped paying is probed now and then, so it comes back
+   when its payloads change.
+   Optionally packets are compressed with a shared LZ4 dictionary: all the
+   nodes should have the same dictionary file. Without the file the policy
+   samples transaction packets and stages and saves a dictionary on exit.
+   compress() / shouldCompress() are called by the writer only,
+   decompress() and getStats() are safe from any thread */
+class CompressionPolicy {
+public:
+    // fragments except the first one carry no message type
+    static constexpr uint16_t Continuation = 256;
+    static constexpr size_t TypesCount = Continuation + 1;
+
+    static constexpr size_t MaxDictionarySize = 64 * 1024;
+
+    struct Stats {
+        uint64_t packets = 0;
+        uint64_t compressed = 0;
+        uint64_t skipped = 0;
+        uint64_t rawBytes = 0;
+        uint64_t savedBytes = 0;
+        uint64_t cpuNs = 0;
+    };
+
+    CompressionPolicy();
+    explicit CompressionPolicy(const NetworkData&);
+    ~CompressionPolicy();
+
+    CompressionPolicy(const CompressionPolicy&) = delete;
+    CompressionPolicy& operator=(const CompressionPolicy&) = delete;
+
+    bool shouldCompress(const uint16_t type, const size_t size);
+
+    // returns compressed size, 0 if it is not smaller than the source
+    int compress(const uint16_t type, const char* source, char* dest, const int sourceSize, const int destSize, bool& withDictionary);
+    int decompress(const char* source, char* dest, const int sourceSize, const int destSize, const bool withDictionary) const;
+
+    bool hasDictionary() const {
+        return !dictionary_.empty();
+    }
+
+    void setDictionary(const cs::Bytes& dictionary, const bool send);
+
+    // the most useful content of an LZ4 dictionary is at its end, so the latest samples go last
+    static cs::Bytes buildDictionary(const std::deque<cs::Bytes>& samples);
+
+    Stats getStats(const uint16_t type) const;
+    void logStats() const;
+
+private:
+    struct TypeState {
+        std::atomic<uint64_t> packets = {0};
+        std::atomic<uint64_t> compressed = {0};
+        std::atomic<uint64_t> skipped = {0};
+        std::atomic<uint64_t> rawBytes = {0};
+        std::atomic<uint64_t> savedBytes = {0};
+        std::atomic<uint64_t> cpuNs = {0};
+
+        // writer only
+        bool enabled = true;
+        bool paying = true;
+        float gain = 1.f;
+        uint32_t sinceProbe = 0;
+    };
+
+    void account(TypeState& state, const int sourceSize, const int compressedSize, const uint64_t ns);
+    void sample(const char* data, const int size);
+
+    bool loadDictionary();
+    void saveDictionary() const;
+
+    std::array<TypeState, TypesCount> types_;
+
+    size_t minSize_ = 0;
+    float minGain_ = 0.f;
+
+    std::string dictionaryPath_;
+    cs::Bytes dictionary_;
+    bool sendWithDictionary_ = false;
+    LZ4_stream_t dictionaryStream_;
+    LZ4_stream_t workStream_;
+
+    bool training_ = false;
+    size_t samplesSize_ = 0;
+    std::deque<cs::Bytes> samples_;
+};
+
+#endif  // COMPRESSION_HPP
@@ -4,6 +4,9 @@
 
 #include <boost/asio.hpp>
 
+#include <chrono>
+#include <vector>
+
 #include <lib/system/allocators.hpp>
 #include <lib/system/cache.hpp>
 #include <lib/system/common.hpp>
@@ -65,6 +68,7 @@ struct Connection {
     , node(std::move(rhs.node))
     , isSignal(rhs.isSignal)
     , connected(rhs.connected)
+    , metrics(rhs.metrics)
     , msgRels(std::move(rhs.msgRels)) {
     }
 
@@ -98,12 +102,48 @@ struct Connection {
     bool isRequested = false;
     uint32_t syncNeighbourRetries = 0;
 
+    // link telemetry, updated by several threads without locks
+    struct Metrics {
+        static constexpr uint32_t DefaultTimeout = 200'000;  // microseconds, until the first round trip sample
+        static constexpr uint32_t LossScale = 1'000'000;      // loss is kept in millionths
+
+        Metrics() = default;
+        Metrics(const Metrics&);
+
+        // round trip (PackInform replies and fragment requests), smoothed as in RFC 6298, microseconds
+        std::atomic<uint32_t> srtt = {0};
+        std::atomic<uint32_t> rttvar = {0};
+
+        // share of the packets sent again because the neighbour did not inform of them, moving average
+        std::atomic<uint32_t> loss = {0};
+
+        std::atomic<uint64_t> bytesIn = {0};
+        std::atomic<uint64_t> bytesOut = {0};
+        std::atomic<uint64_t> resent = {0};     // packets and fragments sent to it again
+        std::atomic<uint64_t> requested = {0};  // fragments asked from it again
+
+        // fragmented messages it completed and the time from the first fragment to the last one
+        std::atomic<uint64_t> completions = {0};
+        std::atomic<uint64_t> completionTime = {0};
+
+        void addRttSample(const uint32_t sample);
+        void addDelivery(const bool lost);
+        void addCompletion(const uint64_t time);
+
+        uint32_t getRetryTimeout() const;
+
+        // expected delivery time, microseconds: the lower the better
+        uint64_t getScore() const;
+    };
+
+    mutable Metrics metrics;
+
     struct MsgRel {
         uint32_t acceptOrder = 0;
         bool needSend = true;
     };
 
-    FixedHashMap<cs::Hash, MsgRel, uint16_t, MaxMessagesToKeep> msgRels;
+    FixedHashMap<cs::Hash, MsgRel, uint64_t, MaxMessagesToKeep> msgRels;
 
     cs::Sequence syncSeqs[BlocksToSync] = {0};
     cs::Sequence syncSeqsRetries[BlocksToSync] = {0};
@@ -125,6 +165,27 @@ public:
     const static uint32_t MinNeighbours = 3;
     const static uint32_t MaxConnectAttempts = 64;
 
+    // telemetry of a neighbour at the moment of the call
+    struct NeighbourMetrics {
+        cs::PublicKey key;
+        ip::udp::endpoint endpoint;
+        bool isSignal = false;
+
+        uint32_t rtt = 0;  // microseconds, 0 until the first sample
+        uint32_t rttVar = 0;
+        double loss = 0;
+
+        uint64_t bytesIn = 0;
+        uint64_t bytesOut = 0;
+        uint64_t resent = 0;
+        uint64_t requested = 0;
+
+        uint64_t completions = 0;
+        uint64_t averageCompletion = 0;  // microseconds
+
+        uint64_t score = 0;
+    };
+
     explicit Neighbourhood(Transport*);
 
     void sendByNeighbours(const Packet*);
@@ -181,6 +242,14 @@ public:
     void releaseSyncRequestee(const cs::Sequence seq);
     void registerDirect(const Packet*, ConnectionPtr);
 
+    // thread safe
+    std::vector<NeighbourMetrics> getMetrics() const;
+    void logMetrics() const;
+
+    // the number of the score the point from [0, 1] falls on when each score takes a share inverse to it,
+    // a zero score takes none; -1 if all are zero
+    static int pickByScore(const std::vector<uint64_t>& scores, const double point);
+
 private:
     struct BroadPackInfo {
         Packet pack;
@@ -199,6 +268,7 @@ private:
         bool received = false;
 
         uint32_t attempts = 0;
+        std::chrono::steady_clock::time_point sentAt;
     };
 
     bool isNewConnectionAvailable() const;
@@ -210,7 +280,7 @@ private:
     void connectNode(RemoteNodePtr, ConnectionPtr);
     void disconnectNode(ConnectionPtr*);
 
-    int getRandomSyncNeighbourNumber(const std::size_t attemptCount = 0);
+    int getRandomSyncNeighbourNumber();
 
     Transport* transport_;
 
@@ -218,9 +288,10 @@ private:
 
     mutable cs::SpinLock nLockFlag_{ATOMIC_FLAG_INIT};
     FixedVector<ConnectionPtr, MaxNeighbours> neighbours_;
+    FixedVector<ConnectionPtr, MaxNeighbours> ranked_;  // neighbours_ by score
 
     mutable cs::SpinLock mLockFlag_{ATOMIC_FLAG_INIT};
-    FixedHashMap<ip::udp::endpoint, ConnectionPtr, uint16_t, MaxConnections> connections_;
+    FixedHashMap<ip::udp::endpoint, ConnectionPtr, uint64_t, MaxConnections> connections_;
 
     struct SenderInfo {
         uint32_t totalSenders = 0;
@@ -228,9 +299,9 @@ private:
         ConnectionPtr prioritySender;
     };
 
-    FixedHashMap<cs::Hash, SenderInfo, uint16_t, MaxMessagesToKeep> msgSenders_;
-    FixedHashMap<cs::Hash, BroadPackInfo, uint16_t, 10000> msgBroads_;
-    FixedHashMap<cs::Hash, DirectPackInfo, uint16_t, 10000> msgDirects_;
+    FixedHashMap<cs::Hash, SenderInfo, uint64_t, MaxMessagesToKeep> msgSenders_;
+    FixedHashMap<cs::Hash, BroadPackInfo, uint64_t, 10000> msgBroads_;
+    FixedHashMap<cs::Hash, DirectPackInfo, uint64_t, 10000> msgDirects_;
 };
 
 #endif  // NEIGHBOURHOOD_HPP
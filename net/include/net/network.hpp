@@ -7,8 +7,14 @@
 #endif
 #include <boost/asio.hpp>
 
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include <client/config.hpp>
 #include <lib/system/cache.hpp>
+#include "pacer.hpp"
 #include "pacmans.hpp"
 
 using io_context = boost::asio::io_context;
@@ -30,6 +36,9 @@ public:
     void sendDirect(const Packet&, const ip::udp::endpoint&);
 
     bool resendFragment(const cs::Hash&, const uint16_t, const ip::udp::endpoint&);
+
+    // resends the fragments marked in the bitmap at once, returns their count
+    uint32_t resendFragments(const cs::Hash&, const uint16_t start, const cs::Bytes& missing, const ip::udp::endpoint&);
     void registerMessage(Packet*, const uint32_t size);
 
     Network(const Network&) = delete;
@@ -43,13 +52,47 @@ public:
         Success
     };
 
+    // recvmmsg batch sizes distribution: [1], [2, 3], [4, 7] ... [128, 255], [256]
+    static constexpr uint16_t MaxRecvBatchSize = 256;
+    static constexpr size_t RecvBatchBuckets = 9;
+    using RecvBatchStats = std::array<uint64_t, RecvBatchBuckets>;
+
+    // the most datagrams one sendmmsg call takes (UIO_MAXIOV)
+    static constexpr size_t MaxSendBatchSize = 1024;
+
+    // reader + processor pairs, each on its own SO_REUSEPORT socket
+    static constexpr uint16_t MaxShards = 16;
+
+    RecvBatchStats getRecvBatchStats() const;
+    void logStats() const;
+
 private:
-    void readerRoutine(const Config&);
+    // the kernel steers datagrams of one sender to one socket, so a shard
+    // sees all fragments of a message and its own order of them
+    struct Shard {
+        IPacMan iPacMan;
+
+        std::thread readerThread;
+        std::thread processorThread;
+
+        __cacheline_aligned std::atomic<ThreadStatus> readerStatus = {NonInit};
+        std::array<std::atomic<uint64_t>, RecvBatchBuckets> recvBatchStats = {};
+        __cacheline_aligned std::atomic<uint64_t> processed = {0};
+#ifdef __linux__
+        int readerEventfd = -1;
+#endif
+    };
+
+    void readerRoutine(const Config&, const size_t shardIndex);
+#ifdef __linux__
+    void readerBatchRoutine(ip::udp::socket*, const NetworkData&, Shard&);
+#endif
+    bool acceptTask(IPacMan::Task&, const size_t packetSize);
     void writerRoutine(const Config&);
-    void processorRoutine();
+    void processorRoutine(const size_t shardIndex);
     inline void processTask(TaskPtr<IPacMan>&);
 
-    ip::udp::socket* getSocketInThread(const bool, const EndpointData&, std::atomic<ThreadStatus>&, const bool useIPv6);
+    ip::udp::socket* getSocketInThread(const bool, const EndpointData&, std::atomic<ThreadStatus>&, const bool useIPv6, const bool reusePort = false);
 
     bool good_;
     bool stopReaderRoutine = false;
@@ -59,28 +102,32 @@ private:
     io_context context_;
     ip::udp::resolver resolver_;
 
-    IPacMan iPacMan_;
+    std::vector<std::unique_ptr<Shard>> shards_;
     OPacMan oPacMan_;
 
+    // encodes on the writer, decodes on the readers
+    CompressionPolicy compression_;
+    Pacer pacer_;
+
     Transport* transport_;
 
-    FixedHashMap<cs::Hash, uint32_t, uint16_t, 100000> packetMap_;
+    // processors of all the shards hash and collect in parallel, but go to the transport one by one
+    std::mutex transportLock_;
+
+    cs::SpinLock packetMapLock_{ATOMIC_FLAG_INIT};
+    FixedHashMap<cs::Hash, uint32_t, uint64_t, 100000> packetMap_;
 
     // Only needed in a one-socket configuration
     __cacheline_aligned std::atomic<bool> singleSockOpened_ = {false};
     __cacheline_aligned std::atomic<ip::udp::socket*> singleSock_ = {nullptr};
     std::atomic<bool> initFlag_ = {false};
 
-    __cacheline_aligned std::atomic<ThreadStatus> readerStatus_ = {NonInit};
     __cacheline_aligned std::atomic<ThreadStatus> writerStatus_ = {NonInit};
 
-    std::thread readerThread_;
     std::thread writerThread_;
-    std::thread processorThread_;
 
     PacketCollector collector_;
 #ifdef __linux__
-    int readerEventfd_;
     int writerEventfd_;
 #elif WIN32
     HANDLE readerEvent_ = nullptr;
@@ -0,0 +1,101 @@
+/* Send blaming letters to @yrtimd */
+#ifndef PACER_HPP
+#define PACER_HPP
+
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include <lib/system/common.hpp>
+#include "packet.hpp"
+
+struct NetworkData;
+
+/* Spreads the fragments of big replies in time, so they do not overflow
+   the socket buffers of the receivers. Every destination has a token
+   bucket (rate and burst in fragments), an optional global bucket caps
+   the whole egress. Packets which have no tokens wait in the queue of
+   their destination, the queues are served round-robin.
+   push() / pop() / getTimeout() are called by the writer,
+   getStats() from any thread */
+class Pacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // a destination which cannot send for so long loses the rest of its fragments
+    static constexpr size_t MaxQueued = Packet::MaxFragments * 2;
+
+    struct Item {
+        ip::udp::endpoint endpoint;
+        Packet pack;
+    };
+
+    struct PeerStats {
+        ip::udp::endpoint endpoint;
+        uint64_t sent = 0;
+        uint64_t paced = 0;    // had to wait for tokens
+        uint64_t dropped = 0;  // the queue was full
+        size_t queued = 0;
+    };
+
+    Pacer() = default;
+    explicit Pacer(const NetworkData&);
+
+    bool isEnabled() const {
+        return peerRate_ > 0 || globalRate_ > 0;
+    }
+
+    void push(const ip::udp::endpoint&, const Packet&, const Clock::time_point now);
+
+    // moves to items at most maxCount packets which may be sent now, returns their count
+    size_t pop(std::vector<Item>& items, const size_t maxCount, const Clock::time_point now);
+
+    // milliseconds till the next packet may be sent, -1 if nothing waits
+    int getTimeout(const Clock::time_point now) const;
+
+    std::vector<PeerStats> getStats() const;
+    void logStats() const;
+
+private:
+    struct Bucket {
+        double tokens = 0;
+        Clock::time_point updated;
+
+        void refill(const double rate, const double burst, const Clock::time_point now);
+    };
+
+    struct Peer {
+        Bucket bucket;
+        std::deque<Packet> queue;
+        bool active = false;
+
+        uint64_t sent = 0;
+        uint64_t paced = 0;
+        uint64_t dropped = 0;
+        Clock::time_point lastSent;
+    };
+
+    bool hasTokens(const Bucket&, const double rate) const;
+    void removeIdle(const Clock::time_point now);
+
+    double peerRate_ = 0;
+    double peerBurst_ = 0;
+    double globalRate_ = 0;
+    double globalBurst_ = 0;
+
+    Bucket global_;
+
+    std::map<ip::udp::endpoint, Peer> peers_;
+    std::deque<std::map<ip::udp::endpoint, Peer>::iterator> active_;
+    size_t queued_ = 0;
+
+    Clock::time_point lastCleanup_;
+
+    mutable cs::SpinLock lock_{ATOMIC_FLAG_INIT};
+};
+
+#endif  // PACER_HPP
@@ -9,18 +9,20 @@
 #include <lib/system/hash.hpp>
 #include <lib/system/logger.hpp>
 #include "lib/system/utils.hpp"
+#include "compression.hpp"
 
 #include <lz4.h>
 
+#include <chrono>
 #include <iostream>
 #include <memory>
 
 /*
-    Static min memory usage (see types below):
+    Memory usage (see types below):
 
     1 fragment = 1'024 b
-    1 message = 80 b * 4'096 fragments = 327'680 b
-    1 collector = 2'048 messages * 327'680 b = 671'088'640 b
+    1 message = 80 b * fragments of this message, slots are allocated when the message starts
+    1 collector = 1'024 messages, a few hundred kilobytes while they are empty
 */
 
 namespace ip = boost::asio::ip;
@@ -33,6 +35,7 @@ enum BaseFlags : uint8_t {
     Encrypted = 1 << 4,
     Signed = 1 << 5,
     Neighbours = 1 << 6,  // send packet to Neighbours only, Neighbours _cant_ resend it
+    Dictionary = 1 << 7,  // compressed with the shared dictionary, see CompressionPolicy
 };
 
 enum Offsets : uint32_t {
@@ -136,6 +139,9 @@ public:
     }
 
     const cs::Hash& getHeaderHash() const;
+
+    // calculates the hashes (and the header hashes of fragments) of several packets at once
+    static void hashBatch(Packet* const* packets, const size_t count);
     bool isHeaderValid() const;
 
     const uint16_t& getFragmentId() const {
@@ -177,7 +183,12 @@ public:
         return data_;
     }
 
-    boost::asio::mutable_buffer encode(boost::asio::mutable_buffer tempBuffer) {
+    // message type for the compression policy
+    uint16_t getCompressionType() const {
+        return isFragmented() && getFragmentId() != 0 ? CompressionPolicy::Continuation : static_cast<uint16_t>(getType());
+    }
+
+    boost::asio::mutable_buffer encode(boost::asio::mutable_buffer tempBuffer, CompressionPolicy* policy = nullptr) {
         if (data_.size() == 0) {
             cswarning() << "Encoding empty packet";
             return boost::asio::buffer(tempBuffer.data(), 0);
@@ -193,21 +204,39 @@ public:
             char* source = static_cast<char*>(data_.get());
             char* dest = static_cast<char*>(tempBuffer.data());
 
-            // copy header
-            std::copy(source, source + headerSize, dest);
-
             int sourceSize = static_cast<int>(data_.size() - headerSize);
             int destSize = static_cast<int>(tempBuffer.size() - headerSize);
 
-            int compressedSize = LZ4_compress_default(source + headerSize, dest + headerSize, sourceSize, destSize);
+            if (policy) {
+                const uint16_t type = getCompressionType();
+
+                if (policy->shouldCompress(type, static_cast<size_t>(sourceSize))) {
+                    bool withDictionary = false;
+                    int compressedSize = policy->compress(type, source + headerSize, dest + headerSize, sourceSize, destSize, withDictionary);
 
-            if ((compressedSize > 0) && (compressedSize < sourceSize)) {
-                return boost::asio::buffer(dest, static_cast<size_t>(compressedSize) + headerSize);
+                    if (compressedSize > 0) {
+                        std::copy(source, source + headerSize, dest);
+
+                        if (withDictionary) {
+                            *dest |= BaseFlags::Dictionary;
+                        }
+
+                        return boost::asio::buffer(dest, static_cast<size_t>(compressedSize) + headerSize);
+                    }
+                }
             }
             else {
+                int compressedSize = LZ4_compress_default(source + headerSize, dest + headerSize, sourceSize, destSize);
+
+                if ((compressedSize > 0) && (compressedSize < sourceSize)) {
+                    std::copy(source, source + headerSize, dest);
+                    return boost::asio::buffer(dest, static_cast<size_t>(compressedSize) + headerSize);
+                }
+
                 csdebug() << "Skipping packet compression, rawSize = " << sourceSize << ", compressedSize = " << compressedSize;
-                *source &= ~BaseFlags::Compressed;
             }
+
+            *source &= ~BaseFlags::Compressed;
         }
 
         char* source = static_cast<char*>(data_.get());
@@ -216,7 +245,7 @@ public:
         return boost::asio::buffer(dest, data_.size());
     }
 
-    size_t decode(size_t packetSize = 0) {
+    size_t decode(size_t packetSize = 0, const CompressionPolicy* policy = nullptr) {
         if (packetSize == 0) {
             return 0;
         }
@@ -245,11 +274,19 @@ public:
             int sourceSize = static_cast<int>(packetSize - headerSize);
             int destSize = static_cast<int>(sizeof(dest) - headerSize);
 
-            auto uncompressedSize = LZ4_decompress_safe(source + headerSize, dest, sourceSize, destSize);
+            const bool withDictionary = checkFlag(BaseFlags::Dictionary);
+            int uncompressedSize = 0;
+
+            if (policy) {
+                uncompressedSize = policy->decompress(source + headerSize, dest, sourceSize, destSize, withDictionary);
+            }
+            else if (!withDictionary) {
+                uncompressedSize = LZ4_decompress_safe(source + headerSize, dest, sourceSize, destSize);
+            }
 
             if ((uncompressedSize > 0) && (uncompressedSize <= destSize)) {
                 std::copy(dest, dest + uncompressedSize, source + headerSize);
-                *source &= ~BaseFlags::Compressed;
+                *source &= ~(BaseFlags::Compressed | BaseFlags::Dictionary);
                 packetSize = static_cast<size_t>(uncompressedSize) + headerSize;
             }
             else {
@@ -313,52 +350,41 @@ public:
     Message(const Message&) = delete;
     Message& operator=(const Message&) = delete;
 
-    ~Message();
-
     bool isComplete() const {
         return packetsLeft_ == 0;
     }
 
     const Packet& getFirstPack() const {
-        return *packets_;
+        return packets_[0];
     }
 
+    // the payload of all the fragments, gathered once on the first call;
+    // a single fragment is shared without copying
     const uint8_t* getFullData() const {
         if (!fullData_) {
             composeFullData();
         }
-        return static_cast<const uint8_t*>(fullData_.get()) + packets_->getHeadersLength();
+        return static_cast<const uint8_t*>(fullData_.get()) + packets_[0].getHeadersLength();
     }
 
     size_t getFullSize() const {
         if (!fullData_) {
             composeFullData();
         }
-        return fullData_.size() - packets_->getHeadersLength();
+        return fullData_.size() - packets_[0].getHeadersLength();
     }
 
     Packet extractData() const {
         if (!fullData_)
             composeFullData();
         Packet result(std::move(fullData_));
-        result.headersLength_ = packets_->getHeadersLength();
+        result.headersLength_ = packets_[0].getHeadersLength();
         return result;
     }
 
-    // scans array of future fragments and clears all dirty elements, scans only the first maxFragment elements
-    // return cleared elements count
-    size_t clearFragments() {
-        return clearBuffer(0, maxFragment_);
-    }
-
-    // scans array of future fragments and clears all dirty elements, scans only unused behind the maxFragment elements
-    // return cleared elements count
-    size_t clearUnused() {
-        return clearBuffer(maxFragment_, Packet::MaxFragments);
-    }
-
 private:
-    size_t clearBuffer(size_t from, size_t to);
+    // allocates empty slots for all the fragments of the message
+    void allocateFragments(const uint32_t count);
 
     static RegionAllocator allocator_;
 
@@ -370,10 +396,17 @@ private:
     uint32_t packetsTotal_ = 0;
 
     uint16_t maxFragment_ = 0;
-    Packet packets_[Packet::MaxFragments];
+    std::unique_ptr<Packet[]> packets_;
 
     cs::Hash headerHash_;
 
+    std::chrono::steady_clock::time_point firstFragment_;
+
+    // recovery of the missing fragments, see Transport::askForMissingPackages
+    std::chrono::steady_clock::time_point lastFragment_;  // the last new fragment came
+    std::chrono::steady_clock::time_point requested_;     // the missing fragments were requested
+    std::chrono::steady_clock::time_point answered_;      // the first new fragment after the request came
+
     mutable RegionPtr fullData_;
 
     friend class PacketCollector;
@@ -391,13 +424,14 @@ public:
     : msgAllocator_(MaxParallelCollections + 1) {
     }
 
-    MessagePtr getMessage(const Packet&, bool&);
+    // completed is set for the call that puts the last fragment in place
+    MessagePtr getMessage(const Packet&, bool& newFragmentedMsg, bool& completed);
 
 private:
     TypedAllocator<Message> msgAllocator_;
 
     cs::SpinLock mLock_{ATOMIC_FLAG_INIT};
-    FixedHashMap<cs::Hash, MessagePtr, uint16_t, MaxParallelCollections> map_;
+    FixedHashMap<cs::Hash, MessagePtr, uint64_t, MaxParallelCollections> map_;
 
     Message lastMessage_;
     friend class Network;
@@ -4,8 +4,9 @@
 
 #include <atomic>
 #include <boost/asio.hpp>
-#include <list>
-#include <mutex>
+
+#include <lib/system/common.hpp>
+#include <lib/system/queues.hpp>
 
 #include "packet.hpp"
 
@@ -50,17 +51,13 @@ private:
     friend Pacman;
 };
 
-template <typename Task>
-struct TaskBody {
-    operator Task&() {
-        return *reinterpret_cast<Task*>(data);
-    }
-
-    char data[sizeof(Task)];
-};
-
+/* Both queues are bounded SPSC rings: IPacMan is fed by the reader
+   thread and drained by the processor, OPacMan is drained by the
+   writer. When a ring is full a packet is dropped and counted. */
 class IPacMan {
 public:
+    static constexpr size_t QueueSize = 1 << 14;
+
     IPacMan()
     : allocator_(1 << 20) {
     }
@@ -72,40 +69,72 @@ public:
     };
 
     Task& allocNext();
-    void enQueueLast();
+    bool enQueueLast();
+    void rejectLast();
 
     TaskPtr<IPacMan> getNextTask();
+    // the queued task index places behind the next one, nullptr if there is none
+    Task* peekTask(const size_t index);
 
-    using TaskIterator = std::list<TaskBody<Task>>::iterator;
+    using TaskIterator = Task*;
     void releaseTask(TaskIterator&);
-    void rejectLast();
+
+    /* Batched receive: allocBatch reserves up to count tasks with
+       Packet::MaxSize buffers, accepted ones are marked by enQueueBatched
+       in the order of the batch, then commitBatch drops the rest,
+       publishes the accepted tasks and returns their number */
+    size_t allocBatch(const size_t count);
+    Task& batchTask(const size_t index);
+    void enQueueBatched(const size_t index);
+    size_t commitBatch();
+
+    uint64_t getDropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
 
 private:
-    std::list<TaskBody<Task>> queue_;
-    std::mutex mutex_;
-    std::atomic<size_t> size_ = {0};
+    Task& allocOverflow();
+
+    SpscRing<Task, QueueSize> queue_;
     RegionAllocator allocator_;
+
+    // receives a datagram when the queue is full, so the socket is still drained
+    Task overflow_;
+    bool overflowed_ = false;
+
+    size_t batchAccepted_ = 0;
+
+    __cacheline_aligned std::atomic<uint64_t> dropped_ = {0};
 };
 
 class OPacMan {
 public:
+    static constexpr size_t QueueSize = 1 << 14;
+
     struct Task {
         ip::udp::endpoint endpoint;
         Packet pack;
     };
 
-    Task* allocNext();
-    void enQueueLast();
+    // may be called from any thread, returns false if the packet is dropped
+    bool enQueue(const Packet&, const ip::udp::endpoint&);
 
     TaskPtr<OPacMan> getNextTask();
 
-    using TaskIterator = std::list<TaskBody<Task>>::iterator;
+    using TaskIterator = Task*;
     void releaseTask(TaskIterator&);
 
+    uint64_t getDropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
 private:
-    std::list<TaskBody<Task>> queue_;
-    std::mutex mutex_;
-    std::atomic<size_t> size_ = {0};
+    SpscRing<Task, QueueSize> queue_;
+
+    // packets are sent from several threads, so the producer side is serialized
+    cs::SpinLock producerLock_{ATOMIC_FLAG_INIT};
+
+    __cacheline_aligned std::atomic<uint64_t> dropped_ = {0};
 };
 
 #endif  // PACMANS_HPP
@@ -4,6 +4,7 @@
 
 #include <boost/asio.hpp>
 #include <csignal>
+#include <map>
 
 #include <client/config.hpp>
 
@@ -39,6 +40,7 @@ enum class NetworkCommand : uint8_t {
     PackRequest,
     PackRenounce,
     BlockSyncRequest,
+    PackRequestMissing,
     SSRegistration = 1,
     SSFirstRound = 31,
     SSRegistrationRefused = 25,
@@ -67,7 +69,7 @@ enum class SSBootstrapStatus : uint8_t {
 };
 
 template <>
-uint16_t getHashIndex(const ip::udp::endpoint&);
+uint64_t getHashIndex(const ip::udp::endpoint&);
 
 class Transport {
 public:
@@ -150,6 +152,8 @@ public:
     ConnectionPtr getConnectionByNumber(const std::size_t number);
     ConnectionPtr getRandomNeighbour();
 
+    std::vector<Neighbourhood::NeighbourMetrics> getNeighboursMetrics() const;
+
     std::unique_lock<cs::SpinLock> getNeighboursLock() const;
 
     // thread safe negihbours methods
@@ -193,11 +197,13 @@ private:
     bool gotPackInform(const TaskPtr<IPacMan>&, RemoteNodePtr&);
     bool gotPackRenounce(const TaskPtr<IPacMan>&, RemoteNodePtr&);
     bool gotPackRequest(const TaskPtr<IPacMan>&, RemoteNodePtr&);
+    bool gotPackRequestMissing(const TaskPtr<IPacMan>&, RemoteNodePtr&);
 
     bool gotPing(const TaskPtr<IPacMan>&, RemoteNodePtr&);
 
     void askForMissingPackages();
-    void requestMissing(const cs::Hash&, const uint16_t, const uint64_t);
+    bool requestMissing(const cs::Hash&, const uint16_t start, const cs::Bytes& missing, const Connection&);
+    bool requestPack(const cs::Hash&, const uint16_t start, const uint64_t req, const Connection&);
 
     /* Actions */
     bool good_;
@@ -218,7 +224,8 @@ private:
 
     TypedAllocator<RemoteNode> remoteNodes_;
 
-    FixedHashMap<ip::udp::endpoint, RemoteNodePtr, uint16_t, maxRemoteNodes_> remoteNodesMap_;
+    cs::SpinLock remoteNodesLock_{ATOMIC_FLAG_INIT};
+    FixedHashMap<ip::udp::endpoint, RemoteNodePtr, uint64_t, maxRemoteNodes_> remoteNodesMap_;
 
     RegionAllocator netPacksAllocator_;
     cs::PublicKey myPublicKey_;
@@ -261,6 +268,22 @@ private:
     cs::SpinLock uLock_{ATOMIC_FLAG_INIT};
     FixedCircularBuffer<MessagePtr, PacketCollector::MaxParallelCollections> uncollected_;
 
+    // the retry timer of a message waits for the round trip of its requestee, doubled on every retry
+    static constexpr uint32_t minRetryTimeout_ = 50'000;      // microseconds, the period of askForMissingPackages
+    static constexpr uint32_t maxRetryTimeout_ = 2'000'000;  // microseconds
+    static constexpr uint32_t maxRetryBackoff_ = 4;
+
+    struct MissingRequest {
+        ConnectionPtr requestee;
+        uint32_t attempts = 0;
+        bool sampled = true;
+        uint64_t pass = 0;
+    };
+
+    // uLock_
+    std::map<cs::Hash, MissingRequest> missingRequests_;
+    uint64_t missingPass_ = 0;
+
     cs::Sequence maxBlock_ = 0;
     cs::Sequence maxBlockCount_;
 
@@ -270,11 +293,9 @@ private:
     Neighbourhood nh_;
 
     static constexpr uint32_t fragmentsFixedMapSize_ = 10000;
-    FixedHashMap<cs::Hash, cs::RoundNumber, uint16_t, fragmentsFixedMapSize_> fragOnRound_;
+    FixedHashMap<cs::Hash, cs::RoundNumber, uint64_t, fragmentsFixedMapSize_> fragOnRound_;
 
 public:
-    inline static size_t cntDirtyAllocs = 0;
-    inline static size_t cntCorruptedFragments = 0;
     inline static size_t cntExtraLargeNotSent = 0;
 };
 
@@ -0,0 +1,132 @@
+/* Loopback load generator for the network shards.
+   Every sender thread owns a socket (its own source port), so the kernel
+   spreads the senders over the SO_REUSEPORT sockets of the node.
+   Run a node with [network] shards = N and compare "packets processed by shards"
+   in its log with the rate printed here. */
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ip = boost::asio::ip;
+
+// wire layout of a fragmented broadcast packet, see net/packet.hpp
+enum : uint8_t {
+    Fragmented = 1 << 1,
+    Broadcast = 1 << 2
+};
+
+constexpr size_t kPublicKeySize = 32;
+constexpr size_t kHeaderSize = 1 + 2 + 2 + 8 + kPublicKeySize;  // flags, fragment id, fragments num, id, sender
+constexpr size_t kMaxPacketSize = 1024;
+
+struct Settings {
+    std::string host = "127.0.0.1";
+    uint16_t port = 6000;
+    size_t senders = 4;
+    size_t seconds = 10;
+    uint16_t fragments = 4;
+    size_t packetSize = kMaxPacketSize;
+};
+
+static void sendRoutine(const Settings& settings, const ip::udp::endpoint& target, const size_t index, std::atomic<bool>& stop, std::atomic<uint64_t>& sent) {
+    boost::asio::io_context context;
+    ip::udp::socket sock(context, target.protocol());
+
+    std::mt19937_64 random(index + 1);
+    uint8_t packet[kMaxPacketSize];
+
+    for (auto& byte : packet) {
+        byte = static_cast<uint8_t>(random());
+    }
+
+    packet[0] = Fragmented | Broadcast;
+    std::memcpy(packet + 3, &settings.fragments, sizeof(uint16_t));
+
+    uint64_t id = static_cast<uint64_t>(index) << 48;
+    uint64_t local = 0;
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        std::memcpy(packet + 5, &id, sizeof(id));
+
+        for (uint16_t fragment = 0; fragment < settings.fragments; ++fragment) {
+            std::memcpy(packet + 1, &fragment, sizeof(uint16_t));
+
+            boost::system::error_code error;
+            sock.send_to(boost::asio::buffer(packet, settings.packetSize), target, 0, error);
+
+            if (!error) {
+                ++local;
+            }
+        }
+
+        ++id;
+
+        if (local >= 1024) {
+            sent.fetch_add(local, std::memory_order_relaxed);
+            local = 0;
+        }
+    }
+
+    sent.fetch_add(local, std::memory_order_relaxed);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cout << "Usage: " << argv[0] << " <host> <port> [senders = 4] [seconds = 10] [fragments = 4] [packet size = 1024]" << std::endl;
+        return 1;
+    }
+
+    Settings settings;
+    settings.host = argv[1];
+    settings.port = static_cast<uint16_t>(std::stoul(argv[2]));
+
+    if (argc > 3) {
+        settings.senders = std::max<size_t>(1, std::stoul(argv[3]));
+    }
+    if (argc > 4) {
+        settings.seconds = std::max<size_t>(1, std::stoul(argv[4]));
+    }
+    if (argc > 5) {
+        settings.fragments = static_cast<uint16_t>(std::max<size_t>(1, std::stoul(argv[5])));
+    }
+    if (argc > 6) {
+        settings.packetSize = std::min(kMaxPacketSize, std::max(kHeaderSize + 1, static_cast<size_t>(std::stoul(argv[6]))));
+    }
+
+    const ip::udp::endpoint target(ip::make_address(settings.host), settings.port);
+
+    std::atomic<bool> stop = {false};
+    std::atomic<uint64_t> sent = {0};
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < settings.senders; ++i) {
+        threads.emplace_back(sendRoutine, std::cref(settings), std::cref(target), i, std::ref(stop), std::ref(sent));
+    }
+
+    uint64_t last = 0;
+
+    for (size_t second = 0; second < settings.seconds; ++second) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        const uint64_t total = sent.load(std::memory_order_relaxed);
+        std::cout << "sent " << total - last << " packets/s" << std::endl;
+        last = total;
+    }
+
+    stop.store(true);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::cout << "total " << sent.load() << " packets from " << settings.senders << " senders in " << settings.seconds << " s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,274 @@
+/* Send blaming letters to @yrtimd */
+#include "compression.hpp"
+
+#include <client/config.hpp>
+#include <lib/system/logger.hpp>
+#include "packet.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+// share of a new packet in the running gain estimate
+constexpr float GainSmoothing = 1.f / 8;
+
+// a type which is not paying is still tried once per this number of its packets
+constexpr uint32_t ProbeInterval = 256;
+
+// payloads kept for the dictionary training
+constexpr size_t MaxSamplesSize = CompressionPolicy::MaxDictionarySize * 4;
+
+bool isSampledType(const uint16_t type) {
+    switch (type) {
+        case MsgTypes::TransactionPacket:
+        case MsgTypes::TransactionsPacketReply:
+        case MsgTypes::FirstStage:
+        case MsgTypes::SecondStage:
+        case MsgTypes::ThirdStage:
+            return true;
+        default:
+            return false;
+    }
+}
+}  // namespace
+
+CompressionPolicy::CompressionPolicy() {
+    LZ4_resetStream(&dictionaryStream_);
+}
+
+CompressionPolicy::CompressionPolicy(const NetworkData& settings)
+: CompressionPolicy() {
+    minSize_ = settings.compressionMinSize;
+    minGain_ = static_cast<float>(settings.compressionMinGain) / 100;
+
+    if (!settings.compressionTypes.empty()) {
+        for (auto& type : types_) {
+            type.enabled = false;
+        }
+
+        std::istringstream is(settings.compressionTypes);
+        std::string item;
+
+        while (std::getline(is, item, ',')) {
+            try {
+                const auto type = std::stoul(item);
+
+                if (type < Continuation) {
+                    types_[type].enabled = true;
+                }
+            }
+            catch (const std::exception&) {
+                cswarning() << "NET> Unknown compression message type: " << item;
+            }
+        }
+
+        types_[Continuation].enabled = true;
+    }
+
+    dictionaryPath_ = settings.compressionDictionary;
+
+    if (dictionaryPath_.empty()) {
+        return;
+    }
+
+    if (loadDictionary()) {
+        sendWithDictionary_ = settings.compressionDictionarySend;
+        cslog() << "NET> Compression dictionary loaded, " << dictionary_.size() << " bytes" << (sendWithDictionary_ ? ", used for sending" : "");
+    }
+    else {
+        training_ = true;
+        cslog() << "NET> No compression dictionary at " << dictionaryPath_ << ", it will be trained on the traffic";
+    }
+}
+
+CompressionPolicy::~CompressionPolicy() {
+    if (training_) {
+        saveDictionary();
+    }
+}
+
+bool CompressionPolicy::shouldCompress(const uint16_t type, const size_t size) {
+    TypeState& state = types_[type];
+    state.packets.fetch_add(1, std::memory_order_relaxed);
+
+    bool result = state.enabled && size >= minSize_;
+
+    if (result && !state.paying && ++state.sinceProbe < ProbeInterval) {
+        result = false;
+    }
+
+    if (!result) {
+        state.skipped.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        state.sinceProbe = 0;
+    }
+
+    return result;
+}
+
+int CompressionPolicy::compress(const uint16_t type, const char* source, char* dest, const int sourceSize, const int destSize, bool& withDictionary) {
+    if (training_ && isSampledType(type)) {
+        sample(source, sourceSize);
+    }
+
+    withDictionary = sendWithDictionary_;
+
+    const auto start = std::chrono::steady_clock::now();
+    int compressedSize = 0;
+
+    if (withDictionary) {
+        // LZ4_loadDict is too slow for every packet, a copy of the loaded stream is not
+        workStream_ = dictionaryStream_;
+        compressedSize = LZ4_compress_fast_continue(&workStream_, source, dest, sourceSize, destSize, 1);
+    }
+    else {
+        compressedSize = LZ4_compress_default(source, dest, sourceSize, destSize);
+    }
+
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    if (compressedSize <= 0 || compressedSize >= sourceSize) {
+        compressedSize = 0;
+    }
+
+    account(types_[type], sourceSize, compressedSize, static_cast<uint64_t>(ns));
+    return compressedSize;
+}
+
+int CompressionPolicy::decompress(const char* source, char* dest, const int sourceSize, const int destSize, const bool withDictionary) const {
+    if (!withDictionary) {
+        return LZ4_decompress_safe(source, dest, sourceSize, destSize);
+    }
+
+    if (dictionary_.empty()) {
+        cswarning() << "NET> Packet compressed with a dictionary, but there is no dictionary";
+        return -1;
+    }
+
+    return LZ4_decompress_safe_usingDict(source, dest, sourceSize, destSize, reinterpret_cast<const char*>(dictionary_.data()), static_cast<int>(dictionary_.size()));
+}
+
+void CompressionPolicy::setDictionary(const cs::Bytes& dictionary, const bool send) {
+    dictionary_.assign(dictionary.end() - static_cast<ptrdiff_t>(std::min(dictionary.size(), MaxDictionarySize)), dictionary.end());
+    sendWithDictionary_ = send && !dictionary_.empty();
+
+    LZ4_resetStream(&dictionaryStream_);
+    LZ4_loadDict(&dictionaryStream_, reinterpret_cast<const char*>(dictionary_.data()), static_cast<int>(dictionary_.size()));
+}
+
+cs::Bytes CompressionPolicy::buildDictionary(const std::deque<cs::Bytes>& samples) {
+    cs::Bytes result;
+    size_t size = 0;
+
+    auto first = samples.end();
+
+    while (first != samples.begin() && size + std::prev(first)->size() <= MaxDictionarySize) {
+        --first;
+        size += first->size();
+    }
+
+    result.reserve(size);
+
+    for (auto it = first; it != samples.end(); ++it) {
+        result.insert(result.end(), it->begin(), it->end());
+    }
+
+    return result;
+}
+
+CompressionPolicy::Stats CompressionPolicy::getStats(const uint16_t type) const {
+    const TypeState& state = types_[type];
+
+    Stats result;
+    result.packets = state.packets.load(std::memory_order_relaxed);
+    result.compressed = state.compressed.load(std::memory_order_relaxed);
+    result.skipped = state.skipped.load(std::memory_order_relaxed);
+    result.rawBytes = state.rawBytes.load(std::memory_order_relaxed);
+    result.savedBytes = state.savedBytes.load(std::memory_order_relaxed);
+    result.cpuNs = state.cpuNs.load(std::memory_order_relaxed);
+
+    return result;
+}
+
+void CompressionPolicy::logStats() const {
+    std::ostringstream os;
+
+    for (uint16_t type = 0; type < TypesCount; ++type) {
+        const Stats stats = getStats(type);
+
+        if (stats.packets == 0) {
+            continue;
+        }
+
+        os << "\n  " << (type == Continuation ? "Continuation" : Packet::messageTypeToString(static_cast<MsgTypes>(type))) << ": packets " << stats.packets
+           << ", compressed " << stats.compressed << ", skipped " << stats.skipped << ", saved " << stats.savedBytes << " of " << stats.rawBytes << " bytes, cpu "
+           << stats.cpuNs / 1000 << " us";
+    }
+
+    const std::string result = os.str();
+
+    if (!result.empty()) {
+        csdebug() << "NET> compression by message types:" << result;
+    }
+}
+
+void CompressionPolicy::account(TypeState& state, const int sourceSize, const int compressedSize, const uint64_t ns) {
+    const float gain = compressedSize ? 1.f - static_cast<float>(compressedSize) / static_cast<float>(sourceSize) : 0.f;
+
+    state.gain += (gain - state.gain) * GainSmoothing;
+    state.paying = state.gain >= minGain_;
+
+    state.rawBytes.fetch_add(static_cast<uint64_t>(sourceSize), std::memory_order_relaxed);
+    state.cpuNs.fetch_add(ns, std::memory_order_relaxed);
+
+    if (compressedSize) {
+        state.compressed.fetch_add(1, std::memory_order_relaxed);
+        state.savedBytes.fetch_add(static_cast<uint64_t>(sourceSize - compressedSize), std::memory_order_relaxed);
+    }
+}
+
+void CompressionPolicy::sample(const char* data, const int size) {
+    samples_.emplace_back(data, data + size);
+    samplesSize_ += static_cast<size_t>(size);
+
+    while (samplesSize_ > MaxSamplesSize) {
+        samplesSize_ -= samples_.front().size();
+        samples_.pop_front();
+    }
+}
+
+bool CompressionPolicy::loadDictionary() {
+    std::ifstream file(dictionaryPath_, std::ios::binary);
+
+    if (!file) {
+        return false;
+    }
+
+    const cs::Bytes dictionary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (dictionary.empty()) {
+        return false;
+    }
+
+    setDictionary(dictionary, false);
+    return true;
+}
+
+void CompressionPolicy::saveDictionary() const {
+    const cs::Bytes dictionary = buildDictionary(samples_);
+
+    if (dictionary.empty()) {
+        return;
+    }
+
+    std::ofstream file(dictionaryPath_, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(dictionary.data()), static_cast<std::streamsize>(dictionary.size()));
+
+    if (file) {
+        cslog() << "NET> Compression dictionary of " << dictionary.size() << " bytes saved to " << dictionaryPath_;
+    }
+}
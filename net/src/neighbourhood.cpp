@@ -6,6 +6,18 @@
 #include <csnode/blockchain.hpp>
 #include <lib/system/utils.hpp>
 
+#include <algorithm>
+#include <sstream>
+
+namespace {
+// share of a new delivery in the loss estimate
+constexpr uint32_t LossSmoothing = 16;
+
+uint64_t toMicroseconds(const std::chrono::steady_clock::duration duration) {
+    return static_cast<uint64_t>(std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), 0));
+}
+}  // namespace
+
 Neighbourhood::Neighbourhood(Transport* net)
 : transport_(net)
 , connectionsAllocator_(MaxConnections + 1)
@@ -20,6 +32,57 @@ T getSecureRandom() {
     return result;
 }
 
+Connection::Metrics::Metrics(const Metrics& rhs)
+: srtt(rhs.srtt.load(std::memory_order_relaxed))
+, rttvar(rhs.rttvar.load(std::memory_order_relaxed))
+, loss(rhs.loss.load(std::memory_order_relaxed))
+, bytesIn(rhs.bytesIn.load(std::memory_order_relaxed))
+, bytesOut(rhs.bytesOut.load(std::memory_order_relaxed))
+, resent(rhs.resent.load(std::memory_order_relaxed))
+, requested(rhs.requested.load(std::memory_order_relaxed))
+, completions(rhs.completions.load(std::memory_order_relaxed))
+, completionTime(rhs.completionTime.load(std::memory_order_relaxed)) {
+}
+
+void Connection::Metrics::addRttSample(const uint32_t sample) {
+    // concurrent samples may overwrite each other, a lost one does not matter
+    const uint32_t oldSrtt = srtt.load(std::memory_order_relaxed);
+
+    if (oldSrtt == 0) {
+        rttvar.store(sample / 2, std::memory_order_relaxed);
+        srtt.store(std::max(sample, 1u), std::memory_order_relaxed);
+        return;
+    }
+
+    const uint32_t delta = oldSrtt > sample ? oldSrtt - sample : sample - oldSrtt;
+    rttvar.store((3 * rttvar.load(std::memory_order_relaxed) + delta) / 4, std::memory_order_relaxed);
+    srtt.store(std::max((7 * oldSrtt + sample) / 8, 1u), std::memory_order_relaxed);
+}
+
+void Connection::Metrics::addDelivery(const bool lost) {
+    const int64_t old = loss.load(std::memory_order_relaxed);
+    const int64_t target = lost ? LossScale : 0;
+    loss.store(static_cast<uint32_t>(old + (target - old) / LossSmoothing), std::memory_order_relaxed);
+}
+
+void Connection::Metrics::addCompletion(const uint64_t time) {
+    completionTime.fetch_add(time, std::memory_order_relaxed);
+    completions.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t Connection::Metrics::getRetryTimeout() const {
+    const uint32_t rtt = srtt.load(std::memory_order_relaxed);
+    return rtt ? rtt + 4 * rttvar.load(std::memory_order_relaxed) : DefaultTimeout;
+}
+
+uint64_t Connection::Metrics::getScore() const {
+    const uint64_t rtt = srtt.load(std::memory_order_relaxed);
+    const uint64_t lost = std::min<uint64_t>(loss.load(std::memory_order_relaxed), LossScale - LossScale / 100);
+
+    // a packet needs 1 / (1 - loss) attempts on average
+    return (rtt ? rtt : DefaultTimeout) * LossScale / (LossScale - lost);
+}
+
 bool Neighbourhood::dispatch(Neighbourhood::BroadPackInfo& bp) {
     bool result = false;
 
@@ -33,7 +96,7 @@ bool Neighbourhood::dispatch(Neighbourhood::BroadPackInfo& bp) {
 
     bool sent = false;
 
-    for (auto& nb : neighbours_) {
+    for (auto& nb : ranked_) {
         bool found = false;
         for (auto ptr = bp.receivers; ptr != bp.recEnd; ++ptr) {
             if (*ptr == nb->id) {
@@ -44,7 +107,15 @@ bool Neighbourhood::dispatch(Neighbourhood::BroadPackInfo& bp) {
 
         if (!found) {
             if (!nb->isSignal || (!bp.pack.isNetwork() && (bp.pack.getType() == MsgTypes::RoundTable || bp.pack.getType() == MsgTypes::BlockHash))) {
-                sent = transport_->sendDirect(&(bp.pack), **nb) || sent;
+                const bool sentTo = transport_->sendDirect(&(bp.pack), **nb);
+
+                // the neighbour has not informed of the previous attempt
+                if (sentTo && bp.attempts && !nb->isSignal) {
+                    nb->metrics.addDelivery(true);
+                    nb->metrics.resent.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                sent = sentTo || sent;
             }
 
             // Assume the SS got this
@@ -71,6 +142,14 @@ bool Neighbourhood::dispatch(Neighbourhood::DirectPackInfo& dp) {
     }
 
     if (transport_->sendDirect(&(dp.pack), **dp.receiver)) {
+        if (dp.attempts) {
+            dp.receiver->metrics.addDelivery(true);
+            dp.receiver->metrics.resent.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            dp.sentAt = std::chrono::steady_clock::now();
+        }
+
         ++dp.attempts;
     }
 
@@ -81,7 +160,7 @@ void Neighbourhood::sendByNeighbours(const Packet* pack) {
     cs::Lock lock(nLockFlag_);
 
     if (pack->isNeighbors()) {
-        for (auto& nb : neighbours_) {
+        for (auto& nb : ranked_) {
             auto& bp = msgDirects_.tryStore(pack->getHash());
 
             bp.pack = *pack;
@@ -185,6 +264,12 @@ void Neighbourhood::checkNeighbours() {
     {
         cs::Lock lock(nLockFlag_);
         size = neighbours_.size();
+
+        // broadcasts and redirects go to the fast neighbours first,
+        // neighbours_ keeps its order since the synchronizer indexes it
+        std::stable_sort(ranked_.begin(), ranked_.end(), [](const ConnectionPtr& lhs, const ConnectionPtr& rhs) {
+            return lhs->metrics.getScore() < rhs->metrics.getScore();
+        });
     }
 
     if (size < MinNeighbours) {
@@ -357,9 +442,15 @@ void Neighbourhood::connectNode(RemoteNodePtr node, ConnectionPtr conn) {
     }
 
     neighbours_.emplace(conn);
+    ranked_.emplace(conn);
 }
 
 void Neighbourhood::disconnectNode(ConnectionPtr* connPtr) {
+    auto rankedPtr = findInVec((*connPtr)->id, ranked_);
+    if (rankedPtr) {
+        ranked_.remove(rankedPtr);
+    }
+
     (*connPtr)->connected = false;
     (*connPtr)->node = RemoteNodePtr();
     neighbours_.remove(connPtr);
@@ -485,6 +576,16 @@ void Neighbourhood::neighbourHasPacket(RemoteNodePtr node, const cs::Hash& hash,
 
     if (isDirect) {
         auto& dp = msgDirects_.tryStore(hash);
+
+        if (!dp.received && dp.pack && dp.receiver && dp.receiver->id == conn->id && dp.attempts) {
+            conn->metrics.addDelivery(false);
+
+            // Karn's rule: a resent packet gives no round trip sample
+            if (dp.attempts == 1) {
+                conn->metrics.addRttSample(static_cast<uint32_t>(std::min<uint64_t>(toMicroseconds(std::chrono::steady_clock::now() - dp.sentAt), UINT32_MAX)));
+            }
+        }
+
         dp.received = true;
     }
     else {
@@ -496,6 +597,12 @@ void Neighbourhood::neighbourHasPacket(RemoteNodePtr node, const cs::Hash& hash,
             }
         }
 
+        // a broadcast ack may come after the neighbour got the packet
+        // from someone else, so it counts a delivery but not a round trip
+        if (bp.pack && bp.attempts) {
+            conn->metrics.addDelivery(false);
+        }
+
         if ((bp.recEnd - bp.receivers) < MaxNeighbours) {
             *(bp.recEnd++) = conn->id;
         }
@@ -555,7 +662,7 @@ void Neighbourhood::neighbourSentRenounce(RemoteNodePtr node, const cs::Hash& ha
 void Neighbourhood::redirectByNeighbours(const Packet* pack) {
     cs::Lock lock(nLockFlag_);
 
-    for (auto& nb : neighbours_) {
+    for (auto& nb : ranked_) {
         Connection::MsgRel& rel = nb->msgRels.tryStore(pack->getHeaderHash());
         if (rel.needSend) {
             transport_->sendDirect(pack, **nb);
@@ -837,37 +944,97 @@ void Neighbourhood::releaseSyncRequestee(const cs::Sequence seq) {
     }
 }
 
-int Neighbourhood::getRandomSyncNeighbourNumber(const std::size_t attemptCount) {
+int Neighbourhood::getRandomSyncNeighbourNumber() {
     if (neighbours_.size() == 0) {
         cslog() << "Neighbourhood, no neighbours";
         return -1;
     }
 
-    const size_t neighbourCount = static_cast<size_t>(neighbours_.size() - 1U);
+    std::vector<uint64_t> scores;
+    scores.reserve(neighbours_.size());
 
-    if (attemptCount > (neighbourCount * 3)) {
-        int index = 0;
-        for (const auto& nb : neighbours_) {
-            if (nb->isSignal || nb->isRequested) {
-                ++index;
-            }
-            else {
-                return index;
-            }
+    for (const auto& nb : neighbours_) {
+        scores.push_back(nb && !nb->isSignal && !nb->isRequested ? nb->metrics.getScore() : 0);
+    }
+
+    return pickByScore(scores, cs::Utils::generateRandomValue<double>(0., 1.));
+}
+
+int Neighbourhood::pickByScore(const std::vector<uint64_t>& scores, const double point) {
+    // the chance of a neighbour is inverse to its expected delivery time
+    double total = 0;
+
+    for (const auto score : scores) {
+        if (score != 0) {
+            total += 1. / static_cast<double>(score);
         }
+    }
+
+    if (total <= 0) {
         return -1;
     }
 
-    const int randomNumber = cs::Utils::generateRandomValue<int>(0, static_cast<int>(neighbourCount));
-    const ConnectionPtr nb = *(neighbours_.begin() + randomNumber);
+    double left = point * total;
+    int last = -1;
 
-    if (!nb) {
-        return -1;
+    for (size_t i = 0; i < scores.size(); ++i) {
+        if (scores[i] == 0) {
+            continue;
+        }
+
+        last = static_cast<int>(i);
+        left -= 1. / static_cast<double>(scores[i]);
+
+        if (left <= 0) {
+            return last;
+        }
+    }
+
+    return last;
+}
+
+std::vector<Neighbourhood::NeighbourMetrics> Neighbourhood::getMetrics() const {
+    cs::Lock lock(nLockFlag_);
+
+    std::vector<NeighbourMetrics> result;
+    result.reserve(neighbours_.size());
+
+    for (const auto& nb : neighbours_) {
+        const Connection::Metrics& metrics = nb->metrics;
+
+        NeighbourMetrics item;
+        item.key = nb->key;
+        item.endpoint = nb->getOut();
+        item.isSignal = nb->isSignal;
+        item.rtt = metrics.srtt.load(std::memory_order_relaxed);
+        item.rttVar = metrics.rttvar.load(std::memory_order_relaxed);
+        item.loss = static_cast<double>(metrics.loss.load(std::memory_order_relaxed)) / Connection::Metrics::LossScale;
+        item.bytesIn = metrics.bytesIn.load(std::memory_order_relaxed);
+        item.bytesOut = metrics.bytesOut.load(std::memory_order_relaxed);
+        item.resent = metrics.resent.load(std::memory_order_relaxed);
+        item.requested = metrics.requested.load(std::memory_order_relaxed);
+        item.completions = metrics.completions.load(std::memory_order_relaxed);
+        item.averageCompletion = item.completions ? metrics.completionTime.load(std::memory_order_relaxed) / item.completions : 0;
+        item.score = metrics.getScore();
+
+        result.push_back(item);
     }
 
-    if (nb->isSignal || nb->isRequested) {
-        return getRandomSyncNeighbourNumber(attemptCount + 1);
+    return result;
+}
+
+void Neighbourhood::logMetrics() const {
+    std::ostringstream os;
+
+    for (const auto& item : getMetrics()) {
+        os << "\n  " << item.endpoint << (item.isSignal ? " (SS)" : "") << ": rtt " << item.rtt << " +- " << item.rttVar << " us, loss " << item.loss * 100 << "%, in "
+           << item.bytesIn << " bytes, out " << item.bytesOut << " bytes, resent " << item.resent << ", requested " << item.requested << ", completed "
+           << item.completions << " in " << item.averageCompletion << " us on average";
     }
 
-    return randomNumber;
+    const std::string result = os.str();
+
+    if (!result.empty()) {
+        csdebug() << "NET> neighbours:" << result;
+    }
 }
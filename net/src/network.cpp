@@ -21,7 +21,9 @@
 #include "network.hpp"
 #include "transport.hpp"
 
+#include <algorithm>
 #include <set>
+#include <sstream>
 
 // disables 10052, 10054 win socket errors
 #if defined(WIN32)
@@ -32,7 +34,7 @@ using boost::asio::buffer;
 
 const ip::udp::socket::message_flags NO_FLAGS = 0;
 
-static ip::udp::socket bindSocket(io_context& context, Network* net, const EndpointData& data, bool ipv6 = true) {
+static ip::udp::socket bindSocket(io_context& context, Network* net, const EndpointData& data, bool ipv6 = true, bool reusePort = false) {
     try {
         ip::udp::socket sock(context, ipv6 ? ip::udp::v6() : ip::udp::v4());
 
@@ -41,6 +43,14 @@ static ip::udp::socket bindSocket(io_context& context, Network* net, const Endpo
         }
 
         sock.set_option(ip::udp::socket::reuse_address(true));
+#ifdef __linux__
+        if (reusePort) {
+            using reuse_port = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+            sock.set_option(reuse_port(true));
+        }
+#else
+        (void)reusePort;
+#endif
 #ifndef __APPLE__
         sock.set_option(ip::udp::socket::send_buffer_size(1 << 23));
         sock.set_option(ip::udp::socket::receive_buffer_size(1 << 23));
@@ -73,11 +83,12 @@ ip::udp::endpoint Network::resolve(const EndpointData& data) {
     return ip::udp::endpoint(data.ip, data.port);
 }
 
-ip::udp::socket* Network::getSocketInThread(const bool openOwn, const EndpointData& epd, std::atomic<Network::ThreadStatus>& status, const bool ipv6) {
+ip::udp::socket* Network::getSocketInThread(const bool openOwn, const EndpointData& epd, std::atomic<Network::ThreadStatus>& status, const bool ipv6,
+                                            const bool reusePort) {
     ip::udp::socket* result = nullptr;
 
     if (openOwn) {
-        result = new ip::udp::socket(bindSocket(context_, this, epd, ipv6));
+        result = new ip::udp::socket(bindSocket(context_, this, epd, ipv6, reusePort));
 
         if (!result->is_open()) {
             result = nullptr;
@@ -94,8 +105,63 @@ ip::udp::socket* Network::getSocketInThread(const bool openOwn, const EndpointDa
     return result;
 }  // resolve
 
-void Network::readerRoutine(const Config& config) {
-    ip::udp::socket* sock = getSocketInThread(config.hasTwoSockets(), config.getInputEndpoint(), readerStatus_, config.useIPv6());
+static inline size_t getRecvBatchBucket(size_t batchSize) {
+    size_t bucket = 0;
+
+    while (batchSize >>= 1) {
+        ++bucket;
+    }
+
+    return std::min(bucket, Network::RecvBatchBuckets - 1);
+}
+
+// the dedup hashes of the queued tasks are calculated at once, processTask() only looks them up
+static void hashTasks(IPacMan& iPacMan, const size_t count, std::vector<Packet*>& packets) {
+    packets.clear();
+
+    for (size_t i = 0; i < count; ++i) {
+        IPacMan::Task* task = iPacMan.peekTask(i);
+
+        if (!task) {
+            break;
+        }
+
+        if (!task->pack.isNetwork() && task->pack.isHeaderValid()) {
+            packets.push_back(&task->pack);
+        }
+    }
+
+    Packet::hashBatch(packets.data(), packets.size());
+}
+
+bool Network::acceptTask(IPacMan::Task& task, const size_t packetSize) {
+    task.size = task.pack.decode(packetSize, &compression_);  // try to decode first
+
+    if (task.size == 0) {
+        cswarning() << "Ignore incorrect packet fragment, drop";
+        return false;
+    }
+
+    if (!task.pack.hasValidFragmentation()) {
+        cswarning() << "Incorrect fragment identity in message or too many fragments, drop (" << task.pack.getFragmentId() << " from " << task.pack.getFragmentsNum()
+                    << "), sender " << task.sender;
+        return false;
+    }
+
+#ifdef LOG_NET
+    csdebug(logger::Net) << "<-- " << packetSize << " bytes from " << task.sender << " " << task.pack;
+#endif
+
+    return true;
+}
+
+void Network::readerRoutine(const Config& config, const size_t shardIndex) {
+    Shard& shard = *shards_[shardIndex];
+    IPacMan& iPacMan = shard.iPacMan;
+
+    // every shard but the first one always listens on its own socket
+    const bool sharded = shards_.size() > 1;
+    ip::udp::socket* sock = getSocketInThread(config.hasTwoSockets() || shardIndex > 0, config.getInputEndpoint(), shard.readerStatus, config.useIPv6(), sharded);
 
     if (!sock) {
         return;
@@ -106,11 +172,18 @@ void Network::readerRoutine(const Config& config) {
         std::this_thread::sleep_for(1s);
     }
 
+#ifdef __linux__
+    if (config.getNetworkSettings().recvBatchSize > 1) {
+        readerBatchRoutine(sock, config.getNetworkSettings(), shard);
+        return;
+    }
+#endif
+
     boost::system::error_code lastError;
     size_t packetSize;
 
     while (stopReaderRoutine == false) {  // changed from true
-        auto& task = iPacMan_.allocNext();
+        auto& task = iPacMan.allocNext();
 
         if (stopReaderRoutine) {
             return;
@@ -126,32 +199,17 @@ void Network::readerRoutine(const Config& config) {
         }
 
         if (!lastError) {
-            task.size = task.pack.decode(packetSize);  // try to decode first
-
-            bool reject = false;
-            if (task.size == 0) {
-                cswarning() << "Ignore incorrect packet fragment, drop";
-                reject = true;
-            }
-            else if (!task.pack.hasValidFragmentation()) {
-                cswarning() << "Incorrect fragment identity in message or too many fragments, drop (" << task.pack.getFragmentId() << " from " << task.pack.getFragmentsNum()
-                            << "), sender " << task.sender;
-                reject = true;
-            }
-
-            if (reject) {
-                iPacMan_.rejectLast();
+            if (!acceptTask(task, packetSize)) {
+                iPacMan.rejectLast();
+                continue;
             }
-            else {
-                iPacMan_.enQueueLast();
 
-#ifdef LOG_NET
-                csdebug(logger::Net) << "<-- " << packetSize << " bytes from " << task.sender << " " << task.pack;
-#endif
+            if (!iPacMan.enQueueLast()) {
+                continue;
             }
 #ifdef __linux__
             static uint64_t one = 1;
-            write(readerEventfd_, &one, sizeof(uint64_t));
+            write(shard.readerEventfd, &one, sizeof(uint64_t));
 #endif
 #if defined(WIN32) || defined(__APPLE__)
             while (readerLock.test_and_set(std::memory_order_acquire))  // acquire lock
@@ -167,14 +225,166 @@ void Network::readerRoutine(const Config& config) {
         }
         else {
             cserror() << "Cannot receive packet. Error " << lastError;
-            iPacMan_.rejectLast();
+            iPacMan.rejectLast();
         }
     }
 
     cswarning() << "readerRoutine STOPPED!!!\n";
 }
 
-static inline void sendPack(ip::udp::socket& sock, TaskPtr<OPacMan>& task, const ip::udp::endpoint& ep) {
+#ifdef __linux__
+void Network::readerBatchRoutine(ip::udp::socket* sock, const NetworkData& settings, Shard& shard) {
+    IPacMan& iPacMan = shard.iPacMan;
+    const size_t batchSize = std::min(settings.recvBatchSize, MaxRecvBatchSize);
+
+    struct timespec timeout {
+        0, static_cast<long>(settings.recvBatchTimeout) * 1000
+    };
+
+    std::vector<struct mmsghdr> msg(batchSize);
+    std::vector<struct iovec> iovecs(batchSize);
+    std::vector<ip::udp::endpoint> senders(batchSize);
+
+    struct pollfd pfd {};
+    pfd.fd = sock->native_handle();
+    pfd.events = POLLIN;
+
+    // a socket failing again and again is not polled at full speed
+    constexpr std::chrono::milliseconds maxErrorPause(1000);
+    std::chrono::milliseconds errorPause(0);
+
+    while (stopReaderRoutine == false) {
+        const size_t reserved = iPacMan.allocBatch(batchSize);
+
+        if (stopReaderRoutine) {
+            return;
+        }
+
+        for (size_t i = 0; i < reserved; ++i) {
+            auto& task = iPacMan.batchTask(i);
+
+            iovecs[i].iov_base = task.pack.data();
+            iovecs[i].iov_len = Packet::MaxSize;
+
+            msg[i] = mmsghdr{};
+            msg[i].msg_hdr.msg_iov = &iovecs[i];
+            msg[i].msg_hdr.msg_iovlen = 1;
+            msg[i].msg_hdr.msg_name = senders[i].data();
+            msg[i].msg_hdr.msg_namelen = static_cast<socklen_t>(senders[i].capacity());
+        }
+
+        // block until the first datagram, then take whatever is already queued
+        int received = recvmmsg(sock->native_handle(), msg.data(), static_cast<unsigned>(reserved), MSG_WAITFORONE, nullptr);
+
+        if (received < 0) {
+            const int error = errno;
+
+            // the socket itself is broken, no retry helps
+            if (error == EBADF || error == ENOTSOCK || error == EINVAL || error == EFAULT) {
+                cserror() << "Cannot receive packets, recvmmsg errno = " << error << ", the reader stops";
+                break;
+            }
+
+            if (error != EINTR) {
+                cserror() << "Cannot receive packets, recvmmsg errno = " << error;
+
+                errorPause = std::min(std::max(errorPause * 2, std::chrono::milliseconds(1)), maxErrorPause);
+                std::this_thread::sleep_for(errorPause);
+            }
+
+            received = 0;
+        }
+        else {
+            errorPause = std::chrono::milliseconds(0);
+
+            if (timeout.tv_nsec > 0 && static_cast<size_t>(received) < reserved && ppoll(&pfd, 1, &timeout, nullptr) > 0) {
+                // linger to fill the rest of the batch
+                int more = recvmmsg(sock->native_handle(), msg.data() + received, static_cast<unsigned>(reserved - received), MSG_DONTWAIT, nullptr);
+
+                if (more > 0) {
+                    received += more;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < static_cast<size_t>(received); ++i) {
+            auto& task = iPacMan.batchTask(i);
+            senders[i].resize(msg[i].msg_hdr.msg_namelen);
+            task.sender = senders[i];
+
+            if (acceptTask(task, msg[i].msg_len)) {
+                iPacMan.enQueueBatched(i);
+            }
+        }
+
+        uint64_t accepted = iPacMan.commitBatch();
+
+        if (received > 0) {
+            shard.recvBatchStats[getRecvBatchBucket(static_cast<size_t>(received))].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // one signal to the processor per batch
+        if (accepted) {
+            write(shard.readerEventfd, &accepted, sizeof(uint64_t));
+        }
+    }
+
+    cswarning() << "readerBatchRoutine STOPPED!!!\n";
+}
+#endif
+
+Network::RecvBatchStats Network::getRecvBatchStats() const {
+    RecvBatchStats result = {};
+
+    for (const auto& shard : shards_) {
+        for (size_t i = 0; i < RecvBatchBuckets; ++i) {
+            result[i] += shard->recvBatchStats[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    return result;
+}
+
+void Network::logStats() const {
+    uint64_t inDropped = 0;
+
+    for (const auto& shard : shards_) {
+        inDropped += shard->iPacMan.getDropped();
+    }
+
+    if (inDropped || oPacMan_.getDropped()) {
+        cslog() << "NET> queues overflow, dropped in: " << inDropped << ", out: " << oPacMan_.getDropped();
+    }
+
+    if (shards_.size() > 1) {
+        std::ostringstream os;
+
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            os << " [" << i << "]: " << shards_[i]->processed.load(std::memory_order_relaxed);
+        }
+
+        csdebug() << "NET> packets processed by shards" << os.str();
+    }
+
+    compression_.logStats();
+    pacer_.logStats();
+
+    const auto batches = getRecvBatchStats();
+
+    if (std::all_of(batches.begin(), batches.end(), [](uint64_t value) { return value == 0; })) {
+        return;
+    }
+
+    std::ostringstream os;
+
+    for (size_t i = 0; i < RecvBatchBuckets; ++i) {
+        os << " [" << (1u << i) << "]: " << batches[i];
+    }
+
+    csdebug() << "NET> recvmmsg batches" << os.str();
+}
+
+static inline void sendPack(ip::udp::socket& sock, TaskPtr<OPacMan>& task, const ip::udp::endpoint& ep, CompressionPolicy& compression) {
     boost::system::error_code lastError;
     size_t size = 0;
     size_t encodedSize = 0;
@@ -184,7 +394,7 @@ static inline void sendPack(ip::udp::socket& sock, TaskPtr<OPacMan>& task, const
     // net code was built on this constant (Packet::MaxSize)
     // and is used it implicitly in a lot of places(
     char packetBuffer[Packet::MaxSize];
-    boost::asio::mutable_buffer encodedPacket = task->pack.encode(buffer(packetBuffer, sizeof(packetBuffer)));
+    boost::asio::mutable_buffer encodedPacket = task->pack.encode(buffer(packetBuffer, sizeof(packetBuffer)), &compression);
     encodedSize = encodedPacket.size();
     do {
         size = sock.send_to(encodedPacket, ep, NO_FLAGS, lastError);
@@ -217,59 +427,102 @@ void Network::writerRoutine(const Config& config) {
     std::vector<std::array<char, Packet::MaxSize>> packets_buffer;
     std::vector<boost::asio::mutable_buffer> encoded_packets;
     std::vector<ip::udp::endpoint> endpoints;
+    std::vector<Pacer::Item> paced;
+
+    auto prepare = [&](const size_t count) {
+        msg.resize(count);
+        std::fill(msg.begin(), msg.end(), mmsghdr{});
+        iovecs.resize(count);
+        std::fill(iovecs.begin(), iovecs.end(), iovec{});
+        packets_buffer.resize(count);
+        endpoints.resize(count);
+        encoded_packets.clear();
+    };
+
+    auto add = [&](Packet& pack, const ip::udp::endpoint& endpoint) {
+        const size_t j = encoded_packets.size();
+        encoded_packets.emplace_back(pack.encode(buffer(packets_buffer[j].data(), Packet::MaxSize), &compression_));
+        endpoints[j] = endpoint;
+        iovecs[j].iov_base = encoded_packets[j].data();
+        iovecs[j].iov_len = encoded_packets[j].size();
+        msg[j].msg_hdr.msg_iov = &iovecs[j];
+        msg[j].msg_hdr.msg_iovlen = 1;
+        msg[j].msg_hdr.msg_name = endpoints[j].data();
+        msg[j].msg_hdr.msg_namelen = endpoints[j].size();
+    };
+
+    auto send = [&]() {
+        uint64_t tasks = encoded_packets.size();
+        int sended = 0;
+        struct mmsghdr* messages = msg.data();
+        while (tasks) {
+            sended = sendmmsg(sock->native_handle(), messages, tasks, 0);
+            if (sended < 0) {
+                cslog() << "sendmmsg errno = " << errno;
+                if (errno != EAGAIN)
+                    break;
+                continue;
+            }
+            messages += sended;
+            tasks -= sended;
+        }
+    };
 #endif
     while (stopWriterRoutine == false) {  // changed from true
 #ifdef __linux__
-        uint64_t tasks;
-        int s = read(writerEventfd_, &tasks, sizeof(uint64_t));
-        if (s != sizeof(uint64_t))
+        uint64_t tasks = 0;
+
+        if (pacer_.isEnabled()) {
+            // wake up for the new packets or for the tokens of the waiting ones
+            pollfd fd = {writerEventfd_, POLLIN, 0};
+
+            if (poll(&fd, 1, pacer_.getTimeout(Pacer::Clock::now())) > 0 && read(writerEventfd_, &tasks, sizeof(uint64_t)) != sizeof(uint64_t)) {
+                tasks = 0;
+            }
+        }
+        else if (read(writerEventfd_, &tasks, sizeof(uint64_t)) != sizeof(uint64_t)) {
             continue;
+        }
 
         if (tasks > 200) {
             cslog() << "strange: too many tasks " << tasks;
         }
 
-        msg.resize(tasks);
-        std::fill(msg.begin(), msg.end(), mmsghdr{});
-        iovecs.resize(tasks);
-        std::fill(iovecs.begin(), iovecs.end(), iovec{});
-        packets_buffer.resize(tasks);
-        endpoints.resize(tasks);
-        encoded_packets.clear();
+        if (pacer_.isEnabled()) {
+            const auto now = Pacer::Clock::now();
+
+            for (uint64_t i = 0; i < tasks; i++) {
+                auto task = oPacMan_.getNextTask();
+                pacer_.push(task->endpoint, task->pack, now);
+            }
+
+            // the paced packets still go out in sendmmsg batches
+            while (pacer_.pop(paced, MaxSendBatchSize, now)) {
+                prepare(paced.size());
+
+                for (auto& item : paced) {
+                    add(item.pack, item.endpoint);
+                }
+
+                send();
+                paced.clear();
+            }
+
+            continue;
+        }
+
+        prepare(tasks);
 
-        int j = 0;
         for (uint64_t i = 0; i < tasks; i++) {
             auto task = oPacMan_.getNextTask();
             std::atomic_thread_fence(std::memory_order_acquire);
             while (!task->pack.data_.ptr_) {
                 cslog() << "net: invalid packet for send!!!!!!!!!";
             }
-            encoded_packets.emplace_back(task->pack.encode(buffer(packets_buffer[j].data(), Packet::MaxSize)));
-            endpoints[j] = task->endpoint;
-            iovecs[j].iov_base = encoded_packets[j].data();
-            iovecs[j].iov_len = encoded_packets[j].size();
-            msg[j].msg_hdr.msg_iov = &iovecs[j];
-            msg[j].msg_hdr.msg_iovlen = 1;
-            msg[j].msg_hdr.msg_name = endpoints[j].data();
-            msg[j].msg_hdr.msg_namelen = endpoints[j].size();
-            ++j;
-        }
-        if (j == 0)
-            continue;
-        tasks = j;
+            add(task->pack, task->endpoint);
+        }
 
-        int sended = 0;
-        struct mmsghdr* messages = msg.data();
-        do {
-            sended = sendmmsg(sock->native_handle(), messages, tasks, 0);
-            if (sended < 0) {
-                cslog() << "sendmmsg errno = " << errno;
-                if (errno != EAGAIN)
-                    break;
-            }
-            messages += sended;
-            tasks -= sended;
-        } while (tasks);
+        send();
 #endif
 #if defined(WIN32) || defined(__APPLE__)
 #ifdef WIN32
@@ -289,7 +542,7 @@ void Network::writerRoutine(const Config& config) {
             while (!task->pack.data_.ptr_) {
                 cslog() << "net: invalid packet!!!!!!!!!";
             }
-            sendPack(*sock, task, task->endpoint);
+            sendPack(*sock, task, task->endpoint, compression_);
         }
 #endif
     }
@@ -298,11 +551,23 @@ void Network::writerRoutine(const Config& config) {
 }
 
 // Processors
-void Network::processorRoutine() {
+void Network::processorRoutine(const size_t shardIndex) {
+    Shard& shard = *shards_[shardIndex];
+    IPacMan& iPacMan = shard.iPacMan;
+
+    // calls queue is not meant for several consumers, the first shard serves it;
+    // the calls reach the node and the solver as the tasks of the other shards do, so under the same lock
     CallsQueue& externals = CallsQueue::instance();
+    std::vector<Packet*> toHash;
+    auto callExternals = [this, &externals, shardIndex]() {
+        if (shardIndex == 0) {
+            std::lock_guard<std::mutex> lock(transportLock_);
+            externals.callAll();
+        }
+    };
 #ifdef __linux__
     struct pollfd pfd {};
-    pfd.fd = readerEventfd_;
+    pfd.fd = shard.readerEventfd;
     pfd.events = POLLIN;
     constexpr int timeout = 50;  // 50ms
 #elif __APPLE__
@@ -312,26 +577,30 @@ void Network::processorRoutine() {
 #endif
 
     while (stopProcessorRoutine == false) {
-        externals.callAll();
+        callExternals();
 #ifdef __linux__
         uint64_t tasks;
         while (true) {
             int ret = poll(&pfd, 1, timeout);
             if (ret != 0)
                 break;
-            externals.callAll();
+            callExternals();
         }
-        int s = read(readerEventfd_, &tasks, sizeof(uint64_t));
+        int s = read(shard.readerEventfd, &tasks, sizeof(uint64_t));
         if (s != sizeof(uint64_t))
             continue;
 
+        hashTasks(iPacMan, tasks, toHash);
+
         for (uint64_t i = 0; i < tasks; i++) {
-            auto task = iPacMan_.getNextTask();
+            auto task = iPacMan.getNextTask();
             while (!task->pack.data_.ptr_) {
                 cslog() << "net: invalid packet processor!!!!!!!!!";
             }
             processTask(task);
         }
+
+        shard.processed.fetch_add(tasks, std::memory_order_relaxed);
 #endif
 #if defined(WIN32) || defined(__APPLE__)
 #ifdef WIN32
@@ -339,7 +608,7 @@ void Network::processorRoutine() {
             auto ret = WaitForSingleObject(readerEvent_, 50);  // timeout 50ms
             if (ret != WAIT_TIMEOUT)
                 break;
-            externals.callAll();
+            callExternals();
         };
 #else
         while (true) {
@@ -347,7 +616,7 @@ void Network::processorRoutine() {
             int ret = kevent(readerKq_, NULL, 0, &event, 1, &timeout);
             if (ret)
                 break;
-            externals.callAll();
+            callExternals();
         }
 #endif
         while (readerLock.test_and_set(std::memory_order_acquire))  // acquire lock
@@ -356,8 +625,10 @@ void Network::processorRoutine() {
         readerTaskCount_ = 0;
         readerLock.clear(std::memory_order_release);  // release lock
 
+        hashTasks(iPacMan, tasks, toHash);
+
         for (int i = 0; i < tasks; i++) {
-            auto task = iPacMan_.getNextTask();
+            auto task = iPacMan.getNextTask();
             processTask(task);
         }
 #endif
@@ -367,6 +638,11 @@ void Network::processorRoutine() {
 
 inline void Network::processTask(TaskPtr<IPacMan>& task) {
     auto remoteSender = transport_->getPackSenderEntry(task->sender);
+    Connection* connection = remoteSender->connection.load(std::memory_order_acquire);
+
+    if (connection) {
+        connection->metrics.bytesIn.fetch_add(task->size, std::memory_order_relaxed);
+    }
 
     if (!(task->pack.isHeaderValid())) {
         static constexpr size_t limit = 100;
@@ -379,6 +655,8 @@ inline void Network::processTask(TaskPtr<IPacMan>& task) {
 
     // Pure network processing, prior blacklist inspection to allow re-registration
     if (task->pack.isNetwork()) {
+        std::lock_guard<std::mutex> lock(transportLock_);
+
         if (cs::PacketValidator::instance().validate(task->pack)) {
             transport_->processNetworkTask(task, remoteSender);
         }
@@ -391,38 +669,54 @@ inline void Network::processTask(TaskPtr<IPacMan>& task) {
         return;
     }
 
-    // Non-network data
-    uint32_t& recCounter = packetMap_.tryStore(task->pack.getHash());
+    // Non-network data, hash is calculated out of the locks
+    const cs::Hash& hash = task->pack.getHash();
+    uint32_t recCounter = 0;
+
+    {
+        cs::Lock lock(packetMapLock_);
+        recCounter = packetMap_.tryStore(hash)++;
+    }
+
     if (!recCounter && task->pack.addressedToMe(transport_->getMyPublicKey())) {
         if (task->pack.isFragmented() || task->pack.isCompressed()) {
             bool newFragmentedMsg = false;
-            MessagePtr msg = collector_.getMessage(task->pack, newFragmentedMsg);
+            bool completed = false;
+            MessagePtr msg = collector_.getMessage(task->pack, newFragmentedMsg, completed);
+
+            std::lock_guard<std::mutex> lock(transportLock_);
             transport_->gotPacket(task->pack, remoteSender);
 
             if (newFragmentedMsg) {
                 transport_->registerMessage(msg);
             }
 
-            if (msg && msg->isComplete()) {
+            if (msg && completed) {
+                // the neighbour which brought the last fragment gets the time of the whole message
+                if (connection) {
+                    const auto time = std::chrono::duration_cast<std::chrono::microseconds>(msg->lastFragment_ - msg->firstFragment_).count();
+                    connection->metrics.addCompletion(static_cast<uint64_t>(time));
+                }
+
                 if (cs::PacketValidator::instance().validate(**msg)) {
                     transport_->processNodeMessage(**msg);
                 }
             }
         }
         else {
+            std::lock_guard<std::mutex> lock(transportLock_);
+
             if (cs::PacketValidator::instance().validate(task->pack)) {
                 transport_->processNodeMessage(task->pack);
             }
         }
     }
 
+    std::lock_guard<std::mutex> lock(transportLock_);
     transport_->redirectPacket(task->pack, remoteSender);
-    ++recCounter;
 }
 
 void Network::sendDirect(const Packet& p, const ip::udp::endpoint& ep) {
-    auto qePtr = oPacMan_.allocNext();
-
     if (ep.size() > 16) {
         cslog() << "endpoint address too big " << ep.size();
         const uint8_t* ptr = reinterpret_cast<const uint8_t*>(ep.data());
@@ -430,10 +724,11 @@ void Network::sendDirect(const Packet& p, const ip::udp::endpoint& ep) {
             cslog() << *ptr++;
         }
     }
-    qePtr->endpoint = ep;
-    qePtr->pack = p;
 
-    oPacMan_.enQueueLast();
+    if (!oPacMan_.enQueue(p, ep)) {
+        return;
+    }
+
 #ifdef __linux__
     static uint64_t one = 1;
     write(writerEventfd_, &one, sizeof(uint64_t));
@@ -453,12 +748,28 @@ void Network::sendDirect(const Packet& p, const ip::udp::endpoint& ep) {
 
 Network::Network(const Config& config, Transport* transport)
 : resolver_(context_)
+, compression_(config.getNetworkSettings())
+#ifdef __linux__
+, pacer_(config.getNetworkSettings())
+#endif
 , transport_(transport) {
 #ifdef __linux__
-    readerEventfd_ = eventfd(0, 0);
-    if (readerEventfd_ == -1) {
-        good_ = false;
-        return;
+    const size_t shardsCount = std::clamp<uint16_t>(config.getNetworkSettings().shards, 1, MaxShards);
+#else
+    const size_t shardsCount = 1;
+#endif
+
+    for (size_t i = 0; i < shardsCount; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+
+#ifdef __linux__
+    for (auto& shard : shards_) {
+        shard->readerEventfd = eventfd(0, 0);
+        if (shard->readerEventfd == -1) {
+            good_ = false;
+            return;
+        }
     }
 
     writerEventfd_ = eventfd(0, 0);
@@ -521,12 +832,18 @@ Network::Network(const Config& config, Transport* transport)
 
     EV_SET(&writerEvent_, 0, EVFILT_USER, EV_DISPATCH | EV_ENABLE, NOTE_FFCOPY | NOTE_TRIGGER, 0, NULL);
 #endif
-    readerThread_ = std::thread(&Network::readerRoutine, this, config);
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        shards_[i]->readerThread = std::thread(&Network::readerRoutine, this, config, i);
+    }
+
     writerThread_ = std::thread(&Network::writerRoutine, this, config);
-    processorThread_ = std::thread(&Network::processorRoutine, this);
+
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        shards_[i]->processorThread = std::thread(&Network::processorRoutine, this, i);
+    }
 
     if (!config.hasTwoSockets()) {
-        auto sockPtr = new ip::udp::socket(bindSocket(context_, this, config.getInputEndpoint(), config.useIPv6()));
+        auto sockPtr = new ip::udp::socket(bindSocket(context_, this, config.getInputEndpoint(), config.useIPv6(), shards_.size() > 1));
 
         if (!sockPtr->is_open()) {
             good_ = false;
@@ -537,16 +854,26 @@ Network::Network(const Config& config, Transport* transport)
         singleSockOpened_.store(true);
     }
 
-    while (readerStatus_.load() == ThreadStatus::NonInit)
-        ;
+    good_ = true;
+
+    for (auto& shard : shards_) {
+        while (shard->readerStatus.load() == ThreadStatus::NonInit)
+            ;
+
+        good_ = good_ && shard->readerStatus.load() == ThreadStatus::Success;
+    }
+
     while (writerStatus_.load() == ThreadStatus::NonInit)
         ;
 
-    good_ = (readerStatus_.load() == ThreadStatus::Success && writerStatus_.load() == ThreadStatus::Success);
+    good_ = good_ && writerStatus_.load() == ThreadStatus::Success;
 
     if (!good_) {
         cserror() << "Cannot start the network: error binding sockets";
     }
+    else if (shards_.size() > 1) {
+        cslog() << "Network started with " << shards_.size() << " receiving shards";
+    }
 }
 
 bool Network::resendFragment(const cs::Hash& hash, const uint16_t id, const ip::udp::endpoint& ep) {
@@ -554,22 +881,72 @@ bool Network::resendFragment(const cs::Hash& hash, const uint16_t id, const ip::
 
     {
         cs::Lock lock(collector_.mLock_);
-        msg = collector_.map_.tryStore(hash);
+        // a neighbour names the hash, an unknown one must not evict a message being collected
+        if (MessagePtr* found = collector_.map_.find(hash)) {
+            msg = *found;
+        }
     }
 
     if (!msg) {
         return false;
     }
 
+    Packet packet;
+
     {
         cs::Lock l(msg->pLock_);
-        if (id < msg->packetsTotal_ && *(msg->packets_ + id)) {
-            sendDirect(*(msg->packets_ + id), ep);
-            return true;
+        if (id < msg->packetsTotal_) {
+            packet = msg->packets_[id];
         }
     }
 
-    return false;
+    if (!packet) {
+        return false;
+    }
+
+    sendDirect(packet, ep);
+    return true;
+}
+
+uint32_t Network::resendFragments(const cs::Hash& hash, const uint16_t start, const cs::Bytes& missing, const ip::udp::endpoint& ep) {
+    MessagePtr msg;
+
+    {
+        cs::Lock lock(collector_.mLock_);
+        // a neighbour names the hash, an unknown one must not evict a message being collected
+        if (MessagePtr* found = collector_.map_.find(hash)) {
+            msg = *found;
+        }
+    }
+
+    if (!msg) {
+        return 0;
+    }
+
+    // the reader thread takes the lock of the message for every fragment, so it is not held while sending
+    std::vector<Packet> packets;
+
+    {
+        cs::Lock l(msg->pLock_);
+
+        for (size_t i = 0; i < missing.size() * 8; ++i) {
+            const size_t id = start + i;
+
+            if (id >= msg->packetsTotal_) {
+                break;
+            }
+
+            if ((missing[i / 8] & (1 << (i % 8))) && msg->packets_[id]) {
+                packets.push_back(msg->packets_[id]);
+            }
+        }
+    }
+
+    for (const auto& packet : packets) {
+        sendDirect(packet, ep);
+    }
+
+    return static_cast<uint32_t>(packets.size());
 }
 
 void Network::sendInit() {
@@ -590,14 +967,10 @@ void Network::registerMessage(Packet* pack, const uint32_t size) {
     }
 
     msg->packetsLeft_ = 0;
-    msg->packetsTotal_ = size;
+    msg->allocateFragments(size);
     msg->headerHash_ = pack->getHeaderHash();
 
-    auto packEnd = msg->packets_ + size;
-    auto rPtr = pack;
-    for (auto wPtr = msg->packets_; wPtr != packEnd; ++wPtr, ++rPtr) {
-        *wPtr = *rPtr;
-    }
+    std::copy(pack, pack + size, msg->packets_.get());
 
     {
         cs::Lock l(collector_.mLock_);
@@ -608,8 +981,10 @@ void Network::registerMessage(Packet* pack, const uint32_t size) {
 Network::~Network() {
     stopReaderRoutine = true;
 
-    if (readerThread_.joinable()) {
-        readerThread_.join();
+    for (auto& shard : shards_) {
+        if (shard->readerThread.joinable()) {
+            shard->readerThread.join();
+        }
     }
 
     stopWriterRoutine = true;
@@ -620,8 +995,10 @@ Network::~Network() {
 
     stopProcessorRoutine = true;
 
-    if (processorThread_.joinable()) {
-        processorThread_.join();
+    for (auto& shard : shards_) {
+        if (shard->processorThread.joinable()) {
+            shard->processorThread.join();
+        }
     }
 
     delete singleSock_.load();
@@ -0,0 +1,225 @@
+/* Send blaming letters to @yrtimd */
+#include "pacer.hpp"
+
+#include <client/config.hpp>
+#include <lib/system/logger.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace {
+// fragments one destination sends before the next one gets its turn
+constexpr size_t Quantum = 16;
+
+constexpr auto CleanupPeriod = std::chrono::seconds(10);
+constexpr auto IdleTimeout = std::chrono::seconds(60);
+}  // namespace
+
+Pacer::Pacer(const NetworkData& settings)
+: peerRate_(settings.pacingRate)
+, peerBurst_(std::max<uint16_t>(settings.pacingBurst, 1))
+, globalRate_(settings.pacingGlobalRate)
+, globalBurst_(std::max<uint16_t>(settings.pacingBurst, 1)) {
+    global_.tokens = globalBurst_;
+    global_.updated = Clock::now();
+
+    if (isEnabled()) {
+        cslog() << "NET> Pacing: " << settings.pacingRate << " fragments/s to a peer, " << settings.pacingGlobalRate << " fragments/s in total, burst "
+                << settings.pacingBurst;
+    }
+}
+
+void Pacer::Bucket::refill(const double rate, const double burst, const Clock::time_point now) {
+    const double elapsed = std::chrono::duration<double>(now - updated).count();
+
+    if (elapsed > 0) {
+        tokens = std::min(burst, tokens + elapsed * rate);
+        updated = now;
+    }
+}
+
+void Pacer::push(const ip::udp::endpoint& endpoint, const Packet& pack, const Clock::time_point now) {
+    cs::Lock lock(lock_);
+
+    auto it = peers_.find(endpoint);
+
+    if (it == peers_.end()) {
+        it = peers_.emplace(endpoint, Peer()).first;
+        it->second.bucket.tokens = peerBurst_;
+        it->second.bucket.updated = now;
+        it->second.lastSent = now;
+    }
+
+    Peer& peer = it->second;
+
+    if (peer.queue.size() >= MaxQueued) {
+        ++peer.dropped;
+        return;
+    }
+
+    if (peerRate_ > 0) {
+        peer.bucket.refill(peerRate_, peerBurst_, now);
+    }
+
+    if (globalRate_ > 0) {
+        global_.refill(globalRate_, globalBurst_, now);
+    }
+
+    // the packets queued before this one take the tokens first
+    if ((peerRate_ > 0 && static_cast<double>(peer.queue.size() + 1) > peer.bucket.tokens) ||
+        (globalRate_ > 0 && static_cast<double>(queued_ + 1) > global_.tokens)) {
+        ++peer.paced;
+    }
+
+    peer.queue.push_back(pack);
+    ++queued_;
+
+    if (!peer.active) {
+        peer.active = true;
+        active_.push_back(it);
+    }
+}
+
+size_t Pacer::pop(std::vector<Item>& items, const size_t maxCount, const Clock::time_point now) {
+    cs::Lock lock(lock_);
+
+    if (globalRate_ > 0) {
+        global_.refill(globalRate_, globalBurst_, now);
+    }
+
+    size_t count = 0;
+    size_t stalled = 0;
+
+    while (count < maxCount && stalled < active_.size() && hasTokens(global_, globalRate_)) {
+        auto it = active_.front();
+        active_.pop_front();
+
+        Peer& peer = it->second;
+        size_t quota = std::min({Quantum, peer.queue.size(), maxCount - count});
+
+        if (peerRate_ > 0) {
+            peer.bucket.refill(peerRate_, peerBurst_, now);
+            quota = std::min(quota, static_cast<size_t>(peer.bucket.tokens));
+            peer.bucket.tokens -= static_cast<double>(quota);
+        }
+
+        if (globalRate_ > 0) {
+            quota = std::min(quota, static_cast<size_t>(global_.tokens));
+            global_.tokens -= static_cast<double>(quota);
+        }
+
+        for (size_t i = 0; i < quota; ++i) {
+            items.push_back(Item{it->first, std::move(peer.queue.front())});
+            peer.queue.pop_front();
+        }
+
+        count += quota;
+        queued_ -= quota;
+        peer.sent += quota;
+
+        if (quota) {
+            peer.lastSent = now;
+            stalled = 0;
+        }
+        else {
+            ++stalled;
+        }
+
+        if (peer.queue.empty()) {
+            peer.active = false;
+        }
+        else {
+            active_.push_back(it);
+        }
+    }
+
+    if (now - lastCleanup_ > CleanupPeriod) {
+        removeIdle(now);
+        lastCleanup_ = now;
+    }
+
+    return count;
+}
+
+int Pacer::getTimeout(const Clock::time_point now) const {
+    cs::Lock lock(lock_);
+
+    if (queued_ == 0) {
+        return -1;
+    }
+
+    // seconds till the bucket has a token
+    auto wait = [now](const Bucket& bucket, const double rate) {
+        if (rate <= 0) {
+            return 0.;
+        }
+
+        const double tokens = bucket.tokens + std::chrono::duration<double>(now - bucket.updated).count() * rate;
+        return tokens >= 1 ? 0. : (1 - tokens) / rate;
+    };
+
+    double peerWait = std::numeric_limits<double>::max();
+
+    for (const auto& it : active_) {
+        peerWait = std::min(peerWait, wait(it->second.bucket, peerRate_));
+    }
+
+    const double seconds = std::max(peerWait, wait(global_, globalRate_));
+    return static_cast<int>(std::ceil(seconds * 1000));
+}
+
+std::vector<Pacer::PeerStats> Pacer::getStats() const {
+    cs::Lock lock(lock_);
+
+    std::vector<PeerStats> result;
+    result.reserve(peers_.size());
+
+    for (const auto& [endpoint, peer] : peers_) {
+        PeerStats stats;
+        stats.endpoint = endpoint;
+        stats.sent = peer.sent;
+        stats.paced = peer.paced;
+        stats.dropped = peer.dropped;
+        stats.queued = peer.queue.size();
+        result.push_back(stats);
+    }
+
+    return result;
+}
+
+void Pacer::logStats() const {
+    if (!isEnabled()) {
+        return;
+    }
+
+    std::ostringstream os;
+
+    for (const auto& stats : getStats()) {
+        if (stats.paced || stats.dropped || stats.queued) {
+            os << "\n  " << stats.endpoint << ": sent " << stats.sent << ", paced " << stats.paced << ", dropped " << stats.dropped << ", queued " << stats.queued;
+        }
+    }
+
+    const std::string result = os.str();
+
+    if (!result.empty()) {
+        csdebug() << "NET> pacing by peers:" << result;
+    }
+}
+
+bool Pacer::hasTokens(const Bucket& bucket, const double rate) const {
+    return rate <= 0 || bucket.tokens >= 1;
+}
+
+void Pacer::removeIdle(const Clock::time_point now) {
+    for (auto it = peers_.begin(); it != peers_.end();) {
+        if (!it->second.active && now - it->second.lastSent > IdleTimeout) {
+            it = peers_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
@@ -87,6 +87,48 @@ const cs::Hash& Packet::getHeaderHash() const {
     return headerHash_;
 }
 
+void Packet::hashBatch(Packet* const* packets, const size_t count) {
+    constexpr size_t chunkSize = 64;
+
+    const void* data[chunkSize];
+    size_t lengths[chunkSize];
+    cs::Hash hashes[chunkSize];
+
+    for (size_t from = 0; from < count; from += chunkSize) {
+        const size_t size = std::min(chunkSize, count - from);
+        Packet* const* chunk = packets + from;
+
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = chunk[i]->data_.get();
+            lengths[i] = chunk[i]->data_.size();
+        }
+
+        generateHashes(data, lengths, hashes, size);
+
+        size_t fragments = 0;
+
+        for (size_t i = 0; i < size; ++i) {
+            chunk[i]->hash_ = hashes[i];
+            chunk[i]->hashed_ = true;
+
+            if (chunk[i]->isFragmented()) {
+                data[fragments] = static_cast<const char*>(chunk[i]->data_.get()) + Offsets::FragmentsNum;
+                lengths[fragments] = Lengths::FragmentedHeader;
+                ++fragments;
+            }
+        }
+
+        generateHashes(data, lengths, hashes, fragments);
+
+        for (size_t i = 0, fragment = 0; i < size; ++i) {
+            if (chunk[i]->isFragmented()) {
+                chunk[i]->headerHash_ = hashes[fragment++];
+                chunk[i]->headerHashed_ = true;
+            }
+        }
+    }
+}
+
 bool Packet::isHeaderValid() const {
     if (isFragmented()) {
         if (isNetwork()) {
@@ -142,7 +184,7 @@ void Packet::recalculateHeadersLength() {
     headersLength_ = calculateHeadersLength();
 }
 
-MessagePtr PacketCollector::getMessage(const Packet& pack, bool& newFragmentedMsg) {
+MessagePtr PacketCollector::getMessage(const Packet& pack, bool& newFragmentedMsg, bool& completed) {
     if (!pack.isFragmented()) {
         return MessagePtr();
     }
@@ -152,36 +194,50 @@ MessagePtr PacketCollector::getMessage(const Packet& pack, bool& newFragmentedMs
     }
 
     newFragmentedMsg = false;
+    completed = false;
 
-    MessagePtr* msgPtr;
     MessagePtr msg;
 
     {
+        // several network shards may collect fragments of the same message
         cs::Lock l(mLock_);
-        msgPtr = &map_.tryStore(pack.getHeaderHash());
-    }
-
-    if (!*msgPtr) {  // First time
-        *msgPtr = msg = msgAllocator_.emplace();
-        msg->packetsLeft_ = pack.getFragmentsNum();
-        msg->packetsTotal_ = pack.getFragmentsNum();
-        msg->headerHash_ = pack.getHeaderHash();
-        // to ensure not to contain dirty fragments in buffer (prevent goodPlace below from to be incorrect):
-        msg->clearFragments();
-        newFragmentedMsg = true;
-    }
-    else {
-        msg = *msgPtr;
+        MessagePtr& msgRef = map_.tryStore(pack.getHeaderHash());
+
+        if (!msgRef) {  // First time
+            msgRef = msg = msgAllocator_.emplace();
+            msg->packetsLeft_ = pack.getFragmentsNum();
+            msg->allocateFragments(pack.getFragmentsNum());
+            msg->headerHash_ = pack.getHeaderHash();
+            msg->firstFragment_ = std::chrono::steady_clock::now();
+            newFragmentedMsg = true;
+        }
+        else {
+            msg = msgRef;
+        }
     }
 
     {
         cs::Lock lock(msg->pLock_);
-        auto goodPlace = msg->packets_ + pack.getFragmentId(); // valid fragmentation has already been tested
+
+        // slots are sized by the first fragment to come, fragments number is a part of the header hash
+        if (pack.getFragmentId() >= msg->packetsTotal_) {
+            cswarning() << "COLLECT> fragment " << pack.getFragmentId() << " is out of " << msg->packetsTotal_ << " fragments of the message, drop";
+            return msg;
+        }
+
+        auto goodPlace = msg->packets_.get() + pack.getFragmentId();
 
         if (!*goodPlace) {
             msg->maxFragment_ = std::max(pack.getFragmentsNum(), msg->maxFragment_);
             --msg->packetsLeft_;
             *goodPlace = pack;
+            completed = (msg->packetsLeft_ == 0);
+
+            msg->lastFragment_ = std::chrono::steady_clock::now();
+
+            if (msg->answered_ < msg->requested_) {
+                msg->answered_ = msg->lastFragment_;
+            }
         }
 
         if (msg->packetsTotal_ >= 20) {
@@ -202,10 +258,20 @@ MessagePtr PacketCollector::getMessage(const Packet& pack, bool& newFragmentedMs
     return msg;
 }
 
+void Message::allocateFragments(const uint32_t count) {
+    packetsTotal_ = count;
+    packets_.reset(new Packet[count]);
+}
+
 /* WARN: All the cases except FRAG + COMPRESSED have bugs in them */
 void Message::composeFullData() const {
     if (getFirstPack().isFragmented()) {
-        const Packet* pack = packets_;
+        if (packetsTotal_ == 1) {
+            fullData_ = packets_[0].data_;
+            return;
+        }
+
+        const Packet* pack = packets_.get();
         uint32_t headersLength = pack->getHeadersLength();
         uint32_t totalSize = headersLength;
 
@@ -216,7 +282,7 @@ void Message::composeFullData() const {
         fullData_ = allocator_.allocateNext(totalSize);
 
         uint8_t* data = static_cast<uint8_t*>(fullData_.get());
-        pack = packets_;
+        pack = packets_.get();
 
         for (uint32_t i = 0; i < packetsTotal_; ++i, ++pack) {
             uint32_t headerSize = static_cast<uint32_t>((i == 0) ? 0 : headersLength);
@@ -230,40 +296,6 @@ void Message::composeFullData() const {
     }
 }
 
-// scans array of future fragments and clears all dirty elements, scans all elements
-size_t Message::clearBuffer(size_t from, size_t to) {
-    if (to <= from || to >= Packet::MaxFragments) {
-        return 0;
-    }
-    size_t cnt = 0;
-    for (size_t i = from; i < to; i++) {
-        // Packet's operator bool redirects call to Packet::data_::operator bool
-        if (packets_[i]) {
-            csdebug() << "Net: potential heap corruption prevented in message.packets_[" << i << "]";
-            cs::Utils::clearMemory(packets_[i]);
-            ++cnt;
-        }
-    }
-    return cnt;
-}
-
-Message::~Message() {
-    /*auto pEnd = packets_ + packetsTotal_;
-    for (auto ptr = packets_; ptr != pEnd; ++ptr)
-      if (ptr) ptr->~Packet();
-
-      memset(packets_, 0, sizeof(Packet*) * packetsTotal_);*/
-
-    //DEBUG: prevent corruption after heap is damaged,
-    // assume maxFragment "points" behind the last fragment,
-    // idea is to avoid call to MemPtr<> destructor on incorrect object
-    size_t cnt = clearUnused();
-    if (cnt > 0) {
-        csdebug() << "Net: memory corruption prevented, invalid fragments (" << cnt << ") is behind the max of " << maxFragment_ << " and cannot been destructed";
-        Transport::cntCorruptedFragments += cnt;
-    }
-}
-
 class PacketFlags {
 public:
     PacketFlags(const Packet& packet)
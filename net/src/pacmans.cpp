@@ -2,75 +2,157 @@
 #include "pacmans.hpp"
 
 IPacMan::Task& IPacMan::allocNext() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    queue_.emplace_back();
-    auto end = queue_.end();
-    Task& task = *(--end);
-    new (&task) Task();
-    task.pack.data_ = allocator_.allocateNext(Packet::MaxSize);
-    return task;
+    Task* task = queue_.emplace();
+
+    if (!task) {
+        return allocOverflow();
+    }
+
+    task->pack.data_ = allocator_.allocateNext(Packet::MaxSize);
+    return *task;
+}
+
+IPacMan::Task& IPacMan::allocOverflow() {
+    overflow_ = Task();
+    overflow_.pack.data_ = allocator_.allocateNext(Packet::MaxSize);
+    overflowed_ = true;
+    return overflow_;
 }
 
-void IPacMan::enQueueLast() {
-    Task& task = queue_.back();
+bool IPacMan::enQueueLast() {
+    if (overflowed_) {
+        overflowed_ = false;
+        overflow_ = Task();
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Task& task = queue_.reserved(0);
     allocator_.shrinkLast(static_cast<uint32_t>(task.size));
-    size_.fetch_add(1, std::memory_order_acq_rel);
+    queue_.publish();
+    return true;
 }
 
 void IPacMan::rejectLast() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    Task& task = queue_.back();
-    task.~Task();
-    queue_.pop_back();
+    if (overflowed_) {
+        overflowed_ = false;
+        overflow_ = Task();
+        return;
+    }
+
+    queue_.discard();
 }
 
 TaskPtr<IPacMan> IPacMan::getNextTask() {
-    while (!size_.load(std::memory_order_acquire)) {
+    Task* task;
+
+    while (!(task = queue_.front())) {
         std::this_thread::yield();
     }
-    std::lock_guard<std::mutex> lock(mutex_);
+
     TaskPtr<IPacMan> result;
     result.owner_ = this;
-    result.it_ = queue_.begin();
+    result.it_ = task;
     return result;
 }
 
+IPacMan::Task* IPacMan::peekTask(const size_t index) {
+    return queue_.peek(index);
+}
+
 void IPacMan::releaseTask(TaskIterator& it) {
-    Task& task = *it;
-    task.~Task();
-    std::lock_guard<std::mutex> lock(mutex_);
-    queue_.erase(it);
-    size_.fetch_sub(1, std::memory_order_acq_rel);
+    assert(it == queue_.front());
+    (void)it;
+    queue_.pop();
+}
+
+size_t IPacMan::allocBatch(const size_t count) {
+    batchAccepted_ = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        Task* task = queue_.emplace();
+
+        if (!task) {
+            break;
+        }
+
+        task->pack.data_ = allocator_.allocateNext(Packet::MaxSize);
+    }
+
+    if (!queue_.reservedCount()) {
+        allocOverflow();
+        return 1;
+    }
+
+    return queue_.reservedCount();
+}
+
+IPacMan::Task& IPacMan::batchTask(const size_t index) {
+    return overflowed_ ? overflow_ : queue_.reserved(index);
+}
+
+void IPacMan::enQueueBatched(const size_t index) {
+    if (overflowed_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Task& task = queue_.reserved(index);
+    allocator_.shrink(task.pack.data_, static_cast<uint32_t>(task.size));
+
+    // accepted tasks are packed to the front of the batch over the rejected ones
+    if (index != batchAccepted_) {
+        std::swap(queue_.reserved(batchAccepted_), task);
+    }
+
+    ++batchAccepted_;
 }
 
-OPacMan::Task* OPacMan::allocNext() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    queue_.emplace_back();
-    auto end = queue_.end();
-    Task& task = *(--end);
-    new (&task) Task();
-    return &task;
+size_t IPacMan::commitBatch() {
+    if (overflowed_) {
+        overflowed_ = false;
+        overflow_ = Task();
+        return 0;
+    }
+
+    while (queue_.reservedCount() > batchAccepted_) {
+        queue_.discard();
+    }
+
+    queue_.publish(batchAccepted_);
+    return batchAccepted_;
 }
 
-void OPacMan::enQueueLast() {
-    size_.fetch_add(1, std::memory_order_acq_rel);
+bool OPacMan::enQueue(const Packet& pack, const ip::udp::endpoint& endpoint) {
+    cs::Lock lock(producerLock_);
+    Task* task = queue_.emplace();
+
+    if (!task) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    task->endpoint = endpoint;
+    task->pack = pack;
+    queue_.publish();
+    return true;
 }
 
 TaskPtr<OPacMan> OPacMan::getNextTask() {
-    while (!size_.load(std::memory_order_acquire)) {
+    Task* task;
+
+    while (!(task = queue_.front())) {
         std::this_thread::yield();
     }
-    std::lock_guard<std::mutex> lock(mutex_);
+
     TaskPtr<OPacMan> result;
     result.owner_ = this;
-    result.it_ = queue_.begin();
+    result.it_ = task;
     return result;
 }
 
 void OPacMan::releaseTask(TaskIterator& it) {
-    Task& task = *it;
-    task.~Task();
-    std::lock_guard<std::mutex> lock(mutex_);
-    queue_.erase(it);
-    size_.fetch_sub(1, std::memory_order_acq_rel);
+    assert(it == queue_.front());
+    (void)it;
+    queue_.pop();
 }
@@ -146,6 +146,7 @@ void Transport::run() {
         bool refreshLimits = ctr % 20 == 0;
         bool checkPending = ctr % 100 == 0;
         bool checkSilent = ctr % 150 == 0;
+        bool logStats = ctr % 1200 == 0;
 
         if (askMissing) {
             askForMissingPackages();
@@ -172,6 +173,11 @@ void Transport::run() {
             nh_.refreshLimits();
         }
 
+        if (logStats) {
+            net_->logStats();
+            nh_.logMetrics();
+        }
+
         pollSignalFlag();
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
@@ -201,6 +207,8 @@ const char* Transport::networkCommandToString(NetworkCommand command) {
         return "PackRenounce";
     case NetworkCommand::BlockSyncRequest:
         return "BlockSyncRequest";
+    case NetworkCommand::PackRequestMissing:
+        return "PackRequestMissing";
     case NetworkCommand::SSRegistration:
         return "SSRegistration";
     case NetworkCommand::SSFirstRound:
@@ -221,34 +229,24 @@ const char* Transport::networkCommandToString(NetworkCommand command) {
 }
 
 template <>
-uint16_t getHashIndex(const ip::udp::endpoint& ep) {
-    uint16_t result = ep.port();
+uint64_t getHashIndex(const ip::udp::endpoint& ep) {
+    uint64_t result = ep.port();
 
     if (ep.protocol() == ip::udp::v4()) {
-        uint32_t address = ep.address().to_v4().to_uint();
-        uint16_t lowBits = static_cast<uint16_t>(address);
-        uint16_t highBits = address >> (sizeof(uint16_t) * CHAR_BIT);
-        result ^= lowBits ^ highBits;
+        result |= static_cast<uint64_t>(ep.address().to_v4().to_uint()) << (sizeof(uint16_t) * CHAR_BIT);
     }
     else {
         auto bytes = ep.address().to_v6().to_bytes();
-        auto ptr = reinterpret_cast<uint8_t*>(&result);
-        auto bytesPtr = bytes.data();
-        for (size_t i = 0; i < 8; ++i) {
-            *ptr ^= *(bytesPtr++);
-        }
-
-        ++ptr;
-
-        for (size_t i = 8; i < 16; ++i) {
-            *ptr ^= *(bytesPtr++);
-        }
+        uint64_t halves[2];
+        std::memcpy(halves, bytes.data(), sizeof(halves));
+        result ^= halves[0] ^ (halves[1] << 1);
     }
 
     return result;
 }
 
 RemoteNodePtr Transport::getPackSenderEntry(const ip::udp::endpoint& ep) {
+    cs::Lock lock(remoteNodesLock_);
     auto& rn = remoteNodesMap_.tryStore(ep);
 
     if (!rn) {  // Newcomer
@@ -263,6 +261,7 @@ bool Transport::sendDirect(const Packet* pack, const Connection& conn) {
     uint32_t nextBytesCount = static_cast<uint32_t>(conn.lastBytesCount.load(std::memory_order_relaxed) + pack->size());
     if (nextBytesCount <= config_.getConnectionBandwidth()) {
         conn.lastBytesCount.fetch_add(static_cast<uint32_t>(pack->size()), std::memory_order_relaxed);
+        conn.metrics.bytesOut.fetch_add(pack->size(), std::memory_order_relaxed);
         net_->sendDirect(*pack, conn.getOut());
         return true;
     }
@@ -366,7 +365,10 @@ void Transport::processNetworkTask(const TaskPtr<IPacMan>& task, RemoteNodePtr&
             // gotPackRenounce(task, sender);
             break;
         case NetworkCommand::PackRequest:
-            // gotPackRequest(task, sender);
+            result = gotPackRequest(task, sender);
+            break;
+        case NetworkCommand::PackRequestMissing:
+            result = gotPackRequestMissing(task, sender);
             break;
         default:
             result = false;
@@ -699,6 +701,10 @@ ConnectionPtr Transport::getRandomNeighbour() {
     return nh_.getRandomSyncNeighbour();
 }
 
+std::vector<Neighbourhood::NeighbourMetrics> Transport::getNeighboursMetrics() const {
+    return nh_.getMetrics();
+}
+
 std::unique_lock<cs::SpinLock> Transport::getNeighboursLock() const {
     return nh_.getNeighboursLock();
 }
@@ -1087,11 +1093,11 @@ void Transport::askForMissingPackages() {
     MessagePtr msg;
     size_t i = 0;
 
-    // magic numbers??
-    const uint64_t maxMask = 1ull << 63;
+    const auto now = std::chrono::steady_clock::now();
 
     cs::Lock lock(uLock_);
     ptr = uncollected_.begin();
+    ++missingPass_;
 
     while (true) {
         if (i >= uncollected_.size()) {
@@ -1102,72 +1108,138 @@ void Transport::askForMissingPackages() {
         ++ptr;
         ++i;
 
+        uint16_t start = 0;
+        cs::Bytes missing;
+        uint64_t count = 0;
+        ConnectionPtr requestee;
+
+        // the legacy request of up to 64 fragments for peers without PackRequestMissing
+        bool legacy = false;
+        uint16_t legacyStart = 0;
+        uint64_t legacyReq = 0;
+
         {
             cs::Lock messageLock(msg->pLock_);
-            const auto end = msg->packets_ + msg->packetsTotal_;
 
-            uint16_t start = 0;
-            uint64_t mask = 0;
-            uint64_t req = 0;
+            if (msg->packetsLeft_ == 0) {
+                continue;
+            }
+
+            MissingRequest& request = missingRequests_[msg->headerHash_];
+            request.pass = missingPass_;
+
+            // the first new fragment after a request is a round trip sample of the requestee
+            if (!request.sampled && msg->answered_ >= msg->requested_) {
+                const auto sample = std::chrono::duration_cast<std::chrono::microseconds>(msg->answered_ - msg->requested_).count();
+                request.requestee->metrics.addRttSample(static_cast<uint32_t>(std::min<int64_t>(sample, maxRetryTimeout_)));
+                request.sampled = true;
+            }
+
+            const uint64_t roundTrip = request.requestee ? request.requestee->metrics.getRetryTimeout() : Connection::Metrics::DefaultTimeout;
+            const uint64_t timeout = std::clamp<uint64_t>(roundTrip << std::min(request.attempts, maxRetryBackoff_), minRetryTimeout_, maxRetryTimeout_);
+
+            // fragments are still coming or the request is not answered yet
+            if (now - std::max(msg->lastFragment_, msg->requested_) < std::chrono::microseconds(timeout)) {
+                continue;
+            }
+
+            const auto begin = msg->packets_.get();
+            const auto end = begin + msg->packetsTotal_;
 
-            for (auto s = msg->packets_; s != end; ++s) {
+            auto first = begin;
+            while (*first) {
+                ++first;
+            }
+
+            auto last = end - 1;
+            while (*last) {
+                --last;
+            }
+
+            // one bit per fragment starting from a byte boundary, up to the last missing one
+            start = cs::numeric_cast<uint16_t>((first - begin) & ~7);
+            missing.resize(static_cast<size_t>(last - begin - start) / 8 + 1);
+
+            for (auto s = begin + start; s <= last; ++s) {
                 if (!*s) {
-                    if (!mask) {
-                        mask = 1;
-                        start = cs::numeric_cast<uint16_t>(s - msg->packets_);
-                    }
-                    req |= mask;
+                    const auto bit = s - begin - start;
+                    missing[bit / 8] |= static_cast<cs::Byte>(1 << (bit % 8));
+                    ++count;
                 }
+            }
 
-                if (mask == maxMask) {
-                    requestMissing(msg->headerHash_, start, req);
+            // the last request brought nothing, the peer may not know the bitmap one
+            if (request.attempts && !request.sampled) {
+                legacy = true;
+                legacyStart = cs::numeric_cast<uint16_t>(first - begin);
 
-                    if (s > (msg->packets_ + msg->maxFragment_) && (end - s) > 128) {
-                        break;
+                for (auto s = first; s <= last && s - first < 64; ++s) {
+                    if (!*s) {
+                        legacyReq |= uint64_t(1) << (s - first);
                     }
-
-                    mask = 0;
-                }
-                else {
-                    mask <<= 1;
                 }
             }
 
-            if (mask) {
-                requestMissing(msg->headerHash_, start, req);
+            requestee = nh_.getNextRequestee(msg->headerHash_);
+
+            if (!requestee) {
+                continue;
             }
         }
-    }
-}
 
-void Transport::requestMissing(const cs::Hash& hash, const uint16_t start, const uint64_t req) {
-    Packet p;
+        // a request dropped by the bandwidth limit is not an attempt
+        if (!requestMissing(msg->headerHash_, start, missing, **requestee)) {
+            continue;
+        }
 
-    {
-        cs::Lock lock(oLock_);
-        oPackStream_.init(BaseFlags::NetworkMsg);
-        oPackStream_ << NetworkCommand::PackRequest << hash << start << req;
-        p = *(oPackStream_.getPackets());
-        oPackStream_.clear();
-    }
+        if (legacy) {
+            requestPack(msg->headerHash_, legacyStart, legacyReq, **requestee);
+        }
+
+        cs::Lock messageLock(msg->pLock_);
+
+        MissingRequest& request = missingRequests_[msg->headerHash_];
+        request.requestee = requestee;
+        request.sampled = false;
+        ++request.attempts;
 
-    ConnectionPtr requestee = nh_.getNextRequestee(hash);
+        requestee->metrics.requested.fetch_add(count, std::memory_order_relaxed);
 
-    if (requestee) {
-        sendDirect(&p, **requestee);
+        msg->requested_ = now;
+    }
+
+    // complete and dropped messages are not asked for any more
+    for (auto it = missingRequests_.begin(); it != missingRequests_.end();) {
+        if (it->second.pass != missingPass_) {
+            it = missingRequests_.erase(it);
+        }
+        else {
+            ++it;
+        }
     }
 }
 
+bool Transport::requestMissing(const cs::Hash& hash, const uint16_t start, const cs::Bytes& missing, const Connection& requestee) {
+    cs::Lock lock(oLock_);
+    oPackStream_.init(BaseFlags::NetworkMsg);
+    oPackStream_ << NetworkCommand::PackRequestMissing << hash << start << missing;
+    const bool sent = sendDirect(oPackStream_.getPackets(), requestee);
+    oPackStream_.clear();
+    return sent;
+}
+
+bool Transport::requestPack(const cs::Hash& hash, const uint16_t start, const uint64_t req, const Connection& requestee) {
+    cs::Lock lock(oLock_);
+    oPackStream_.init(BaseFlags::NetworkMsg);
+    oPackStream_ << NetworkCommand::PackRequest << hash << start << req;
+    const bool sent = sendDirect(oPackStream_.getPackets(), requestee);
+    oPackStream_.clear();
+    return sent;
+}
+
 void Transport::registerMessage(MessagePtr msg) {
     cs::Lock lock(uLock_);
-    auto& ptr = uncollected_.emplace(msg);
-    //DEBUG:
-    Message& message = *ptr.get();
-    size_t cnt = message.clearUnused();
-    if (cnt > 0) {
-        csdebug() << "Net: potential heap corruption detected in uncollected message fragments (" << cnt << ")";
-        Transport::cntDirtyAllocs += cnt;
-    }
+    uncollected_.emplace(msg);
 }
 
 bool Transport::gotPackRequest(const TaskPtr<IPacMan>&, RemoteNodePtr& sender) {
@@ -1203,6 +1275,28 @@ bool Transport::gotPackRequest(const TaskPtr<IPacMan>&, RemoteNodePtr& sender) {
         mask <<= 1;
     }
 
+    conn->metrics.resent.fetch_add(snt, std::memory_order_relaxed);
+    return true;
+}
+
+bool Transport::gotPackRequestMissing(const TaskPtr<IPacMan>&, RemoteNodePtr& sender) {
+    ConnectionPtr conn = nh_.getConnection(sender);
+    if (!conn) {
+        return false;
+    }
+
+    cs::Hash hHash;
+    uint16_t start = 0u;
+    cs::Bytes missing;
+
+    iPackStream_ >> hHash >> start >> missing;
+
+    if (!iPackStream_.good() || !iPackStream_.end() || missing.size() * 8 > Packet::MaxFragments) {
+        return false;
+    }
+
+    const uint32_t resent = net_->resendFragments(hHash, start, missing, conn->getOut());
+    conn->metrics.resent.fetch_add(resent, std::memory_order_relaxed);
     return true;
 }
 
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "blockhashes.hpp"
+#include "datastream.hpp"
+
+namespace {
+csdb::Pool makeBlock(const csdb::PoolHash& previous, cs::Sequence sequence) {
+    csdb::Pool pool(previous, sequence);
+    pool.compose();
+    return pool;
+}
+
+std::vector<csdb::Pool> makeChain(size_t count) {
+    std::vector<csdb::Pool> chain;
+    csdb::PoolHash previous;
+
+    for (cs::Sequence i = 0; i < count; ++i) {
+        chain.push_back(makeBlock(previous, i));
+        previous = chain.back().hash();
+    }
+
+    return chain;
+}
+}  // namespace
+
+TEST(BlockHashes, FindsHashesAndSequences) {
+    const auto chain = makeChain(3000);
+    cs::BlockHashes hashes;
+
+    for (const auto& block : chain) {
+        ASSERT_TRUE(hashes.loadNextBlock(block));
+    }
+
+    ASSERT_EQ(hashes.size(), chain.size());
+    ASSERT_EQ(hashes.getLast(), chain.back().hash());
+
+    for (const auto& block : chain) {
+        ASSERT_EQ(hashes.find(block.sequence()), block.hash());
+        ASSERT_EQ(hashes.find(block.hash()), block.sequence());
+    }
+
+    ASSERT_EQ(hashes.find(makeBlock(chain.back().hash(), 3000).hash()), 0u);
+    ASSERT_TRUE(hashes.find(cs::Sequence(3000)).is_empty());
+}
+
+TEST(BlockHashes, RejectsBlocksOutOfOrder) {
+    const auto chain = makeChain(3);
+    cs::BlockHashes hashes;
+
+    ASSERT_TRUE(hashes.loadNextBlock(chain[0]));
+    ASSERT_FALSE(hashes.loadNextBlock(chain[2]));
+    ASSERT_TRUE(hashes.loadNextBlock(chain[1]));
+    ASSERT_FALSE(hashes.loadNextBlock(chain[1]));
+}
+
+TEST(BlockHashes, RemoveLastKeepsIndexConsistent) {
+    const auto chain = makeChain(2000);
+    cs::BlockHashes hashes;
+
+    for (const auto& block : chain) {
+        ASSERT_TRUE(hashes.loadNextBlock(block));
+    }
+
+    for (size_t i = 0; i < 500; ++i) {
+        ASSERT_EQ(hashes.removeLast(), chain[chain.size() - 1 - i].hash());
+    }
+
+    ASSERT_EQ(hashes.getDbStructure().last_, 1499u);
+    ASSERT_EQ(hashes.find(chain[1500].hash()), 0u);
+
+    for (size_t i = 0; i < 1500; ++i) {
+        ASSERT_EQ(hashes.find(chain[i].hash()), i);
+    }
+
+    // the removed blocks may come again
+    ASSERT_TRUE(hashes.loadNextBlock(chain[1500]));
+    ASSERT_EQ(hashes.find(chain[1500].hash()), 1500u);
+}
+
+TEST(BlockHashes, SerializesAsVectorOfPoolHashes) {
+    const auto chain = makeChain(100);
+    cs::BlockHashes hashes;
+    std::vector<csdb::PoolHash> poolHashes;
+
+    for (const auto& block : chain) {
+        ASSERT_TRUE(hashes.loadNextBlock(block));
+        poolHashes.push_back(block.hash());
+    }
+
+    cs::Bytes bytes;
+    cs::DataStream stream(bytes);
+    hashes.serialize(stream);
+
+    cs::Bytes expected;
+    cs::DataStream expectedStream(expected);
+    expectedStream << poolHashes;
+    ASSERT_EQ(bytes, expected);
+
+    cs::DataStream input(bytes.data(), bytes.size());
+    cs::BlockHashes restored;
+    ASSERT_TRUE(restored.deserialize(input));
+    ASSERT_EQ(restored.size(), chain.size());
+    ASSERT_EQ(restored.getDbStructure().last_, 99u);
+    ASSERT_EQ(restored.find(chain[42].hash()), 42u);
+    ASSERT_TRUE(restored.loadNextBlock(makeBlock(chain.back().hash(), 100)));
+}
+
+TEST(BlockHashes, FrozenHashesStayAsSerialized) {
+    const auto chain = makeChain(5000);
+    cs::BlockHashes hashes;
+
+    for (size_t i = 0; i < 4000; ++i) {
+        ASSERT_TRUE(hashes.loadNextBlock(chain[i]));
+    }
+
+    cs::Bytes expected;
+    cs::DataStream out(expected);
+    hashes.serialize(out);
+
+    auto serialize = hashes.freeze();
+
+    // the last blocks are replaced and the chain grows past the frozen ones
+    for (size_t i = 0; i < 10; ++i) {
+        hashes.removeLast();
+    }
+    for (size_t i = 3990; i < chain.size(); ++i) {
+        ASSERT_TRUE(hashes.loadNextBlock(i < 4000 ? makeBlock(csdb::PoolHash{}, i) : chain[i]));
+    }
+
+    cs::Bytes bytes;
+    cs::DataStream frozen(bytes);
+    serialize(frozen);
+    EXPECT_EQ(bytes, expected);
+}
+
+TEST(BlockHashes, DISABLED_benchmark_10M_blocks) {
+    constexpr size_t blocksCount = 10000000;
+    constexpr size_t lookups = 1000000;
+    constexpr size_t linearLookups = 20;
+
+    std::mt19937_64 random(42);
+    std::vector<cs::Hash> keys(blocksCount);
+
+    for (auto& key : keys) {
+        for (auto& byte : key) {
+            byte = static_cast<uint8_t>(random());
+        }
+    }
+
+    // the snapshot layout is the quickest way to load that many blocks
+    cs::Bytes bytes;
+    cs::DataStream stream(bytes);
+    stream << keys.size();
+
+    for (const auto& key : keys) {
+        stream << cs::BytesView(key.data(), key.size());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    cs::BlockHashes hashes;
+    cs::DataStream input(bytes.data(), bytes.size());
+    ASSERT_TRUE(hashes.deserialize(input));
+    std::cout << "load: " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+
+    std::vector<csdb::PoolHash> queries;
+    std::vector<cs::Sequence> sequences;
+
+    for (size_t i = 0; i < lookups; ++i) {
+        sequences.push_back(static_cast<cs::Sequence>(random() % blocksCount));
+        queries.push_back(csdb::PoolHash::from_binary(cs::Bytes(keys[sequences.back()].begin(), keys[sequences.back()].end())));
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i) {
+        ASSERT_EQ(hashes.find(queries[i]), sequences[i]);
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "indexed: " << static_cast<double>(ns) / lookups << " ns/op" << std::endl;
+
+    // the former layout
+    std::vector<csdb::PoolHash> poolHashes;
+    poolHashes.reserve(blocksCount);
+
+    for (const auto& key : keys) {
+        poolHashes.push_back(csdb::PoolHash::from_binary(cs::Bytes(key.begin(), key.end())));
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < linearLookups; ++i) {
+        const auto it = std::find(poolHashes.cbegin(), poolHashes.cend(), queries[i]);
+        ASSERT_EQ(static_cast<cs::Sequence>(std::distance(poolHashes.cbegin(), it)), sequences[i]);
+    }
+    ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "std::find over std::vector<csdb::PoolHash>: " << static_cast<double>(ns) / linearLookups << " ns/op" << std::endl;
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <net/neighbourhood.hpp>
+
+TEST(ConnectionMetrics, SmoothsRoundTrip) {
+    Connection::Metrics metrics;
+    EXPECT_EQ(metrics.getRetryTimeout(), Connection::Metrics::DefaultTimeout);
+
+    // the first sample is taken as is, its half is the variance
+    metrics.addRttSample(1000);
+    EXPECT_EQ(metrics.srtt.load(), 1000u);
+    EXPECT_EQ(metrics.rttvar.load(), 500u);
+    EXPECT_EQ(metrics.getRetryTimeout(), 3000u);
+
+    // then srtt = 7/8 srtt + 1/8 sample, rttvar = 3/4 rttvar + 1/4 |srtt - sample|
+    metrics.addRttSample(2000);
+    EXPECT_EQ(metrics.srtt.load(), 1125u);
+    EXPECT_EQ(metrics.rttvar.load(), 625u);
+    EXPECT_EQ(metrics.getRetryTimeout(), 1125u + 4 * 625u);
+
+    for (int i = 0; i < 200; ++i) {
+        metrics.addRttSample(400);
+    }
+    EXPECT_NEAR(metrics.srtt.load(), 400u, 8u);
+    EXPECT_LT(metrics.rttvar.load(), 8u);
+
+    // a zero sample does not look like no sample at all
+    Connection::Metrics local;
+    local.addRttSample(0);
+    EXPECT_EQ(local.srtt.load(), 1u);
+}
+
+TEST(ConnectionMetrics, EstimatesLoss) {
+    Connection::Metrics metrics;
+
+    metrics.addDelivery(true);
+    EXPECT_EQ(metrics.loss.load(), Connection::Metrics::LossScale / 16);
+
+    for (int i = 0; i < 200; ++i) {
+        metrics.addDelivery(true);
+    }
+    EXPECT_GT(metrics.loss.load(), Connection::Metrics::LossScale * 99 / 100);
+
+    for (int i = 0; i < 200; ++i) {
+        metrics.addDelivery(false);
+    }
+    EXPECT_LT(metrics.loss.load(), Connection::Metrics::LossScale / 100);
+
+    // every other packet lost
+    for (int i = 0; i < 400; ++i) {
+        metrics.addDelivery(i % 2 == 0);
+    }
+    EXPECT_NEAR(metrics.loss.load(), Connection::Metrics::LossScale / 2, Connection::Metrics::LossScale / 16);
+}
+
+TEST(ConnectionMetrics, ScoresExpectedDeliveryTime) {
+    Connection::Metrics metrics;
+    EXPECT_EQ(metrics.getScore(), Connection::Metrics::DefaultTimeout);
+
+    metrics.addRttSample(1000);
+    EXPECT_EQ(metrics.getScore(), 1000u);
+
+    // half of the packets lost, two attempts on average
+    metrics.loss = Connection::Metrics::LossScale / 2;
+    EXPECT_EQ(metrics.getScore(), 2000u);
+
+    // a neighbour losing everything is still given a chance
+    metrics.loss = Connection::Metrics::LossScale;
+    EXPECT_EQ(metrics.getScore(), 100000u);
+
+    metrics.addCompletion(300);
+    metrics.addCompletion(500);
+    EXPECT_EQ(metrics.completions.load(), 2u);
+    EXPECT_EQ(metrics.completionTime.load(), 800u);
+}
+
+TEST(Neighbourhood, PicksByInverseScore) {
+    // the second one is skipped, the first takes 3/4 of the range and the third 1/4
+    const std::vector<uint64_t> scores = {100, 0, 300};
+
+    EXPECT_EQ(Neighbourhood::pickByScore(scores, 0.), 0);
+    EXPECT_EQ(Neighbourhood::pickByScore(scores, 0.74), 0);
+    EXPECT_EQ(Neighbourhood::pickByScore(scores, 0.76), 2);
+    EXPECT_EQ(Neighbourhood::pickByScore(scores, 1.), 2);
+
+    int picks[3] = {0, 0, 0};
+    for (int i = 0; i < 1000; ++i) {
+        ++picks[Neighbourhood::pickByScore(scores, (i + 0.5) / 1000)];
+    }
+    EXPECT_EQ(picks[0], 750);
+    EXPECT_EQ(picks[1], 0);
+    EXPECT_EQ(picks[2], 250);
+
+    EXPECT_EQ(Neighbourhood::pickByScore({}, 0.5), -1);
+    EXPECT_EQ(Neighbourhood::pickByScore({0, 0}, 0.5), -1);
+}
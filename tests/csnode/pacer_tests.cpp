@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <client/config.hpp>
+#include <net/pacer.hpp>
+
+namespace {
+const ip::udp::endpoint kFirst(ip::make_address("127.0.0.1"), 6000);
+const ip::udp::endpoint kSecond(ip::make_address("127.0.0.2"), 6000);
+
+NetworkData makeSettings(const uint16_t rate, const uint16_t globalRate, const uint16_t burst) {
+    NetworkData settings;
+    settings.pacingRate = rate;
+    settings.pacingGlobalRate = globalRate;
+    settings.pacingBurst = burst;
+    return settings;
+}
+
+Packet makePacket(RegionAllocator& allocator) {
+    Packet pack(allocator.allocateNext(64));
+    *static_cast<uint8_t*>(pack.data()) = BaseFlags::Broadcast;
+    return pack;
+}
+}  // namespace
+
+TEST(Pacer, DisabledByDefault) {
+    Pacer pacer(NetworkData{});
+    ASSERT_FALSE(pacer.isEnabled());
+}
+
+TEST(Pacer, SendsBurstThenPaces) {
+    Pacer pacer(makeSettings(1000, 0, 10));
+    RegionAllocator allocator(4096, 1);
+
+    auto now = Pacer::Clock::now();
+
+    for (size_t i = 0; i < 25; ++i) {
+        pacer.push(kFirst, makePacket(allocator), now);
+    }
+
+    std::vector<Pacer::Item> items;
+    ASSERT_EQ(pacer.pop(items, 100, now), 10u);
+    ASSERT_EQ(pacer.pop(items, 100, now), 0u);
+
+    // a token per millisecond
+    ASSERT_EQ(pacer.getTimeout(now), 1);
+
+    now += std::chrono::milliseconds(5);
+    ASSERT_EQ(pacer.pop(items, 100, now), 5u);
+
+    now += std::chrono::seconds(1);
+    ASSERT_EQ(pacer.pop(items, 100, now), 10u);
+    ASSERT_EQ(pacer.getTimeout(now), -1);
+
+    const auto stats = pacer.getStats();
+    ASSERT_EQ(stats.size(), 1u);
+    ASSERT_EQ(stats[0].sent, 25u);
+    ASSERT_EQ(stats[0].paced, 15u);
+    ASSERT_EQ(stats[0].queued, 0u);
+}
+
+TEST(Pacer, SharesGlobalRateBetweenPeers) {
+    Pacer pacer(makeSettings(0, 1000, 32));
+    RegionAllocator allocator(8192, 1);
+
+    const auto now = Pacer::Clock::now();
+
+    for (size_t i = 0; i < 64; ++i) {
+        pacer.push(kFirst, makePacket(allocator), now);
+        pacer.push(kSecond, makePacket(allocator), now);
+    }
+
+    std::vector<Pacer::Item> items;
+    ASSERT_EQ(pacer.pop(items, 1000, now), 32u);
+
+    const auto first = std::count_if(items.begin(), items.end(), [](const Pacer::Item& item) { return item.endpoint == kFirst; });
+    ASSERT_EQ(first, 16);
+}
+
+TEST(Pacer, DropsWhenQueueIsFull) {
+    Pacer pacer(makeSettings(1, 0, 1));
+    RegionAllocator allocator(Pacer::MaxQueued * 64 + 4096, 1);
+
+    const auto now = Pacer::Clock::now();
+
+    for (size_t i = 0; i < Pacer::MaxQueued + 5; ++i) {
+        pacer.push(kFirst, makePacket(allocator), now);
+    }
+
+    const auto stats = pacer.getStats();
+    ASSERT_EQ(stats[0].queued, Pacer::MaxQueued);
+    ASSERT_EQ(stats[0].dropped, 5u);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "packstream.hpp"
+
+#include <client/config.hpp>
+#include <net/packet.hpp>
+
+namespace {
+const cs::PublicKey kSenderKey = {0x53, 0x4b, 0xd3, 0xdf, 0x77, 0x29, 0xfd, 0xcf, 0xea, 0x4a, 0xcd, 0x0e, 0xcc, 0x14, 0xaa, 0x05,
+                                  0x0b, 0x77, 0x11, 0x6d, 0x8f, 0xcd, 0x80, 0x4b, 0x45, 0x36, 0x6b, 0x5c, 0xae, 0x4a, 0x06, 0x82};
+}  // namespace
+
+TEST(Packet, HashBatchMatchesSingleHashing) {
+    RegionAllocator allocator(Packet::MaxSize * 256, 1);
+    cs::OPackStream stream(&allocator, kSenderKey);
+
+    // more packets than fit one hashing chunk
+    stream.init(BaseFlags::Fragmented | BaseFlags::Broadcast);
+    stream << MsgTypes::RequestedBlock << cs::RoundNumber(42) << cs::Bytes(Packet::MaxSize * 100, 0x5a);
+
+    const uint32_t count = stream.getPacketsCount();
+    Packet* packets = stream.getPackets();
+
+    ASSERT_GT(count, 64u);
+
+    std::vector<Packet> batch(packets, packets + count);
+    std::vector<Packet*> pointers;
+
+    for (auto& packet : batch) {
+        pointers.push_back(&packet);
+    }
+
+    Packet::hashBatch(pointers.data(), pointers.size());
+
+    for (uint32_t i = 0; i < count; ++i) {
+        Packet single(packets[i]);
+
+        ASSERT_EQ(batch[i].getHash(), single.getHash());
+        ASSERT_EQ(batch[i].getHeaderHash(), single.getHeaderHash());
+    }
+}
+
+namespace {
+Packet makeCompressedPacket(RegionAllocator& allocator, const MsgTypes type, const cs::Bytes& payload) {
+    cs::OPackStream stream(&allocator, kSenderKey);
+    stream.init(BaseFlags::Broadcast | BaseFlags::Compressed);
+    stream << type << cs::RoundNumber(1) << payload;
+
+    return *stream.getPackets();
+}
+
+cs::Bytes makeRandomPayload(const size_t size, uint32_t seed) {
+    cs::Bytes payload(size);
+
+    for (auto& byte : payload) {
+        seed = seed * 1103515245 + 12345;
+        byte = static_cast<cs::Byte>(seed >> 16);
+    }
+
+    return payload;
+}
+}  // namespace
+
+TEST(CompressionPolicy, SkipsSmallPayloads) {
+    NetworkData settings;
+    settings.compressionMinSize = 200;
+    CompressionPolicy policy(settings);
+
+    RegionAllocator allocator(Packet::MaxSize * 4, 1);
+    Packet packet = makeCompressedPacket(allocator, MsgTypes::TransactionPacket, cs::Bytes(100, 0));
+
+    char buffer[Packet::MaxSize];
+    const auto encoded = packet.encode(boost::asio::buffer(buffer, sizeof(buffer)), &policy);
+
+    ASSERT_EQ(encoded.size(), packet.size());
+    ASSERT_FALSE(packet.isCompressed());
+
+    const auto stats = policy.getStats(MsgTypes::TransactionPacket);
+    ASSERT_EQ(stats.packets, 1u);
+    ASSERT_EQ(stats.skipped, 1u);
+    ASSERT_EQ(stats.cpuNs, 0u);
+}
+
+TEST(CompressionPolicy, StopsCompressingWhenNotPaying) {
+    NetworkData settings;
+    settings.compressionMinSize = 0;
+    CompressionPolicy policy(settings);
+
+    RegionAllocator allocator(Packet::MaxSize * 4, 1);
+    char buffer[Packet::MaxSize];
+
+    for (uint32_t i = 0; i < 100; ++i) {
+        Packet packet = makeCompressedPacket(allocator, MsgTypes::TransactionPacket, makeRandomPayload(800, i));
+        packet.encode(boost::asio::buffer(buffer, sizeof(buffer)), &policy);
+    }
+
+    const auto stats = policy.getStats(MsgTypes::TransactionPacket);
+    ASSERT_EQ(stats.packets, 100u);
+
+    // a byte or two of the header is saved until the estimate falls below the minimal gain
+    ASSERT_LT(stats.compressed, 30u);
+    ASSERT_EQ(stats.skipped, stats.packets - stats.compressed);
+}
+
+TEST(CompressionPolicy, DictionaryRoundTrip) {
+    NetworkData settings;
+    CompressionPolicy sender(settings);
+    CompressionPolicy receiver(settings);
+
+    const cs::Bytes payload = makeRandomPayload(600, 7);
+
+    std::deque<cs::Bytes> samples = {payload};
+    const cs::Bytes dictionary = CompressionPolicy::buildDictionary(samples);
+    sender.setDictionary(dictionary, true);
+    receiver.setDictionary(dictionary, false);
+
+    RegionAllocator allocator(Packet::MaxSize * 4, 1);
+    Packet packet = makeCompressedPacket(allocator, MsgTypes::TransactionPacket, payload);
+    const cs::Bytes original(static_cast<const uint8_t*>(packet.data()), static_cast<const uint8_t*>(packet.data()) + packet.size());
+
+    char buffer[Packet::MaxSize];
+    const auto encoded = packet.encode(boost::asio::buffer(buffer, sizeof(buffer)), &sender);
+
+    // random bytes are only compressible with the dictionary
+    ASSERT_LT(encoded.size(), original.size() / 2);
+    ASSERT_TRUE(*static_cast<const uint8_t*>(encoded.data()) & BaseFlags::Dictionary);
+
+    RegionAllocator receiving(Packet::MaxSize, 1);
+    Packet received(receiving.allocateNext(Packet::MaxSize));
+    std::copy(buffer, buffer + encoded.size(), static_cast<char*>(received.data()));
+
+    ASSERT_EQ(received.decode(encoded.size(), &receiver), original.size());
+    // the flags differ: the received packet is not compressed any more
+    ASSERT_TRUE(std::equal(original.begin() + 1, original.end(), static_cast<const uint8_t*>(received.data()) + 1));
+
+    // without the dictionary the packet is dropped
+    CompressionPolicy plain(settings);
+    std::copy(buffer, buffer + encoded.size(), static_cast<char*>(received.data()));
+    ASSERT_EQ(received.decode(encoded.size(), &plain), 0u);
+}
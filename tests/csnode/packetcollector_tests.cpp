@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include "packstream.hpp"
+
+#include <net/packet.hpp>
+
+namespace {
+const cs::PublicKey kSenderKey = {0x53, 0x4b, 0xd3, 0xdf, 0x77, 0x29, 0xfd, 0xcf, 0xea, 0x4a, 0xcd, 0x0e, 0xcc, 0x14, 0xaa, 0x05,
+                                  0x0b, 0x77, 0x11, 0x6d, 0x8f, 0xcd, 0x80, 0x4b, 0x45, 0x36, 0x6b, 0x5c, 0xae, 0x4a, 0x06, 0x82};
+
+cs::Bytes makePayload(const size_t size) {
+    cs::Bytes payload(size);
+
+    for (size_t i = 0; i < size; ++i) {
+        payload[i] = static_cast<cs::Byte>(i * 7);
+    }
+
+    return payload;
+}
+}  // namespace
+
+TEST(PacketCollector, CollectsFragmentsInAnyOrder) {
+    RegionAllocator allocator(Packet::MaxSize * 16, 1);
+    cs::OPackStream stream(&allocator, kSenderKey);
+
+    const cs::Bytes payload = makePayload(5000);
+
+    stream.init(BaseFlags::Fragmented | BaseFlags::Broadcast);
+    stream << MsgTypes::RequestedBlock << cs::RoundNumber(42) << payload;
+
+    const uint32_t count = stream.getPacketsCount();
+    Packet* packets = stream.getPackets();
+
+    ASSERT_GT(count, 1u);
+
+    PacketCollector collector;
+    MessagePtr msg;
+
+    for (uint32_t i = count; i > 0; --i) {
+        bool newFragmentedMsg = false;
+        bool completed = false;
+
+        msg = collector.getMessage(packets[i - 1], newFragmentedMsg, completed);
+
+        ASSERT_TRUE(msg);
+        ASSERT_EQ(newFragmentedMsg, i == count);
+        ASSERT_EQ(completed, i == 1);
+    }
+
+    ASSERT_TRUE(msg->isComplete());
+
+    // a repeated fragment does not complete the message again
+    bool newFragmentedMsg = false;
+    bool completed = false;
+    collector.getMessage(packets[0], newFragmentedMsg, completed);
+
+    ASSERT_FALSE(newFragmentedMsg);
+    ASSERT_FALSE(completed);
+
+    cs::IPackStream istream;
+    istream.init(msg->getFullData(), msg->getFullSize());
+
+    MsgTypes type;
+    cs::RoundNumber round = 0;
+    cs::Bytes received;
+    istream >> type >> round >> received;
+
+    ASSERT_TRUE(istream.good());
+    ASSERT_EQ(type, MsgTypes::RequestedBlock);
+    ASSERT_EQ(round, 42u);
+    ASSERT_EQ(received, payload);
+}
+
+TEST(PacketCollector, SingleFragmentIsNotCopied) {
+    RegionAllocator allocator(Packet::MaxSize * 4, 1);
+    cs::OPackStream stream(&allocator, kSenderKey);
+
+    stream.init(BaseFlags::Fragmented | BaseFlags::Broadcast);
+    stream << MsgTypes::RoundTable << cs::RoundNumber(1) << makePayload(100);
+
+    ASSERT_EQ(stream.getPacketsCount(), 1u);
+    Packet* packets = stream.getPackets();
+
+    PacketCollector collector;
+    bool newFragmentedMsg = false;
+    bool completed = false;
+    MessagePtr msg = collector.getMessage(*packets, newFragmentedMsg, completed);
+
+    ASSERT_TRUE(completed);
+    ASSERT_EQ(msg->getFullData(), packets->getMsgData());
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <cscrypto/cscrypto.hpp>
+
+#include "signaturecache.hpp"
+#include "signatureverifier.hpp"
+
+namespace {
+cs::Hash makeKey(size_t n) {
+    cs::Hash key{};
+    for (size_t i = 0; i < key.size(); ++i) {
+        key[i] = static_cast<cs::Byte>(n >> (i % 4 * 8)) ^ static_cast<cs::Byte>(i * 31);
+    }
+    return key;
+}
+}  // namespace
+
+TEST(SignatureCache, CountsHitsAndMisses) {
+    cs::SignatureCache cache(100, 4);
+    cache.insert(makeKey(1));
+
+    ASSERT_TRUE(cache.contains(makeKey(1)));
+    ASSERT_FALSE(cache.contains(makeKey(2)));
+
+    const auto stats = cache.stats();
+    ASSERT_EQ(stats.hits, 1u);
+    ASSERT_EQ(stats.misses, 1u);
+    ASSERT_EQ(stats.size, 1u);
+}
+
+TEST(SignatureCache, ForgetsOldestWhenFull) {
+    cs::SignatureCache cache(3, 1);
+
+    for (size_t i = 0; i < 5; ++i) {
+        cache.insert(makeKey(i));
+    }
+
+    ASSERT_FALSE(cache.contains(makeKey(0)));
+    ASSERT_FALSE(cache.contains(makeKey(1)));
+    ASSERT_TRUE(cache.contains(makeKey(4)));
+    ASSERT_EQ(cache.stats().size, 3u);
+    ASSERT_EQ(cache.stats().evictions, 2u);
+}
+
+TEST(SignatureCache, KeepsOnlyRightSignatures) {
+    ASSERT_TRUE(cscrypto::cryptoInit());
+    cs::PublicKey key;
+    auto privateKey = cscrypto::generateKeyPair(key);
+
+    std::vector<cs::Bytes> messages;
+    std::vector<cs::Signature> signatures;
+    for (size_t i = 0; i < 20; ++i) {
+        messages.emplace_back(64, static_cast<cs::Byte>(i));
+        signatures.push_back(cscrypto::generateSignature(privateKey, messages.back().data(), messages.back().size()));
+    }
+    signatures[7][0] ^= 1;
+
+    cs::SignatureItems items;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        items.push_back(cs::SignatureItem{signatures[i].data(), key.data(), messages[i].data(), messages[i].size()});
+    }
+
+    cs::SignatureCache cache(100, 4);
+    cs::SignatureVerifier verifier(2);
+    cs::Bytes results;
+
+    verifier.verify(items, results, &cache);
+    ASSERT_EQ(results[7], 0);
+    ASSERT_EQ(cache.stats().size, 19u);
+    ASSERT_EQ(cache.stats().hits, 0u);
+
+    // the second pass finds the right ones, the wrong one is checked again
+    size_t invalid = 0;
+    ASSERT_FALSE(verifier.verifyAll(items, &invalid, &cache));
+    ASSERT_EQ(invalid, 7u);
+    ASSERT_GE(cache.stats().hits, 7u);
+
+    // another key is another entry
+    cs::PublicKey otherKey;
+    cscrypto::generateKeyPair(otherKey);
+    ASSERT_FALSE(cache.contains(cs::SignatureCache::key(cs::SignatureItem{signatures[0].data(), otherKey.data(), messages[0].data(), messages[0].size()})));
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <thread>
+
+#include <cscrypto/cscrypto.hpp>
+
+#include "signatureverifier.hpp"
+
+namespace {
+struct Signed {
+    cs::PublicKey key;
+    std::vector<cs::Bytes> messages;
+    std::vector<cs::Signature> signatures;
+
+    explicit Signed(size_t count, size_t messageSize = 100) {
+        EXPECT_TRUE(cscrypto::cryptoInit());
+        auto privateKey = cscrypto::generateKeyPair(key);
+
+        for (size_t i = 0; i < count; ++i) {
+            messages.emplace_back(messageSize, static_cast<cs::Byte>(i));
+            messages.back()[0] = static_cast<cs::Byte>(i >> 8);
+            signatures.push_back(cscrypto::generateSignature(privateKey, messages.back().data(), messages.back().size()));
+        }
+    }
+
+    cs::SignatureItems items() const {
+        cs::SignatureItems result;
+
+        for (size_t i = 0; i < messages.size(); ++i) {
+            result.push_back(cs::SignatureItem{signatures[i].data(), key.data(), messages[i].data(), messages[i].size()});
+        }
+
+        return result;
+    }
+};
+}  // namespace
+
+TEST(SignatureVerifier, ChecksEveryItem) {
+    Signed data(100);
+    data.signatures[17][0] ^= 1;
+    data.messages[64][5] ^= 1;
+
+    cs::SignatureVerifier verifier(3);
+    cs::Bytes results;
+    verifier.verify(data.items(), results);
+
+    ASSERT_EQ(results.size(), 100u);
+    for (size_t i = 0; i < results.size(); ++i) {
+        ASSERT_EQ(results[i], (i == 17 || i == 64) ? 0 : 1) << i;
+    }
+}
+
+TEST(SignatureVerifier, FindsFirstInvalid) {
+    Signed data(200);
+    cs::SignatureVerifier verifier(3);
+
+    size_t invalid = 0;
+    ASSERT_TRUE(verifier.verifyAll(data.items(), &invalid));
+
+    data.signatures[150][1] ^= 1;
+    data.signatures[90][1] ^= 1;
+    ASSERT_FALSE(verifier.verifyAll(data.items(), &invalid));
+    ASSERT_EQ(invalid, 90u);
+}
+
+TEST(SignatureVerifier, WorksWithoutWorkers) {
+    Signed data(20);
+    data.signatures[3][2] ^= 1;
+
+    cs::SignatureVerifier verifier(0);
+    size_t invalid = 0;
+    ASSERT_FALSE(verifier.verifyAll(data.items(), &invalid));
+    ASSERT_EQ(invalid, 3u);
+    ASSERT_TRUE(verifier.verifyAll({}));
+}
+
+TEST(SignatureVerifier, VerifiesAsyncOnWorkers) {
+    auto data = std::make_shared<Signed>(100);
+    data->signatures[42][0] ^= 1;
+    const cs::SignatureItems items = data->items();
+
+    cs::SignatureVerifier verifier(2);
+    std::promise<std::pair<cs::Bytes, std::thread::id>> done;
+
+    // the items are copied and the holder keeps the buffers, the caller drops its own
+    verifier.verifyAsync(items, std::move(data), [&done](const cs::Bytes& results) { done.set_value({results, std::this_thread::get_id()}); });
+
+    const auto [results, thread] = done.get_future().get();
+    EXPECT_NE(thread, std::this_thread::get_id());
+    ASSERT_EQ(results.size(), 100u);
+    for (size_t i = 0; i < results.size(); ++i) {
+        ASSERT_EQ(results[i], i == 42 ? 0 : 1) << i;
+    }
+
+    // without workers the handler runs on the calling thread
+    cs::SignatureVerifier sequential(0);
+    auto single = std::make_shared<Signed>(3);
+    bool called = false;
+    sequential.verifyAsync(single->items(), single, [&called](const cs::Bytes& results) { called = results == cs::Bytes(3, 1); });
+    EXPECT_TRUE(called);
+}
+
+TEST(SignatureVerifier, DISABLED_benchmark_full_block) {
+    // about the size of a full block
+    constexpr size_t count = 10000;
+    Signed data(count, 150);
+    const auto items = data.items();
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& item : items) {
+        ASSERT_TRUE(cscrypto::verifySignature(item.signature, item.publicKey, item.data, item.size));
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "one by one: " << count * 1000 / std::max<decltype(ms)>(ms, 1) << " signatures/s" << std::endl;
+
+    auto& verifier = cs::SignatureVerifier::instance();
+    start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(verifier.verifyAll(items));
+    ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "verifier, " << verifier.workers() << " workers: " << count * 1000 / std::max<decltype(ms)>(ms, 1) << " signatures/s" << std::endl;
+}
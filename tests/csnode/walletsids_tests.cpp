@@ -0,0 +1,324 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <csnode/datastream.hpp>
+
+#include "walletsids.hpp"
+
+namespace {
+csdb::Address makeAddress(uint64_t n) {
+    cs::PublicKey key{};
+    for (size_t i = 0; i < key.size(); ++i) {
+        key[i] = static_cast<cs::Byte>(n >> (8 * (i % sizeof(n))));
+    }
+    key[31] = 1;
+    return csdb::Address::from_public_key(key);
+}
+
+// counts the bytes of the map nodes and buckets
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    explicit CountingAllocator(size_t& total)
+    : bytes(&total) {
+    }
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other)
+    : bytes(other.bytes) {
+    }
+
+    T* allocate(size_t n) {
+        *bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        *bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    bool operator==(const CountingAllocator& other) const {
+        return bytes == other.bytes;
+    }
+
+    bool operator!=(const CountingAllocator& other) const {
+        return bytes != other.bytes;
+    }
+
+    size_t* bytes;
+};
+}  // namespace
+
+TEST(WalletsIds, FindsInsertedIds) {
+    cs::WalletsIds ids;
+    cs::WalletsIds::WalletId id = 0;
+
+    for (uint64_t i = 0; i < 5000; ++i) {
+        ASSERT_TRUE(ids.normal().get(makeAddress(i), id));
+        ASSERT_EQ(id, i);
+    }
+    EXPECT_FALSE(ids.normal().get(makeAddress(10), id));
+    EXPECT_EQ(id, 10u);
+    EXPECT_FALSE(ids.normal().insert(makeAddress(11), 20));
+    EXPECT_EQ(ids.size(), 5000u);
+
+    for (uint64_t i = 0; i < 5000; ++i) {
+        ASSERT_TRUE(ids.normal().find(makeAddress(i), id));
+        ASSERT_EQ(id, i);
+
+        csdb::Address address;
+        ASSERT_TRUE(ids.normal().findaddr(static_cast<cs::WalletsIds::WalletId>(i), address));
+        ASSERT_EQ(address, makeAddress(i));
+    }
+
+    EXPECT_FALSE(ids.normal().find(makeAddress(5000), id));
+    EXPECT_TRUE(ids.normal().find(csdb::Address::from_wallet_id(7), id));
+    EXPECT_EQ(id, 7u);
+
+    csdb::Address address;
+    EXPECT_FALSE(ids.normal().findaddr(5000, address));
+}
+
+TEST(WalletsIds, RemovesAndReplacesSpecialIds) {
+    cs::WalletsIds ids;
+    cs::WalletsIds::WalletId id = 0;
+
+    ASSERT_TRUE(ids.special().findAnyOrInsertSpecial(makeAddress(1), id));
+    const auto special = id;
+    EXPECT_TRUE(cs::WalletsIds::Special::isSpecial(special));
+
+    cs::WalletsIds::WalletId replaced = 0;
+    ASSERT_TRUE(ids.special().insertNormal(makeAddress(1), 3, replaced));
+    EXPECT_EQ(replaced, special);
+    ASSERT_TRUE(ids.normal().find(makeAddress(1), id));
+    EXPECT_EQ(id, 3u);
+    EXPECT_FALSE(ids.special().insertNormal(makeAddress(1), 4, replaced));
+
+    csdb::Address address;
+    EXPECT_FALSE(ids.normal().findaddr(special, address));
+
+    ASSERT_TRUE(ids.normal().insert(makeAddress(2), 4));
+    EXPECT_TRUE(ids.normal().remove(makeAddress(2)));
+    EXPECT_FALSE(ids.normal().find(makeAddress(2), id));
+    EXPECT_FALSE(ids.normal().findaddr(4, address));
+    EXPECT_EQ(ids.size(), 1u);
+
+    // the removed id is given to the next wallet
+    ASSERT_TRUE(ids.normal().get(makeAddress(5), id));
+    EXPECT_EQ(id, 4u);
+    ASSERT_TRUE(ids.normal().findaddr(4, address));
+    EXPECT_EQ(address, makeAddress(5));
+}
+
+TEST(WalletsIds, KeepsIdsInSnapshot) {
+    cs::WalletsIds ids;
+    cs::WalletsIds::WalletId id = 0;
+    for (uint64_t i = 0; i < 3000; ++i) {
+        ids.normal().get(makeAddress(i), id);
+    }
+
+    cs::Bytes bytes;
+    cs::DataStream out(bytes);
+    ids.serialize(out);
+
+    cs::DataStream in(bytes.data(), bytes.size());
+    cs::WalletsIds restored;
+    ASSERT_TRUE(restored.deserialize(in));
+    EXPECT_EQ(restored.size(), 3000u);
+
+    for (uint64_t i = 0; i < 3000; ++i) {
+        ASSERT_TRUE(restored.normal().find(makeAddress(i), id));
+        ASSERT_EQ(id, i);
+    }
+
+    ASSERT_TRUE(restored.normal().get(makeAddress(3000), id));
+    EXPECT_EQ(id, 3000u);
+}
+
+TEST(WalletsIds, FrozenIdsStayAsSerialized) {
+    cs::WalletsIds ids;
+    cs::WalletsIds::WalletId id = 0;
+    for (uint64_t i = 0; i < 3000; ++i) {
+        ids.normal().get(makeAddress(i), id);
+    }
+    ASSERT_TRUE(ids.special().findAnyOrInsertSpecial(makeAddress(5000), id));
+
+    cs::Bytes expected;
+    cs::DataStream out(expected);
+    ids.serialize(out);
+
+    auto serialize = ids.freeze();
+
+    // the removed ids are given to other keys, the special one becomes normal
+    for (uint64_t i = 0; i < 3000; i += 7) {
+        ids.normal().remove(makeAddress(i));
+    }
+    for (uint64_t i = 3000; i < 4000; ++i) {
+        ids.normal().get(makeAddress(i), id);
+    }
+    cs::WalletsIds::WalletId special = 0;
+    ASSERT_TRUE(ids.special().insertNormal(makeAddress(5000), 5000, special));
+
+    cs::Bytes bytes;
+    cs::DataStream frozen(bytes);
+    serialize(frozen);
+    EXPECT_EQ(bytes, expected);
+
+    cs::DataStream in(bytes.data(), bytes.size());
+    cs::WalletsIds restored;
+    ASSERT_TRUE(restored.deserialize(in));
+    EXPECT_EQ(restored.size(), 3001u);
+    ASSERT_TRUE(restored.normal().find(makeAddress(2999), id));
+    EXPECT_EQ(id, 2999u);
+}
+
+TEST(WalletsIds, FindsAlongWithTheWriter) {
+    constexpr uint64_t count = 100000;
+    cs::WalletsIds ids;
+    std::atomic<uint64_t> inserted{0};
+    std::atomic<bool> stop{false};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&, r] {
+            std::mt19937_64 random(r);
+            while (!stop.load()) {
+                const uint64_t known = inserted.load();
+                if (known == 0) {
+                    continue;
+                }
+
+                const uint64_t i = random() % known;
+                cs::WalletsIds::WalletId id = 0;
+                ASSERT_TRUE(ids.normal().find(makeAddress(i), id));
+                ASSERT_EQ(id, i);
+            }
+        });
+    }
+
+    // the table grows many times meanwhile
+    for (uint64_t i = 0; i < count; ++i) {
+        cs::WalletsIds::WalletId id = 0;
+        ids.normal().get(makeAddress(i), id);
+        inserted.store(i + 1);
+    }
+
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+}
+
+TEST(WalletsIds, FreesReplacedTables) {
+    cs::WalletsIds ids;
+    cs::WalletsIds::WalletId id = 0;
+    std::atomic<bool> stop{false};
+
+    for (uint64_t i = 0; i < 100; ++i) {
+        ids.normal().get(makeAddress(i), id);
+    }
+
+    // keeps finding the first ones while the removed slots fill the table again and again
+    std::thread reader([&] {
+        while (!stop.load()) {
+            for (uint64_t i = 0; i < 100; ++i) {
+                cs::WalletsIds::WalletId found = 0;
+                ASSERT_TRUE(ids.normal().find(makeAddress(i), found));
+                ASSERT_EQ(found, i);
+            }
+        }
+    });
+
+    // the same id again, so the keys do not grow; the table replaced first is kept to be refilled
+    auto churn = [&](uint64_t from, uint64_t to) {
+        for (uint64_t i = from; i < to; ++i) {
+            ids.normal().insert(makeAddress(i), 100);
+            ids.normal().remove(makeAddress(i));
+        }
+    };
+
+    churn(100, 10000);
+    const size_t memory = ids.memory();
+    churn(10000, 30000);
+
+    stop = true;
+    reader.join();
+
+    EXPECT_EQ(ids.size(), 100u);
+    EXPECT_EQ(ids.memory(), memory);
+}
+
+TEST(WalletsIds, DISABLED_benchmark_ten_million_wallets) {
+    constexpr uint64_t count = 10000000;
+    constexpr uint64_t lookups = 5000000;
+
+    std::vector<csdb::Address> addresses;
+    addresses.reserve(count);
+    std::mt19937_64 random(1);
+    for (uint64_t i = 0; i < count; ++i) {
+        addresses.push_back(makeAddress(random()));
+    }
+
+    std::vector<uint64_t> order(lookups);
+    for (auto& i : order) {
+        i = random() % count;
+    }
+
+    auto measure = [](const char* name, auto&& func) {
+        const auto start = std::chrono::steady_clock::now();
+        func();
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << name << ": " << ms << " ms" << std::endl;
+    };
+
+    {
+        // the map the ids were kept in
+        size_t bytes = 0;
+        using Map = std::unordered_map<csdb::Address, cs::WalletsIds::WalletId, std::hash<csdb::Address>, std::equal_to<csdb::Address>,
+                                       CountingAllocator<std::pair<const csdb::Address, cs::WalletsIds::WalletId>>>;
+        Map map(0, std::hash<csdb::Address>(), std::equal_to<csdb::Address>(), Map::allocator_type(bytes));
+
+        measure("map, insert", [&] {
+            for (uint64_t i = 0; i < count; ++i) {
+                map.emplace(addresses[i], static_cast<cs::WalletsIds::WalletId>(i));
+            }
+        });
+
+        uint64_t sum = 0;
+        measure("map, find", [&] {
+            for (uint64_t i : order) {
+                sum += map.find(addresses[i])->second;
+            }
+        });
+
+        std::cout << "map: " << bytes / count << " bytes per wallet, the data of the addresses excluded, sum " << sum << std::endl;
+    }
+
+    cs::WalletsIds ids;
+    measure("table, insert", [&] {
+        cs::WalletsIds::WalletId id = 0;
+        for (uint64_t i = 0; i < count; ++i) {
+            ids.normal().get(addresses[i], id);
+        }
+    });
+
+    uint64_t sum = 0;
+    measure("table, find", [&] {
+        for (uint64_t i : order) {
+            cs::WalletsIds::WalletId id = 0;
+            ids.normal().find(addresses[i], id);
+            sum += id;
+        }
+    });
+
+    std::cout << "table: " << ids.memory() / count << " bytes per wallet, sum " << sum << std::endl;
+}
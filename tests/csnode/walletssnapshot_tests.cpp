@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <csnode/datastream.hpp>
+#include <csnode/walletscache.hpp>
+#include <csnode/walletsids.hpp>
+#include <csnode/walletssnapshot.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace {
+csdb::PoolHash makeHash(uint8_t n) {
+    return csdb::PoolHash::from_binary(cs::Bytes(32, n));
+}
+
+cs::Bytes makeState(uint8_t n, size_t size = 1000) {
+    cs::Bytes state(size);
+    for (size_t i = 0; i < size; ++i) {
+        state[i] = static_cast<cs::Byte>(n + i);
+    }
+    return state;
+}
+
+class WalletsSnapshotTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = (fs::temp_directory_path() / "walletssnapshot_tests").string();
+        fs::remove_all(path_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(path_);
+    }
+
+    // the writer finishes the queued snapshot before the destructor returns
+    void save(cs::Sequence sequence, uint8_t n, size_t keep = 2) {
+        cs::WalletsSnapshot snapshot(path_, keep);
+        snapshot.save(sequence, makeHash(n), makeState(n));
+    }
+
+    std::string fileName(cs::Sequence sequence) const {
+        return (fs::path(path_) / ("wallets." + std::to_string(sequence) + ".snapshot")).string();
+    }
+
+    void patch(cs::Sequence sequence, std::streamoff offset, char byte) const {
+        std::fstream file(fileName(sequence), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(offset, offset < 0 ? std::ios::end : std::ios::beg);
+        file.put(byte);
+    }
+
+    // the sequences offered to the handler in order, the state of the accepted one
+    std::vector<cs::Sequence> load(const std::function<bool(cs::Sequence, const csdb::PoolHash&)>& accept, cs::Bytes* state = nullptr) const {
+        std::vector<cs::Sequence> offered;
+        cs::WalletsSnapshot snapshot(path_);
+
+        snapshot.load([&](cs::Sequence sequence, const csdb::PoolHash& hash, cs::DataStream& stream) {
+            offered.push_back(sequence);
+            if (!accept(sequence, hash)) {
+                return false;
+            }
+            if (state != nullptr) {
+                state->assign(stream.data(), stream.data() + stream.size());
+            }
+            return true;
+        });
+
+        return offered;
+    }
+
+    std::string path_;
+};
+}  // namespace
+
+TEST_F(WalletsSnapshotTest, RoundTrip) {
+    save(10, 1);
+
+    cs::Bytes state;
+    csdb::PoolHash loadedHash;
+    const auto offered = load(
+        [&](cs::Sequence, const csdb::PoolHash& hash) {
+            loadedHash = hash;
+            return true;
+        },
+        &state);
+
+    ASSERT_EQ(offered, std::vector<cs::Sequence>{10});
+    EXPECT_EQ(loadedHash, makeHash(1));
+    EXPECT_EQ(state, makeState(1));
+}
+
+TEST_F(WalletsSnapshotTest, WritesUnderTheFinalNameOnly) {
+    save(10, 1);
+
+    EXPECT_TRUE(fs::exists(fileName(10)));
+    EXPECT_FALSE(fs::exists(fileName(10) + ".tmp"));
+
+    // a temporary file left by a crash is not offered
+    fs::copy_file(fileName(10), fileName(20) + ".tmp");
+    EXPECT_EQ(load([](cs::Sequence, const csdb::PoolHash&) { return true; }), std::vector<cs::Sequence>{10});
+}
+
+TEST_F(WalletsSnapshotTest, SkipsDamagedFile) {
+    save(10, 1);
+    patch(10, -1, '\x7F');
+
+    EXPECT_TRUE(load([](cs::Sequence, const csdb::PoolHash&) { return true; }).empty());
+}
+
+TEST_F(WalletsSnapshotTest, SkipsAnotherFormat) {
+    save(10, 1);
+
+    // the format follows the magic, the checksum covers the state only
+    patch(10, sizeof(uint32_t), '\x7F');
+    EXPECT_TRUE(load([](cs::Sequence, const csdb::PoolHash&) { return true; }).empty());
+}
+
+TEST_F(WalletsSnapshotTest, FallsBackToOlder) {
+    save(10, 1);
+    save(20, 2);
+
+    // the newest one is offered first, the block hash of the chain decides
+    cs::Bytes state;
+    auto offered = load([](cs::Sequence, const csdb::PoolHash& hash) { return hash == makeHash(1); }, &state);
+    EXPECT_EQ(offered, (std::vector<cs::Sequence>{20, 10}));
+    EXPECT_EQ(state, makeState(1));
+
+    // a damaged newest one is not offered at all
+    patch(20, -1, '\x7F');
+    offered = load([](cs::Sequence, const csdb::PoolHash&) { return true; }, &state);
+    EXPECT_EQ(offered, std::vector<cs::Sequence>{10});
+    EXPECT_EQ(state, makeState(1));
+
+    EXPECT_EQ(load([](cs::Sequence, const csdb::PoolHash&) { return false; }), std::vector<cs::Sequence>{10});
+}
+
+TEST_F(WalletsSnapshotTest, RemovesOld) {
+    save(10, 1);
+    save(20, 2);
+    save(30, 3);
+
+    EXPECT_FALSE(fs::exists(fileName(10)));
+    EXPECT_TRUE(fs::exists(fileName(20)));
+    EXPECT_TRUE(fs::exists(fileName(30)));
+
+    save(40, 4, 1);
+    EXPECT_EQ(load([](cs::Sequence, const csdb::PoolHash&) { return false; }), std::vector<cs::Sequence>{40});
+}
+
+TEST(WalletsCache, KeepsStateInSnapshot) {
+    cs::WalletsIds ids;
+    cs::WalletsCache::Config config;
+    config.initialWalletsNum_ = 16;
+    cs::WalletsCache cache(config, csdb::Address::from_wallet_id(0), csdb::Address::from_wallet_id(1), ids);
+
+    // the layout WalletsCache::serialize() writes: the wallets by id, a missing one is a zero byte
+    cs::Bytes bytes;
+    cs::DataStream out(bytes);
+    out << size_t(3);
+
+    for (uint8_t i = 0; i < 3; ++i) {
+        if (i == 1) {
+            out << uint8_t(0);
+            continue;
+        }
+
+        cs::TransactionsTail tail;
+        tail.push(100 + i);
+        out << uint8_t(1) << cs::PublicKey{i} << csdb::Amount(i * 10);
+        out.addValue(tail);
+        out << uint64_t(i + 5);
+#ifdef MONITOR_NODE
+        out << uint64_t(1000 + i);
+#endif
+#ifdef TRANSACTIONS_INDEX
+        out << csdb::PoolHash() << cs::Sequence(0);
+#endif
+    }
+
+    // no smart contract transactions
+    out << size_t(0) << size_t(0);
+#ifdef MONITOR_NODE
+    out << size_t(0);
+#endif
+
+    cs::DataStream in(bytes.data(), bytes.size());
+    ASSERT_TRUE(cache.deserialize(in));
+    EXPECT_EQ(cache.getCount(), 3u);
+
+    const auto updater = cache.createUpdater();
+    cs::WalletsCache::WalletData wallet;
+    ASSERT_TRUE(updater->findWallet(2, wallet));
+    EXPECT_EQ(wallet.address_, cs::PublicKey{2});
+    EXPECT_EQ(wallet.balance_, csdb::Amount(20));
+    EXPECT_EQ(wallet.transNum_, 7u);
+    EXPECT_EQ(wallet.trxTail_.getLastTransactionId(), 102u);
+    EXPECT_FALSE(updater->findWallet(1, wallet));
+
+    cs::Bytes serialized;
+    cs::DataStream again(serialized);
+    cache.serialize(again);
+    EXPECT_EQ(serialized, bytes);
+
+    // a cut state is refused and the wallets stay as they were
+    cs::DataStream cut(bytes.data(), bytes.size() / 2);
+    EXPECT_FALSE(cache.deserialize(cut));
+    ASSERT_TRUE(updater->findWallet(0, wallet));
+    EXPECT_EQ(wallet.transNum_, 5u);
+}
@@ -0,0 +1,304 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include <lib/system/common.hpp>
+
+#include "walletscache.hpp"
+#include "walletsstorage.hpp"
+
+TEST(WalletsStorage, KeepsReferencesWhileGrowing) {
+    cs::WalletsStorage<uint64_t, 2> storage;
+    storage.resize(3);
+    ASSERT_EQ(storage.size(), 3u);
+    EXPECT_EQ(storage[2], 0u);
+
+    uint64_t& first = storage[0];
+    first = 10;
+
+    storage.resize(100);
+    storage[99] = 99;
+    EXPECT_EQ(&first, &storage[0]);
+    EXPECT_EQ(storage[0], 10u);
+    EXPECT_EQ(storage[99], 99u);
+    EXPECT_GE(storage.memory(), 25 * (4 * sizeof(uint64_t) + sizeof(void*)));
+
+    ASSERT_NE(storage.find(99), nullptr);
+    EXPECT_EQ(*storage.find(99), 99u);
+    EXPECT_EQ(storage.find(100), nullptr);
+}
+
+TEST(WalletsStorage, ResetsDroppedEntries) {
+    cs::WalletsStorage<uint64_t, 2> storage;
+    storage.resize(6);
+    storage[5] = 5;
+    storage[1] = 1;
+
+    storage.resize(2);
+    storage.resize(6);
+    EXPECT_EQ(storage[1], 1u);
+    EXPECT_EQ(storage[5], 0u);
+
+    storage.clear();
+    EXPECT_EQ(storage.size(), 0u);
+    EXPECT_EQ(storage.memory(), 0u);
+}
+
+TEST(WalletsStorage, DISABLED_benchmark_million_wallets) {
+    using Cache = cs::WalletsCache;
+    constexpr size_t count = 1000000;
+
+    // the layout the cache had, a heap block per wallet
+    std::vector<std::unique_ptr<Cache::WalletData>> blocks;
+    blocks.reserve(count);
+    cs::WalletsStorage<Cache::WalletHead> heads;
+    cs::WalletsStorage<Cache::WalletTail> tails;
+    heads.resize(count);
+    tails.resize(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        blocks.push_back(std::make_unique<Cache::WalletData>());
+        blocks.back()->balance_ = csdb::Amount(static_cast<int32_t>(i % 100));
+        heads[i].balance_ = blocks.back()->balance_;
+    }
+
+    std::cout << "heap blocks: " << count * (sizeof(void*) + sizeof(Cache::WalletData)) << " bytes, allocator headers excluded" << std::endl;
+    std::cout << "pages: " << heads.memory() + tails.memory() << " bytes, heads " << heads.memory() << std::endl;
+
+    auto scan = [](const char* name, auto&& func) {
+        const auto start = std::chrono::steady_clock::now();
+        csdb::Amount total;
+        for (int i = 0; i < 10; ++i) {
+            total += func();
+        }
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << name << ": " << us / 10 << " us per scan, total " << total.to_string() << std::endl;
+    };
+
+    scan("heap blocks", [&blocks] {
+        csdb::Amount sum;
+        for (const auto& wallet : blocks) {
+            sum += wallet->balance_;
+        }
+        return sum;
+    });
+
+    scan("heads", [&heads] {
+        csdb::Amount sum;
+        for (size_t i = 0; i < heads.size(); ++i) {
+            sum += heads[i].balance_;
+        }
+        return sum;
+    });
+}
+
+namespace {
+using Wallets = cs::WalletsCache::Wallets;
+
+// the balance and the transactions number of a wallet are stored together, so they always match
+cs::WalletsCache::WalletData makeWallet(int32_t value) {
+    cs::WalletsCache::WalletData wallet;
+    wallet.balance_ = csdb::Amount(value);
+    wallet.transNum_ = static_cast<uint64_t>(value);
+    return wallet;
+}
+}  // namespace
+
+TEST(Wallets, StoresAndErases) {
+    Wallets wallets;
+    wallets.store(5, makeWallet(7));
+    EXPECT_EQ(wallets.size(), 6u);
+    EXPECT_EQ(wallets.count(), 1u);
+
+    cs::WalletsCache::WalletHead head;
+    EXPECT_FALSE(wallets.read(4, &head, nullptr));
+    EXPECT_FALSE(wallets.read(6, &head, nullptr));
+    ASSERT_TRUE(wallets.read(5, &head, nullptr));
+    EXPECT_EQ(head.transNum_, 7u);
+
+    wallets.store(5, makeWallet(8));
+    EXPECT_EQ(wallets.count(), 1u);
+
+    cs::WalletsCache::WalletData wallet;
+    ASSERT_TRUE(wallets.load(5, wallet));
+    EXPECT_EQ(wallet.balance_, csdb::Amount(8));
+
+    wallets.erase(5);
+    EXPECT_EQ(wallets.count(), 0u);
+    EXPECT_FALSE(wallets.read(5, &head, nullptr));
+}
+
+TEST(Wallets, ReadsAlongWithTheWriter) {
+    constexpr int32_t count = 10000;
+    Wallets wallets;
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> found{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            cs::WalletsCache::WalletHead head;
+            while (!stop.load()) {
+                for (cs::WalletsCache::WalletId id = 0; id < wallets.size(); ++id) {
+                    if (wallets.read(id, &head, nullptr)) {
+                        ASSERT_EQ(head.balance_, csdb::Amount(static_cast<int32_t>(head.transNum_)));
+                        ++found;
+                    }
+                }
+            }
+        });
+    }
+
+    // the wallets grow and change while they are read
+    for (int32_t round = 0; round < 20; ++round) {
+        for (int32_t i = 0; i < count; ++i) {
+            wallets.store(static_cast<cs::WalletsCache::WalletId>(i), makeWallet(round * count + i));
+        }
+    }
+
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(wallets.count(), static_cast<size_t>(count));
+    EXPECT_GT(found.load(), 0u);
+}
+
+TEST(Wallets, FrozenStaysAlongWithTheWriter) {
+    constexpr int32_t count = 10000;
+    Wallets wallets;
+    for (int32_t i = 0; i < count; ++i) {
+        wallets.store(static_cast<cs::WalletsCache::WalletId>(i), makeWallet(i));
+    }
+    wallets.erase(7);
+
+    auto frozen = wallets.freeze();
+    std::atomic<size_t> mismatches{0};
+
+    // the writer changes every wallet while the frozen ones are read
+    std::thread reader([&] {
+        for (cs::WalletsCache::WalletId id = 0; id < frozen->size(); ++id) {
+            const auto wallet = wallets.read(*frozen, id);
+            if (id == 7 ? wallet.has_value() : !wallet || wallet->transNum_ != id) {
+                ++mismatches;
+            }
+        }
+    });
+
+    for (int32_t i = 0; i < count; ++i) {
+        if (i % 3 == 0) {
+            wallets.erase(static_cast<cs::WalletsCache::WalletId>(i));
+        }
+        else {
+            wallets.store(static_cast<cs::WalletsCache::WalletId>(i), makeWallet(count + i));
+        }
+    }
+    wallets.store(count, makeWallet(count));
+
+    reader.join();
+    EXPECT_EQ(mismatches.load(), 0u);
+    EXPECT_EQ(frozen->size(), static_cast<size_t>(count));
+
+    // the writer drops the frozen ones the reader has released
+    frozen.reset();
+    wallets.store(1, makeWallet(1));
+}
+
+TEST(Wallets, DISABLED_benchmark_mixed_read_apply) {
+    constexpr int32_t count = 1000000;
+    // about the wallets a full block changes
+    constexpr int32_t blockWallets = 20000;
+    // the writer has a core of its own
+    const size_t readers = std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 4) - 1;
+    constexpr size_t reads = 200000;
+    constexpr std::chrono::microseconds interval(5);
+
+    Wallets wallets;
+    wallets.reserve(count);
+    for (int32_t i = 0; i < count; ++i) {
+        wallets.store(static_cast<cs::WalletsCache::WalletId>(i), makeWallet(i));
+    }
+
+    // the writer applies the blocks one by one while the readers find random wallets
+    auto run = [&](const char* name, bool locked) {
+        cs::SpinLock lock{ATOMIC_FLAG_INIT};
+        std::atomic<bool> stop{false};
+
+        std::thread writer([&] {
+            cs::WalletsCache::WalletData wallet;
+            for (int32_t block = 0; !stop.load(); ++block) {
+                std::unique_lock<cs::SpinLock> guard(lock, std::defer_lock);
+                if (locked) {
+                    guard.lock();
+                }
+
+                for (int32_t i = 0; i < blockWallets; ++i) {
+                    const auto id = static_cast<cs::WalletsCache::WalletId>((block * blockWallets + i) % count);
+                    wallets.load(id, wallet);
+                    wallet.balance_ += csdb::Amount(1);
+                    ++wallet.transNum_;
+                    wallets.store(id, wallet);
+                }
+
+                if (guard.owns_lock()) {
+                    guard.unlock();
+                }
+                // the next block comes later
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        });
+
+        std::vector<std::vector<int64_t>> latencies(readers);
+        std::vector<std::thread> threads;
+        for (size_t r = 0; r < readers; ++r) {
+            threads.emplace_back([&, r] {
+                std::mt19937 random(static_cast<uint32_t>(r));
+                cs::WalletsCache::WalletHead head;
+                latencies[r].reserve(reads);
+
+                // the reads come at a steady rate, a read waiting for the writer delays the next ones too
+                const auto begin = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < reads; ++i) {
+                    const auto id = static_cast<cs::WalletsCache::WalletId>(random() % count);
+                    const auto start = begin + i * interval;
+                    while (std::chrono::steady_clock::now() < start) {
+                        std::this_thread::yield();
+                    }
+
+                    if (locked) {
+                        std::lock_guard<cs::SpinLock> guard(lock);
+                        wallets.read(id, &head, nullptr);
+                    }
+                    else {
+                        wallets.read(id, &head, nullptr);
+                    }
+                    latencies[r].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        stop = true;
+        writer.join();
+
+        std::vector<int64_t> all;
+        for (const auto& part : latencies) {
+            all.insert(all.end(), part.begin(), part.end());
+        }
+        std::sort(all.begin(), all.end());
+        std::cout << name << ": p50 " << all[all.size() / 2] << " ns, p99 " << all[all.size() * 99 / 100] << " ns, max " << all.back() << " ns" << std::endl;
+    };
+
+    run("lock around the reads and the applied blocks", true);
+    run("seqlock reads", false);
+}
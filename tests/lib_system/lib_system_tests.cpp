@@ -1,12 +1,17 @@
 #define TESTING
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstring>
+#include <iostream>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <random>
 #include <thread>
 
 #include <lib/system/allocators.hpp>
+#include <lib/system/hash.hpp>
 #include <lib/system/queues.hpp>
 #include <lib/system/structures.hpp>
 
@@ -90,6 +95,29 @@ TEST(RegionAllocator, alloc_with_resizes) {
     ASSERT_EQ(allocator.getPagesNum(), 1);
 }
 
+TEST(RegionAllocator, batch_with_resizes) {
+    constexpr uint32_t kBatchSize = 10;
+    constexpr uint32_t kPageSize = AlignNumberTo64(sizeof(Region) + 50) * kBatchSize;
+
+    RegionAllocator allocator(kPageSize, 1);
+
+    for (uint32_t round = 0; round < 100; ++round) {
+        std::vector<RegionPtr> batch;
+
+        for (uint32_t i = 0; i < kBatchSize; ++i) {
+            batch.push_back(allocator.allocateNext(50));
+        }
+
+        for (uint32_t i = 0; i < kBatchSize; ++i) {
+            allocator.shrink(batch[i], i + 1);
+            ASSERT_EQ(batch[i].size(), i + 1);
+        }
+    }
+
+    // every batch frees the whole page, so it is reused
+    ASSERT_EQ(allocator.getPagesNum(), 1);
+}
+
 TEST(RegionAllocator, multithreaded_stress) {
     RegionAllocator a(10000, 10);
     uint64_t total = 0;
@@ -287,6 +315,211 @@ TEST(boost_spsc_queue, DISABLED_multithreaded_stress) {
     ASSERT_EQ(wSum.load(std::memory_order_acquire), rSum.load(std::memory_order_acquire));
 }
 
+TEST(SpscRing, consecutive) {
+    SpscRing<uint32_t, 1024> ring;
+
+    for (uint32_t i = 0; i < 1024; ++i) {
+        ASSERT_NE(ring.emplace(i), nullptr);
+        ring.publish();
+    }
+
+    ASSERT_EQ(ring.emplace(0u), nullptr);
+    ASSERT_EQ(ring.size(), 1024u);
+
+    for (uint32_t i = 0; i < 1024; ++i) {
+        ASSERT_EQ(*ring.front(), i);
+        ring.pop();
+    }
+
+    ASSERT_EQ(ring.front(), nullptr);
+}
+
+TEST(SpscRing, reserve_and_discard) {
+    SpscRing<std::shared_ptr<uint32_t>, 8> ring;
+    auto value = std::make_shared<uint32_t>(42);
+
+    for (uint32_t i = 0; i < 5; ++i) {
+        ring.emplace(value);
+    }
+
+    ASSERT_EQ(ring.reservedCount(), 5u);
+    ASSERT_EQ(ring.front(), nullptr);
+
+    ring.discard();
+    ring.discard();
+    ring.publish(3);
+
+    ASSERT_EQ(value.use_count(), 4);
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        ASSERT_EQ(**ring.front(), 42u);
+        ring.pop();
+    }
+
+    ASSERT_EQ(value.use_count(), 1);
+}
+
+TEST(SpscRing, peek) {
+    SpscRing<uint32_t, 8> ring;
+
+    for (uint32_t i = 0; i < 6; ++i) {
+        ring.emplace(i);
+    }
+    ring.publish(4);
+
+    // the reserved ones are not seen
+    ASSERT_EQ(*ring.peek(0), 0u);
+    ASSERT_EQ(*ring.peek(3), 3u);
+    ASSERT_EQ(ring.peek(4), nullptr);
+
+    ring.pop();
+    ring.publish(2);
+
+    ASSERT_EQ(*ring.peek(0), 1u);
+    ASSERT_EQ(*ring.peek(4), 5u);
+    ASSERT_EQ(ring.peek(5), nullptr);
+}
+
+TEST(SpscRing, multithreaded_stress) {
+    SpscRing<uint64_t, 256> ring;
+    constexpr uint64_t count = 1000000;
+    uint64_t rSum = 0;
+
+    std::thread producer([&]() {
+        for (uint64_t i = 0; i < count; ++i) {
+            while (!ring.emplace(i)) {
+                std::this_thread::yield();
+            }
+
+            ring.publish();
+        }
+    });
+
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t* value;
+
+        while (!(value = ring.front())) {
+            std::this_thread::yield();
+        }
+
+        ASSERT_EQ(*value, i);
+        rSum += *value;
+        ring.pop();
+    }
+
+    producer.join();
+    ASSERT_EQ(rSum, count * (count - 1) / 2);
+}
+
+// IPacMan / OPacMan before SpscRing: std::list of tasks guarded by a mutex
+template <typename T>
+class ListQueue {
+public:
+    T& allocNext() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.emplace_back();
+        return queue_.back();
+    }
+
+    void enQueueLast() {
+        size_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    T* getNextTask() {
+        while (!size_.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        return &queue_.front();
+    }
+
+    void releaseTask() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.pop_front();
+        size_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+private:
+    std::list<T> queue_;
+    std::mutex mutex_;
+    std::atomic<size_t> size_ = {0};
+};
+
+struct PacManTask {
+    std::array<uint8_t, 28> endpoint;
+    size_t size;
+    std::array<uint8_t, 96> packet;
+};
+
+// run with --gtest_also_run_disabled_tests to compare the queues
+TEST(SpscRing, DISABLED_benchmark_vs_list) {
+    constexpr uint64_t count = 10000000;
+
+    auto measure = [](const char* name, auto produce, auto consume) {
+        const auto start = std::chrono::steady_clock::now();
+
+        std::thread producer([&]() {
+            for (uint64_t i = 0; i < count; ++i) {
+                produce(i);
+            }
+        });
+
+        uint64_t sum = 0;
+
+        for (uint64_t i = 0; i < count; ++i) {
+            sum += consume();
+        }
+
+        producer.join();
+
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << name << ": " << count << " tasks in " << ms << " ms, " << (ms ? count / ms * 1000 : 0) << " tasks/s" << std::endl;
+
+        ASSERT_EQ(sum, count * (count - 1) / 2);
+    };
+
+    ListQueue<PacManTask> list;
+
+    measure("std::list + mutex",
+            [&](uint64_t i) {
+                auto& task = list.allocNext();
+                task.size = i;
+                list.enQueueLast();
+            },
+            [&]() {
+                auto task = list.getNextTask();
+                auto size = task->size;
+                list.releaseTask();
+                return size;
+            });
+
+    auto ring = std::make_unique<SpscRing<PacManTask, 1 << 14>>();
+
+    measure("SpscRing",
+            [&](uint64_t i) {
+                PacManTask* task;
+
+                while (!(task = ring->emplace())) {
+                    std::this_thread::yield();
+                }
+
+                task->size = i;
+                ring->publish();
+            },
+            [&]() {
+                PacManTask* task;
+
+                while (!(task = ring->front())) {
+                    std::this_thread::yield();
+                }
+
+                auto size = task->size;
+                ring->pop();
+                return size;
+            });
+}
+
 // TODO: Enable test and fix crush on linux
 TEST(typed_allocator, DISABLED_one_page) {
     TypedAllocator<uint32_t> allocator(100);
@@ -455,6 +688,260 @@ TEST(FixedHashMap, destroy) {
     ASSERT_EQ(IntWithCounter::counter, 0);
 }
 
+TEST(FixedHashMap, eviction_with_collisions) {
+    // uint16_t index folds every 65536 keys together
+    FixedHashMap<uint32_t, uint64_t, uint16_t, 1000> hm;
+
+    for (uint32_t i = 0; i < 200000; ++i) {
+        auto& c = hm.tryStore(i * 65536 + i % 7);
+        ASSERT_EQ(c, 0);
+        c = i;
+
+        if (i >= 1000 && i % 997 == 0) {
+            for (uint32_t j = i - 999; j <= i; ++j) {
+                ASSERT_EQ(hm.tryStore(j * 65536 + j % 7), j);
+            }
+        }
+    }
+
+    ASSERT_EQ(hm.size(), 1000u);
+}
+
+TEST(FixedHashMap, find_does_not_store) {
+    FixedHashMap<uint32_t, uint64_t, uint16_t, 10> hm;
+
+    for (uint32_t i = 0; i < 10; ++i) {
+        hm.tryStore(i) = i + 1;
+    }
+
+    // a miss neither adds a key nor evicts the oldest one
+    for (uint32_t i = 100; i < 200; ++i) {
+        ASSERT_EQ(hm.find(i), nullptr);
+    }
+
+    ASSERT_EQ(hm.size(), 10u);
+    for (uint32_t i = 0; i < 10; ++i) {
+        auto found = hm.find(i);
+        ASSERT_NE(found, nullptr);
+        ASSERT_EQ(*found, i + 1);
+    }
+}
+
+TEST(FixedHashMap, stats) {
+    FixedHashMap<uint32_t, uint64_t, uint16_t, 10000> hm;
+
+    for (uint32_t i = 0; i < 30000; ++i) {
+        hm.tryStore(i);
+    }
+
+    const auto stats = hm.getStats();
+
+    ASSERT_EQ(stats.size, 10000u);
+    ASSERT_EQ(stats.slots, 32768u);
+    ASSERT_LE(stats.loadFactor, 0.5);
+    ASSERT_GE(stats.averageProbe, 1.0);
+    ASSERT_LT(stats.maxProbe, 64u);
+}
+
+// FixedHashMap before open addressing: 1 << 16 buckets chained by a
+// doubly-linked list, index is the hash xor-folded into two bytes
+class ChainedHashMap {
+public:
+    struct Element {
+        Element *up, *down = nullptr;
+        Element** bucket;
+
+        cs::Hash key;
+        uint32_t data = 0;
+
+        Element(const cs::Hash& _key, Element** _bucket)
+        : bucket(_bucket)
+        , key(_key) {
+        }
+    };
+
+    ChainedHashMap()
+    : buckets_(new Element*[1 << 16]()) {
+    }
+
+    ~ChainedHashMap() {
+        delete[] buckets_;
+    }
+
+    uint32_t& tryStore(const cs::Hash& key) {
+        Element** myBucket = buckets_ + index(key);
+
+        for (Element* elt = *myBucket; elt; elt = elt->up) {
+            if (elt->key == key) {
+                return elt->data;
+            }
+        }
+
+        if (buffer_.size() == 100000) {
+            auto toRemove = buffer_.frontPtr();
+
+            if (toRemove->down) {
+                toRemove->down->up = toRemove->up;
+            }
+            else {
+                *(toRemove->bucket) = toRemove->up;
+            }
+
+            if (toRemove->up) {
+                toRemove->up->down = toRemove->down;
+            }
+        }
+
+        Element& newComer = buffer_.emplace(key, myBucket);
+        newComer.up = *myBucket;
+
+        if (newComer.up) {
+            newComer.up->down = &newComer;
+        }
+
+        *myBucket = &newComer;
+        return newComer.data;
+    }
+
+private:
+    static uint16_t index(const cs::Hash& hash) {
+        uint16_t result = 0;
+        auto byte = reinterpret_cast<uint8_t*>(&result);
+
+        for (size_t i = 0; i < hash.size() / 2; ++i) {
+            byte[0] ^= hash[i];
+        }
+
+        for (size_t i = hash.size() / 2; i < hash.size(); ++i) {
+            byte[1] ^= hash[i];
+        }
+
+        return result;
+    }
+
+    FixedCircularBuffer<Element, 100000> buffer_;
+    Element** buckets_;
+};
+
+// run with --gtest_also_run_disabled_tests to compare the maps
+TEST(FixedHashMap, DISABLED_benchmark_vs_chained) {
+    constexpr size_t keysCount = 300000;
+    constexpr size_t operations = 5000000;
+
+    // dedup-like stream: every second key has been seen recently
+    std::vector<cs::Hash> keys(keysCount);
+    std::mt19937_64 random(42);
+
+    for (auto& key : keys) {
+        for (auto& byte : key) {
+            byte = static_cast<uint8_t>(random());
+        }
+    }
+
+    std::vector<uint32_t> stream(operations);
+
+    for (size_t i = 0; i < operations; ++i) {
+        const size_t fresh = (i / 2) % keysCount;
+        stream[i] = static_cast<uint32_t>(i % 2 ? fresh : (fresh + keysCount - random() % 50000) % keysCount);
+    }
+
+    auto measure = [&](const char* name, auto& map) {
+        uint64_t sum = 0;
+        const auto start = std::chrono::steady_clock::now();
+
+        for (auto index : stream) {
+            sum += map.tryStore(keys[index])++;
+        }
+
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        std::cout << name << ": " << operations << " lookups at 100k entries, " << static_cast<double>(ns) / operations << " ns/op, checksum " << sum << std::endl;
+        return sum;
+    };
+
+    auto chained = std::make_unique<ChainedHashMap>();
+    auto open = std::make_unique<FixedHashMap<cs::Hash, uint32_t, uint64_t, 100000>>();
+
+    const auto chainedSum = measure("chained, 16-bit index", *chained);
+    const auto openSum = measure("open addressing", *open);
+
+    const auto stats = open->getStats();
+    std::cout << "load factor " << stats.loadFactor << ", average probe " << stats.averageProbe << ", max probe " << stats.maxProbe << std::endl;
+
+    ASSERT_EQ(chainedSum, openSum);
+}
+
+TEST(generateHashes, matches_generateHash) {
+    // around the block of 128 bytes, the packet and the fragment header sizes, and an odd count
+    const std::vector<size_t> sizes = {0, 1, 50, 127, 128, 129, 255, 256, 257, 1000, 1024, 4096, 3, 128, 1024, 50, 0, 777, 1023};
+    std::vector<std::vector<uint8_t>> buffers;
+    std::mt19937_64 random(1);
+
+    for (size_t size : sizes) {
+        buffers.emplace_back(size);
+        for (auto& byte : buffers.back()) {
+            byte = static_cast<uint8_t>(random());
+        }
+    }
+
+    for (size_t count = 0; count <= buffers.size(); ++count) {
+        std::vector<const void*> data;
+        std::vector<size_t> lengths;
+
+        for (size_t i = 0; i < count; ++i) {
+            data.push_back(buffers[i].data());
+            lengths.push_back(buffers[i].size());
+        }
+
+        std::vector<cs::Hash> hashes(count);
+        generateHashes(data.data(), lengths.data(), hashes.data(), count);
+
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(hashes[i], generateHash(buffers[i].data(), buffers[i].size())) << "count " << count << ", buffer " << i;
+        }
+    }
+}
+
+TEST(generateHashes, DISABLED_benchmark_vs_generateHash) {
+    constexpr size_t packets = 4096;
+    constexpr size_t rounds = 50;
+
+    for (size_t size : {size_t(50), size_t(1024)}) {
+        std::vector<uint8_t> buffer(packets * size);
+        std::mt19937_64 random(2);
+        for (auto& byte : buffer) {
+            byte = static_cast<uint8_t>(random());
+        }
+
+        std::vector<const void*> data(packets);
+        std::vector<size_t> lengths(packets, size);
+        for (size_t i = 0; i < packets; ++i) {
+            data[i] = buffer.data() + i * size;
+        }
+
+        std::vector<cs::Hash> single(packets);
+        std::vector<cs::Hash> batch(packets);
+
+        auto measure = [&](const char* name, auto&& func) {
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t round = 0; round < rounds; ++round) {
+                func();
+            }
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            std::cout << name << ", " << size << " bytes: " << static_cast<double>(ns) / (rounds * packets) << " ns/buffer" << std::endl;
+        };
+
+        measure("generateHash", [&] {
+            for (size_t i = 0; i < packets; ++i) {
+                single[i] = generateHash(data[i], lengths[i]);
+            }
+        });
+
+        measure("generateHashes", [&] { generateHashes(data.data(), lengths.data(), batch.data(), packets); });
+
+        ASSERT_EQ(single, batch);
+    }
+}
+
 TEST(FixedCircularBuffer, BasicCreation) {
     IntWithCounter::counter = 0;
     FixedCircularBuffer<IntWithCounter, 32> buffer;